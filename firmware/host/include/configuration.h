@@ -0,0 +1,56 @@
+/*******************************************************************************
+  Host System Configuration Header
+
+  File Name:
+    configuration.h
+
+  Summary:
+    Build-time configuration of the host (Linux) unit test build.
+
+  Description:
+    Stands in for src/config/pic32mz_w1/configuration.h, which pulls in the
+    XC32 device headers. Only the options used by the modules built on the
+    host are defined, with the same values as the board configuration; keep
+    them in step when the board configuration changes.
+*******************************************************************************/
+
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+/* File System Service Configuration */
+#define SYS_FS_MEDIA_MAX_BLOCK_SIZE          512
+
+/* Memory Driver Global Configuration Options */
+#define DRV_MEMORY_INSTANCES_NUMBER          1
+
+/* Memory Driver Instance 0 Configuration */
+#define DRV_MEMORY_INDEX_0                   0
+#define DRV_MEMORY_CLIENTS_NUMBER_IDX0       4
+#define DRV_MEMORY_BUFFER_QUEUE_SIZE_IDX0    2
+
+/* Top of the flash kept out of the FAT volume for the telemetry journal and the DPS cache */
+#define DRV_MEMORY_FS_RESERVED_SIZE          (64 * 1024)
+
+/* SST26 Driver Instance Configuration */
+#define DRV_SST26_INDEX                 0
+#define DRV_SST26_CLIENTS_NUMBER        1
+#define DRV_SST26_START_ADDRESS         0x0
+#define DRV_SST26_PAGE_SIZE             256
+#define DRV_SST26_ERASE_BUFFER_SIZE     4096
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // CONFIGURATION_H
+/*******************************************************************************
+ End of File
+*/
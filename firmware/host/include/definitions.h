@@ -0,0 +1,53 @@
+/*******************************************************************************
+  Host System Definitions
+
+  File Name:
+    definitions.h
+
+  Summary:
+    Project system definitions of the host (Linux) unit test build.
+
+  Description:
+    Stands in for src/config/pic32mz_w1/definitions.h. It includes the
+    Harmony headers of the services the host modules use, the memory driver
+    and the OSAL, and maps the console and the few RTOS calls they make onto
+    the host.
+*******************************************************************************/
+
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "osal/osal.h"
+#include "driver/memory/drv_memory.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+/* No data cache on the host */
+#define CACHE_ALIGN
+
+#define SYS_CONSOLE_PRINT(fmt, ...)     printf(fmt, ##__VA_ARGS__)
+#define SYS_CONSOLE_MESSAGE(message)    printf("%s", message)
+
+/* ThreadX sleep in 1 ms ticks, TX_TIMER_TICKS_PER_SECOND of the target */
+unsigned int tx_thread_sleep(unsigned long timer_ticks);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // DEFINITIONS_H
+/*******************************************************************************
+ End of File
+*/
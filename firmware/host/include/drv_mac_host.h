@@ -0,0 +1,59 @@
+/*******************************************************************************
+  Host MAC Driver Header
+
+  File Name:
+    drv_mac_host.h
+
+  Summary:
+    Loopback MAC driver of the host build.
+
+  Description:
+    DRV_MAC_HOST_Object is a Harmony TCPIP_MAC_OBJECT that stands in for the
+    PIC32MZW1 Wi-Fi MAC behind the Azure glue. Every transmitted frame is
+    received back: TCPIP_MAC_PacketTx queues the packet and signals
+    TCPIP_MAC_EV_TX_DONE, TCPIP_MAC_Process copies each queued frame into an
+    RX packet taken with the stack pktAllocF, acknowledges the TX packet
+    with pktAckF and signals TCPIP_MAC_EV_RX_PKTPEND. The RX packets are
+    returned with pktFreeF when the stack acknowledges them.
+
+    The link can be taken down to exercise the link loss paths of a client.
+*******************************************************************************/
+
+#ifndef _DRV_MAC_HOST_H
+#define _DRV_MAC_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tcpip/tcpip_mac_object.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+/* Locally administered address reported when the stack does not set one */
+#define DRV_MAC_HOST_ADDRESS            { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 }
+
+// *****************************************************************************
+
+extern const TCPIP_MAC_OBJECT DRV_MAC_HOST_Object;
+
+/* Reports the link state, signals TCPIP_MAC_EV_CONN_ESTABLISHED/LOST on a
+   change. Frames sent while the link is down are acknowledged with
+   TCPIP_MAC_PKT_ACK_LINK_DOWN and not looped back */
+void DRV_MAC_HOST_LinkSet(bool up);
+
+#endif /* _DRV_MAC_HOST_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,71 @@
+/*******************************************************************************
+  Host Memory Driver Header
+
+  File Name:
+    drv_memory_host.h
+
+  Summary:
+    Test controls of the RAM backed memory driver of the host build.
+
+  Description:
+    drv_memory_host.c implements the DRV_MEMORY client interface on a RAM
+    image with the SST26 geometry and NOR semantics: an erase sets a sector
+    to 0xFF and a page program can only clear bits. Requests complete
+    before the Async call returns, the transfer handler runs on the caller.
+
+    The controls below let a test start from a blank part, reject requests
+    as if the driver queue was full, fail requests, or cut the power in the
+    middle of a program so that the recovery of the flash clients can be
+    exercised.
+*******************************************************************************/
+
+#ifndef _DRV_MEMORY_HOST_H
+#define _DRV_MEMORY_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+/* 1 MB part, the reserved area sits at its top like on the 8 MB SST26VF064B */
+#define DRV_MEMORY_HOST_MEDIA_SIZE      (1024 * 1024)
+#define DRV_MEMORY_HOST_SECTORS         (DRV_MEMORY_HOST_MEDIA_SIZE / DRV_SST26_ERASE_BUFFER_SIZE)
+
+// *****************************************************************************
+
+/* Erases the whole part, closes the clients, clears the controls and counters */
+void DRV_MEMORY_HOST_Reset(void);
+/* Closes the clients and clears the controls, the flash contents and the
+   counters are kept, for the clients to be initialized again */
+void DRV_MEMORY_HOST_Reboot(void);
+/* The next count requests find the request queue full */
+void DRV_MEMORY_HOST_QueueFullSet(uint32_t count);
+/* The program or erase after the next count ones completes with an error,
+   the flash is left unchanged */
+void DRV_MEMORY_HOST_FailSet(uint32_t count);
+/* The program after the next count ones only gets its first length bytes
+   into the flash, then every request fails until DRV_MEMORY_HOST_Reboot */
+void DRV_MEMORY_HOST_PowerCutSet(uint32_t count, uint32_t length);
+
+uint8_t *DRV_MEMORY_HOST_Image(void);
+uint32_t DRV_MEMORY_HOST_EraseCount(uint32_t sector);
+uint32_t DRV_MEMORY_HOST_ProgramCount(void);
+uint32_t DRV_MEMORY_HOST_ReadCount(void);
+
+#endif /* _DRV_MEMORY_HOST_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
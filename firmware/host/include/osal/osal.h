@@ -0,0 +1,100 @@
+/*******************************************************************************
+  Host OSAL Header
+
+  File Name:
+    osal.h
+
+  Summary:
+    OSAL implementation for the host (Linux) unit test build.
+
+  Description:
+    Same interface as osal_threadx.h, implemented on POSIX threads, so the
+    Harmony drivers and the application modules that synchronize through
+    the OSAL build and run unchanged on the host.
+*******************************************************************************/
+
+#ifndef _OSAL_H
+#define _OSAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint8_t         count;
+    uint8_t         maxCount;
+} OSAL_SEM_HANDLE_TYPE;
+
+typedef pthread_mutex_t                 OSAL_MUTEX_HANDLE_TYPE;
+typedef uint32_t                        OSAL_CRITSECT_DATA_TYPE;
+
+#define OSAL_WAIT_FOREVER               0xFFFF
+#define OSAL_SEM_DECLARE(semID)         OSAL_SEM_HANDLE_TYPE semID
+#define OSAL_MUTEX_DECLARE(mutexID)     OSAL_MUTEX_HANDLE_TYPE mutexID
+#define OSAL_ASSERT(test, message)      test
+
+typedef enum OSAL_SEM_TYPE
+{
+  OSAL_SEM_TYPE_BINARY,
+  OSAL_SEM_TYPE_COUNTING
+} OSAL_SEM_TYPE;
+
+typedef enum OSAL_CRIT_TYPE
+{
+  OSAL_CRIT_TYPE_LOW,
+  OSAL_CRIT_TYPE_HIGH
+} OSAL_CRIT_TYPE;
+
+typedef enum OSAL_RESULT
+{
+  OSAL_RESULT_NOT_IMPLEMENTED = -1,
+  OSAL_RESULT_FALSE = 0,
+  OSAL_RESULT_TRUE = 1
+} OSAL_RESULT;
+
+OSAL_RESULT OSAL_SEM_Create(OSAL_SEM_HANDLE_TYPE* semID, OSAL_SEM_TYPE type, uint8_t maxCount, uint8_t initialCount);
+OSAL_RESULT OSAL_SEM_Delete(OSAL_SEM_HANDLE_TYPE* semID);
+OSAL_RESULT OSAL_SEM_Pend(OSAL_SEM_HANDLE_TYPE* semID, uint16_t waitMS);
+OSAL_RESULT OSAL_SEM_Post(OSAL_SEM_HANDLE_TYPE* semID);
+OSAL_RESULT OSAL_SEM_PostISR(OSAL_SEM_HANDLE_TYPE* semID);
+uint8_t OSAL_SEM_GetCount(OSAL_SEM_HANDLE_TYPE* semID);
+
+/* There are no interrupts on the host, the critical sections take one
+   process wide recursive lock */
+OSAL_CRITSECT_DATA_TYPE OSAL_CRIT_Enter(OSAL_CRIT_TYPE severity);
+void OSAL_CRIT_Leave(OSAL_CRIT_TYPE severity, OSAL_CRITSECT_DATA_TYPE status);
+
+OSAL_RESULT OSAL_MUTEX_Create(OSAL_MUTEX_HANDLE_TYPE* mutexID);
+OSAL_RESULT OSAL_MUTEX_Delete(OSAL_MUTEX_HANDLE_TYPE* mutexID);
+OSAL_RESULT OSAL_MUTEX_Lock(OSAL_MUTEX_HANDLE_TYPE* mutexID, uint16_t waitMS);
+OSAL_RESULT OSAL_MUTEX_Unlock(OSAL_MUTEX_HANDLE_TYPE* mutexID);
+
+void* OSAL_Malloc(size_t size);
+void OSAL_Free(void* pData);
+
+OSAL_RESULT OSAL_Initialize(void);
+const char* OSAL_Name(void);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // _OSAL_H
+/*******************************************************************************
+ End of File
+*/
@@ -0,0 +1,26 @@
+/*******************************************************************************
+  Host Interrupt System Service Header
+
+  File Name:
+    sys_int.h
+
+  Summary:
+    Empty stand-in for the PIC32 interrupt system service.
+
+  Description:
+    The Harmony driver headers include sys_int.h for the EVIC interrupt
+    sources, none of which exist on the host. The host modules do not use
+    the interrupt service, only the header has to resolve.
+*******************************************************************************/
+
+#ifndef SYS_INT_H
+#define SYS_INT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif // SYS_INT_H
+/*******************************************************************************
+ End of File
+*/
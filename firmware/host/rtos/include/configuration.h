@@ -0,0 +1,97 @@
+/*******************************************************************************
+  Host RTOS Image Configuration
+
+  File Name:
+    configuration.h
+
+  Summary:
+    Build-time configuration of the host (Linux) RTOS image.
+
+  Description:
+    Stands in for src/config/pic32mz_w1/configuration.h with the options of
+    the services the image keeps: the memory driver on the RAM backed SST26,
+    the I2C client index of the sensors and the Azure glue interface. The
+    interface is not TCPIP_IF_PIC32MZW1: the loopback MAC behind it needs no
+    segment gap of its own, and the Wi-Fi MAC gap does not fit
+    NX_PHYSICAL_HEADER once the gap descriptor holds a 64-bit pointer.
+*******************************************************************************/
+
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+#include "device.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+/* TIME System Service Configuration Options */
+#define SYS_TIME_INDEX_0                     (0)
+#define SYS_TIME_CPU_CLOCK_FREQUENCY         (200000000)
+
+#define SYS_CONSOLE_INDEX_0                  0
+#define SYS_CONSOLE_DEVICE_MAX_INSTANCES     1
+#define SYS_CONSOLE_PRINT_BUFFER_SIZE        512
+
+#define SYS_DEBUG_ENABLE
+#define SYS_DEBUG_GLOBAL_ERROR_LEVEL         SYS_ERROR_DEBUG
+
+/* File System Service Configuration */
+#define SYS_FS_MEDIA_NUMBER                  1
+#define SYS_FS_VOLUME_NUMBER                 1
+#define SYS_FS_AUTOMOUNT_ENABLE              false
+#define SYS_FS_MAX_FILES                     2
+#define SYS_FS_MAX_FILE_SYSTEM_TYPE          1
+#define SYS_FS_MEDIA_MAX_BLOCK_SIZE          512
+#define SYS_FS_MEDIA_MANAGER_BUFFER_SIZE     2048
+#define SYS_FS_USE_LFN                       1
+#define SYS_FS_FILE_NAME_LEN                 255
+#define SYS_FS_CWD_STRING_LEN                1024
+#define SYS_FS_FAT_MAX_SS                    SYS_FS_MEDIA_MAX_BLOCK_SIZE
+
+/* I2C Driver Instance 0 Configuration Options */
+#define DRV_I2C_INDEX_0                      0
+#define DRV_I2C_CLIENTS_NUMBER_IDX0          1
+#define DRV_I2C_INSTANCES_NUMBER             1
+
+/* Memory Driver Global Configuration Options */
+#define DRV_MEMORY_INSTANCES_NUMBER          1
+
+/* Memory Driver Instance 0 Configuration */
+#define DRV_MEMORY_INDEX_0                   0
+#define DRV_MEMORY_CLIENTS_NUMBER_IDX0       4
+#define DRV_MEMORY_BUFFER_QUEUE_SIZE_IDX0    2
+
+/* Top of the flash kept out of the FAT volume for the telemetry journal and the DPS cache */
+#define DRV_MEMORY_FS_RESERVED_SIZE          (64 * 1024)
+
+/* SST26 Driver Instance Configuration */
+#define DRV_SST26_INDEX                 0
+#define DRV_SST26_CLIENTS_NUMBER        1
+#define DRV_SST26_START_ADDRESS         0x0
+#define DRV_SST26_PAGE_SIZE             256
+#define DRV_SST26_ERASE_BUFFER_SIZE     4096
+
+/* USB Device Layer, only its types are used */
+#define USB_DEVICE_DRIVER_INITIALIZE_EXPLICIT
+#define USB_DEVICE_INSTANCES_NUMBER          1
+#define USB_DEVICE_EP0_BUFFER_SIZE           64
+#define USB_ALIGN                            CACHE_ALIGN
+
+/* AzureIoT Interface Index 0 Configuration */
+#define AZURE_INTERFACE_DEFAULT_INTERFACE_NAME_IDX0     "LOOPBACK"
+#define AZURE_INTERFACE_DEFAULT_MAC_ADDR_IDX0           0
+#define AZURE_INTERFACE_DEFAULT_DRIVER_IDX0             DRV_MAC_HOST_Object
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // CONFIGURATION_H
+/*******************************************************************************
+ End of File
+*/
@@ -0,0 +1,67 @@
+/*******************************************************************************
+  Host RTOS Image System Definitions
+
+  File Name:
+    definitions.h
+
+  Summary:
+    Project system definitions of the host (Linux) RTOS image.
+
+  Description:
+    Stands in for src/config/pic32mz_w1/definitions.h when the application,
+    the Azure IoT sample and the glue run on ThreadX on its Linux port. The
+    Harmony headers are the target ones; the services behind them are the
+    host ones of src/sys_host.c, with the sensors' I2C bus answering nothing
+    and the loopback MAC in place of the Wi-Fi driver.
+*******************************************************************************/
+
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "crypto/crypto.h"
+#include "tx_api.h"
+#include "osal/osal.h"
+#include "system/debug/sys_debug.h"
+#include "system/int/sys_int.h"
+#include "system/time/sys_time.h"
+#include "system/console/sys_console.h"
+#include "system/fs/sys_fs.h"
+#include "system/reset/sys_reset.h"
+#include "driver/i2c/drv_i2c.h"
+#include "driver/memory/drv_memory.h"
+#include "usb/usb_device.h"
+#include "bsp/bsp.h"
+#include "peripheral/gpio/plib_gpio.h"
+#include "azure_glue.h"
+#include "tcpip/tcpip_mac.h"
+#include "tcpip/tcpip_mac_object.h"
+#include "drv_mac_host.h"
+#include "drv_memory_host.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+/* strlcat of the XC32 C library, glibc has none */
+size_t strlcat(char *dst, const char *src, size_t size);
+
+#include "app.h"
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // DEFINITIONS_H
+/*******************************************************************************
+ End of File
+*/
@@ -0,0 +1,53 @@
+/*******************************************************************************
+  Host RTOS Image Device Header
+
+  File Name:
+    device.h
+
+  Summary:
+    Special function registers of the host RTOS image.
+
+  Description:
+    Stands in for the xc.h device header. The generated port macros of
+    bsp.h and plib_gpio.h write and read these; on the host they are plain
+    words with no pins behind them, so a set, clear or invert write is
+    only recorded in its own register.
+*******************************************************************************/
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <stdint.h>
+#include "toolchain_specifics.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+/* No coherent (uncached) memory on the host */
+#undef CACHE_ALIGN
+#define CACHE_ALIGN
+
+#define DEVICE_HOST_PORT_REGISTERS(port)                        \
+    extern volatile uint32_t LAT##port, LAT##port##SET,         \
+        LAT##port##CLR, LAT##port##INV, TRIS##port##SET,        \
+        TRIS##port##CLR, PORT##port, CNEN##port##SET,           \
+        CNEN##port##CLR;
+
+DEVICE_HOST_PORT_REGISTERS(A)
+DEVICE_HOST_PORT_REGISTERS(B)
+DEVICE_HOST_PORT_REGISTERS(C)
+DEVICE_HOST_PORT_REGISTERS(K)
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // DEVICE_H
+/*******************************************************************************
+ End of File
+*/
@@ -0,0 +1,56 @@
+/*******************************************************************************
+  Host Debug System Service Header
+
+  File Name:
+    sys_debug.h
+
+  Summary:
+    Debug print of the host RTOS image.
+
+  Description:
+    Stands in for the Harmony debug service on the console. nx_user.h maps
+    printf onto _SYS_DEBUG_PRINT after including this header, so stdio.h is
+    included here, ahead of that macro.
+*******************************************************************************/
+
+#ifndef SYS_DEBUG_H
+#define SYS_DEBUG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+typedef enum
+{
+    SYS_ERROR_FATAL     = 0,
+    SYS_ERROR_ERROR     = 1,
+    SYS_ERROR_WARNING   = 2,
+    SYS_ERROR_INFO      = 3,
+    SYS_ERROR_DEBUG     = 4
+} SYS_ERROR_LEVEL;
+
+void SYS_DEBUG_Print(SYS_ERROR_LEVEL level, const char *format, ...);
+void SYS_DEBUG_ErrorLevelSet(SYS_ERROR_LEVEL level);
+
+#define _SYS_DEBUG_PRINT(level, format, ...)    SYS_DEBUG_Print(level, format, ##__VA_ARGS__)
+#define _SYS_DEBUG_MESSAGE(level, message)      SYS_DEBUG_Print(level, "%s", message)
+#define SYS_DEBUG_PRINT(level, fmt, ...)        _SYS_DEBUG_PRINT(level, fmt, ##__VA_ARGS__)
+#define SYS_DEBUG_MESSAGE(level, message)       _SYS_DEBUG_MESSAGE(level, message)
+#define SYS_ERROR_PRINT(level, fmt, ...)        SYS_DEBUG_PRINT(level, fmt, ##__VA_ARGS__)
+#define SYS_ERROR_MESSAGE(level, message)       SYS_DEBUG_MESSAGE(level, message)
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // SYS_DEBUG_H
+/*******************************************************************************
+ End of File
+*/
@@ -0,0 +1,52 @@
+/*******************************************************************************
+  Host RTOS Image Interrupt System Service Header
+
+  File Name:
+    sys_int.h
+
+  Summary:
+    Interrupt source control of the host RTOS image.
+
+  Description:
+    The Azure glue masks the MAC interrupt source around its RX queue. The
+    host MAC signals its events from threads under its own lock, so there
+    is no source to mask and the calls only have to resolve.
+*******************************************************************************/
+
+#ifndef SYS_INT_H
+#define SYS_INT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+typedef int INT_SOURCE;
+
+static inline bool SYS_INT_SourceDisable(INT_SOURCE source)
+{
+    (void)source;
+    return false;
+}
+
+static inline void SYS_INT_SourceRestore(INT_SOURCE source, bool status)
+{
+    (void)source;
+    (void)status;
+}
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // SYS_INT_H
+/*******************************************************************************
+ End of File
+*/
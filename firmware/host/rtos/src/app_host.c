@@ -0,0 +1,64 @@
+/*******************************************************************************
+  Host RTOS Image Application
+
+  File Name:
+    app_host.c
+
+  Summary:
+    Application state machine of the host RTOS image.
+
+  Description:
+    Stands in for app.c. There is no file system, USB drive, ECC608 or Wi-Fi
+    on the host: APP_Tasks starts NetX Duo and the Azure IoT sample as the
+    target does, then reports the loopback link as a connected Wi-Fi
+    station. The globals of app.c that the sample and the application
+    modules use keep their target defaults.
+*******************************************************************************/
+
+#include "definitions.h"
+
+#define REGISTRATION_ID_MAX_LEN 64
+UCHAR g_registration_id[REGISTRATION_ID_MAX_LEN];
+UINT g_registration_id_length;
+
+APP_DATA app_pic32mz_w1Data;
+
+char default_id_scope[64]         =   "0ne006B6CF8";
+char default_registration_id[64]  =   "PIC32MZW1";
+char default_primary_key[128]     =   "mujHRQMx8dUsZETtlWxSonGZ24++L69c8KjIvZDT+5M=";
+
+extern APP_CONNECT_STATUS appConnectStatus;
+extern void nx_azure_init(void);
+extern void sample_wifi_notify(void);
+
+void APP_Initialize(void)
+{
+    app_pic32mz_w1Data.appPic32mzW1State = APP_STATE_AZ_INIT;
+}
+
+void APP_Tasks(void)
+{
+    switch(app_pic32mz_w1Data.appPic32mzW1State)
+    {
+        case APP_STATE_AZ_INIT:
+            nx_azure_init();
+            app_pic32mz_w1Data.appPic32mzW1State = APP_STATE_INIT;
+            break;
+
+        case APP_STATE_INIT:
+            /* The loopback link is up from the start */
+            appConnectStatus.wifi = true;
+            sample_wifi_notify();
+            SYS_CONSOLE_MESSAGE("WiFi Connected\r\n");
+            app_pic32mz_w1Data.appPic32mzW1State = APP_STATE_SERVICE_TASKS;
+            break;
+
+        case APP_STATE_SERVICE_TASKS:
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,34 @@
+/*******************************************************************************
+  Host RTOS Image ECC608 Crypto Method
+
+  File Name:
+    atca_host.c
+
+  Summary:
+    ECDSA method of the host RTOS image in place of the ECC608 one.
+
+  Description:
+    The host has no ECC608, so crypto_method_ecdsa_pkcs11_atca of
+    ecc608_ciphersuites is the software ECDSA of the NetX crypto library:
+    server certificates are verified the same way, and the device key,
+    which only exists in the secure element, cannot sign.
+*******************************************************************************/
+
+#include "nx_crypto_ecdsa.h"
+
+NX_CRYPTO_METHOD crypto_method_ecdsa_pkcs11_atca =
+{
+    NX_CRYPTO_DIGITAL_SIGNATURE_ECDSA,                  /* ECDSA crypto algorithm                 */
+    0,                                                  /* Key size in bits                       */
+    0,                                                  /* IV size in bits                        */
+    0,                                                  /* ICV size in bits, not used             */
+    0,                                                  /* Block size in bytes                    */
+    sizeof(NX_CRYPTO_ECDSA),                            /* Metadata size in bytes                 */
+    _nx_crypto_method_ecdsa_init,                       /* ECDSA initialization routine           */
+    _nx_crypto_method_ecdsa_cleanup,                    /* ECDSA cleanup routine                  */
+    _nx_crypto_method_ecdsa_operation,                  /* ECDSA operation                        */
+};
+
+/*******************************************************************************
+ End of File
+ */
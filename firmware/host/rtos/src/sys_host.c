@@ -0,0 +1,224 @@
+/*******************************************************************************
+  Host RTOS Image System Services
+
+  File Name:
+    sys_host.c
+
+  Summary:
+    Harmony services and initialization data of the host RTOS image.
+
+  Description:
+    The console and debug prints go to stdout. The time service counts
+    microseconds of the monotonic clock and the random numbers come from
+    getrandom(). No device answers on the I2C bus: a transfer is refused
+    the way the driver refuses one while its queue is full, so the click
+    drivers see their sensors as absent. The pin interrupts are never
+    raised and a software reset ends the process.
+
+    The Azure glue is initialized, as on the target, with the interface of
+    configuration.h: the loopback MAC of drv_mac_host.c.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+#include "definitions.h"
+
+// *****************************************************************************
+// Special function registers of device.h
+
+#define DEVICE_HOST_PORT_DEFINE(port)                           \
+    volatile uint32_t LAT##port, LAT##port##SET,                \
+        LAT##port##CLR, LAT##port##INV, TRIS##port##SET,        \
+        TRIS##port##CLR, PORT##port, CNEN##port##SET,           \
+        CNEN##port##CLR;
+
+DEVICE_HOST_PORT_DEFINE(A)
+DEVICE_HOST_PORT_DEFINE(B)
+DEVICE_HOST_PORT_DEFINE(C)
+DEVICE_HOST_PORT_DEFINE(K)
+
+// *****************************************************************************
+// Azure glue initialization data
+
+const AZURE_GLUE_NETWORK_CONFIG azure_net_config[] =
+{
+/*** Interface 0 Configuration  ***/
+{
+   .macAddr = AZURE_INTERFACE_DEFAULT_MAC_ADDR_IDX0,
+   .pMacObject = &AZURE_INTERFACE_DEFAULT_DRIVER_IDX0,
+},
+};
+
+const AZURE_GLUE_INIT azure_glue_init =
+{
+    .nNets = sizeof(azure_net_config) / sizeof(*azure_net_config),
+    .pNetConf = azure_net_config,
+};
+
+// *****************************************************************************
+// Console and debug
+
+static SYS_ERROR_LEVEL sysDebugLevel = SYS_DEBUG_GLOBAL_ERROR_LEVEL;
+
+void SYS_CONSOLE_Print(const SYS_CONSOLE_HANDLE handle, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    fflush(stdout);
+}
+
+void SYS_CONSOLE_Message(const SYS_CONSOLE_HANDLE handle, const char *message)
+{
+    fputs(message, stdout);
+    fflush(stdout);
+}
+
+void SYS_DEBUG_Print(SYS_ERROR_LEVEL level, const char *format, ...)
+{
+    va_list args;
+
+    if(level > sysDebugLevel)
+    {
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    fflush(stdout);
+}
+
+void SYS_DEBUG_ErrorLevelSet(SYS_ERROR_LEVEL level)
+{
+    sysDebugLevel = level;
+}
+
+// *****************************************************************************
+// Time
+
+uint32_t SYS_TIME_FrequencyGet(void)
+{
+    return 1000000;
+}
+
+uint64_t SYS_TIME_Counter64Get(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+SYS_TIME_HANDLE SYS_TIME_CallbackRegisterMS(SYS_TIME_CALLBACK callback, uintptr_t context,
+                                            uint32_t ms, SYS_TIME_CALLBACK_TYPE type)
+{
+    return SYS_TIME_HANDLE_INVALID;
+}
+
+// *****************************************************************************
+// Reset
+
+void SYS_RESET_SoftwareReset(void)
+{
+    printf("Software reset\r\n");
+    exit(EXIT_SUCCESS);
+}
+
+// *****************************************************************************
+// I2C driver, an empty bus
+
+DRV_HANDLE DRV_I2C_Open(const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT ioIntent)
+{
+    return drvIndex == DRV_I2C_INDEX_0 ? (DRV_HANDLE)1 : DRV_HANDLE_INVALID;
+}
+
+bool DRV_I2C_WriteTransfer(const DRV_HANDLE handle, uint16_t address, void* const buffer, const size_t size)
+{
+    return false;
+}
+
+bool DRV_I2C_ReadTransfer(const DRV_HANDLE handle, uint16_t address, void* const buffer, const size_t size)
+{
+    return false;
+}
+
+bool DRV_I2C_WriteReadTransfer(const DRV_HANDLE handle, uint16_t address, void* const writeBuffer, const size_t writeSize,
+                               void* const readBuffer, const size_t readSize)
+{
+    return false;
+}
+
+// *****************************************************************************
+// GPIO, the pins never change
+
+bool GPIO_PinInterruptCallbackRegister(GPIO_PIN pin, const GPIO_PIN_CALLBACK callBack, uintptr_t context)
+{
+    return true;
+}
+
+// *****************************************************************************
+// Random numbers
+
+int CRYPT_RNG_Initialize(CRYPT_RNG_CTX* rng)
+{
+    return rng != NULL ? 0 : -1;
+}
+
+int CRYPT_RNG_BlockGenerate(CRYPT_RNG_CTX* rng, unsigned char* b, unsigned int sz)
+{
+    ssize_t n;
+
+    if(rng == NULL || b == NULL)
+    {
+        return -1;
+    }
+    while(sz != 0)
+    {
+        if((n = getrandom(b, sz, 0)) <= 0)
+        {
+            return -1;
+        }
+        b += n;
+        sz -= n;
+    }
+    return 0;
+}
+
+int CRYPT_RNG_Deinitialize(CRYPT_RNG_CTX* rng)
+{
+    return 0;
+}
+
+// *****************************************************************************
+// C library
+
+size_t strlcat(char *dst, const char *src, size_t size)
+{
+    size_t dstLen = strnlen(dst, size);
+    size_t srcLen = strlen(src);
+
+    if(dstLen == size)
+    {
+        return size + srcLen;
+    }
+    if(srcLen < size - dstLen)
+    {
+        memcpy(dst + dstLen, src, srcLen + 1);
+    }
+    else
+    {
+        memcpy(dst + dstLen, src, size - dstLen - 1);
+        dst[size - 1] = 0;
+    }
+    return dstLen + srcLen;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,78 @@
+/*******************************************************************************
+  Host RTOS Image Tasks
+
+  File Name:
+    tasks_host.c
+
+  Summary:
+    Threads and entry point of the host RTOS image.
+
+  Description:
+    Stands in for tasks.c and main.c. The byte pool of the OSAL and the APP
+    thread are created as on the target. There is no idle thread: on the
+    Linux port a thread that spins without kernel calls keeps the processor.
+
+    The image runs until it is killed, or for the number of seconds given
+    as its argument and then exits with success, so a test can check its
+    output.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include "definitions.h"
+
+#define TX_BYTE_POOL_SIZE       (TX_LINUX_MEMORY_SIZE)
+#define APP_TASK_STACK_SIZE     4096
+
+TX_BYTE_POOL   byte_pool_0;
+
+static TX_THREAD    _APP_Task_TCB;
+static uint8_t*     _APP_Task_Stk_Ptr;
+static TX_TIMER     runTimeTimer;
+static ULONG        runTimeSeconds;
+
+static void _APP_Tasks(ULONG thread_input)
+{
+    while(1)
+    {
+        APP_Tasks();
+        tx_thread_sleep((ULONG)(50 / (TX_TICK_PERIOD_MS)));
+    }
+}
+
+static void _RunTimeExpired(ULONG input)
+{
+    printf("Run time of %u s over\r\n", (unsigned)runTimeSeconds);
+    exit(EXIT_SUCCESS);
+}
+
+void tx_application_define(void* first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_BYTE_POOL_SIZE);
+
+    APP_Initialize();
+
+    tx_byte_allocate(&byte_pool_0, (VOID **)&_APP_Task_Stk_Ptr, APP_TASK_STACK_SIZE, TX_NO_WAIT);
+    tx_thread_create(&_APP_Task_TCB, "_APP_Tasks", _APP_Tasks, 0,
+                     _APP_Task_Stk_Ptr, APP_TASK_STACK_SIZE, 1, 1, TX_NO_TIME_SLICE, TX_AUTO_START);
+
+    if(runTimeSeconds != 0)
+    {
+        tx_timer_create(&runTimeTimer, "run time", _RunTimeExpired, 0,
+                        runTimeSeconds * TX_TIMER_TICKS_PER_SECOND, 0, TX_AUTO_ACTIVATE);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1)
+    {
+        runTimeSeconds = strtoul(argv[1], 0, 10);
+    }
+
+    tx_kernel_enter();
+    return EXIT_FAILURE;
+}
+
+/*******************************************************************************
+ End of File
+ */
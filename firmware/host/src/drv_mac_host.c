@@ -0,0 +1,500 @@
+/*******************************************************************************
+  Host MAC Driver
+
+  File Name:
+    drv_mac_host.c
+
+  Summary:
+    Loopback Harmony MAC driver for the host build.
+
+  Description:
+    See drv_mac_host.h. A single instance, the queues are protected by an
+    OSAL mutex so the stack and a test thread can both call in. The event
+    callback is made outside of the lock.
+*******************************************************************************/
+
+#include <string.h>
+#include "definitions.h"
+#include "drv_mac_host.h"
+
+#define DRV_MAC_HOST_HANDLE             ((DRV_HANDLE)0x4D41)
+#define DRV_MAC_HOST_OBJ                ((SYS_MODULE_OBJ)0x4D41)
+
+typedef struct
+{
+    TCPIP_MAC_PACKET* head;
+    TCPIP_MAC_PACKET* tail;
+} DRV_MAC_HOST_QUEUE;
+
+typedef struct
+{
+    bool initialized;
+    bool open;
+    bool linkUp;
+    TCPIP_MAC_MODULE_CTRL macControl;   // copied, the caller may pass it on its stack
+    TCPIP_MAC_ADDR address;
+    OSAL_MUTEX_DECLARE(lock);
+    DRV_MAC_HOST_QUEUE txQueue;
+    DRV_MAC_HOST_QUEUE rxQueue;
+    TCPIP_MAC_EVENT eventMask;
+    TCPIP_MAC_EVENT eventPending;
+    TCPIP_MAC_RX_STATISTICS rxStat;
+    TCPIP_MAC_TX_STATISTICS txStat;
+} DRV_MAC_HOST_DATA;
+
+static DRV_MAC_HOST_DATA drvMacHost;
+
+static void DRV_MAC_HOST_QueueAdd(DRV_MAC_HOST_QUEUE* pQ, TCPIP_MAC_PACKET* pPkt)
+{
+    pPkt->next = 0;
+    if(pQ->tail == 0)
+    {
+        pQ->head = pPkt;
+    }
+    else
+    {
+        pQ->tail->next = pPkt;
+    }
+    pQ->tail = pPkt;
+}
+
+static TCPIP_MAC_PACKET* DRV_MAC_HOST_QueueRemove(DRV_MAC_HOST_QUEUE* pQ)
+{
+    TCPIP_MAC_PACKET* pPkt = pQ->head;
+
+    if(pPkt != 0)
+    {
+        pQ->head = pPkt->next;
+        if(pQ->head == 0)
+        {
+            pQ->tail = 0;
+        }
+        pPkt->next = 0;
+    }
+    return pPkt;
+}
+
+/* Latches events and reports the enabled ones, called without the lock */
+static void DRV_MAC_HOST_EventSignal(TCPIP_MAC_EVENT events)
+{
+    TCPIP_MAC_EVENT enabled;
+
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    drvMacHost.eventPending |= events;
+    enabled = drvMacHost.eventPending & drvMacHost.eventMask;
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+
+    if(enabled != 0 && drvMacHost.macControl.eventF != 0)
+    {
+        drvMacHost.macControl.eventF(enabled, drvMacHost.macControl.eventParam);
+    }
+}
+
+/* RX packet ackFunc: the stack is done with it */
+static bool DRV_MAC_HOST_RxAck(TCPIP_MAC_PACKET* pPkt, const void* param)
+{
+    drvMacHost.macControl.pktFreeF(pPkt);
+    return false;
+}
+
+/* Copies a TX frame into a new RX packet; 0 if none could be allocated */
+static TCPIP_MAC_PACKET* DRV_MAC_HOST_Loopback(TCPIP_MAC_PACKET* pTxPkt)
+{
+    const TCPIP_MAC_ETHERNET_HEADER* pMacHdr;
+    TCPIP_MAC_DATA_SEGMENT* pSeg;
+    TCPIP_MAC_PACKET* pRxPkt;
+    uint16_t frameLen = 0;
+    uint8_t* pDst;
+
+    for(pSeg = pTxPkt->pDSeg; pSeg != 0; pSeg = pSeg->next)
+    {
+        frameLen += pSeg->segLen;
+    }
+
+    pRxPkt = drvMacHost.macControl.pktAllocF(sizeof(TCPIP_MAC_PACKET), frameLen, 0);
+    if(pRxPkt == 0)
+    {
+        return 0;
+    }
+    if(pRxPkt->pDSeg->segSize < frameLen)
+    {
+        drvMacHost.macControl.pktFreeF(pRxPkt);
+        return 0;
+    }
+
+    pDst = pRxPkt->pDSeg->segLoad;
+    for(pSeg = pTxPkt->pDSeg; pSeg != 0; pSeg = pSeg->next)
+    {
+        memcpy(pDst, pSeg->segLoad, pSeg->segLen);
+        pDst += pSeg->segLen;
+    }
+
+    // the MAC strips the Ethernet header from the segment length
+    pMacHdr = (const TCPIP_MAC_ETHERNET_HEADER*)pRxPkt->pDSeg->segLoad;
+    pRxPkt->pDSeg->segLen = frameLen - sizeof(TCPIP_MAC_ETHERNET_HEADER);
+    pRxPkt->pDSeg->next = 0;
+    pRxPkt->pMacLayer = pRxPkt->pDSeg->segLoad;
+    pRxPkt->pNetLayer = pRxPkt->pMacLayer + sizeof(TCPIP_MAC_ETHERNET_HEADER);
+    pRxPkt->pktFlags &= ~TCPIP_MAC_PKT_FLAG_CAST_MASK;
+    if(memcmp(pMacHdr->DestMACAddr.v, "\xff\xff\xff\xff\xff\xff", sizeof(pMacHdr->DestMACAddr.v)) == 0)
+    {
+        pRxPkt->pktFlags |= TCPIP_MAC_PKT_FLAG_BCAST;
+    }
+    else if((pMacHdr->DestMACAddr.v[0] & 0x01) != 0)
+    {
+        pRxPkt->pktFlags |= TCPIP_MAC_PKT_FLAG_MCAST;
+    }
+    else
+    {
+        pRxPkt->pktFlags |= TCPIP_MAC_PKT_FLAG_UNICAST;
+    }
+    pRxPkt->pktFlags |= TCPIP_MAC_PKT_FLAG_QUEUED;
+    pRxPkt->ackFunc = DRV_MAC_HOST_RxAck;
+    pRxPkt->ackParam = 0;
+
+    return pRxPkt;
+}
+
+// *****************************************************************************
+
+static SYS_MODULE_OBJ DRV_MAC_HOST_Initialize(const SYS_MODULE_INDEX index, const SYS_MODULE_INIT * const init)
+{
+    static const uint8_t defaultAddress[] = DRV_MAC_HOST_ADDRESS;
+    const TCPIP_MAC_INIT* macInit = (const TCPIP_MAC_INIT*)init;
+    static const TCPIP_MAC_ADDR noAddress;
+
+    if(drvMacHost.initialized || macInit == 0 || macInit->macControl == 0)
+    {
+        return SYS_MODULE_OBJ_INVALID;
+    }
+
+    memset(&drvMacHost, 0, sizeof(drvMacHost));
+    if(OSAL_MUTEX_Create(&drvMacHost.lock) != OSAL_RESULT_TRUE)
+    {
+        return SYS_MODULE_OBJ_INVALID;
+    }
+    drvMacHost.macControl = *macInit->macControl;
+    drvMacHost.address = drvMacHost.macControl.ifPhyAddress;
+    if(memcmp(&drvMacHost.address, &noAddress, sizeof(noAddress)) == 0)
+    {
+        memcpy(drvMacHost.address.v, defaultAddress, sizeof(drvMacHost.address.v));
+    }
+    drvMacHost.linkUp = true;
+    drvMacHost.initialized = true;
+
+    return DRV_MAC_HOST_OBJ;
+}
+
+static void DRV_MAC_HOST_Deinitialize(SYS_MODULE_OBJ object)
+{
+    TCPIP_MAC_PACKET* pPkt;
+
+    if(!drvMacHost.initialized)
+    {
+        return;
+    }
+
+    // hand everything back to the stack
+    while((pPkt = DRV_MAC_HOST_QueueRemove(&drvMacHost.txQueue)) != 0)
+    {
+        pPkt->pktFlags &= ~TCPIP_MAC_PKT_FLAG_QUEUED;
+        pPkt->ackRes = TCPIP_MAC_PKT_ACK_NET_DOWN;
+        drvMacHost.macControl.pktAckF(pPkt, TCPIP_MAC_PKT_ACK_NET_DOWN, TCPIP_MODULE_MAC_EXTERNAL);
+    }
+    while((pPkt = DRV_MAC_HOST_QueueRemove(&drvMacHost.rxQueue)) != 0)
+    {
+        drvMacHost.macControl.pktFreeF(pPkt);
+    }
+
+    OSAL_MUTEX_Delete(&drvMacHost.lock);
+    drvMacHost.initialized = false;
+    drvMacHost.open = false;
+}
+
+static void DRV_MAC_HOST_Reinitialize(SYS_MODULE_OBJ object, const SYS_MODULE_INIT * const init)
+{
+}
+
+static SYS_STATUS DRV_MAC_HOST_Status(SYS_MODULE_OBJ object)
+{
+    return drvMacHost.initialized ? SYS_STATUS_READY : SYS_STATUS_UNINITIALIZED;
+}
+
+static void DRV_MAC_HOST_Tasks(SYS_MODULE_OBJ object)
+{
+}
+
+static DRV_HANDLE DRV_MAC_HOST_Open(const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT intent)
+{
+    if(!drvMacHost.initialized || drvMacHost.open)
+    {
+        return DRV_HANDLE_INVALID;
+    }
+    drvMacHost.open = true;
+    return DRV_MAC_HOST_HANDLE;
+}
+
+static void DRV_MAC_HOST_Close(DRV_HANDLE hMac)
+{
+    drvMacHost.open = false;
+}
+
+static bool DRV_MAC_HOST_LinkCheck(DRV_HANDLE hMac)
+{
+    return drvMacHost.linkUp;
+}
+
+static TCPIP_MAC_RES DRV_MAC_HOST_RxFilterHashTableEntrySet(DRV_HANDLE hMac, const TCPIP_MAC_ADDR* DestMACAddr)
+{
+    return TCPIP_MAC_RES_OK;
+}
+
+static bool DRV_MAC_HOST_PowerMode(DRV_HANDLE hMac, TCPIP_MAC_POWER_MODE pwrMode)
+{
+    return true;
+}
+
+static TCPIP_MAC_RES DRV_MAC_HOST_PacketTx(DRV_HANDLE hMac, TCPIP_MAC_PACKET * ptrPacket)
+{
+    if(hMac != DRV_MAC_HOST_HANDLE || !drvMacHost.open)
+    {
+        return TCPIP_MAC_RES_OP_ERR;
+    }
+    if(ptrPacket == 0 || ptrPacket->pDSeg == 0)
+    {
+        return TCPIP_MAC_RES_PACKET_ERR;
+    }
+
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    ptrPacket->pktFlags |= TCPIP_MAC_PKT_FLAG_QUEUED;
+    DRV_MAC_HOST_QueueAdd(&drvMacHost.txQueue, ptrPacket);
+    drvMacHost.txStat.nTxPendBuffers++;
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+
+    DRV_MAC_HOST_EventSignal(TCPIP_MAC_EV_TX_DONE);
+    return TCPIP_MAC_RES_OK;
+}
+
+static TCPIP_MAC_PACKET* DRV_MAC_HOST_PacketRx(DRV_HANDLE hMac, TCPIP_MAC_RES* pRes, TCPIP_MAC_PACKET_RX_STAT* pPktStat)
+{
+    TCPIP_MAC_PACKET* pPkt;
+
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    pPkt = DRV_MAC_HOST_QueueRemove(&drvMacHost.rxQueue);
+    if(pPkt != 0)
+    {
+        drvMacHost.rxStat.nRxPendBuffers--;
+        drvMacHost.rxStat.nRxOkPackets++;
+    }
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+
+    if(pRes != 0)
+    {
+        *pRes = pPkt != 0 ? TCPIP_MAC_RES_OK : TCPIP_MAC_RES_PENDING;
+    }
+    if(pPktStat != 0)
+    {
+        memset(pPktStat, 0, sizeof(*pPktStat));
+    }
+    return pPkt;
+}
+
+/* Loops the queued TX frames back and acknowledges them */
+static TCPIP_MAC_RES DRV_MAC_HOST_Process(DRV_HANDLE hMac)
+{
+    TCPIP_MAC_EVENT events = TCPIP_MAC_EV_NONE;
+    TCPIP_MAC_PKT_ACK_RES ackRes;
+    TCPIP_MAC_PACKET* pTxPkt;
+    TCPIP_MAC_PACKET* pRxPkt;
+
+    while(true)
+    {
+        OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+        pTxPkt = DRV_MAC_HOST_QueueRemove(&drvMacHost.txQueue);
+        if(pTxPkt != 0)
+        {
+            drvMacHost.txStat.nTxPendBuffers--;
+        }
+        OSAL_MUTEX_Unlock(&drvMacHost.lock);
+        if(pTxPkt == 0)
+        {
+            break;
+        }
+
+        pRxPkt = 0;
+        if(!drvMacHost.linkUp)
+        {
+            ackRes = TCPIP_MAC_PKT_ACK_LINK_DOWN;
+        }
+        else
+        {
+            ackRes = TCPIP_MAC_PKT_ACK_TX_OK;
+            if((pRxPkt = DRV_MAC_HOST_Loopback(pTxPkt)) == 0)
+            {
+                events |= TCPIP_MAC_EV_RX_BUFNA;
+            }
+        }
+
+        OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+        if(ackRes == TCPIP_MAC_PKT_ACK_TX_OK)
+        {
+            drvMacHost.txStat.nTxOkPackets++;
+        }
+        else
+        {
+            drvMacHost.txStat.nTxErrorPackets++;
+        }
+        if(pRxPkt != 0)
+        {
+            DRV_MAC_HOST_QueueAdd(&drvMacHost.rxQueue, pRxPkt);
+            drvMacHost.rxStat.nRxPendBuffers++;
+            events |= TCPIP_MAC_EV_RX_PKTPEND | TCPIP_MAC_EV_RX_DONE;
+        }
+        else if(ackRes == TCPIP_MAC_PKT_ACK_TX_OK)
+        {
+            drvMacHost.rxStat.nRxBuffNotAvailable++;
+        }
+        OSAL_MUTEX_Unlock(&drvMacHost.lock);
+
+        pTxPkt->pktFlags &= ~TCPIP_MAC_PKT_FLAG_QUEUED;
+        pTxPkt->ackRes = ackRes;
+        drvMacHost.macControl.pktAckF(pTxPkt, ackRes, TCPIP_MODULE_MAC_EXTERNAL);
+    }
+
+    if(events != TCPIP_MAC_EV_NONE)
+    {
+        DRV_MAC_HOST_EventSignal(events);
+    }
+    return TCPIP_MAC_RES_OK;
+}
+
+static TCPIP_MAC_RES DRV_MAC_HOST_StatisticsGet(DRV_HANDLE hMac, TCPIP_MAC_RX_STATISTICS* pRxStatistics, TCPIP_MAC_TX_STATISTICS* pTxStatistics)
+{
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    if(pRxStatistics != 0)
+    {
+        *pRxStatistics = drvMacHost.rxStat;
+    }
+    if(pTxStatistics != 0)
+    {
+        *pTxStatistics = drvMacHost.txStat;
+    }
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+    return TCPIP_MAC_RES_OK;
+}
+
+static TCPIP_MAC_RES DRV_MAC_HOST_ParametersGet(DRV_HANDLE hMac, TCPIP_MAC_PARAMETERS* pMacParams)
+{
+    if(!drvMacHost.initialized)
+    {
+        return TCPIP_MAC_RES_NOT_READY_ERR;
+    }
+
+    memset(pMacParams, 0, sizeof(*pMacParams));
+    pMacParams->ifPhyAddress = drvMacHost.address;
+    pMacParams->processFlags = TCPIP_MAC_PROCESS_FLAG_RX | TCPIP_MAC_PROCESS_FLAG_TX;
+    pMacParams->macType = TCPIP_MAC_TYPE_WLAN;
+    pMacParams->linkMtu = TCPIP_MAC_LINK_MTU_WLAN;
+    pMacParams->checksumOffloadRx = TCPIP_MAC_CHECKSUM_NONE;
+    pMacParams->checksumOffloadTx = TCPIP_MAC_CHECKSUM_NONE;
+    pMacParams->macTxPrioNum = 1;
+    pMacParams->macRxPrioNum = 1;
+    return TCPIP_MAC_RES_OK;
+}
+
+static TCPIP_MAC_RES DRV_MAC_HOST_RegisterStatisticsGet(DRV_HANDLE hMac, TCPIP_MAC_STATISTICS_REG_ENTRY* pRegEntries, int nEntries, int* pHwEntries)
+{
+    if(pHwEntries != 0)
+    {
+        *pHwEntries = 0;
+    }
+    return TCPIP_MAC_RES_OK;
+}
+
+static size_t DRV_MAC_HOST_ConfigGet(DRV_HANDLE hMac, void* configBuff, size_t buffSize, size_t* pConfigSize)
+{
+    if(pConfigSize != 0)
+    {
+        *pConfigSize = 0;
+    }
+    return 0;
+}
+
+static bool DRV_MAC_HOST_EventMaskSet(DRV_HANDLE hMac, TCPIP_MAC_EVENT macEvents, bool enable)
+{
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    if(enable)
+    {
+        drvMacHost.eventMask |= macEvents;
+    }
+    else
+    {
+        drvMacHost.eventMask &= ~macEvents;
+    }
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+    return true;
+}
+
+static bool DRV_MAC_HOST_EventAcknowledge(DRV_HANDLE hMac, TCPIP_MAC_EVENT macEvents)
+{
+    bool pending;
+
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    pending = (drvMacHost.eventPending & macEvents) != 0;
+    drvMacHost.eventPending &= ~macEvents;
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+    return pending;
+}
+
+static TCPIP_MAC_EVENT DRV_MAC_HOST_EventPendingGet(DRV_HANDLE hMac)
+{
+    TCPIP_MAC_EVENT events;
+
+    OSAL_MUTEX_Lock(&drvMacHost.lock, OSAL_WAIT_FOREVER);
+    events = drvMacHost.eventPending & drvMacHost.eventMask;
+    OSAL_MUTEX_Unlock(&drvMacHost.lock);
+    return events;
+}
+
+void DRV_MAC_HOST_LinkSet(bool up)
+{
+    if(!drvMacHost.initialized || drvMacHost.linkUp == up)
+    {
+        return;
+    }
+    drvMacHost.linkUp = up;
+    DRV_MAC_HOST_EventSignal(up ? TCPIP_MAC_EV_CONN_ESTABLISHED : TCPIP_MAC_EV_CONN_LOST);
+}
+
+// *****************************************************************************
+
+const TCPIP_MAC_OBJECT DRV_MAC_HOST_Object =
+{
+    .macId                                  = TCPIP_MODULE_MAC_EXTERNAL,
+    .macType                                = TCPIP_MAC_TYPE_WLAN,
+    .macName                                = "HOSTLOOP",
+    .TCPIP_MAC_Initialize                   = DRV_MAC_HOST_Initialize,
+    .TCPIP_MAC_Deinitialize                 = DRV_MAC_HOST_Deinitialize,
+    .TCPIP_MAC_Reinitialize                 = DRV_MAC_HOST_Reinitialize,
+    .TCPIP_MAC_Status                       = DRV_MAC_HOST_Status,
+    .TCPIP_MAC_Tasks                        = DRV_MAC_HOST_Tasks,
+    .TCPIP_MAC_Open                         = DRV_MAC_HOST_Open,
+    .TCPIP_MAC_Close                        = DRV_MAC_HOST_Close,
+    .TCPIP_MAC_LinkCheck                    = DRV_MAC_HOST_LinkCheck,
+    .TCPIP_MAC_RxFilterHashTableEntrySet    = DRV_MAC_HOST_RxFilterHashTableEntrySet,
+    .TCPIP_MAC_PowerMode                    = DRV_MAC_HOST_PowerMode,
+    .TCPIP_MAC_PacketTx                     = DRV_MAC_HOST_PacketTx,
+    .TCPIP_MAC_PacketRx                     = DRV_MAC_HOST_PacketRx,
+    .TCPIP_MAC_Process                      = DRV_MAC_HOST_Process,
+    .TCPIP_MAC_StatisticsGet                = DRV_MAC_HOST_StatisticsGet,
+    .TCPIP_MAC_ParametersGet                = DRV_MAC_HOST_ParametersGet,
+    .TCPIP_MAC_RegisterStatisticsGet        = DRV_MAC_HOST_RegisterStatisticsGet,
+    .TCPIP_MAC_ConfigGet                    = DRV_MAC_HOST_ConfigGet,
+    .TCPIP_MAC_EventMaskSet                 = DRV_MAC_HOST_EventMaskSet,
+    .TCPIP_MAC_EventAcknowledge             = DRV_MAC_HOST_EventAcknowledge,
+    .TCPIP_MAC_EventPendingGet              = DRV_MAC_HOST_EventPendingGet,
+};
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,313 @@
+/*******************************************************************************
+  Host Memory Driver
+
+  File Name:
+    drv_memory_host.c
+
+  Summary:
+    RAM backed DRV_MEMORY client interface for the host build.
+
+  Description:
+    See drv_memory_host.h. Only the client calls used by the application
+    modules are implemented. A single instance with DRV_MEMORY_CLIENTS_NUMBER_IDX0
+    clients, each with its own transfer handler, like the target driver.
+*******************************************************************************/
+
+#include <string.h>
+#include "definitions.h"
+#include "drv_memory_host.h"
+
+#define DRV_MEMORY_HOST_TOKEN_SHIFT     8
+
+typedef struct
+{
+    bool inUse;
+    DRV_MEMORY_TRANSFER_HANDLER handler;
+    uintptr_t context;
+} DRV_MEMORY_HOST_CLIENT;
+
+typedef struct
+{
+    uint8_t image[DRV_MEMORY_HOST_MEDIA_SIZE];
+    uint32_t eraseCount[DRV_MEMORY_HOST_SECTORS];
+    uint32_t programCount;
+    uint32_t readCount;
+    uint32_t queueFull;
+    /* Requests until the armed failure, 0 when not armed */
+    uint32_t failCountdown;
+    uint32_t powerCutCountdown;
+    uint32_t powerCutLength;
+    bool powerOff;
+    uint32_t token;
+    SYS_MEDIA_REGION_GEOMETRY geometryTable[3];
+    SYS_MEDIA_GEOMETRY geometry;
+    DRV_MEMORY_HOST_CLIENT clients[DRV_MEMORY_CLIENTS_NUMBER_IDX0];
+} DRV_MEMORY_HOST_DATA;
+
+static DRV_MEMORY_HOST_DATA drvMemoryHost;
+static bool drvMemoryHostReady;
+
+/* The part comes up blank */
+static void DRV_MEMORY_HOST_Ready(void)
+{
+    if (!drvMemoryHostReady)
+    {
+        DRV_MEMORY_HOST_Reset();
+    }
+}
+
+void DRV_MEMORY_HOST_Reset(void)
+{
+    memset(&drvMemoryHost, 0, sizeof(drvMemoryHost));
+    memset(drvMemoryHost.image, 0xFF, sizeof(drvMemoryHost.image));
+
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY].blockSize = 1;
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY].numBlocks = DRV_MEMORY_HOST_MEDIA_SIZE;
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_WRITE_ENTRY].blockSize = DRV_SST26_PAGE_SIZE;
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_WRITE_ENTRY].numBlocks = DRV_MEMORY_HOST_MEDIA_SIZE / DRV_SST26_PAGE_SIZE;
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].blockSize = DRV_SST26_ERASE_BUFFER_SIZE;
+    drvMemoryHost.geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].numBlocks = DRV_MEMORY_HOST_SECTORS;
+    drvMemoryHost.geometry.mediaProperty = (SYS_MEDIA_PROPERTY)(SYS_MEDIA_READ_IS_BLOCKING | SYS_MEDIA_WRITE_IS_BLOCKING);
+    drvMemoryHost.geometry.numReadRegions = 1;
+    drvMemoryHost.geometry.numWriteRegions = 1;
+    drvMemoryHost.geometry.numEraseRegions = 1;
+    drvMemoryHost.geometry.geometryTable = drvMemoryHost.geometryTable;
+
+    drvMemoryHostReady = true;
+}
+
+void DRV_MEMORY_HOST_Reboot(void)
+{
+    DRV_MEMORY_HOST_Ready();
+    memset(drvMemoryHost.clients, 0, sizeof(drvMemoryHost.clients));
+    drvMemoryHost.queueFull = 0;
+    drvMemoryHost.failCountdown = 0;
+    drvMemoryHost.powerCutCountdown = 0;
+    drvMemoryHost.powerOff = false;
+}
+
+void DRV_MEMORY_HOST_QueueFullSet(uint32_t count)
+{
+    DRV_MEMORY_HOST_Ready();
+    drvMemoryHost.queueFull = count;
+}
+
+void DRV_MEMORY_HOST_FailSet(uint32_t count)
+{
+    DRV_MEMORY_HOST_Ready();
+    drvMemoryHost.failCountdown = count + 1;
+}
+
+void DRV_MEMORY_HOST_PowerCutSet(uint32_t count, uint32_t length)
+{
+    DRV_MEMORY_HOST_Ready();
+    drvMemoryHost.powerCutCountdown = count + 1;
+    drvMemoryHost.powerCutLength = length;
+}
+
+
+uint8_t *DRV_MEMORY_HOST_Image(void)
+{
+    DRV_MEMORY_HOST_Ready();
+    return drvMemoryHost.image;
+}
+
+uint32_t DRV_MEMORY_HOST_EraseCount(uint32_t sector)
+{
+    return (sector < DRV_MEMORY_HOST_SECTORS) ? drvMemoryHost.eraseCount[sector] : 0;
+}
+
+uint32_t DRV_MEMORY_HOST_ProgramCount(void)
+{
+    return drvMemoryHost.programCount;
+}
+
+uint32_t DRV_MEMORY_HOST_ReadCount(void)
+{
+    return drvMemoryHost.readCount;
+}
+
+// *****************************************************************************
+
+static DRV_MEMORY_HOST_CLIENT *DRV_MEMORY_HOST_ClientGet(const DRV_HANDLE handle)
+{
+    uint32_t index = handle & DRV_MEMORY_INDEX_MASK;
+
+    if ((handle == DRV_HANDLE_INVALID) || (index >= DRV_MEMORY_CLIENTS_NUMBER_IDX0) ||
+        !drvMemoryHost.clients[index].inUse)
+    {
+        return NULL;
+    }
+    return &drvMemoryHost.clients[index];
+}
+
+/* Counts down an armed failure, true when it fires on this request */
+static bool DRV_MEMORY_HOST_Countdown(uint32_t *countdown)
+{
+    if (*countdown == 0)
+    {
+        return false;
+    }
+    return (--(*countdown) == 0);
+}
+
+static void DRV_MEMORY_HOST_Request(const DRV_HANDLE handle, DRV_MEMORY_COMMAND_HANDLE *commandHandle,
+        DRV_MEMORY_OPERATION_TYPE opType, void *buffer, uint32_t blockStart, uint32_t nBlock)
+{
+    DRV_MEMORY_HOST_CLIENT *client = DRV_MEMORY_HOST_ClientGet(handle);
+    uint32_t entry;
+    uint32_t blockSize;
+    uint32_t address;
+    uint32_t length;
+    uint32_t index;
+    bool success = true;
+
+    *commandHandle = DRV_MEMORY_COMMAND_HANDLE_INVALID;
+    DRV_MEMORY_HOST_Ready();
+
+    switch (opType)
+    {
+        case DRV_MEMORY_OPERATION_TYPE_READ:
+            entry = SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY;
+            break;
+        case DRV_MEMORY_OPERATION_TYPE_WRITE:
+            entry = SYS_MEDIA_GEOMETRY_TABLE_WRITE_ENTRY;
+            break;
+        default:
+            entry = SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY;
+            break;
+    }
+
+    if ((client == NULL) || ((buffer == NULL) && (opType != DRV_MEMORY_OPERATION_TYPE_ERASE)) ||
+        (nBlock == 0) || ((blockStart + nBlock) > drvMemoryHost.geometryTable[entry].numBlocks))
+    {
+        return;
+    }
+    if (drvMemoryHost.queueFull != 0)
+    {
+        drvMemoryHost.queueFull--;
+        return;
+    }
+
+    blockSize = drvMemoryHost.geometryTable[entry].blockSize;
+    address = blockStart * blockSize;
+    length = nBlock * blockSize;
+
+    if (drvMemoryHost.powerOff)
+    {
+        success = false;
+    }
+    else if (opType == DRV_MEMORY_OPERATION_TYPE_READ)
+    {
+        memcpy(buffer, &drvMemoryHost.image[address], length);
+        drvMemoryHost.readCount++;
+    }
+    else if (DRV_MEMORY_HOST_Countdown(&drvMemoryHost.failCountdown))
+    {
+        success = false;
+    }
+    else if (opType == DRV_MEMORY_OPERATION_TYPE_WRITE)
+    {
+        if (DRV_MEMORY_HOST_Countdown(&drvMemoryHost.powerCutCountdown))
+        {
+            length = (drvMemoryHost.powerCutLength < length) ? drvMemoryHost.powerCutLength : length;
+            drvMemoryHost.powerOff = true;
+            success = false;
+        }
+        /* NOR program, bits only go from 1 to 0 */
+        for (index = 0; index < length; index++)
+        {
+            drvMemoryHost.image[address + index] &= ((const uint8_t *)buffer)[index];
+        }
+        drvMemoryHost.programCount += nBlock;
+    }
+    else
+    {
+        memset(&drvMemoryHost.image[address], 0xFF, length);
+        for (index = 0; index < nBlock; index++)
+        {
+            drvMemoryHost.eraseCount[blockStart + index]++;
+        }
+    }
+
+    drvMemoryHost.token = (drvMemoryHost.token + 1) & 0xFFFF;
+    *commandHandle = (DRV_MEMORY_COMMAND_HANDLE)(drvMemoryHost.token << DRV_MEMORY_HOST_TOKEN_SHIFT) + 1;
+    if (client->handler != NULL)
+    {
+        client->handler(success ? DRV_MEMORY_EVENT_COMMAND_COMPLETE : DRV_MEMORY_EVENT_COMMAND_ERROR,
+                *commandHandle, client->context);
+    }
+}
+
+// *****************************************************************************
+
+DRV_HANDLE DRV_MEMORY_Open(const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT ioIntent)
+{
+    uint32_t index;
+
+    if (drvIndex != DRV_MEMORY_INDEX_0)
+    {
+        return DRV_HANDLE_INVALID;
+    }
+
+    DRV_MEMORY_HOST_Ready();
+    for (index = 0; index < DRV_MEMORY_CLIENTS_NUMBER_IDX0; index++)
+    {
+        if (!drvMemoryHost.clients[index].inUse)
+        {
+            drvMemoryHost.clients[index].inUse = true;
+            drvMemoryHost.clients[index].handler = NULL;
+            drvMemoryHost.clients[index].context = 0;
+            return (DRV_HANDLE)index;
+        }
+    }
+    return DRV_HANDLE_INVALID;
+}
+
+void DRV_MEMORY_Close(const DRV_HANDLE handle)
+{
+    DRV_MEMORY_HOST_CLIENT *client = DRV_MEMORY_HOST_ClientGet(handle);
+
+    if (client != NULL)
+    {
+        client->inUse = false;
+    }
+}
+
+void DRV_MEMORY_TransferHandlerSet(const DRV_HANDLE handle, const void *transferHandler, const uintptr_t context)
+{
+    DRV_MEMORY_HOST_CLIENT *client = DRV_MEMORY_HOST_ClientGet(handle);
+
+    if (client != NULL)
+    {
+        client->handler = (DRV_MEMORY_TRANSFER_HANDLER)transferHandler;
+        client->context = context;
+    }
+}
+
+SYS_MEDIA_GEOMETRY *DRV_MEMORY_GeometryGet(const DRV_HANDLE handle)
+{
+    return (DRV_MEMORY_HOST_ClientGet(handle) != NULL) ? &drvMemoryHost.geometry : NULL;
+}
+
+void DRV_MEMORY_AsyncRead(const DRV_HANDLE handle, DRV_MEMORY_COMMAND_HANDLE *commandHandle,
+        void *targetBuffer, uint32_t blockStart, uint32_t nBlock)
+{
+    DRV_MEMORY_HOST_Request(handle, commandHandle, DRV_MEMORY_OPERATION_TYPE_READ, targetBuffer, blockStart, nBlock);
+}
+
+void DRV_MEMORY_AsyncWrite(const DRV_HANDLE handle, DRV_MEMORY_COMMAND_HANDLE *commandHandle,
+        void *sourceBuffer, uint32_t blockStart, uint32_t nBlock)
+{
+    DRV_MEMORY_HOST_Request(handle, commandHandle, DRV_MEMORY_OPERATION_TYPE_WRITE, sourceBuffer, blockStart, nBlock);
+}
+
+void DRV_MEMORY_AsyncErase(const DRV_HANDLE handle, DRV_MEMORY_COMMAND_HANDLE *commandHandle,
+        uint32_t blockStart, uint32_t nBlock)
+{
+    DRV_MEMORY_HOST_Request(handle, commandHandle, DRV_MEMORY_OPERATION_TYPE_ERASE, NULL, blockStart, nBlock);
+}
+
+/*******************************************************************************
+ End of File
+ */
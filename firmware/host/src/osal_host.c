@@ -0,0 +1,200 @@
+/*******************************************************************************
+  Host OSAL
+
+  File Name:
+    osal_host.c
+
+  Summary:
+    OSAL and RTOS services of the host (Linux) unit test build.
+
+  Description:
+    OSAL semaphores and mutexes on POSIX threads, plus the ThreadX calls the
+    application modules make directly.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <time.h>
+#include "definitions.h"
+
+static pthread_mutex_t osalCritLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* Absolute CLOCK_REALTIME deadline waitMS from now */
+static void OSAL_HOST_Deadline(struct timespec *deadline, uint16_t waitMS)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += waitMS / 1000;
+    deadline->tv_nsec += (long)(waitMS % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// *****************************************************************************
+
+OSAL_RESULT OSAL_SEM_Create(OSAL_SEM_HANDLE_TYPE* semID, OSAL_SEM_TYPE type, uint8_t maxCount, uint8_t initialCount)
+{
+    if ((pthread_mutex_init(&semID->mutex, NULL) != 0) || (pthread_cond_init(&semID->cond, NULL) != 0))
+    {
+        return OSAL_RESULT_FALSE;
+    }
+    semID->maxCount = (type == OSAL_SEM_TYPE_BINARY) ? 1 : maxCount;
+    semID->count = (initialCount > semID->maxCount) ? semID->maxCount : initialCount;
+    return OSAL_RESULT_TRUE;
+}
+
+OSAL_RESULT OSAL_SEM_Delete(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    pthread_cond_destroy(&semID->cond);
+    pthread_mutex_destroy(&semID->mutex);
+    return OSAL_RESULT_TRUE;
+}
+
+OSAL_RESULT OSAL_SEM_Pend(OSAL_SEM_HANDLE_TYPE* semID, uint16_t waitMS)
+{
+    struct timespec deadline;
+    OSAL_RESULT result = OSAL_RESULT_TRUE;
+
+    if ((waitMS != OSAL_WAIT_FOREVER) && (waitMS != 0))
+    {
+        OSAL_HOST_Deadline(&deadline, waitMS);
+    }
+
+    pthread_mutex_lock(&semID->mutex);
+    while ((semID->count == 0) && (result == OSAL_RESULT_TRUE))
+    {
+        if (waitMS == OSAL_WAIT_FOREVER)
+        {
+            pthread_cond_wait(&semID->cond, &semID->mutex);
+        }
+        else if ((waitMS == 0) || (pthread_cond_timedwait(&semID->cond, &semID->mutex, &deadline) == ETIMEDOUT))
+        {
+            result = OSAL_RESULT_FALSE;
+        }
+    }
+    if (result == OSAL_RESULT_TRUE)
+    {
+        semID->count--;
+    }
+    pthread_mutex_unlock(&semID->mutex);
+
+    return result;
+}
+
+OSAL_RESULT OSAL_SEM_Post(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    OSAL_RESULT result = OSAL_RESULT_FALSE;
+
+    pthread_mutex_lock(&semID->mutex);
+    if (semID->count < semID->maxCount)
+    {
+        semID->count++;
+        pthread_cond_signal(&semID->cond);
+        result = OSAL_RESULT_TRUE;
+    }
+    pthread_mutex_unlock(&semID->mutex);
+
+    return result;
+}
+
+OSAL_RESULT OSAL_SEM_PostISR(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    return OSAL_SEM_Post(semID);
+}
+
+uint8_t OSAL_SEM_GetCount(OSAL_SEM_HANDLE_TYPE* semID)
+{
+    uint8_t count;
+
+    pthread_mutex_lock(&semID->mutex);
+    count = semID->count;
+    pthread_mutex_unlock(&semID->mutex);
+
+    return count;
+}
+
+// *****************************************************************************
+
+OSAL_CRITSECT_DATA_TYPE OSAL_CRIT_Enter(OSAL_CRIT_TYPE severity)
+{
+    pthread_mutex_lock(&osalCritLock);
+    return 0;
+}
+
+void OSAL_CRIT_Leave(OSAL_CRIT_TYPE severity, OSAL_CRITSECT_DATA_TYPE status)
+{
+    pthread_mutex_unlock(&osalCritLock);
+}
+
+// *****************************************************************************
+
+OSAL_RESULT OSAL_MUTEX_Create(OSAL_MUTEX_HANDLE_TYPE* mutexID)
+{
+    return (pthread_mutex_init(mutexID, NULL) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+}
+
+OSAL_RESULT OSAL_MUTEX_Delete(OSAL_MUTEX_HANDLE_TYPE* mutexID)
+{
+    return (pthread_mutex_destroy(mutexID) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+}
+
+OSAL_RESULT OSAL_MUTEX_Lock(OSAL_MUTEX_HANDLE_TYPE* mutexID, uint16_t waitMS)
+{
+    struct timespec deadline;
+
+    if (waitMS == OSAL_WAIT_FOREVER)
+    {
+        return (pthread_mutex_lock(mutexID) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+    }
+    if (waitMS == 0)
+    {
+        return (pthread_mutex_trylock(mutexID) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+    }
+    OSAL_HOST_Deadline(&deadline, waitMS);
+    return (pthread_mutex_timedlock(mutexID, &deadline) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+}
+
+OSAL_RESULT OSAL_MUTEX_Unlock(OSAL_MUTEX_HANDLE_TYPE* mutexID)
+{
+    return (pthread_mutex_unlock(mutexID) == 0) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE;
+}
+
+// *****************************************************************************
+
+void* OSAL_Malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void OSAL_Free(void* pData)
+{
+    free(pData);
+}
+
+OSAL_RESULT OSAL_Initialize(void)
+{
+    return OSAL_RESULT_TRUE;
+}
+
+const char* OSAL_Name(void)
+{
+    return "POSIX";
+}
+
+// *****************************************************************************
+
+unsigned int tx_thread_sleep(unsigned long timer_ticks)
+{
+    struct timespec delay;
+
+    delay.tv_sec = timer_ticks / 1000;
+    delay.tv_nsec = (long)(timer_ticks % 1000) * 1000000L;
+    nanosleep(&delay, NULL);
+    return 0;
+}
+
+/*******************************************************************************
+ End of File
+ */
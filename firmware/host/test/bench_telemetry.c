@@ -0,0 +1,447 @@
+/*******************************************************************************
+  Host Benchmark
+
+  File Name:
+    bench_telemetry.c
+
+  Summary:
+    Telemetry serialization: snprintf and copy against writing in place.
+
+  Description:
+    Serializes the readings of one telemetry interval both ways the sample
+    has done it and reports, per interval, the bytes copied besides the
+    payload itself, the time and cycles taken and the stack used:
+
+    - copy: a model of the code the telemetry builder replaced, which is no
+      longer in the tree: each click reading is snprintf'd into a stack
+      buffer, its members are merged into the batch buffer and the batch is
+      appended to the packet;
+    - in place: the telemetry builder itself, sample_telemetry_builder_* of
+      sample_telemetry.c, writing JSON into a NetX packet laid out as
+      nx_azure_iot_hub_client_telemetry_message_create leaves it. There is
+      no hub connection to publish it, so the payload is closed as
+      sample_telemetry_builder_send does before it publishes.
+
+    Both payloads are parsed back and compared. The figures are host
+    figures: the ratio carries over to the target, the absolute numbers
+    do not.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "definitions.h"
+#include "nx_api.h"
+#include "nx_azure_iot.h"
+#include "sample_telemetry.h"
+#include "app_format.h"
+#include "cJSON.h"
+#include "host_test.h"
+#include "host_stack.h"
+
+/* As the sample: telemetry packet payload, snprintf buffer, batch */
+#define BENCH_PACKET_SIZE           (1536)
+#define BENCH_TOPIC_SIZE            (96)
+#define BENCH_MSGLEN_MAX            (90)
+#define BENCH_BATCH_PAYLOAD_MAX     (256)
+
+#define BENCH_ITERATIONS            (20000)
+#define BENCH_THREAD_STACK_SIZE     (16384)
+#define BENCH_POOL_PACKETS          (4)
+
+typedef struct
+{
+    const char *name;
+    float value;
+    uint8_t digits;
+} BENCH_READING;
+
+/* One interval of a WFI32-IoT with the Altitude 2, PHT and Temp&Hum 14 clicks */
+static const BENCH_READING benchReadings[] =
+{
+    { "WFI32IoT_temperature", 24.8125f, 2 },
+    { "WFI32IoT_light", 412.0f, 0 },
+    { "ALT2_temperature", 25.31f, 2 },
+    { "ALT2_pressure", 1009.87f, 2 },
+    { "ALT2_altitude", 29.64f, 2 },
+    { "PHT_temperature", 25.07f, 2 },
+    { "PHT_pressure", 1009.91f, 2 },
+    { "PHT_humidity", 41.28f, 2 },
+    { "TEMPHUM14_temperature", 24.96f, 2 },
+    { "TEMPHUM14_humidity", 40.73f, 2 },
+};
+#define BENCH_READINGS  (sizeof(benchReadings) / sizeof(benchReadings[0]))
+
+/* Readings per snprintf, as the clicks were formatted */
+static const uint8_t benchGroups[] = { 2, 3, 3, 2 };
+
+typedef struct
+{
+    uint8_t data[BENCH_PACKET_SIZE];
+    uint32_t length;                /* Topic, packet id and payload */
+} BENCH_PACKET;
+
+typedef struct
+{
+    BENCH_PACKET packets[2];        /* A batch overflow sends a second message */
+    uint32_t messages;
+    uint32_t copied;                /* Bytes moved besides writing the payload once */
+    uint8_t extract;                /* In place: copy the payload out to check it */
+} BENCH_RESULT;
+
+static BENCH_PACKET *bench_packet_create(BENCH_RESULT *result)
+{
+    BENCH_PACKET *packet = &result->packets[result->messages++];
+
+    /* The topic and packet id are written by message create and send, the
+       same both ways */
+    memset(packet->data, 'T', BENCH_TOPIC_SIZE + 2);
+    packet->length = BENCH_TOPIC_SIZE + 2;
+    return packet;
+}
+
+/* nx_packet_data_append */
+static void bench_packet_append(BENCH_RESULT *result, const void *data, uint32_t length)
+{
+    BENCH_PACKET *packet = &result->packets[result->messages - 1];
+
+    memcpy(&packet->data[packet->length], data, length);
+    packet->length += length;
+    result->copied += length;
+}
+
+// *****************************************************************************
+// Copy: snprintf, batch, append
+
+typedef struct
+{
+    char buffer[BENCH_BATCH_PAYLOAD_MAX + 1];
+    uint32_t length;
+} BENCH_BATCH;
+
+static void bench_copy_flush(BENCH_RESULT *result, BENCH_BATCH *batch)
+{
+    if (batch->length == 0)
+    {
+        return;
+    }
+    batch->buffer[batch->length++] = '}';
+    bench_packet_create(result);
+    bench_packet_append(result, batch->buffer, batch->length);
+    batch->length = 0;
+}
+
+static void bench_copy_add(BENCH_RESULT *result, BENCH_BATCH *batch, const char *message, uint32_t length)
+{
+    uint32_t members = length - 2;
+
+    if (batch->length + ((batch->length == 0) ? 1 : 2) + members + 1 > BENCH_BATCH_PAYLOAD_MAX)
+    {
+        bench_copy_flush(result, batch);
+    }
+    if (batch->length == 0)
+    {
+        batch->buffer[batch->length++] = '{';
+    }
+    else
+    {
+        batch->buffer[batch->length++] = ',';
+        batch->buffer[batch->length++] = ' ';
+    }
+    memcpy(&batch->buffer[batch->length], &message[1], members);
+    batch->length += members;
+    result->copied += members;
+}
+
+static void __attribute__((noinline)) bench_copy(BENCH_RESULT *result)
+{
+    BENCH_BATCH batch = { .length = 0 };
+    char buffer[BENCH_MSGLEN_MAX];
+    uint32_t length;
+    uint32_t reading = 0;
+    uint32_t group;
+    uint32_t index;
+
+    result->messages = 0;
+    result->copied = 0;
+    for (group = 0; group < sizeof(benchGroups); group++)
+    {
+        length = 0;
+        buffer[length++] = '{';
+        for (index = 0; index < benchGroups[group]; index++, reading++)
+        {
+            if (benchReadings[reading].digits == 0)
+            {
+                length += snprintf(&buffer[length], sizeof(buffer) - length, "%s\"%s\": %u",
+                        index ? ", " : "", benchReadings[reading].name, (unsigned)benchReadings[reading].value);
+            }
+            else
+            {
+                length += snprintf(&buffer[length], sizeof(buffer) - length, "%s\"%s\": %.*f",
+                        index ? ", " : "", benchReadings[reading].name, benchReadings[reading].digits,
+                        benchReadings[reading].value);
+            }
+        }
+        buffer[length++] = '}';
+        bench_copy_add(result, &batch, buffer, length);
+    }
+    bench_copy_flush(result, &batch);
+
+    /* The payload itself had to be written once, what is left was copying */
+    for (index = 0; index < result->messages; index++)
+    {
+        result->copied -= result->packets[index].length - (BENCH_TOPIC_SIZE + 2);
+    }
+}
+
+// *****************************************************************************
+// In place: the telemetry builder into a NetX packet
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD benchThread;
+static NX_PACKET_POOL benchPool;
+static NX_AZURE_IOT_HUB_CLIENT benchHubClient;
+static ULONG benchThreadStack[BENCH_THREAD_STACK_SIZE / sizeof(ULONG)];
+static ULONG benchPoolArea[(BENCH_PACKET_SIZE + sizeof(NX_PACKET)) * BENCH_POOL_PACKETS / sizeof(ULONG)];
+static UCHAR benchTopic[BENCH_TOPIC_SIZE];
+static uint32_t benchInPlaceCopied;
+
+/* The packet as message create leaves it, holding the topic, and the
+   builder around it. QoS 0: the packet id comes from the hub connection */
+static UINT bench_message_open(SAMPLE_TELEMETRY_BUILDER *builder)
+{
+    NX_PACKET *packet;
+    UINT status;
+
+    memset(builder, 0, sizeof(*builder));
+    if ((status = nx_packet_allocate(&benchPool, &packet, NX_TCP_PACKET, NX_NO_WAIT)))
+    {
+        return status;
+    }
+    packet->nx_packet_prepend_ptr += NX_AZURE_IOT_PUBLISH_PACKET_START_OFFSET;
+    packet->nx_packet_append_ptr = packet->nx_packet_prepend_ptr;
+    if ((status = nx_packet_data_append(packet, benchTopic, sizeof(benchTopic), &benchPool, NX_NO_WAIT)))
+    {
+        nx_packet_release(packet);
+        return status;
+    }
+
+    builder->hub_client_ptr = &benchHubClient;
+    builder->packet_ptr = packet;
+    builder->wait_option = NX_NO_WAIT;
+    builder->qos = NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS;
+    return sample_telemetry_builder_qos_set(builder, NX_AZURE_IOT_MQTT_QOS_0);
+}
+
+static void __attribute__((noinline)) bench_in_place(BENCH_RESULT *result)
+{
+    SAMPLE_TELEMETRY_BUILDER builder;
+    BENCH_PACKET *packet;
+    ULONG length = 0;
+    UINT status;
+    uint32_t index;
+
+    result->messages = 0;
+    result->copied = benchInPlaceCopied;
+    packet = bench_packet_create(result);
+
+    status = bench_message_open(&builder);
+    for (index = 0; index < BENCH_READINGS; index++)
+    {
+        if (benchReadings[index].digits == 0)
+        {
+            sample_telemetry_builder_append_int32(&builder, benchReadings[index].name,
+                                                  (int32_t)benchReadings[index].value);
+        }
+        else
+        {
+            sample_telemetry_builder_append_double(&builder, benchReadings[index].name,
+                                                   benchReadings[index].value, benchReadings[index].digits);
+        }
+    }
+    if (status == NX_SUCCESS)
+    {
+        status = builder.status;
+    }
+    if (status == NX_SUCCESS)
+    {
+        status = nx_azure_iot_json_writer_append_end_object(&builder.json_writer);
+    }
+    HOST_TEST_CHECK(status == NX_SUCCESS);
+
+    /* Its length, the payload itself stays in the packet */
+    packet->length += builder.packet_ptr->nx_packet_length - builder.topic_length;
+    if (result->extract)
+    {
+        nx_packet_data_extract_offset(builder.packet_ptr, builder.topic_length, &packet->data[BENCH_TOPIC_SIZE + 2],
+                                      BENCH_PACKET_SIZE - (BENCH_TOPIC_SIZE + 2), &length);
+    }
+    sample_telemetry_builder_delete(&builder);
+}
+
+/* The builder stages the text of a fixed-point value and copies it into the
+   packet, the one copy it makes */
+static uint32_t bench_in_place_copied(void)
+{
+    char text[APP_FORMAT_FIXED_SIZE];
+    uint32_t copied = 0;
+    uint32_t index;
+
+    for (index = 0; index < BENCH_READINGS; index++)
+    {
+        if (benchReadings[index].digits != 0)
+        {
+            copied += APP_FORMAT_fixed(text, sizeof(text), benchReadings[index].value, benchReadings[index].digits);
+        }
+    }
+    return copied;
+}
+
+// *****************************************************************************
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+typedef void (*BENCH_FUNCTION)(BENCH_RESULT *result);
+
+static BENCH_FUNCTION benchStackFunction;
+
+static void bench_stack_entry(void *result)
+{
+    if (benchStackFunction != NULL)
+    {
+        benchStackFunction((BENCH_RESULT *)result);
+    }
+}
+
+/* Deepest stack use of one interval, net of what an empty call uses */
+static uint32_t bench_stack_used(BENCH_FUNCTION function, BENCH_RESULT *result)
+{
+    benchStackFunction = function;
+    return HOST_STACK_used(bench_stack_entry, result);
+}
+
+static void bench_run(const char *label, BENCH_FUNCTION function, uint32_t idleStack, BENCH_RESULT *result)
+{
+    uint64_t start;
+    uint64_t cycles;
+    uint64_t elapsed;
+    uint32_t payload = 0;
+    uint32_t stack;
+    uint32_t index;
+
+    /* Once first, so that the lazy binding of the library calls does not
+       count as stack */
+    function(result);
+    stack = bench_stack_used(function, result) - idleStack;
+
+    start = bench_now_ns();
+    cycles = bench_cycles();
+    for (index = 0; index < BENCH_ITERATIONS; index++)
+    {
+        function(result);
+    }
+    cycles = bench_cycles() - cycles;
+    elapsed = bench_now_ns() - start;
+
+    for (index = 0; index < result->messages; index++)
+    {
+        payload += result->packets[index].length - (BENCH_TOPIC_SIZE + 2);
+    }
+    printf("%-9s %u message(s), %4u payload bytes, %4u bytes copied, %6.0f ns, %7.0f cycles, %5u stack bytes\n",
+            label, result->messages, payload, result->copied, (double)elapsed / BENCH_ITERATIONS,
+            (double)cycles / BENCH_ITERATIONS, stack);
+}
+
+/* Every reading is in the payload with its value */
+static void bench_check(const BENCH_RESULT *result)
+{
+    char payload[BENCH_PACKET_SIZE + 1];
+    uint32_t found = 0;
+    uint32_t length;
+    uint32_t message;
+    uint32_t index;
+    cJSON *object;
+    cJSON *item;
+
+    for (message = 0; message < result->messages; message++)
+    {
+        length = result->packets[message].length - (BENCH_TOPIC_SIZE + 2);
+        memcpy(payload, &result->packets[message].data[BENCH_TOPIC_SIZE + 2], length);
+        payload[length] = 0;
+        object = cJSON_Parse(payload);
+        HOST_TEST_CHECK(object != NULL);
+        for (index = 0; index < BENCH_READINGS; index++)
+        {
+            if ((item = cJSON_GetObjectItem(object, benchReadings[index].name)) != NULL)
+            {
+                HOST_TEST_CHECK(fabs(item->valuedouble - benchReadings[index].value) <= 0.005001);
+                found++;
+            }
+        }
+        cJSON_Delete(object);
+    }
+    HOST_TEST_CHECK(found == BENCH_READINGS);
+}
+
+static void bench_entry(ULONG input)
+{
+    static BENCH_RESULT copy;
+    static BENCH_RESULT inPlace;
+    uint32_t idleStack = bench_stack_used(NULL, NULL);
+
+    memset(benchTopic, 'T', sizeof(benchTopic));
+    benchInPlaceCopied = bench_in_place_copied();
+
+    printf("%u readings per interval, %u iterations\n", (unsigned)BENCH_READINGS, BENCH_ITERATIONS);
+    bench_run("copy", bench_copy, idleStack, &copy);
+    bench_run("in place", bench_in_place, idleStack, &inPlace);
+    inPlace.extract = 1;
+    bench_in_place(&inPlace);
+    bench_check(&copy);
+    bench_check(&inPlace);
+    HOST_TEST_CHECK(inPlace.copied < copy.copied);
+    HOST_TEST_CHECK(benchPool.nx_packet_pool_available == benchPool.nx_packet_pool_total);
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&benchPool, "bench pool", BENCH_PACKET_SIZE, benchPoolArea, sizeof(benchPoolArea));
+    tx_thread_create(&benchThread, "bench", bench_entry, 0, benchThreadStack, sizeof(benchThreadStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
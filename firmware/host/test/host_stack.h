@@ -0,0 +1,72 @@
+/*******************************************************************************
+  Host Test Stack Measure Header
+
+  File Name:
+    host_stack.h
+
+  Summary:
+    Deepest stack use of a call, for the host tests and benchmarks.
+
+  Description:
+    The call runs in the calling thread on a stack of its own, filled with a
+    pattern beforehand; the bytes no longer holding the pattern afterwards
+    are the deepest use. Staying in the calling thread keeps ThreadX calls
+    valid: the kernel still sees its own thread running. What switching to
+    the stack and back uses itself is HOST_STACK_used(NULL, NULL).
+
+    The figures are those of the host build, 64-bit pointers and the x86-64
+    calling convention, not those of the target.
+*******************************************************************************/
+
+#ifndef _HOST_STACK_H
+#define _HOST_STACK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <ucontext.h>
+
+#define HOST_STACK_SIZE         (64 * 1024)
+#define HOST_STACK_FILL         (0xEF)
+
+typedef void (*HOST_STACK_FUNCTION)(void *argument);
+
+static uint8_t hostStack[HOST_STACK_SIZE] __attribute__((aligned(4096)));
+static ucontext_t hostStackCaller;
+static ucontext_t hostStackCallee;
+static HOST_STACK_FUNCTION hostStackFunction;
+static void *hostStackArgument;
+
+static void host_stack_entry(void)
+{
+    if (hostStackFunction != NULL)
+    {
+        hostStackFunction(hostStackArgument);
+    }
+}
+
+static inline uint32_t HOST_STACK_used(HOST_STACK_FUNCTION function, void *argument)
+{
+    uint32_t untouched;
+
+    memset(hostStack, HOST_STACK_FILL, sizeof(hostStack));
+    hostStackFunction = function;
+    hostStackArgument = argument;
+
+    getcontext(&hostStackCallee);
+    hostStackCallee.uc_stack.ss_sp = hostStack;
+    hostStackCallee.uc_stack.ss_size = sizeof(hostStack);
+    hostStackCallee.uc_link = &hostStackCaller;
+    makecontext(&hostStackCallee, host_stack_entry, 0);
+    swapcontext(&hostStackCaller, &hostStackCallee);
+
+    for (untouched = 0; (untouched < sizeof(hostStack)) && (hostStack[untouched] == HOST_STACK_FILL); untouched++)
+    {
+    }
+    return sizeof(hostStack) - untouched;
+}
+
+#endif /* _HOST_STACK_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,40 @@
+/*******************************************************************************
+  Host Unit Test Header
+
+  File Name:
+    host_test.h
+
+  Summary:
+    Minimal checks for the host unit tests.
+
+  Description:
+    A failed check prints its location and is counted, the test carries on.
+    HOST_TEST_RESULT is the exit status of the test, non zero when any
+    check failed, which is what ctest looks at.
+*******************************************************************************/
+
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures;
+
+#define HOST_TEST_CHECK(condition)                                              \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+                    #condition);                                                \
+            hostTestFailures++;                                                 \
+        }                                                                       \
+    } while (0)
+
+#define HOST_TEST_RESULT()      (hostTestFailures == 0 ? 0 : 1)
+
+#endif /* _HOST_TEST_H */
+
+/*******************************************************************************
+ End of File
+ */
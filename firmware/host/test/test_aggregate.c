@@ -0,0 +1,224 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_aggregate.c
+
+  Summary:
+    Fixed-point window aggregation against a double precision reference.
+
+  Description:
+    Without an argument, runs the edge cases: the sample limit, windows at
+    the ends of the Q19.12 range and a large offset with a small spread.
+    With the path of a trace (one value per line, # comments), replays it
+    through windows of the lengths the pressure clicks use and compares
+    each summary with a two pass computation in double.
+*******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include "app_aggregate.h"
+#include "host_test.h"
+
+#define TEST_AGGREGATE_ONE          (1 << APP_AGGREGATE_FRAC_BITS)
+#define TEST_AGGREGATE_TRACE_MAX    (65536)
+#define TEST_AGGREGATE_DELTA        ((double)APP_AGGREGATE_DELTA_MAX / TEST_AGGREGATE_ONE)
+
+static double testAggregateTrace[TEST_AGGREGATE_TRACE_MAX];
+
+/* The sample as the window holds it */
+static double test_aggregate_fixed(double value)
+{
+    double limit = (double)(INT32_MAX >> APP_AGGREGATE_FRAC_BITS);
+
+    value = (value > limit) ? limit : ((value < -limit) ? -limit : value);
+    return round(value * TEST_AGGREGATE_ONE) / TEST_AGGREGATE_ONE;
+}
+
+/* Compares the window over values with the two pass mean and variance of
+   the samples as held, clamped to APP_AGGREGATE_DELTA_MAX of the first */
+static void test_aggregate_check(const double *values, uint32_t count)
+{
+    APP_AGGREGATE_WINDOW window;
+    APP_AGGREGATE_SUMMARY summary;
+    double min = INFINITY;
+    double max = -INFINITY;
+    double mean = 0.0;
+    double variance = 0.0;
+    double offset;
+    double sample;
+    uint32_t index;
+
+    APP_AGGREGATE_reset(&window);
+    for (index = 0; index < count; index++)
+    {
+        APP_AGGREGATE_add(&window, (float)values[index]);
+    }
+    count = (count < APP_AGGREGATE_SAMPLES_MAX) ? count : APP_AGGREGATE_SAMPLES_MAX;
+
+    offset = test_aggregate_fixed((float)values[0]);
+    for (index = 0; index < count; index++)
+    {
+        sample = test_aggregate_fixed((float)values[index]);
+        min = fmin(min, sample);
+        max = fmax(max, sample);
+        sample = fmin(fmax(sample - offset, -TEST_AGGREGATE_DELTA), TEST_AGGREGATE_DELTA);
+        mean += sample;
+    }
+    mean /= count;
+    for (index = 0; index < count; index++)
+    {
+        sample = test_aggregate_fixed((float)values[index]) - offset;
+        sample = fmin(fmax(sample, -TEST_AGGREGATE_DELTA), TEST_AGGREGATE_DELTA);
+        variance += (sample - mean) * (sample - mean);
+    }
+    variance /= count;
+    mean += offset;
+
+    HOST_TEST_CHECK(APP_AGGREGATE_summary(&window, &summary));
+    HOST_TEST_CHECK(summary.count == count);
+    HOST_TEST_CHECK(summary.min == (float)min);
+    HOST_TEST_CHECK(summary.max == (float)max);
+    /* float rounding of the result, the arithmetic before it is exact */
+    HOST_TEST_CHECK(fabs(summary.mean - mean) <= 2e-7 * fabs(mean) + 1e-6);
+    HOST_TEST_CHECK(fabs(summary.variance - variance) <= 1e-6 * variance + 1e-6);
+    HOST_TEST_CHECK(summary.variance >= 0.0f);
+}
+
+/* Against the float values before quantization: the window is as good as
+   Q19.12 allows */
+static void test_aggregate_accuracy(const double *values, uint32_t count)
+{
+    APP_AGGREGATE_WINDOW window;
+    APP_AGGREGATE_SUMMARY summary;
+    double mean = 0.0;
+    double variance = 0.0;
+    uint32_t index;
+
+    APP_AGGREGATE_reset(&window);
+    for (index = 0; index < count; index++)
+    {
+        APP_AGGREGATE_add(&window, (float)values[index]);
+        mean += (float)values[index];
+    }
+    mean /= count;
+    for (index = 0; index < count; index++)
+    {
+        variance += ((float)values[index] - mean) * ((float)values[index] - mean);
+    }
+    variance /= count;
+
+    HOST_TEST_CHECK(APP_AGGREGATE_summary(&window, &summary));
+    HOST_TEST_CHECK(fabs(summary.mean - mean) <= 1.0 / TEST_AGGREGATE_ONE + 2e-7 * fabs(mean));
+    HOST_TEST_CHECK(fabs(sqrt(summary.variance) - sqrt(variance)) <= 1.0 / TEST_AGGREGATE_ONE + 1e-6 * sqrt(variance));
+}
+
+static void test_aggregate_edges(void)
+{
+    static double values[APP_AGGREGATE_SAMPLES_MAX + 10];
+    APP_AGGREGATE_WINDOW window;
+    APP_AGGREGATE_SUMMARY summary;
+    uint32_t index;
+
+    APP_AGGREGATE_reset(&window);
+    HOST_TEST_CHECK(!APP_AGGREGATE_summary(&window, &summary));
+
+    values[0] = -3.5;
+    test_aggregate_check(values, 1);
+
+    /* The full sample count swinging across the whole range: the deltas
+       are clamped, nothing overflows */
+    for (index = 0; index < APP_AGGREGATE_SAMPLES_MAX + 10; index++)
+    {
+        values[index] = (index & 1) ? -600000.0 : 600000.0;
+    }
+    test_aggregate_check(values, APP_AGGREGATE_SAMPLES_MAX + 10);
+    APP_AGGREGATE_reset(&window);
+    for (index = 0; index < APP_AGGREGATE_SAMPLES_MAX + 10; index++)
+    {
+        APP_AGGREGATE_add(&window, (float)values[index]);
+    }
+    HOST_TEST_CHECK(APP_AGGREGATE_summary(&window, &summary));
+    HOST_TEST_CHECK(summary.count == APP_AGGREGATE_SAMPLES_MAX);
+    HOST_TEST_CHECK(summary.min == -(float)(INT32_MAX >> APP_AGGREGATE_FRAC_BITS));
+    HOST_TEST_CHECK(summary.max == (float)(INT32_MAX >> APP_AGGREGATE_FRAC_BITS));
+    HOST_TEST_CHECK(isfinite(summary.variance) && summary.variance > 1e6f);
+
+    /* Within the bound, the whole sample count at the largest spread */
+    for (index = 0; index < APP_AGGREGATE_SAMPLES_MAX; index++)
+    {
+        values[index] = (index & 1) ? -2048.0 : 0.0;
+    }
+    test_aggregate_check(values, APP_AGGREGATE_SAMPLES_MAX);
+    test_aggregate_accuracy(values, APP_AGGREGATE_SAMPLES_MAX);
+
+    /* A large offset does not cost resolution */
+    for (index = 0; index < 1000; index++)
+    {
+        values[index] = 100000.0 + ((int)(index % 7) - 3) / 64.0;
+    }
+    test_aggregate_check(values, 1000);
+    test_aggregate_accuracy(values, 1000);
+}
+
+static uint32_t test_aggregate_load(const char *path)
+{
+    char line[64];
+    uint32_t count = 0;
+    FILE *trace = fopen(path, "r");
+
+    if (trace == NULL)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 0;
+    }
+    while ((count < TEST_AGGREGATE_TRACE_MAX) && (fgets(line, sizeof(line), trace) != NULL))
+    {
+        if ((line[0] != '#') && (line[0] != '\n'))
+        {
+            testAggregateTrace[count++] = strtod(line, NULL);
+        }
+    }
+    fclose(trace);
+    return count;
+}
+
+/* Windows of 1 s at 10 Hz up to the whole trace at 50 Hz */
+static void test_aggregate_trace(const char *path)
+{
+    static const uint32_t windows[] = { 10, 50, 100, 500, 1500 };
+    uint32_t count = test_aggregate_load(path);
+    uint32_t length;
+    uint32_t start;
+    uint32_t index;
+
+    HOST_TEST_CHECK(count > 0);
+    for (index = 0; index < sizeof(windows) / sizeof(windows[0]); index++)
+    {
+        length = windows[index];
+        for (start = 0; start + length <= count; start += length)
+        {
+            test_aggregate_check(&testAggregateTrace[start], length);
+            test_aggregate_accuracy(&testAggregateTrace[start], length);
+        }
+    }
+    if (count > 0)
+    {
+        test_aggregate_check(testAggregateTrace, count);
+        test_aggregate_accuracy(testAggregateTrace, count);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        test_aggregate_trace(argv[1]);
+    }
+    else
+    {
+        test_aggregate_edges();
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,123 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_cjson.c
+
+  Summary:
+    Cloud configuration file parsing.
+
+  Description:
+    Parses cloud.json the way the application does, rejects malformed and
+    incomplete files, and reads back the default file the application writes
+    when there is none.
+*******************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "cJSON.h"
+#include "host_test.h"
+
+/* Tags of app.h, which does not build on the host */
+#define AZURE_CLOUD_IDSCOPE_JSON_TAG        "ID_SCOPE"
+#define AZURE_CLOUD_DEVICEID_JSON_TAG       "REGISTRATION_ID"
+#define AZURE_CLOUD_PRIMARY_KEY_JSON_TAG    "PRIMARY_KEY"
+
+#define TEST_CJSON_VALUE_MAX    (128)
+
+typedef struct
+{
+    char idScope[TEST_CJSON_VALUE_MAX];
+    char registrationId[TEST_CJSON_VALUE_MAX];
+    char primaryKey[TEST_CJSON_VALUE_MAX];
+} TEST_CJSON_CONFIG;
+
+static bool test_cjson_string(cJSON *object, const char *tag, char *value)
+{
+    cJSON *item = cJSON_GetObjectItem(object, tag);
+
+    if (!item || item->type != cJSON_String || strlen(item->valuestring) >= TEST_CJSON_VALUE_MAX)
+    {
+        return false;
+    }
+    strcpy(value, item->valuestring);
+    return true;
+}
+
+/* As APP_CheckCloudConfig */
+static bool test_cjson_parse(const char *text, TEST_CJSON_CONFIG *config)
+{
+    cJSON *messageJson = cJSON_Parse(text);
+    bool parsed;
+
+    if (messageJson == NULL)
+    {
+        return false;
+    }
+    parsed = test_cjson_string(messageJson, AZURE_CLOUD_IDSCOPE_JSON_TAG, config->idScope) &&
+            test_cjson_string(messageJson, AZURE_CLOUD_DEVICEID_JSON_TAG, config->registrationId) &&
+            test_cjson_string(messageJson, AZURE_CLOUD_PRIMARY_KEY_JSON_TAG, config->primaryKey);
+    cJSON_Delete(messageJson);
+    return parsed;
+}
+
+static void test_cjson_config(void)
+{
+    TEST_CJSON_CONFIG config;
+
+    HOST_TEST_CHECK(test_cjson_parse(
+            "{\r\n\t\"ID_SCOPE\":\t\"0ne00000000\",\r\n"
+            "\t\"REGISTRATION_ID\":\t\"sn0123456789abcdef\",\r\n"
+            "\t\"PRIMARY_KEY\":\t\"c2VjcmV0IGtleSBmb3IgdGVzdGluZw==\"\r\n}", &config));
+    HOST_TEST_CHECK(strcmp(config.idScope, "0ne00000000") == 0);
+    HOST_TEST_CHECK(strcmp(config.registrationId, "sn0123456789abcdef") == 0);
+    HOST_TEST_CHECK(strcmp(config.primaryKey, "c2VjcmV0IGtleSBmb3IgdGVzdGluZw==") == 0);
+
+    /* Order and extra members do not matter, escapes are decoded */
+    HOST_TEST_CHECK(test_cjson_parse(
+            "{\"PRIMARY_KEY\":\"k\",\"extra\":[1,2,{\"a\":null}],"
+            "\"REGISTRATION_ID\":\"sn\\u0030\\/1\",\"ID_SCOPE\":\"s\"}", &config));
+    HOST_TEST_CHECK(strcmp(config.registrationId, "sn0/1") == 0);
+
+    /* Malformed or incomplete files are refused */
+    HOST_TEST_CHECK(!test_cjson_parse("", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{\"ID_SCOPE\":\"s\",}", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{\"ID_SCOPE\":\"s\",\"REGISTRATION_ID\":\"r\"", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{\"ID_SCOPE\":\"s\",\"REGISTRATION_ID\":\"r\"}", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{\"ID_SCOPE\":1,\"REGISTRATION_ID\":\"r\",\"PRIMARY_KEY\":\"k\"}", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("[\"ID_SCOPE\",\"REGISTRATION_ID\",\"PRIMARY_KEY\"]", &config));
+    HOST_TEST_CHECK(!test_cjson_parse("{\"ID_SCOPE\":\"s\\ud800\",\"REGISTRATION_ID\":\"r\",\"PRIMARY_KEY\":\"k\"}", &config));
+}
+
+/* The default file written by the application reads back */
+static void test_cjson_default(void)
+{
+    TEST_CJSON_CONFIG config;
+    cJSON *jsonObj = cJSON_CreateObject();
+    char *printBuffer;
+
+    cJSON_AddItemToObject(jsonObj, AZURE_CLOUD_IDSCOPE_JSON_TAG, cJSON_CreateString("0ne00000000"));
+    cJSON_AddItemToObject(jsonObj, AZURE_CLOUD_DEVICEID_JSON_TAG, cJSON_CreateString("dev\"ice\\1"));
+    cJSON_AddItemToObject(jsonObj, AZURE_CLOUD_PRIMARY_KEY_JSON_TAG, cJSON_CreateString("key"));
+    printBuffer = cJSON_Print(jsonObj);
+    cJSON_Delete(jsonObj);
+
+    HOST_TEST_CHECK(printBuffer != NULL);
+    if (printBuffer != NULL)
+    {
+        HOST_TEST_CHECK(test_cjson_parse(printBuffer, &config));
+        HOST_TEST_CHECK(strcmp(config.idScope, "0ne00000000") == 0);
+        HOST_TEST_CHECK(strcmp(config.registrationId, "dev\"ice\\1") == 0);
+        HOST_TEST_CHECK(strcmp(config.primaryKey, "key") == 0);
+        free(printBuffer);
+    }
+}
+
+int main(void)
+{
+    test_cjson_config();
+    test_cjson_default();
+    return HOST_TEST_RESULT();
+}
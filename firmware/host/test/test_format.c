@@ -0,0 +1,120 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_format.c
+
+  Summary:
+    APP_FORMAT_fixed against the C library printf.
+
+  Description:
+    APP_FORMAT_fixed must print the same text as printf("%.*f") for every
+    value it accepts. Checked on edge values and on a large pseudo random
+    sweep of bit patterns, for all supported fractional digit counts.
+*******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "app_format.h"
+#include "host_test.h"
+
+#define TEST_FORMAT_SWEEP       2000000
+
+/* Formats like printf would, 0 when APP_FORMAT_fixed refused the value */
+static size_t test_format_compare(float value, uint8_t digits)
+{
+    char expected[64];
+    char text[APP_FORMAT_FIXED_SIZE];
+    size_t length;
+
+    length = APP_FORMAT_fixed(text, sizeof(text), value, digits);
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    snprintf(expected, sizeof(expected), "%.*f", digits, value);
+    if ((strcmp(text, expected) != 0) || (length != strlen(expected)))
+    {
+        fprintf(stderr, "%a %u: \"%s\" expected \"%s\"\n", value, digits, text, expected);
+        hostTestFailures++;
+    }
+    return length;
+}
+
+static void test_format_edges(void)
+{
+    static const float values[] =
+    {
+        0.0f, -0.0f, 0.5f, 1.5f, 2.5f, -2.5f, 0.125f, 0.375f, 1.0e-7f, 1.0e-45f,
+        0.05f, 0.15f, 0.25f, 0.35f, 9.9999995f, 99.995f, 1013.25f, -40.0f,
+        16777216.0f, 123456.789f, 4294967296.0f, 1.0e12f,
+    };
+    char text[APP_FORMAT_FIXED_SIZE];
+    uint8_t digits;
+    size_t index;
+
+    for (index = 0; index < sizeof(values) / sizeof(values[0]); index++)
+    {
+        for (digits = 0; digits <= APP_FORMAT_DIGITS_MAX; digits++)
+        {
+            HOST_TEST_CHECK(test_format_compare(values[index], digits) != 0);
+        }
+    }
+
+    /* Refused: not a number, out of the 64 bit range, too many digits */
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, sizeof(text), NAN, 2) == 0);
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, sizeof(text), INFINITY, 2) == 0);
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, sizeof(text), -INFINITY, 2) == 0);
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, sizeof(text), 3.0e38f, 2) == 0);
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, sizeof(text), 1.0f, APP_FORMAT_DIGITS_MAX + 1) == 0);
+
+    /* The buffer has to hold the terminator too */
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, 5, 12.25f, 2) == 0);
+    HOST_TEST_CHECK(APP_FORMAT_fixed(text, 6, 12.25f, 2) == 5);
+    HOST_TEST_CHECK(strcmp(text, "12.25") == 0);
+}
+
+/* Every value below 2^43 has to be accepted, the 24 bit mantissa can then
+   be shifted left by at most 19 bits */
+static void test_format_sweep(void)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits;
+    uint32_t state = 0x12345678;
+    uint32_t index;
+    uint32_t refused = 0;
+    uint8_t digits;
+
+    for (index = 0; index < TEST_FORMAT_SWEEP; index++)
+    {
+        /* xorshift32 */
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        bits.u = state;
+        if (!isfinite(bits.f))
+        {
+            continue;
+        }
+
+        digits = (uint8_t)(index % (APP_FORMAT_DIGITS_MAX + 1));
+        if (test_format_compare(bits.f, digits) == 0)
+        {
+            HOST_TEST_CHECK(fabsf(bits.f) >= ldexpf(1.0f, 43));
+            refused++;
+        }
+    }
+    printf("%u values formatted, %u out of range\n", TEST_FORMAT_SWEEP - refused, refused);
+}
+
+int main(void)
+{
+    test_format_edges();
+    test_format_sweep();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,167 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_identity.c
+
+  Summary:
+    DPS assignment cache on the RAM backed SST26.
+
+  Description:
+    Stores, loads and invalidates the cached assignment, and checks that an
+    entry cached for another ID scope or registration ID, or torn by a power
+    cut, is not used, nor any entry while the FAT volume overlaps it.
+*******************************************************************************/
+
+#include <string.h>
+#include "app_identity.h"
+#include "drv_memory_host.h"
+#include "host_test.h"
+
+#define TEST_IDENTITY_SECTOR    ((DRV_MEMORY_HOST_MEDIA_SIZE / DRV_SST26_ERASE_BUFFER_SIZE) - 1)
+
+static const char testIdScope[] = "0ne00000000";
+static const char testRegistrationId[] = "sn0123456789abcdef";
+static const char testHostname[] = "hub-test.azure-devices.net";
+static const char testDeviceId[] = "sn0123456789abcdef";
+
+static uint32_t test_identity_key(const char *idScope, const char *registrationId)
+{
+    return APP_IDENTITY_key((const uint8_t *)idScope, strlen(idScope),
+            (const uint8_t *)registrationId, strlen(registrationId));
+}
+
+/* Loads the entry for key, checking it against the test assignment */
+static bool test_identity_load(uint32_t key)
+{
+    uint8_t hostname[APP_IDENTITY_HOSTNAME_MAX];
+    uint8_t deviceId[APP_IDENTITY_DEVICE_ID_MAX];
+    uint32_t hostnameLength = sizeof(hostname);
+    uint32_t deviceIdLength = sizeof(deviceId);
+
+    if (!APP_IDENTITY_load(key, hostname, &hostnameLength, deviceId, &deviceIdLength))
+    {
+        return false;
+    }
+    HOST_TEST_CHECK(hostnameLength == strlen(testHostname));
+    HOST_TEST_CHECK(memcmp(hostname, testHostname, hostnameLength) == 0);
+    HOST_TEST_CHECK(deviceIdLength == strlen(testDeviceId));
+    HOST_TEST_CHECK(memcmp(deviceId, testDeviceId, deviceIdLength) == 0);
+    return true;
+}
+
+static bool test_identity_store(uint32_t key)
+{
+    return APP_IDENTITY_store(key, (const uint8_t *)testHostname, strlen(testHostname),
+            (const uint8_t *)testDeviceId, strlen(testDeviceId));
+}
+
+static void test_identity_cache(void)
+{
+    uint32_t key = test_identity_key(testIdScope, testRegistrationId);
+    uint8_t longName[APP_IDENTITY_HOSTNAME_MAX + 1];
+    uint8_t hostname[4];
+    uint8_t deviceId[APP_IDENTITY_DEVICE_ID_MAX];
+    uint32_t hostnameLength = sizeof(hostname);
+    uint32_t deviceIdLength = sizeof(deviceId);
+
+    DRV_MEMORY_HOST_Reset();
+    HOST_TEST_CHECK(!test_identity_load(key));
+
+    HOST_TEST_CHECK(test_identity_store(key));
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_IDENTITY_SECTOR) == 1);
+    DRV_MEMORY_HOST_Reboot();
+    HOST_TEST_CHECK(test_identity_load(key));
+
+    /* The same assignment again costs no erase */
+    HOST_TEST_CHECK(test_identity_store(key));
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_IDENTITY_SECTOR) == 1);
+
+    /* Another ID scope or registration ID does not use the entry */
+    HOST_TEST_CHECK(test_identity_key(testIdScope, "sn0123456789abcdee") != key);
+    HOST_TEST_CHECK(test_identity_key("0ne00000001", testRegistrationId) != key);
+    HOST_TEST_CHECK(!test_identity_load(test_identity_key(testIdScope, "sn0123456789abcdee")));
+    HOST_TEST_CHECK(!test_identity_load(test_identity_key("0ne00000001", testRegistrationId)));
+
+    /* Buffers too small for the entry */
+    HOST_TEST_CHECK(!APP_IDENTITY_load(key, hostname, &hostnameLength, deviceId, &deviceIdLength));
+
+    memset(longName, 'a', sizeof(longName));
+    HOST_TEST_CHECK(!APP_IDENTITY_store(key, longName, sizeof(longName),
+            (const uint8_t *)testDeviceId, strlen(testDeviceId)));
+    HOST_TEST_CHECK(test_identity_load(key));
+
+    /* A rejection by the hub drops the entry without an erase */
+    HOST_TEST_CHECK(APP_IDENTITY_invalidate());
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_IDENTITY_SECTOR) == 1);
+    HOST_TEST_CHECK(!test_identity_load(key));
+    HOST_TEST_CHECK(APP_IDENTITY_invalidate());
+
+    HOST_TEST_CHECK(test_identity_store(key));
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_IDENTITY_SECTOR) == 2);
+    HOST_TEST_CHECK(test_identity_load(key));
+}
+
+static void test_identity_faults(void)
+{
+    uint32_t key = test_identity_key(testIdScope, testRegistrationId);
+
+    /* Power lost after the erase, half way through the entry */
+    DRV_MEMORY_HOST_Reset();
+    DRV_MEMORY_HOST_PowerCutSet(0, 64);
+    HOST_TEST_CHECK(!test_identity_store(key));
+    DRV_MEMORY_HOST_Reboot();
+    HOST_TEST_CHECK(!test_identity_load(key));
+
+    /* A failed program is reported and nothing is cached */
+    DRV_MEMORY_HOST_FailSet(1);
+    HOST_TEST_CHECK(!test_identity_store(key));
+    HOST_TEST_CHECK(!test_identity_load(key));
+
+    /* A full driver queue is retried */
+    DRV_MEMORY_HOST_QueueFullSet(3);
+    HOST_TEST_CHECK(test_identity_store(key));
+    HOST_TEST_CHECK(test_identity_load(key));
+}
+
+/* A FAT volume of 512 byte sectors at sector 0, as SYS_FS_FORMAT_SFD lays it out */
+static void test_identity_volume(uint32_t sectors)
+{
+    uint8_t *boot = DRV_MEMORY_HOST_Image();
+
+    boot[0] = 0xEB;
+    boot[11] = 0x00;
+    boot[12] = 0x02;
+    memset(&boot[19], 0, 2);
+    memcpy(&boot[32], &sectors, 4);
+    boot[510] = 0x55;
+    boot[511] = 0xAA;
+}
+
+static void test_identity_overlap(void)
+{
+    uint32_t key = test_identity_key(testIdScope, testRegistrationId);
+
+    /* The volume ends at the reserved area */
+    DRV_MEMORY_HOST_Reset();
+    test_identity_volume((DRV_MEMORY_HOST_MEDIA_SIZE - DRV_MEMORY_FS_RESERVED_SIZE) / 512);
+    HOST_TEST_CHECK(APP_IDENTITY_reservedFree());
+    HOST_TEST_CHECK(test_identity_store(key));
+    HOST_TEST_CHECK(test_identity_load(key));
+
+    /* Formatted over the whole part, the sector may be a FAT cluster */
+    test_identity_volume(DRV_MEMORY_HOST_MEDIA_SIZE / 512);
+    HOST_TEST_CHECK(!APP_IDENTITY_reservedFree());
+    HOST_TEST_CHECK(!test_identity_load(key));
+    HOST_TEST_CHECK(!test_identity_store(test_identity_key(testIdScope, "sn0123456789abcdee")));
+    HOST_TEST_CHECK(!APP_IDENTITY_invalidate());
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_IDENTITY_SECTOR) == 1);
+}
+
+int main(void)
+{
+    test_identity_cache();
+    test_identity_faults();
+    test_identity_overlap();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,286 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_ip_checksum.c
+
+  Summary:
+    _nx_ip_checksum_compute against a byte-wise RFC 1071 reference.
+
+  Description:
+    The word-wise sum of NetX Duo must give the one's complement sum the
+    reference gives on the same bytes, read two by two in network order.
+    Checked on a pseudo random sweep of lengths, odd tails included, of
+    start offsets and of packet chains split where NetX splits them, for
+    ICMP and for UDP, TCP and ICMPv6 with their pseudo headers. Buffers of
+    0xFF bytes, which carry on every add, are checked up to the largest
+    datagram. The time both take on a TCP segment is printed.
+
+    NetX keeps prepend_ptr 4 byte aligned and only the last packet of a
+    chain may end on an odd byte; the sweep stays within those rules.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "nx_api.h"
+#include "nx_ip.h"
+#include "host_test.h"
+
+#define TEST_CHECKSUM_SWEEP     200000
+#define TEST_CHECKSUM_LENGTH    3000
+#define TEST_CHECKSUM_CHUNKS    4
+#define TEST_CHECKSUM_LARGEST   65535
+#define TEST_CHECKSUM_SEGMENT   1460
+#define TEST_CHECKSUM_RUNS      200000
+
+/* Room for the start offset and for the byte written past an odd tail */
+#define TEST_CHECKSUM_BUFFER    (TEST_CHECKSUM_LARGEST + 32)
+
+static ULONG buffers[TEST_CHECKSUM_CHUNKS][TEST_CHECKSUM_BUFFER / sizeof(ULONG)];
+static NX_PACKET packets[TEST_CHECKSUM_CHUNKS];
+static UCHAR data[TEST_CHECKSUM_BUFFER];
+static uint32_t randomState = 0x12345678;
+
+static uint32_t test_random(void)
+{
+    /* xorshift32 */
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/* RFC 1071: 16 bit big endian words, an odd byte padded with zero */
+static uint32_t reference_sum(const UCHAR *bytes, UINT length)
+{
+    uint32_t sum = 0;
+    UINT i;
+
+    for (i = 0; i + 1 < length; i += 2)
+    {
+        sum += ((uint32_t)bytes[i] << 8) | bytes[i + 1];
+    }
+    if (length & 1)
+    {
+        sum += (uint32_t)bytes[length - 1] << 8;
+    }
+    return sum;
+}
+
+static uint32_t reference_address_sum(const ULONG *address, UINT words)
+{
+    uint32_t sum = 0;
+    UINT i;
+
+    for (i = 0; i < words; i++)
+    {
+        sum += (address[i] >> 16) + (address[i] & 0xFFFF);
+    }
+    return sum;
+}
+
+static USHORT reference_checksum(ULONG protocol, UINT version, const UCHAR *bytes, UINT length,
+                                 const ULONG *source, const ULONG *destination)
+{
+    uint64_t sum = reference_sum(bytes, length);
+    UINT words = (version == NX_IP_VERSION_V6) ? 4 : 1;
+
+    if ((protocol == NX_PROTOCOL_UDP) || (protocol == NX_PROTOCOL_TCP) || (protocol == NX_PROTOCOL_ICMPV6))
+    {
+        sum += protocol + length;
+        sum += reference_address_sum(source, words) + reference_address_sum(destination, words);
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (USHORT)sum;
+}
+
+/* Lays the bytes out over a chain of packets, each starting at its offset */
+static NX_PACKET *chain_build(const UCHAR *bytes, const UINT *lengths, const UINT *offsets, UINT count,
+                              UINT version)
+{
+    UINT i;
+
+    for (i = 0; i < count; i++)
+    {
+        memset(&packets[i], 0, sizeof(packets[i]));
+        packets[i].nx_packet_prepend_ptr = (UCHAR *)buffers[i] + offsets[i];
+        packets[i].nx_packet_append_ptr = packets[i].nx_packet_prepend_ptr + lengths[i];
+        packets[i].nx_packet_next = (i + 1 < count) ? &packets[i + 1] : NX_NULL;
+        memcpy(packets[i].nx_packet_prepend_ptr, bytes, lengths[i]);
+        bytes += lengths[i];
+    }
+#ifdef FEATURE_NX_IPV6
+    packets[0].nx_packet_ip_version = (UCHAR)version;
+#else
+    (void)version;
+#endif
+    return &packets[0];
+}
+
+static int checksum_compare(ULONG protocol, UINT version, const UINT *lengths, const UINT *offsets, UINT count)
+{
+    ULONG source[4];
+    ULONG destination[4];
+    NX_PACKET *packet;
+    UINT length = 0;
+    USHORT expected;
+    USHORT checksum;
+    UINT i;
+
+    for (i = 0; i < 4; i++)
+    {
+        source[i] = test_random();
+        destination[i] = test_random();
+    }
+    for (i = 0; i < count; i++)
+    {
+        length += lengths[i];
+    }
+
+    packet = chain_build(data, lengths, offsets, count, version);
+    expected = reference_checksum(protocol, version, data, length, source, destination);
+    checksum = _nx_ip_checksum_compute(packet, protocol, length, source, destination);
+    if (checksum != expected)
+    {
+        fprintf(stderr, "protocol %lu version %u length %u in %u packets, offset %u: %04x expected %04x\n",
+                (unsigned long)protocol, version, length, count, offsets[0], checksum, expected);
+        return 0;
+    }
+    return 1;
+}
+
+static void test_sweep(void)
+{
+    static const ULONG protocols[] = { NX_PROTOCOL_ICMP, NX_PROTOCOL_UDP, NX_PROTOCOL_TCP, NX_PROTOCOL_ICMPV6 };
+    UINT lengths[TEST_CHECKSUM_CHUNKS];
+    UINT offsets[TEST_CHECKSUM_CHUNKS];
+    UINT length;
+    UINT count;
+    UINT version;
+    ULONG protocol;
+    UINT run;
+    UINT i;
+    int failures = 0;
+
+    for (run = 0; run < TEST_CHECKSUM_SWEEP; run++)
+    {
+        length = test_random() % (TEST_CHECKSUM_LENGTH + 1);
+        for (i = 0; i < length; i++)
+        {
+            data[i] = (UCHAR)test_random();
+        }
+
+        /* Packets but the last hold a multiple of 2 bytes */
+        count = 1 + test_random() % TEST_CHECKSUM_CHUNKS;
+        for (i = 0; i < count; i++)
+        {
+            offsets[i] = 4 * (test_random() % 4);
+            lengths[i] = (i + 1 < count) ? 2 * (test_random() % (length / (2 * count) + 2)) : 0;
+            if (lengths[i] > length)
+            {
+                lengths[i] = length & ~1u;
+            }
+            length -= lengths[i];
+        }
+        lengths[count - 1] = length;
+
+        protocol = protocols[run % (sizeof(protocols) / sizeof(protocols[0]))];
+        version = (protocol == NX_PROTOCOL_ICMPV6) ? NX_IP_VERSION_V6 : NX_IP_VERSION_V4;
+#ifndef FEATURE_NX_IPV6
+        if (protocol == NX_PROTOCOL_ICMPV6)
+        {
+            continue;
+        }
+#endif
+        if (!checksum_compare(protocol, version, lengths, offsets, count) && (++failures > 10))
+        {
+            break;
+        }
+    }
+    HOST_TEST_CHECK(failures == 0);
+}
+
+static void test_carries(void)
+{
+    UINT lengths[2];
+    UINT offsets[2] = { 0, 4 };
+    UINT length;
+
+    memset(data, 0xFF, sizeof(data));
+    for (length = 0; length <= TEST_CHECKSUM_LARGEST; length += (length < 64) ? 1 : 4093)
+    {
+        lengths[0] = length;
+        HOST_TEST_CHECK(checksum_compare(NX_PROTOCOL_ICMP, NX_IP_VERSION_V4, lengths, offsets, 1));
+        HOST_TEST_CHECK(checksum_compare(NX_PROTOCOL_UDP, NX_IP_VERSION_V4, lengths, offsets, 1));
+
+        lengths[0] = (length / 2) & ~1u;
+        lengths[1] = length - lengths[0];
+        HOST_TEST_CHECK(checksum_compare(NX_PROTOCOL_TCP, NX_IP_VERSION_V4, lengths, offsets, 2));
+    }
+    lengths[0] = TEST_CHECKSUM_LARGEST;
+    HOST_TEST_CHECK(checksum_compare(NX_PROTOCOL_UDP, NX_IP_VERSION_V4, lengths, offsets, 1));
+}
+
+static void test_speed(void)
+{
+    ULONG source = IP_ADDRESS(10, 0, 0, 2);
+    ULONG destination = IP_ADDRESS(10, 0, 0, 1);
+    UINT length = TEST_CHECKSUM_SEGMENT;
+    UINT offset = 0;
+    NX_PACKET *packet;
+    volatile USHORT sink = 0;
+    uint64_t start;
+    uint64_t netxNs;
+    uint64_t referenceNs;
+    UINT run;
+    UINT i;
+
+    for (i = 0; i < length; i++)
+    {
+        data[i] = (UCHAR)test_random();
+    }
+    packet = chain_build(data, &length, &offset, 1, NX_IP_VERSION_V4);
+
+    start = test_now_ns();
+    for (run = 0; run < TEST_CHECKSUM_RUNS; run++)
+    {
+        sink += _nx_ip_checksum_compute(packet, NX_PROTOCOL_TCP, length, &source, &destination);
+    }
+    netxNs = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (run = 0; run < TEST_CHECKSUM_RUNS; run++)
+    {
+        sink += reference_checksum(NX_PROTOCOL_TCP, NX_IP_VERSION_V4, packet -> nx_packet_prepend_ptr, length,
+                                   &source, &destination);
+    }
+    referenceNs = test_now_ns() - start;
+    (void)sink;
+
+    printf("ip checksum: %u byte segment, netx %llu ns, byte-wise reference %llu ns\n", length,
+           (unsigned long long)(netxNs / TEST_CHECKSUM_RUNS), (unsigned long long)(referenceNs / TEST_CHECKSUM_RUNS));
+}
+
+int main(void)
+{
+    test_sweep();
+    test_carries();
+    test_speed();
+    return HOST_TEST_RESULT();
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,288 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_journal.c
+
+  Summary:
+    Telemetry journal on the RAM backed SST26.
+
+  Description:
+    Appends, reads back and consumes records across sectors, across resets,
+    when the journal overflows and when the power is cut in the middle of a
+    program, and checks that the journal stays out of the DPS cache sector
+    and the FAT volume, and off when a volume reaches into its sectors.
+*******************************************************************************/
+
+#include <string.h>
+#include "app_journal.h"
+#include "app_identity.h"
+#include "drv_memory_host.h"
+#include "host_test.h"
+
+#define TEST_JOURNAL_SECTORS        ((DRV_MEMORY_FS_RESERVED_SIZE - APP_IDENTITY_AREA_SIZE) / DRV_SST26_ERASE_BUFFER_SIZE)
+#define TEST_JOURNAL_SECTOR_RECORDS ((DRV_SST26_ERASE_BUFFER_SIZE / sizeof(APP_JOURNAL_RECORD)) - 1)
+#define TEST_JOURNAL_CAPACITY       (TEST_JOURNAL_SECTORS * TEST_JOURNAL_SECTOR_RECORDS)
+#define TEST_JOURNAL_BASE_SECTOR    ((DRV_MEMORY_HOST_MEDIA_SIZE - DRV_MEMORY_FS_RESERVED_SIZE) / DRV_SST26_ERASE_BUFFER_SIZE)
+#define TEST_JOURNAL_BATCH          (32)
+
+/* The reading number n is recognizable from all of its fields */
+static void test_journal_append(uint32_t n)
+{
+    HOST_TEST_CHECK(APP_JOURNAL_append((uint8_t)(n % 7), (uint8_t)(n / 3), 1700000000 + n, (float)n * 0.5f));
+}
+
+static void test_journal_reboot(void)
+{
+    DRV_MEMORY_HOST_Reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+}
+
+/* Reads count pending records back without consuming them, expecting the
+   readings first..first+count-1 */
+static void test_journal_expect(uint32_t first, uint32_t count)
+{
+    APP_JOURNAL_RECORD records[TEST_JOURNAL_BATCH];
+    uint32_t got;
+    uint32_t index;
+    uint32_t n;
+
+    got = APP_JOURNAL_peek(records, (count < TEST_JOURNAL_BATCH) ? count : TEST_JOURNAL_BATCH);
+    HOST_TEST_CHECK(got == ((count < TEST_JOURNAL_BATCH) ? count : TEST_JOURNAL_BATCH));
+    for (index = 0; index < got; index++)
+    {
+        n = first + index;
+        HOST_TEST_CHECK(records[index].field == (uint8_t)(n % 7));
+        HOST_TEST_CHECK(records[index].group == (uint8_t)(n / 3));
+        HOST_TEST_CHECK(records[index].timestamp == 1700000000 + n);
+        HOST_TEST_CHECK(records[index].value == (float)n * 0.5f);
+    }
+}
+
+/* Consumes count records in batches, checking each batch */
+static void test_journal_drain(uint32_t first, uint32_t count)
+{
+    uint32_t batch;
+
+    while (count > 0)
+    {
+        batch = (count < TEST_JOURNAL_BATCH) ? count : TEST_JOURNAL_BATCH;
+        test_journal_expect(first, batch);
+        HOST_TEST_CHECK(APP_JOURNAL_consume(batch));
+        first += batch;
+        count -= batch;
+    }
+}
+
+static void test_journal_order(void)
+{
+    uint32_t n;
+
+    DRV_MEMORY_HOST_Reset();
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 0);
+
+    /* Across three sectors */
+    for (n = 0; n < 600; n++)
+    {
+        test_journal_append(n);
+    }
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 600);
+    test_journal_drain(0, 250);
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 350);
+
+    /* Pending records and their order survive a reset */
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 350);
+    test_journal_expect(250, TEST_JOURNAL_BATCH);
+
+    for (n = 600; n < 700; n++)
+    {
+        test_journal_append(n);
+    }
+    test_journal_drain(250, 450);
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 0);
+    HOST_TEST_CHECK(APP_JOURNAL_dropped() == 0);
+
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 0);
+}
+
+static void test_journal_overflow(void)
+{
+    uint32_t total = TEST_JOURNAL_CAPACITY + 3 * TEST_JOURNAL_SECTOR_RECORDS;
+    uint32_t minErase = UINT32_MAX;
+    uint32_t maxErase = 0;
+    uint32_t sector;
+    uint32_t erases;
+    uint32_t n;
+
+    DRV_MEMORY_HOST_Reset();
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+
+    /* The oldest sectors are dropped whole, the newest records are kept */
+    for (n = 0; n < total; n++)
+    {
+        test_journal_append(n);
+    }
+    HOST_TEST_CHECK(APP_JOURNAL_pending() + APP_JOURNAL_dropped() == total);
+    HOST_TEST_CHECK(APP_JOURNAL_pending() <= TEST_JOURNAL_CAPACITY);
+    HOST_TEST_CHECK(APP_JOURNAL_pending() >= TEST_JOURNAL_CAPACITY - TEST_JOURNAL_SECTOR_RECORDS);
+    HOST_TEST_CHECK(APP_JOURNAL_dropped() % TEST_JOURNAL_SECTOR_RECORDS == 0);
+    test_journal_expect(APP_JOURNAL_dropped(), TEST_JOURNAL_BATCH);
+
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() + APP_JOURNAL_dropped() >= TEST_JOURNAL_CAPACITY - TEST_JOURNAL_SECTOR_RECORDS);
+    test_journal_drain(total - APP_JOURNAL_pending(), APP_JOURNAL_pending());
+
+    /* Round-robin: the erases are spread evenly */
+    for (sector = 0; sector < TEST_JOURNAL_SECTORS; sector++)
+    {
+        erases = DRV_MEMORY_HOST_EraseCount(TEST_JOURNAL_BASE_SECTOR + sector);
+        minErase = (erases < minErase) ? erases : minErase;
+        maxErase = (erases > maxErase) ? erases : maxErase;
+    }
+    HOST_TEST_CHECK(minErase >= 1);
+    HOST_TEST_CHECK(maxErase - minErase <= 1);
+}
+
+static void test_journal_faults(void)
+{
+    uint32_t n;
+
+    DRV_MEMORY_HOST_Reset();
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+    for (n = 0; n < 20; n++)
+    {
+        test_journal_append(n);
+    }
+
+    /* A full driver queue is retried */
+    DRV_MEMORY_HOST_QueueFullSet(5);
+    test_journal_append(20);
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 21);
+
+    /* Power lost half way through the record of reading 21, slot 22 starts
+       at byte 96 of its page: only its first 8 bytes are programmed */
+    DRV_MEMORY_HOST_PowerCutSet(0, 96 + 8);
+    HOST_TEST_CHECK(!APP_JOURNAL_append(0, 0, 0, 0.0f));
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 21);
+    test_journal_expect(0, 21);
+
+    /* The torn slot is skipped, the journal carries on after it */
+    for (n = 21; n < 40; n++)
+    {
+        test_journal_append(n);
+    }
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 40);
+    test_journal_drain(0, 40);
+
+    /* A failed consume leaves the records pending after a reset: delivered
+       at least once */
+    for (n = 40; n < 50; n++)
+    {
+        test_journal_append(n);
+    }
+    DRV_MEMORY_HOST_FailSet(0);
+    HOST_TEST_CHECK(!APP_JOURNAL_consume(10));
+    test_journal_reboot();
+    HOST_TEST_CHECK(APP_JOURNAL_pending() == 10);
+    test_journal_drain(40, 10);
+}
+
+/* Nothing is written outside the journal sectors of the reserved area */
+static void test_journal_bounds(void)
+{
+    const uint8_t *image = DRV_MEMORY_HOST_Image();
+    uint32_t journalStart = DRV_MEMORY_HOST_MEDIA_SIZE - DRV_MEMORY_FS_RESERVED_SIZE;
+    uint32_t journalEnd = DRV_MEMORY_HOST_MEDIA_SIZE - APP_IDENTITY_AREA_SIZE;
+    uint32_t address;
+    bool untouched = true;
+
+    for (address = 0; address < DRV_MEMORY_HOST_MEDIA_SIZE; address++)
+    {
+        if (((address < journalStart) || (address >= journalEnd)) && (image[address] != 0xFF))
+        {
+            untouched = false;
+        }
+    }
+    HOST_TEST_CHECK(untouched);
+}
+
+/* Lays out a FAT volume of 512 byte sectors from sector start, behind a
+   partition table unless it starts at sector 0 */
+static void test_journal_volume(uint32_t start, uint32_t sectors)
+{
+    uint8_t *image = DRV_MEMORY_HOST_Image();
+    uint8_t *boot = &image[start * 512];
+
+    if (start != 0)
+    {
+        image[446 + 4] = 0x0C;
+        memcpy(&image[446 + 8], &start, 4);
+        memcpy(&image[446 + 12], &sectors, 4);
+        image[510] = 0x55;
+        image[511] = 0xAA;
+    }
+    boot[0] = 0xEB;
+    boot[11] = 0x00;
+    boot[12] = 0x02;
+    if (sectors < 0x10000)
+    {
+        boot[19] = (uint8_t)sectors;
+        boot[20] = (uint8_t)(sectors >> 8);
+        memset(&boot[32], 0, 4);
+    }
+    else
+    {
+        memset(&boot[19], 0, 2);
+        memcpy(&boot[32], &sectors, 4);
+    }
+    boot[510] = 0x55;
+    boot[511] = 0xAA;
+}
+
+/* A volume formatted before the area was reserved keeps the journal off */
+static void test_journal_overlap(void)
+{
+    const uint32_t reservedSector = (DRV_MEMORY_HOST_MEDIA_SIZE - DRV_MEMORY_FS_RESERVED_SIZE) / 512;
+    uint32_t sector;
+
+    /* Over the whole part, behind a partition table or on its own */
+    DRV_MEMORY_HOST_Reset();
+    test_journal_volume(63, (DRV_MEMORY_HOST_MEDIA_SIZE / 512) - 63);
+    HOST_TEST_CHECK(!APP_JOURNAL_init());
+    HOST_TEST_CHECK(!APP_JOURNAL_append(1, 0, 0, 1.0f));
+
+    DRV_MEMORY_HOST_Reset();
+    test_journal_volume(0, reservedSector + 1);
+    HOST_TEST_CHECK(!APP_JOURNAL_init());
+
+    for (sector = 0; sector < TEST_JOURNAL_SECTORS; sector++)
+    {
+        HOST_TEST_CHECK(DRV_MEMORY_HOST_EraseCount(TEST_JOURNAL_BASE_SECTOR + sector) == 0);
+    }
+    HOST_TEST_CHECK(DRV_MEMORY_HOST_ProgramCount() == 0);
+
+    /* A volume formatted on the reduced geometry ends at the area */
+    DRV_MEMORY_HOST_Reset();
+    test_journal_volume(63, reservedSector - 63);
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+    DRV_MEMORY_HOST_Reset();
+    test_journal_volume(0, reservedSector);
+    HOST_TEST_CHECK(APP_JOURNAL_init());
+}
+
+int main(void)
+{
+    test_journal_order();
+    test_journal_bounds();
+    test_journal_overflow();
+    test_journal_bounds();
+    test_journal_faults();
+    test_journal_bounds();
+    test_journal_overlap();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,261 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_mac_loopback.c
+
+  Summary:
+    Loopback MAC driver with packet pools laid out like the glue's.
+
+  Description:
+    The TX and RX packets come from lock-free AZ_NODE_POOLs of packet,
+    segment and buffer items as in azure_glue.c. Frames sent are looped
+    back, received with their payload and Ethernet header accounting, and
+    every packet returns to its pool. Running out of RX packets and losing
+    the link are reported the way the PIC32MZW1 MAC reports them.
+*******************************************************************************/
+
+#include <string.h>
+#include "definitions.h"
+#include "drv_mac_host.h"
+#include "azure_glue_private.h"
+#include "host_test.h"
+
+#define TEST_MAC_BUFFER_SIZE    (1536)
+#define TEST_MAC_RX_ITEMS       (8)
+#define TEST_MAC_TX_ITEMS       (8)
+#define TEST_MAC_PAYLOAD_SIZE   (100)
+
+typedef struct
+{
+    TCPIP_MAC_PACKET packet;
+    TCPIP_MAC_DATA_SEGMENT segment;
+    uint8_t buffer[TEST_MAC_BUFFER_SIZE] __attribute__((aligned(4)));
+} TEST_MAC_ITEM;
+
+static TEST_MAC_ITEM testMacRxItems[TEST_MAC_RX_ITEMS];
+static TEST_MAC_ITEM testMacTxItems[TEST_MAC_TX_ITEMS];
+static AZ_NODE_POOL testMacRxPool;
+static AZ_NODE_POOL testMacTxPool;
+
+static uint32_t testMacTxOk;
+static uint32_t testMacTxLinkDown;
+static TCPIP_MAC_EVENT testMacEvents;
+
+static void test_mac_pool_init(AZ_NODE_POOL *pool, TEST_MAC_ITEM *items, size_t nItems)
+{
+    size_t index;
+
+    memset(items, 0, nItems * sizeof(*items));
+    for (index = 0; index < nItems; index++)
+    {
+        items[index].packet.pDSeg = &items[index].segment;
+    }
+    _Azure_NodePoolInitialize(pool, items, nItems, sizeof(*items));
+}
+
+/* As _Azure_Glue_MacRxPkt_Alloc: the MAC header starts at offset 2 */
+static TCPIP_MAC_PACKET *test_mac_rx_alloc(uint16_t pktLen, uint16_t segLoadLen, TCPIP_MAC_PACKET_FLAGS flags)
+{
+    TEST_MAC_ITEM *item = (TEST_MAC_ITEM *)_Azure_NodePoolGet(&testMacRxPool);
+
+    if (item == 0)
+    {
+        return 0;
+    }
+    item->segment.segBuffer = item->buffer;
+    item->segment.segLoad = item->buffer + 2;
+    item->segment.segSize = TEST_MAC_BUFFER_SIZE - 2;
+    item->segment.segLen = 0;
+    item->segment.next = 0;
+    item->packet.pMacLayer = item->segment.segLoad;
+    item->packet.pktFlags = flags;
+    return &item->packet;
+}
+
+static void test_mac_rx_free(TCPIP_MAC_PACKET *pPkt)
+{
+    _Azure_NodePoolPut(&testMacRxPool, (AZ_SGL_LIST_NODE *)pPkt);
+}
+
+static void test_mac_tx_ack(TCPIP_MAC_PACKET *pPkt, TCPIP_MAC_PKT_ACK_RES ackRes, int moduleId)
+{
+    HOST_TEST_CHECK(moduleId == TCPIP_MODULE_MAC_EXTERNAL);
+    HOST_TEST_CHECK((pPkt->pktFlags & TCPIP_MAC_PKT_FLAG_QUEUED) == 0);
+    if (ackRes == TCPIP_MAC_PKT_ACK_TX_OK)
+    {
+        testMacTxOk++;
+    }
+    else if (ackRes == TCPIP_MAC_PKT_ACK_LINK_DOWN)
+    {
+        testMacTxLinkDown++;
+    }
+    _Azure_NodePoolPut(&testMacTxPool, (AZ_SGL_LIST_NODE *)pPkt);
+}
+
+static void test_mac_event(TCPIP_MAC_EVENT event, const void *eventParam)
+{
+    testMacEvents |= event;
+}
+
+static const TCPIP_MAC_MODULE_CTRL testMacControl =
+{
+    .pktAllocF = test_mac_rx_alloc,
+    .pktFreeF = test_mac_rx_free,
+    .pktAckF = test_mac_tx_ack,
+    .eventF = test_mac_event,
+    .nIfs = 1,
+};
+
+static const TCPIP_MAC_INIT testMacInit =
+{
+    .macControl = &testMacControl,
+};
+
+static const TCPIP_MAC_OBJECT *testMac = &DRV_MAC_HOST_Object;
+
+/* Sends frame n, unicast to the interface address, the header and the
+   payload in separate segments as the stack may chain them */
+static TCPIP_MAC_RES test_mac_send(DRV_HANDLE hMac, const uint8_t *address, uint32_t n)
+{
+    TEST_MAC_ITEM *item = (TEST_MAC_ITEM *)_Azure_NodePoolGet(&testMacTxPool);
+    static TCPIP_MAC_DATA_SEGMENT payloadSegments[TEST_MAC_TX_ITEMS];
+    TCPIP_MAC_DATA_SEGMENT *payload;
+    TCPIP_MAC_ETHERNET_HEADER *header;
+    uint32_t index;
+
+    if (item == 0)
+    {
+        return TCPIP_MAC_RES_ALLOC_ERR;
+    }
+    payload = &payloadSegments[item - testMacTxItems];
+
+    header = (TCPIP_MAC_ETHERNET_HEADER *)item->buffer;
+    memcpy(header->DestMACAddr.v, address, sizeof(header->DestMACAddr.v));
+    memcpy(header->SourceMACAddr.v, address, sizeof(header->SourceMACAddr.v));
+    header->Type = 0x0008;
+    for (index = 0; index < TEST_MAC_PAYLOAD_SIZE; index++)
+    {
+        item->buffer[sizeof(*header) + index] = (uint8_t)(n + index);
+    }
+
+    item->segment.segLoad = item->buffer;
+    item->segment.segLen = sizeof(*header);
+    item->segment.next = payload;
+    payload->segLoad = item->buffer + sizeof(*header);
+    payload->segLen = TEST_MAC_PAYLOAD_SIZE;
+    payload->next = 0;
+    item->packet.pktFlags = 0;
+    return testMac->TCPIP_MAC_PacketTx(hMac, &item->packet);
+}
+
+/* Receives frame n and hands it back to the MAC */
+static void test_mac_receive(DRV_HANDLE hMac, uint32_t n)
+{
+    TCPIP_MAC_PACKET *pPkt;
+    TCPIP_MAC_RES res;
+    bool match = true;
+    uint32_t index;
+
+    pPkt = testMac->TCPIP_MAC_PacketRx(hMac, &res, 0);
+    HOST_TEST_CHECK(pPkt != 0 && res == TCPIP_MAC_RES_OK);
+    if (pPkt == 0)
+    {
+        return;
+    }
+    HOST_TEST_CHECK(pPkt->pDSeg->segLoad == pPkt->pDSeg->segBuffer + 2);
+    HOST_TEST_CHECK(pPkt->pDSeg->segLen == TEST_MAC_PAYLOAD_SIZE);
+    HOST_TEST_CHECK(pPkt->pNetLayer == pPkt->pMacLayer + sizeof(TCPIP_MAC_ETHERNET_HEADER));
+    HOST_TEST_CHECK((pPkt->pktFlags & TCPIP_MAC_PKT_FLAG_CAST_MASK) == TCPIP_MAC_PKT_FLAG_UNICAST);
+    for (index = 0; index < TEST_MAC_PAYLOAD_SIZE; index++)
+    {
+        match = match && (pPkt->pNetLayer[index] == (uint8_t)(n + index));
+    }
+    HOST_TEST_CHECK(match);
+
+    pPkt->ackFunc(pPkt, pPkt->ackParam);
+}
+
+static void test_mac_loopback(void)
+{
+    TCPIP_MAC_PARAMETERS params;
+    SYS_MODULE_OBJ object;
+    DRV_HANDLE hMac;
+    uint32_t n;
+
+    test_mac_pool_init(&testMacRxPool, testMacRxItems, TEST_MAC_RX_ITEMS);
+    test_mac_pool_init(&testMacTxPool, testMacTxItems, TEST_MAC_TX_ITEMS);
+
+    object = testMac->TCPIP_MAC_Initialize(0, (const SYS_MODULE_INIT *)&testMacInit);
+    HOST_TEST_CHECK(object != SYS_MODULE_OBJ_INVALID);
+    hMac = testMac->TCPIP_MAC_Open(0, DRV_IO_INTENT_READWRITE);
+    HOST_TEST_CHECK(hMac != DRV_HANDLE_INVALID);
+    HOST_TEST_CHECK(testMac->TCPIP_MAC_ParametersGet(hMac, &params) == TCPIP_MAC_RES_OK);
+    HOST_TEST_CHECK(testMac->TCPIP_MAC_LinkCheck(hMac));
+    testMac->TCPIP_MAC_EventMaskSet(hMac, TCPIP_MAC_EV_RX_ALL | TCPIP_MAC_EV_TX_ALL | TCPIP_MAC_EV_CONN_ALL, true);
+
+    /* A full batch, as many frames as there are RX packets */
+    for (n = 0; n < TEST_MAC_TX_ITEMS; n++)
+    {
+        HOST_TEST_CHECK(test_mac_send(hMac, params.ifPhyAddress.v, n) == TCPIP_MAC_RES_OK);
+    }
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacTxPool) == 0);
+    testMacEvents = TCPIP_MAC_EV_NONE;
+    HOST_TEST_CHECK(testMac->TCPIP_MAC_Process(hMac) == TCPIP_MAC_RES_OK);
+    HOST_TEST_CHECK((testMacEvents & TCPIP_MAC_EV_RX_PKTPEND) != 0);
+    HOST_TEST_CHECK(testMacTxOk == TEST_MAC_TX_ITEMS);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacTxPool) == TEST_MAC_TX_ITEMS);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacRxPool) == 0);
+    testMac->TCPIP_MAC_EventAcknowledge(hMac, testMacEvents);
+
+    for (n = 0; n < TEST_MAC_TX_ITEMS; n++)
+    {
+        test_mac_receive(hMac, n);
+    }
+    HOST_TEST_CHECK(testMac->TCPIP_MAC_PacketRx(hMac, 0, 0) == 0);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacRxPool) == TEST_MAC_RX_ITEMS);
+
+    /* Out of RX packets: the frames are dropped, not the TX packets */
+    for (n = 0; n < TEST_MAC_RX_ITEMS; n++)
+    {
+        HOST_TEST_CHECK(test_mac_send(hMac, params.ifPhyAddress.v, n) == TCPIP_MAC_RES_OK);
+    }
+    testMac->TCPIP_MAC_Process(hMac);
+    HOST_TEST_CHECK(test_mac_send(hMac, params.ifPhyAddress.v, 100) == TCPIP_MAC_RES_OK);
+    testMacEvents = TCPIP_MAC_EV_NONE;
+    testMac->TCPIP_MAC_Process(hMac);
+    HOST_TEST_CHECK((testMacEvents & TCPIP_MAC_EV_RX_BUFNA) != 0);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacTxPool) == TEST_MAC_TX_ITEMS);
+    HOST_TEST_CHECK(testMacRxPool.emptyCnt >= 1);
+    for (n = 0; n < TEST_MAC_RX_ITEMS; n++)
+    {
+        test_mac_receive(hMac, n);
+    }
+    testMac->TCPIP_MAC_EventAcknowledge(hMac, testMacEvents);
+
+    /* Link down: acknowledged as such and not looped back */
+    testMacEvents = TCPIP_MAC_EV_NONE;
+    DRV_MAC_HOST_LinkSet(false);
+    HOST_TEST_CHECK((testMacEvents & TCPIP_MAC_EV_CONN_LOST) != 0);
+    HOST_TEST_CHECK(!testMac->TCPIP_MAC_LinkCheck(hMac));
+    HOST_TEST_CHECK(test_mac_send(hMac, params.ifPhyAddress.v, 0) == TCPIP_MAC_RES_OK);
+    testMac->TCPIP_MAC_Process(hMac);
+    HOST_TEST_CHECK(testMacTxLinkDown == 1);
+    HOST_TEST_CHECK(testMac->TCPIP_MAC_PacketRx(hMac, 0, 0) == 0);
+    DRV_MAC_HOST_LinkSet(true);
+    HOST_TEST_CHECK((testMacEvents & TCPIP_MAC_EV_CONN_ESTABLISHED) != 0);
+
+    /* Queued frames are handed back on deinitialize */
+    HOST_TEST_CHECK(test_mac_send(hMac, params.ifPhyAddress.v, 0) == TCPIP_MAC_RES_OK);
+    testMac->TCPIP_MAC_Close(hMac);
+    testMac->TCPIP_MAC_Deinitialize(object);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacTxPool) == TEST_MAC_TX_ITEMS);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testMacRxPool) == TEST_MAC_RX_ITEMS);
+    HOST_TEST_CHECK(testMacRxPool.hiWater == TEST_MAC_RX_ITEMS);
+}
+
+int main(void)
+{
+    test_mac_loopback();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,493 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_mqtt_window.c
+
+  Summary:
+    QoS 1 transmit window of the telemetry thread against a test broker.
+
+  Description:
+    The NetX MQTT client of a hub client connects, without TLS, to a broker
+    thread on the loopback network. The broker answers CONNECT, counts the
+    publishes it receives and sends each PUBACK a set time after the
+    publish, or holds them, or drops the connection.
+
+    With the PUBACKs held, sample_telemetry_window_wait lets the first
+    NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH publishes through and then times
+    out; a publish past it fails before anything is sent. A waiter must
+    then wake on the first PUBACK and on a dropped connection, well before
+    its timeout.
+
+    Messages are then sent back to back at QoS 0 and at QoS 1 through the
+    window with a PUBACK delay standing for the round trip to the hub. The
+    broker must never see more publishes unacknowledged than the window,
+    and the messages per second of both are printed. The broker socket has
+    a small receive window: NetX acknowledges a segment on its 200 ms
+    delayed ACK timer unless a window update is due, and QoS 0 would be
+    paced by that timer rather than by the client.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "nx_azure_iot_hub_client.h"
+#include "sample_telemetry.h"
+#include "host_test.h"
+
+#define TEST_STACK_SIZE         16384
+#define TEST_PACKET_SIZE        1568
+#define TEST_POOL_PACKETS       48
+#define TEST_IP_ADDRESS         IP_ADDRESS(10, 0, 0, 2)
+#define TEST_MQTT_PORT          1883
+#define TEST_WINDOW_SIZE        1024
+#define TEST_WAIT               (5 * NX_IP_PERIODIC_RATE)
+#define TEST_TOPIC              "devices/host-test/messages/events/"
+#define TEST_MESSAGE            "{\"temperature\":21.50,\"pressure\":1013.25,\"light\":312}"
+#define TEST_QOS0_MESSAGES      2000
+#define TEST_QOS1_MESSAGES      200
+#define TEST_ACK_DELAY          20
+#define TEST_WAKE_DELAY         100
+#define TEST_WAKE_SLACK         20
+#define TEST_ACKS_MAX           64
+#define TEST_BUFFER_SIZE        4096
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static TX_THREAD brokerThread;
+static NX_PACKET_POOL txPool;
+static NX_PACKET_POOL rxPool;
+static NX_IP testIp;
+static NX_TCP_SOCKET brokerSocket;
+static NX_AZURE_IOT_HUB_CLIENT hubClient;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG brokerStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG mqttStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG ipStack[2048 / sizeof(ULONG)];
+static ULONG arpCache[1024 / sizeof(ULONG)];
+static ULONG txPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static ULONG rxPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/* Broker controls, set by the test thread */
+static volatile ULONG brokerAckDelay;
+static volatile UINT brokerHold;
+static volatile ULONG brokerHoldUntil;
+static volatile ULONG brokerDropAt;
+
+/* Broker counters, read by the test thread */
+static volatile UINT brokerConnects;
+static volatile UINT brokerPublishes[2];
+static volatile UINT brokerAcked;
+static volatile UINT brokerUnackedMax;
+
+typedef struct
+{
+    USHORT packet_id;
+    ULONG due;
+} TEST_ACK;
+
+static TEST_ACK brokerAcks[TEST_ACKS_MAX];
+static UINT brokerAckCount;
+static UCHAR brokerBuffer[TEST_BUFFER_SIZE];
+static ULONG brokerLength;
+
+extern VOID nx_driver_harmony(NX_IP_DRIVER *driver_req_ptr);
+extern void nx_driver_rx_packet_pool_set(NX_PACKET_POOL *pool_ptr);
+
+static void broker_send(const UCHAR *data, UINT length)
+{
+    NX_PACKET *packet;
+
+    if (nx_packet_allocate(&txPool, &packet, NX_TCP_PACKET, TEST_WAIT) != NX_SUCCESS)
+    {
+        return;
+    }
+    if ((nx_packet_data_append(packet, (VOID *)data, length, &txPool, TEST_WAIT) != NX_SUCCESS) ||
+        (nx_tcp_socket_send(&brokerSocket, packet, TEST_WAIT) != NX_SUCCESS))
+    {
+        nx_packet_release(packet);
+    }
+}
+
+/* One control packet from the client: CONNACK to CONNECT, PINGRESP to
+   PINGREQ, a PUBACK queued for a QoS 1 PUBLISH */
+static void broker_packet(const UCHAR *packet, ULONG header_length, ULONG remaining)
+{
+    static const UCHAR connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    static const UCHAR pingresp[] = { 0xD0, 0x00 };
+    const UCHAR *variable = packet + header_length;
+    UINT qos;
+    ULONG topic_length;
+    UINT unacked;
+
+    switch (packet[0] >> 4)
+    {
+    case 1:
+        brokerConnects++;
+        broker_send(connack, sizeof(connack));
+        break;
+
+    case 3:
+        qos = (packet[0] >> 1) & 3;
+        brokerPublishes[qos != 0]++;
+        if ((qos == 1) && (remaining >= 2))
+        {
+            topic_length = ((ULONG)variable[0] << 8) | variable[1];
+            HOST_TEST_CHECK(topic_length + 4 <= remaining);
+            HOST_TEST_CHECK(brokerAckCount < TEST_ACKS_MAX);
+            if ((topic_length + 4 <= remaining) && (brokerAckCount < TEST_ACKS_MAX))
+            {
+                brokerAcks[brokerAckCount].packet_id = (USHORT)((variable[topic_length + 2] << 8) |
+                                                                variable[topic_length + 3]);
+                brokerAcks[brokerAckCount].due = tx_time_get() + brokerAckDelay;
+                brokerAckCount++;
+            }
+            unacked = brokerPublishes[1] - brokerAcked;
+            brokerUnackedMax = (unacked > brokerUnackedMax) ? unacked : brokerUnackedMax;
+        }
+        break;
+
+    case 12:
+        broker_send(pingresp, sizeof(pingresp));
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Takes the complete control packets off the front of the buffer */
+static void broker_parse(void)
+{
+    ULONG offset = 0;
+    ULONG header_length;
+    ULONG remaining;
+    UINT shift;
+
+    for (;;)
+    {
+        header_length = 1;
+        remaining = 0;
+        shift = 0;
+        do
+        {
+            if (offset + header_length >= brokerLength)
+            {
+                goto done;
+            }
+            remaining |= (ULONG)(brokerBuffer[offset + header_length] & 0x7F) << shift;
+            shift += 7;
+        } while (brokerBuffer[offset + header_length++] & 0x80);
+
+        if (offset + header_length + remaining > brokerLength)
+        {
+            break;
+        }
+        broker_packet(&brokerBuffer[offset], header_length, remaining);
+        offset += header_length + remaining;
+    }
+
+done:
+    memmove(brokerBuffer, &brokerBuffer[offset], brokerLength - offset);
+    brokerLength -= offset;
+}
+
+/* PUBACKs that are due, in the order of their publishes */
+static void broker_acks_send(void)
+{
+    UCHAR puback[4] = { 0x40, 0x02 };
+    ULONG now = tx_time_get();
+    UINT sent = 0;
+
+    if (brokerHold && ((LONG)(now - brokerHoldUntil) < 0))
+    {
+        return;
+    }
+    brokerHold = NX_FALSE;
+
+    while ((sent < brokerAckCount) && ((LONG)(now - brokerAcks[sent].due) >= 0))
+    {
+        puback[2] = (UCHAR)(brokerAcks[sent].packet_id >> 8);
+        puback[3] = (UCHAR)brokerAcks[sent].packet_id;
+        broker_send(puback, sizeof(puback));
+        brokerAcked++;
+        sent++;
+    }
+    memmove(brokerAcks, &brokerAcks[sent], (brokerAckCount - sent) * sizeof(TEST_ACK));
+    brokerAckCount -= sent;
+}
+
+static void broker_entry(ULONG input)
+{
+    NX_PACKET *packet;
+    ULONG length;
+    UINT status;
+
+    nx_tcp_socket_create(&testIp, &brokerSocket, "broker socket", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+                         0x80, TEST_WINDOW_SIZE, NX_NULL, NX_NULL);
+    nx_tcp_server_socket_listen(&testIp, TEST_MQTT_PORT, &brokerSocket, 1, NX_NULL);
+
+    for (;;)
+    {
+        if (nx_tcp_server_socket_accept(&brokerSocket, NX_WAIT_FOREVER) == NX_SUCCESS)
+        {
+            brokerLength = 0;
+            brokerAckCount = 0;
+            for (;;)
+            {
+                status = nx_tcp_socket_receive(&brokerSocket, &packet, 1);
+                if (status == NX_SUCCESS)
+                {
+                    length = 0;
+                    if (packet -> nx_packet_length <= sizeof(brokerBuffer) - brokerLength)
+                    {
+                        nx_packet_data_retrieve(packet, &brokerBuffer[brokerLength], &length);
+                    }
+                    nx_packet_release(packet);
+                    HOST_TEST_CHECK(length != 0);
+                    brokerLength += length;
+                    broker_parse();
+                }
+                else if (status != NX_NO_PACKET)
+                {
+                    break;
+                }
+
+                if (brokerDropAt && ((LONG)(tx_time_get() - brokerDropAt) >= 0))
+                {
+                    brokerDropAt = 0;
+                    break;
+                }
+                broker_acks_send();
+            }
+            nx_tcp_socket_disconnect(&brokerSocket, TEST_WAIT);
+        }
+        nx_tcp_server_socket_unaccept(&brokerSocket);
+        nx_tcp_server_socket_relisten(&testIp, TEST_MQTT_PORT, &brokerSocket);
+    }
+}
+
+/* As the hub client does on an MQTT disconnect */
+static VOID test_disconnect_notify(NXD_MQTT_CLIENT *client_ptr)
+{
+    NX_PARAMETER_NOT_USED(client_ptr);
+    hubClient.nx_azure_iot_hub_client_state = NX_AZURE_IOT_HUB_CLIENT_STATUS_NOT_CONNECTED;
+}
+
+static NXD_MQTT_CLIENT *test_mqtt(void)
+{
+    return &(hubClient.nx_azure_iot_hub_client_resource.resource_mqtt);
+}
+
+static UINT test_publish(UINT qos)
+{
+    return nxd_mqtt_client_publish(test_mqtt(), TEST_TOPIC, sizeof(TEST_TOPIC) - 1,
+                                   TEST_MESSAGE, sizeof(TEST_MESSAGE) - 1, NX_FALSE, qos, TEST_WAIT);
+}
+
+static UINT test_queue_depth(void)
+{
+    return test_mqtt() -> message_transmit_queue_depth;
+}
+
+/* Waits until the broker has acknowledged all publishes */
+static void test_drain(void)
+{
+    ULONG start = tx_time_get();
+
+    while ((test_queue_depth() != 0) && (tx_time_get() - start < TEST_WAIT))
+    {
+        tx_thread_sleep(1);
+    }
+    HOST_TEST_CHECK(test_queue_depth() == 0);
+}
+
+static void test_connect(void)
+{
+    NXD_ADDRESS broker;
+
+    broker.nxd_ip_version = NX_IP_VERSION_V4;
+    broker.nxd_ip_address.v4 = TEST_IP_ADDRESS;
+
+    HOST_TEST_CHECK(nxd_mqtt_client_create(test_mqtt(), "test mqtt", "host-test", sizeof("host-test") - 1,
+                                           &testIp, &txPool, mqttStack, sizeof(mqttStack), 4,
+                                           NX_NULL, 0) == NX_SUCCESS);
+    nxd_mqtt_client_disconnect_notify_set(test_mqtt(), test_disconnect_notify);
+    HOST_TEST_CHECK(nxd_mqtt_client_connect(test_mqtt(), &broker, TEST_MQTT_PORT, 60, NX_TRUE,
+                                            TEST_WAIT) == NX_SUCCESS);
+    HOST_TEST_CHECK(brokerConnects == 1);
+    hubClient.nx_azure_iot_hub_client_state = NX_AZURE_IOT_HUB_CLIENT_STATUS_CONNECTED;
+    HOST_TEST_CHECK(sample_telemetry_window_attach(&hubClient) == NX_AZURE_IOT_SUCCESS);
+}
+
+/* Fills the window with the PUBACKs held until the given time */
+static void test_window_fill(ULONG hold_until)
+{
+    UINT i;
+
+    brokerHoldUntil = hold_until;
+    brokerHold = NX_TRUE;
+    for (i = 0; i < NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH; i++)
+    {
+        HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, NX_NO_WAIT) == NX_AZURE_IOT_SUCCESS);
+        HOST_TEST_CHECK(test_publish(1) == NX_SUCCESS);
+    }
+    HOST_TEST_CHECK(test_queue_depth() == NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH);
+}
+
+static void test_window(void)
+{
+    ULONG start;
+    ULONG elapsed;
+    UINT base;
+
+    brokerAckDelay = 0;
+
+    /* Full window: the wait times out, a publish past it fails */
+    test_window_fill(tx_time_get() + TEST_WAIT);
+    start = tx_time_get();
+    HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, TEST_WAKE_DELAY) == NX_TX_QUEUE_DEPTH);
+    elapsed = tx_time_get() - start;
+    HOST_TEST_CHECK(elapsed >= TEST_WAKE_DELAY);
+    base = brokerPublishes[1];
+    HOST_TEST_CHECK(test_publish(1) != NX_SUCCESS);
+    tx_thread_sleep(TEST_ACK_DELAY);
+    HOST_TEST_CHECK(brokerPublishes[1] == base);
+    HOST_TEST_CHECK(test_queue_depth() == NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH);
+
+    /* A waiter wakes on the first PUBACK, not at its timeout */
+    brokerHoldUntil = tx_time_get() + TEST_WAKE_DELAY;
+    start = tx_time_get();
+    HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, SAMPLE_TELEMETRY_WINDOW_WAIT) == NX_AZURE_IOT_SUCCESS);
+    elapsed = tx_time_get() - start;
+    HOST_TEST_CHECK(elapsed >= TEST_WAKE_DELAY - 1);
+    HOST_TEST_CHECK(elapsed <= TEST_WAKE_DELAY + TEST_WAKE_SLACK);
+    test_drain();
+    printf("mqtt window: waiter woken %lu ticks after the wait, the PUBACK was sent after %u\n",
+           (unsigned long)elapsed, TEST_WAKE_DELAY);
+}
+
+/* Messages per second at QoS 0 and at QoS 1 through the window */
+static void test_rate(void)
+{
+    static const UINT counts[2] = { TEST_QOS0_MESSAGES, TEST_QOS1_MESSAGES };
+    ULONG start;
+    uint64_t elapsed[2];
+    UINT base;
+    UINT i;
+
+    brokerAckDelay = TEST_ACK_DELAY;
+    brokerUnackedMax = 0;
+
+    base = brokerPublishes[0];
+    start = tx_time_get();
+    elapsed[0] = test_now_ns();
+    for (i = 0; i < counts[0]; i++)
+    {
+        HOST_TEST_CHECK(test_publish(0) == NX_SUCCESS);
+    }
+    while ((brokerPublishes[0] - base < counts[0]) && (tx_time_get() - start < TEST_WAIT))
+    {
+        tx_thread_sleep(1);
+    }
+    elapsed[0] = test_now_ns() - elapsed[0];
+    HOST_TEST_CHECK(brokerPublishes[0] - base == counts[0]);
+
+    base = brokerAcked;
+    start = tx_time_get();
+    elapsed[1] = test_now_ns();
+    for (i = 0; i < counts[1]; i++)
+    {
+        HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, SAMPLE_TELEMETRY_WINDOW_WAIT) == NX_AZURE_IOT_SUCCESS);
+        HOST_TEST_CHECK(test_publish(1) == NX_SUCCESS);
+    }
+    test_drain();
+    elapsed[1] = test_now_ns() - elapsed[1];
+    HOST_TEST_CHECK(brokerAcked - base == counts[1]);
+    HOST_TEST_CHECK(brokerUnackedMax == NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH);
+
+    /* The window bounds QoS 1 to its depth per PUBACK delay */
+    start = tx_time_get() - start;
+    HOST_TEST_CHECK(start >= (counts[1] / NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH - 1) * TEST_ACK_DELAY);
+    HOST_TEST_CHECK(start <= 2 * (counts[1] / NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH) * TEST_ACK_DELAY);
+
+    printf("mqtt window: QoS 0 %llu msg/s, QoS 1 %llu msg/s with a window of %u and a %u ms PUBACK delay\n",
+           (unsigned long long)(counts[0] * 1000000000ull / elapsed[0]),
+           (unsigned long long)(counts[1] * 1000000000ull / elapsed[1]),
+           NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH, TEST_ACK_DELAY * 1000 / NX_IP_PERIODIC_RATE);
+}
+
+/* A waiter gives up when the connection drops, not at its timeout */
+static void test_disconnect(void)
+{
+    ULONG start;
+    ULONG elapsed;
+
+    brokerAckDelay = 0;
+    test_window_fill(tx_time_get() + TEST_WAIT);
+    brokerDropAt = tx_time_get() + TEST_WAKE_DELAY;
+    start = tx_time_get();
+    HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, SAMPLE_TELEMETRY_WINDOW_WAIT) == NX_TX_QUEUE_DEPTH);
+    elapsed = tx_time_get() - start;
+    HOST_TEST_CHECK(elapsed >= TEST_WAKE_DELAY - 1);
+    HOST_TEST_CHECK(elapsed < SAMPLE_TELEMETRY_WINDOW_WAIT / 2);
+    HOST_TEST_CHECK(hubClient.nx_azure_iot_hub_client_state == NX_AZURE_IOT_HUB_CLIENT_STATUS_NOT_CONNECTED);
+
+    /* Disconnected, nothing frees a slot: no wait at all */
+    start = tx_time_get();
+    HOST_TEST_CHECK(sample_telemetry_window_wait(&hubClient, SAMPLE_TELEMETRY_WINDOW_WAIT) == NX_TX_QUEUE_DEPTH);
+    HOST_TEST_CHECK(tx_time_get() - start <= 1);
+}
+
+static void test_entry(ULONG input)
+{
+    ULONG status = 0;
+
+    HOST_TEST_CHECK(nx_ip_status_check(&testIp, NX_IP_ADDRESS_RESOLVED, &status, TEST_WAIT) == NX_SUCCESS);
+
+    test_connect();
+    test_window();
+    test_rate();
+    test_disconnect();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&txPool, "tx pool", TEST_PACKET_SIZE, txPoolArea, sizeof(txPoolArea));
+    nx_packet_pool_create(&rxPool, "rx pool", TEST_PACKET_SIZE, rxPoolArea, sizeof(rxPoolArea));
+    nx_driver_rx_packet_pool_set(&rxPool);
+    HOST_TEST_CHECK(nx_ip_create(&testIp, "test ip", TEST_IP_ADDRESS, 0xFFFFFF00UL, &txPool, nx_driver_harmony,
+                                 ipStack, sizeof(ipStack), NX_DEMO_IP_THREAD_PRIORITY) == NX_SUCCESS);
+    nx_arp_enable(&testIp, arpCache, sizeof(arpCache));
+    nx_tcp_enable(&testIp);
+
+    tx_thread_create(&brokerThread, "broker", broker_entry, 0, brokerStack, sizeof(brokerStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,223 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_netx_loopback.c
+
+  Summary:
+    NetX Duo over the target driver, the Azure glue and the loopback MAC.
+
+  Description:
+    An IP instance is created on nx_driver_harmony as sample_netx_duo.c
+    does. UDP datagrams of every size that fits one packet are sent to the
+    subnet broadcast address, go through the glue and the MAC driver and
+    come back up the receive path to a socket bound on their port. Each one
+    must arrive intact and every packet must return to its pool. The time
+    from the send call to the receive is printed, and the bring-up time from
+    the IP instance creation to its link being enabled, the glue bring-up
+    in it.
+
+    The glue has no room for its segment gap in a chained packet: a datagram
+    spanning two packets is dropped by the driver, and must not be released
+    twice.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "host_test.h"
+
+#define TEST_STACK_SIZE         4096
+#define TEST_PACKET_SIZE        1568
+#define TEST_POOL_PACKETS       16
+#define TEST_IP_ADDRESS         IP_ADDRESS(10, 0, 0, 2)
+#define TEST_BROADCAST          IP_ADDRESS(10, 0, 0, 255)
+#define TEST_UDP_PORT           5000
+#define TEST_DATAGRAMS          400
+#define TEST_PAYLOAD_MAX        (TEST_PACKET_SIZE - NX_UDP_PACKET - NX_PHYSICAL_TRAILER)
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static NX_PACKET_POOL txPool;
+static NX_PACKET_POOL rxPool;
+static NX_IP testIp;
+static NX_UDP_SOCKET testSocket;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG ipStack[2048 / sizeof(ULONG)];
+static ULONG arpCache[1024 / sizeof(ULONG)];
+static ULONG txPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static ULONG rxPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+
+static UCHAR payload[TEST_PAYLOAD_MAX + 64];
+static UCHAR received[TEST_PAYLOAD_MAX];
+static uint64_t latencyUs[TEST_DATAGRAMS];
+static uint64_t ipCreated;
+
+extern VOID nx_driver_harmony(NX_IP_DRIVER *driver_req_ptr);
+extern void nx_driver_rx_packet_pool_set(NX_PACKET_POOL *pool_ptr);
+
+static int latency_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void payload_fill(UINT sequence, UINT length)
+{
+    UINT i;
+
+    for (i = 0; i < length; i++)
+    {
+        payload[i] = (UCHAR)(sequence * 7 + i);
+    }
+}
+
+static UINT datagram_send(UINT length)
+{
+    NX_PACKET *packet;
+    UINT status;
+
+    status = nx_packet_allocate(&txPool, &packet, NX_UDP_PACKET, NX_IP_PERIODIC_RATE);
+    if (status != NX_SUCCESS)
+    {
+        return status;
+    }
+    status = nx_packet_data_append(packet, payload, length, &txPool, NX_IP_PERIODIC_RATE);
+    if (status == NX_SUCCESS)
+    {
+        status = nx_udp_socket_send(&testSocket, packet, TEST_BROADCAST, TEST_UDP_PORT);
+    }
+    if (status != NX_SUCCESS)
+    {
+        nx_packet_release(packet);
+    }
+    return status;
+}
+
+/* Receives one datagram, its length or -1 */
+static int datagram_receive(ULONG wait)
+{
+    NX_PACKET *packet;
+    ULONG length = 0;
+
+    if (nx_udp_socket_receive(&testSocket, &packet, wait) != NX_SUCCESS)
+    {
+        return -1;
+    }
+    nx_packet_data_retrieve(packet, received, &length);
+    nx_packet_release(packet);
+    return (int)length;
+}
+
+static void test_datagrams(void)
+{
+    UINT sequence;
+    UINT length;
+    uint64_t sent;
+    int receivedLength;
+    int lost = 0;
+
+    for (sequence = 0; sequence < TEST_DATAGRAMS; sequence++)
+    {
+        /* Sizes over the whole range, odd ones included, the largest first */
+        length = 1 + (sequence * 37) % TEST_PAYLOAD_MAX;
+        if (sequence == 0)
+        {
+            length = TEST_PAYLOAD_MAX;
+        }
+        payload_fill(sequence, length);
+
+        sent = SYS_TIME_Counter64Get();
+        HOST_TEST_CHECK(datagram_send(length) == NX_SUCCESS);
+        receivedLength = datagram_receive(NX_IP_PERIODIC_RATE);
+        latencyUs[sequence] = SYS_TIME_Counter64Get() - sent;
+        if (receivedLength < 0)
+        {
+            lost++;
+            continue;
+        }
+        HOST_TEST_CHECK(receivedLength == (int)length);
+        HOST_TEST_CHECK(memcmp(received, payload, length) == 0);
+    }
+    HOST_TEST_CHECK(lost == 0);
+
+    qsort(latencyUs, TEST_DATAGRAMS, sizeof(latencyUs[0]), latency_compare);
+    printf("netx loopback: %d datagrams, send to receive median %llu us, 99th %llu us\n",
+           TEST_DATAGRAMS, (unsigned long long)latencyUs[TEST_DATAGRAMS / 2],
+           (unsigned long long)latencyUs[TEST_DATAGRAMS * 99 / 100]);
+}
+
+static void test_chained(void)
+{
+    /* The payload spills into a second packet */
+    payload_fill(0, TEST_PAYLOAD_MAX + 64);
+    datagram_send(TEST_PAYLOAD_MAX + 64);
+    HOST_TEST_CHECK(datagram_receive(NX_IP_PERIODIC_RATE / 10) < 0);
+
+    /* And the next one still goes through */
+    payload_fill(1, TEST_PAYLOAD_MAX);
+    HOST_TEST_CHECK(datagram_send(TEST_PAYLOAD_MAX) == NX_SUCCESS);
+    HOST_TEST_CHECK(datagram_receive(NX_IP_PERIODIC_RATE) == TEST_PAYLOAD_MAX);
+}
+
+static void test_pools(void)
+{
+    /* Frames still in the glue or the driver come back once the IP thread ran */
+    tx_thread_sleep(NX_IP_PERIODIC_RATE / 10);
+    HOST_TEST_CHECK(txPool.nx_packet_pool_available == txPool.nx_packet_pool_total);
+    HOST_TEST_CHECK(rxPool.nx_packet_pool_available == rxPool.nx_packet_pool_total);
+}
+
+static void test_entry(ULONG input)
+{
+    ULONG status = 0;
+
+    /* The IP thread holds its mutex while it initializes and enables the driver */
+    HOST_TEST_CHECK(nx_ip_status_check(&testIp, NX_IP_INITIALIZE_DONE, &status, 5 * NX_IP_PERIODIC_RATE) == NX_SUCCESS);
+    tx_mutex_get(&(testIp.nx_ip_protection), TX_WAIT_FOREVER);
+    tx_mutex_put(&(testIp.nx_ip_protection));
+    printf("netx loopback: bring-up %llu us\n", (unsigned long long)(SYS_TIME_Counter64Get() - ipCreated));
+
+    /* As sample_netx_duo.c, the driver does not report its link status */
+    HOST_TEST_CHECK(nx_ip_status_check(&testIp, NX_IP_ADDRESS_RESOLVED, &status, 5 * NX_IP_PERIODIC_RATE) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_udp_socket_create(&testIp, &testSocket, "test socket", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+                                         0x80, TEST_POOL_PACKETS) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_udp_socket_bind(&testSocket, TEST_UDP_PORT, NX_NO_WAIT) == NX_SUCCESS);
+
+    test_datagrams();
+    test_chained();
+    test_pools();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&txPool, "tx pool", TEST_PACKET_SIZE, txPoolArea, sizeof(txPoolArea));
+    nx_packet_pool_create(&rxPool, "rx pool", TEST_PACKET_SIZE, rxPoolArea, sizeof(rxPoolArea));
+    nx_driver_rx_packet_pool_set(&rxPool);
+    ipCreated = SYS_TIME_Counter64Get();
+    HOST_TEST_CHECK(nx_ip_create(&testIp, "test ip", TEST_IP_ADDRESS, 0xFFFFFF00UL, &txPool, nx_driver_harmony,
+                                 ipStack, sizeof(ipStack), NX_DEMO_IP_THREAD_PRIORITY) == NX_SUCCESS);
+    nx_arp_enable(&testIp, arpCache, sizeof(arpCache));
+    nx_udp_enable(&testIp);
+
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
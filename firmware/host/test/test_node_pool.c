@@ -0,0 +1,167 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_node_pool.c
+
+  Summary:
+    Lock-free node pool of the glue under contention.
+
+  Description:
+    Threads take nodes out of one AZ_NODE_POOL and put them back as the
+    NetX threads and the MAC driver do with the packet pools. A node is
+    never handed to two owners at once and every node is back in the pool
+    at the end.
+*******************************************************************************/
+
+#include <string.h>
+#include <pthread.h>
+#include "definitions.h"
+#include "azure_glue_private.h"
+#include "host_test.h"
+
+#define TEST_POOL_NODES         (16)
+#define TEST_POOL_THREADS       (8)
+#define TEST_POOL_ITERATIONS    (200000)
+#define TEST_POOL_HOLD          (3)
+
+typedef struct
+{
+    AZ_SGL_LIST_NODE node;
+    uint32_t owner;
+    uint32_t uses;
+} TEST_POOL_NODE;
+
+static TEST_POOL_NODE testPoolNodes[TEST_POOL_NODES];
+static AZ_NODE_POOL testPool;
+static uint32_t testPoolDoubleOwned;
+static uint32_t testPoolForeign;
+
+static bool test_pool_own(TEST_POOL_NODE *pNode, uint32_t owner)
+{
+    uint32_t expected = 0;
+
+    if ((uint8_t *)pNode < (uint8_t *)testPoolNodes || (uint8_t *)pNode >= (uint8_t *)(testPoolNodes + TEST_POOL_NODES) ||
+        ((uint8_t *)pNode - (uint8_t *)testPoolNodes) % sizeof(TEST_POOL_NODE) != 0)
+    {
+        __atomic_fetch_add(&testPoolForeign, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    if (!__atomic_compare_exchange_n(&pNode->owner, &expected, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        __atomic_fetch_add(&testPoolDoubleOwned, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_fetch_add(&pNode->uses, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void *test_pool_thread(void *arg)
+{
+    uint32_t owner = (uint32_t)(uintptr_t)arg;
+    TEST_POOL_NODE *held[TEST_POOL_HOLD];
+    uint32_t nHeld;
+    uint32_t iteration;
+    uint32_t index;
+    TEST_POOL_NODE *pNode;
+
+    for (iteration = 0; iteration < TEST_POOL_ITERATIONS; iteration++)
+    {
+        /* Varying batches so that the heads change under the other threads */
+        nHeld = 0;
+        for (index = 0; index < 1 + (iteration + owner) % TEST_POOL_HOLD; index++)
+        {
+            if ((pNode = (TEST_POOL_NODE *)_Azure_NodePoolGet(&testPool)) == 0)
+            {
+                break;
+            }
+            if (test_pool_own(pNode, owner))
+            {
+                held[nHeld++] = pNode;
+            }
+        }
+        for (index = 0; index < nHeld; index++)
+        {
+            __atomic_store_n(&held[index]->owner, 0, __ATOMIC_RELEASE);
+            _Azure_NodePoolPut(&testPool, &held[index]->node);
+        }
+    }
+    return 0;
+}
+
+static void test_pool_single(void)
+{
+    AZ_SGL_LIST_NODE *taken[TEST_POOL_NODES];
+    uint32_t index;
+
+    _Azure_NodePoolInitialize(&testPool, testPoolNodes, TEST_POOL_NODES, sizeof(TEST_POOL_NODE));
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testPool) == TEST_POOL_NODES);
+
+    /* Array order first, then empty */
+    for (index = 0; index < TEST_POOL_NODES; index++)
+    {
+        taken[index] = _Azure_NodePoolGet(&testPool);
+        HOST_TEST_CHECK(taken[index] == &testPoolNodes[index].node);
+    }
+    HOST_TEST_CHECK(_Azure_NodePoolGet(&testPool) == 0);
+    HOST_TEST_CHECK(testPool.emptyCnt == 1);
+    HOST_TEST_CHECK(testPool.hiWater == TEST_POOL_NODES);
+
+    /* Last in, first out */
+    _Azure_NodePoolPut(&testPool, taken[5]);
+    _Azure_NodePoolPut(&testPool, taken[2]);
+    HOST_TEST_CHECK(_Azure_NodePoolGet(&testPool) == taken[2]);
+    HOST_TEST_CHECK(_Azure_NodePoolGet(&testPool) == taken[5]);
+
+    for (index = 0; index < TEST_POOL_NODES; index++)
+    {
+        _Azure_NodePoolPut(&testPool, taken[index]);
+    }
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testPool) == TEST_POOL_NODES);
+}
+
+static void test_pool_contention(void)
+{
+    pthread_t threads[TEST_POOL_THREADS];
+    uint32_t index;
+    uint32_t uses = 0;
+    uint32_t free = 0;
+
+    memset(testPoolNodes, 0, sizeof(testPoolNodes));
+    _Azure_NodePoolInitialize(&testPool, testPoolNodes, TEST_POOL_NODES, sizeof(TEST_POOL_NODE));
+
+    for (index = 0; index < TEST_POOL_THREADS; index++)
+    {
+        HOST_TEST_CHECK(pthread_create(&threads[index], 0, test_pool_thread, (void *)(uintptr_t)(index + 1)) == 0);
+    }
+    for (index = 0; index < TEST_POOL_THREADS; index++)
+    {
+        pthread_join(threads[index], 0);
+    }
+
+    HOST_TEST_CHECK(testPoolDoubleOwned == 0);
+    HOST_TEST_CHECK(testPoolForeign == 0);
+    HOST_TEST_CHECK(testPool.getCnt == testPool.putCnt);
+    HOST_TEST_CHECK(_Azure_NodePoolFreeCount(&testPool) == TEST_POOL_NODES);
+    for (index = 0; index < TEST_POOL_NODES; index++)
+    {
+        uses += testPoolNodes[index].uses;
+    }
+    HOST_TEST_CHECK(uses == testPool.getCnt);
+
+    /* Every node is on the free list exactly once */
+    while (_Azure_NodePoolGet(&testPool) != 0)
+    {
+        free++;
+    }
+    HOST_TEST_CHECK(free == TEST_POOL_NODES);
+
+    printf("%u gets, %u empty, %u retries\n", testPool.getCnt, testPool.emptyCnt, testPool.retryCnt);
+}
+
+int main(void)
+{
+    test_pool_single();
+    test_pool_contention();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,236 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_rx_burst.c
+
+  Summary:
+    A burst of frames through the batched receive path of the glue and of
+    nx_driver_harmony.
+
+  Description:
+    An IP instance is created on nx_driver_harmony over the loopback MAC, as
+    test_netx_loopback.c does. The test thread holds the IP mutex while it
+    sends a burst of UDP datagrams to the subnet broadcast address, so that
+    the IP thread cannot run its deferred pass before the whole burst sits
+    in the MAC. Once the mutex is released, every datagram must arrive
+    intact, handed to NetX in a single nx_driver_receive_chain call.
+
+    The deferred wakeups of the IP thread and the chain walk are counted by
+    wrapping _nx_ip_driver_deferred_processing and nx_driver_receive_chain
+    at link time. The burst costs one wakeup for the transmit completions
+    and a single one for all of its received frames.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "host_test.h"
+
+#define TEST_STACK_SIZE         4096
+#define TEST_PACKET_SIZE        1568
+#define TEST_POOL_PACKETS       16
+#define TEST_IP_ADDRESS         IP_ADDRESS(10, 0, 0, 2)
+#define TEST_BROADCAST          IP_ADDRESS(10, 0, 0, 255)
+#define TEST_UDP_PORT           5000
+#define TEST_BURST              8
+#define TEST_ROUNDS             20
+#define TEST_PAYLOAD_SIZE       200
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static NX_PACKET_POOL txPool;
+static NX_PACKET_POOL rxPool;
+static NX_IP testIp;
+static NX_UDP_SOCKET testSocket;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG ipStack[2048 / sizeof(ULONG)];
+static ULONG arpCache[1024 / sizeof(ULONG)];
+static ULONG txPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static ULONG rxPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+
+static UCHAR payload[TEST_PAYLOAD_SIZE];
+static UCHAR received[TEST_PAYLOAD_SIZE];
+
+/* Updated by the IP thread, read by the test thread once it went idle */
+static volatile UINT wakeups;
+static volatile UINT chains;
+static volatile UINT chainPackets;
+static volatile UINT chainPacketsMax;
+
+extern VOID nx_driver_harmony(NX_IP_DRIVER *driver_req_ptr);
+extern void nx_driver_rx_packet_pool_set(NX_PACKET_POOL *pool_ptr);
+
+VOID __real__nx_ip_driver_deferred_processing(NX_IP *ip_ptr);
+void __real_nx_driver_receive_chain(NX_PACKET *packet_ptr);
+
+VOID __wrap__nx_ip_driver_deferred_processing(NX_IP *ip_ptr)
+{
+    wakeups++;
+    __real__nx_ip_driver_deferred_processing(ip_ptr);
+}
+
+void __wrap_nx_driver_receive_chain(NX_PACKET *packet_ptr)
+{
+    NX_PACKET *packet;
+    UINT count = 0;
+
+    for (packet = packet_ptr; packet != NX_NULL; packet = packet->nx_packet_queue_next)
+    {
+        count++;
+    }
+    chains++;
+    chainPackets += count;
+    if (count > chainPacketsMax)
+    {
+        chainPacketsMax = count;
+    }
+    __real_nx_driver_receive_chain(packet_ptr);
+}
+
+static void payload_fill(UINT sequence)
+{
+    UINT i;
+
+    for (i = 0; i < TEST_PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (UCHAR)(sequence * 7 + i);
+    }
+}
+
+static UINT datagram_send(UINT sequence)
+{
+    NX_PACKET *packet;
+    UINT status;
+
+    status = nx_packet_allocate(&txPool, &packet, NX_UDP_PACKET, NX_IP_PERIODIC_RATE);
+    if (status != NX_SUCCESS)
+    {
+        return status;
+    }
+    payload_fill(sequence);
+    status = nx_packet_data_append(packet, payload, TEST_PAYLOAD_SIZE, &txPool, NX_IP_PERIODIC_RATE);
+    if (status == NX_SUCCESS)
+    {
+        status = nx_udp_socket_send(&testSocket, packet, TEST_BROADCAST, TEST_UDP_PORT);
+    }
+    if (status != NX_SUCCESS)
+    {
+        nx_packet_release(packet);
+    }
+    return status;
+}
+
+static void counters_clear(void)
+{
+    wakeups = 0;
+    chains = 0;
+    chainPackets = 0;
+    chainPacketsMax = 0;
+}
+
+static void test_burst(void)
+{
+    NX_PACKET *packet;
+    ULONG length;
+    UINT round;
+    UINT sequence;
+    UINT wakeupsMax = 0;
+    int lost = 0;
+
+    for (round = 0; round < TEST_ROUNDS; round++)
+    {
+        /* Let the IP thread go idle, nothing left over from the last round */
+        tx_thread_sleep(NX_IP_PERIODIC_RATE / 100);
+        counters_clear();
+
+        /* The IP thread blocks on its mutex until the whole burst is in the MAC */
+        tx_mutex_get(&(testIp.nx_ip_protection), TX_WAIT_FOREVER);
+        for (sequence = 0; sequence < TEST_BURST; sequence++)
+        {
+            HOST_TEST_CHECK(datagram_send(round * TEST_BURST + sequence) == NX_SUCCESS);
+        }
+        tx_mutex_put(&(testIp.nx_ip_protection));
+
+        for (sequence = 0; sequence < TEST_BURST; sequence++)
+        {
+            if (nx_udp_socket_receive(&testSocket, &packet, NX_IP_PERIODIC_RATE) != NX_SUCCESS)
+            {
+                lost++;
+                continue;
+            }
+            length = 0;
+            nx_packet_data_retrieve(packet, received, &length);
+            nx_packet_release(packet);
+            payload_fill(round * TEST_BURST + sequence);
+            HOST_TEST_CHECK(length == TEST_PAYLOAD_SIZE);
+            HOST_TEST_CHECK(memcmp(received, payload, TEST_PAYLOAD_SIZE) == 0);
+        }
+
+        /* All of the burst in one chain, one wakeup for the TX done, one for the RX */
+        tx_thread_sleep(NX_IP_PERIODIC_RATE / 100);
+        HOST_TEST_CHECK(chains == 1);
+        HOST_TEST_CHECK(chainPackets == TEST_BURST);
+        HOST_TEST_CHECK(chainPacketsMax == TEST_BURST);
+        HOST_TEST_CHECK(wakeups == 2);
+        if (wakeups > wakeupsMax)
+        {
+            wakeupsMax = wakeups;
+        }
+    }
+    HOST_TEST_CHECK(lost == 0);
+
+    printf("rx burst: %d rounds of %d frames, %u frames per chain, %u deferred wakeups per burst\n",
+           TEST_ROUNDS, TEST_BURST, chainPacketsMax, wakeupsMax);
+}
+
+static void test_pools(void)
+{
+    tx_thread_sleep(NX_IP_PERIODIC_RATE / 10);
+    HOST_TEST_CHECK(txPool.nx_packet_pool_available == txPool.nx_packet_pool_total);
+    HOST_TEST_CHECK(rxPool.nx_packet_pool_available == rxPool.nx_packet_pool_total);
+}
+
+static void test_entry(ULONG input)
+{
+    ULONG status = 0;
+
+    /* As sample_netx_duo.c, the driver does not report its link status */
+    HOST_TEST_CHECK(nx_ip_status_check(&testIp, NX_IP_ADDRESS_RESOLVED, &status, 5 * NX_IP_PERIODIC_RATE) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_udp_socket_create(&testIp, &testSocket, "test socket", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+                                         0x80, TEST_POOL_PACKETS) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_udp_socket_bind(&testSocket, TEST_UDP_PORT, NX_NO_WAIT) == NX_SUCCESS);
+
+    test_burst();
+    test_pools();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&txPool, "tx pool", TEST_PACKET_SIZE, txPoolArea, sizeof(txPoolArea));
+    nx_packet_pool_create(&rxPool, "rx pool", TEST_PACKET_SIZE, rxPoolArea, sizeof(rxPoolArea));
+    nx_driver_rx_packet_pool_set(&rxPool);
+    HOST_TEST_CHECK(nx_ip_create(&testIp, "test ip", TEST_IP_ADDRESS, 0xFFFFFF00UL, &txPool, nx_driver_harmony,
+                                 ipStack, sizeof(ipStack), NX_DEMO_IP_THREAD_PRIORITY) == NX_SUCCESS);
+    nx_arp_enable(&testIp, arpCache, sizeof(arpCache));
+    nx_udp_enable(&testIp);
+
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,670 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_telemetry_cbor.c
+
+  Summary:
+    CBOR payload of the telemetry builder, decoded back and against JSON.
+
+  Description:
+    Messages are written by sample_telemetry.c into NetX packets laid out as
+    nx_azure_iot_hub_client_telemetry_message_create leaves them. There is
+    no hub connection to publish them, so the payload is closed as
+    sample_telemetry_builder_send does before it publishes.
+
+    The CBOR payload is decoded by the generic decoder below, written from
+    the reference algorithms of RFC 8949 (appendix C, and appendix D for
+    half precision): any major type, definite and indefinite lengths and
+    every float width. Integers over the whole int32 range and floats,
+    negative ones included, must come back as the same int32 and as the
+    same float32 bits, under their keys.
+
+    One telemetry interval of readings is then encoded both ways, and the
+    payload bytes and the encode time per message are printed.
+*******************************************************************************/
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "nx_azure_iot.h"
+#include "sample_telemetry.h"
+#include "cJSON.h"
+#include "host_test.h"
+
+#define TEST_STACK_SIZE         16384
+#define TEST_PACKET_SIZE        1536
+#define TEST_POOL_PACKETS       8
+#define TEST_TOPIC              "devices/host-test/messages/events/"
+#define TEST_PAYLOAD_MAX        1024
+#define TEST_ITEMS_MAX          48
+#define TEST_ITERATIONS         20000
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static NX_PACKET_POOL testPool;
+static NX_AZURE_IOT_HUB_CLIENT hubClient;
+static SAMPLE_TELEMETRY_BUILDER builder;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG poolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static UCHAR payload[TEST_PAYLOAD_MAX + 1];
+
+typedef struct
+{
+    const char *name;
+    int32_t value;
+} TEST_INT;
+
+typedef struct
+{
+    const char *name;
+    double value;
+    UINT digits;
+} TEST_DOUBLE;
+
+/* Every head size on both sides of zero */
+static const TEST_INT testInts[] =
+{
+    { "zero", 0 },
+    { "small", 23 },
+    { "byte_low", 24 },
+    { "byte_high", 255 },
+    { "short_low", 256 },
+    { "short_high", 65535 },
+    { "long_low", 65536 },
+    { "long_high", INT32_MAX },
+    { "minus_one", -1 },
+    { "minus_small", -24 },
+    { "minus_byte_low", -25 },
+    { "minus_byte_high", -256 },
+    { "minus_short_low", -257 },
+    { "minus_short_high", -65536 },
+    { "minus_long_low", -65537 },
+    { "minus_long_high", INT32_MIN },
+};
+
+static const TEST_DOUBLE testDoubles[] =
+{
+    { "WFI32IoT_temperature", 24.8125, 2 },
+    { "VAV_pressure", -3.2719, 4 },
+    { "ALT2_pressure", 1009.87, 2 },
+    { "cold", -40.5, 2 },
+    { "tiny", 1.0e-3, 4 },
+    { "negative_zero", -0.0, 2 },
+    { "largest", FLT_MAX, 0 },
+    { "most_negative", -FLT_MAX, 0 },
+    { "smallest_normal", FLT_MIN, 0 },
+    /* 24 characters and longer keys take a length byte */
+    { "TEMPHUM14_temperature_stddev", -0.0625, 2 },
+};
+
+/* One interval of a WFI32-IoT with the Altitude 2, PHT and Temp&Hum 14
+   clicks, batched behind an earlier group */
+static const TEST_DOUBLE intervalReadings[] =
+{
+    { "WFI32IoT_temperature", 24.8125, 2 },
+    { "WFI32IoT_light", 412.0, 0 },
+    { "ALT2_temperature", 25.31, 2 },
+    { "ALT2_pressure", 1009.87, 2 },
+    { "ALT2_altitude", 29.64, 2 },
+    { "PHT_temperature", 25.07, 2 },
+    { "PHT_pressure", 1009.91, 2 },
+    { "PHT_humidity", 41.28, 2 },
+    { "TEMPHUM14_temperature", 24.96, 2 },
+    { "TEMPHUM14_humidity", 40.73, 2 },
+};
+
+#define TEST_COUNT(array)       (sizeof(array) / sizeof(array[0]))
+
+// *****************************************************************************
+// Decoder, RFC 8949 appendix C and D
+
+typedef enum
+{
+    CBOR_UNSIGNED,
+    CBOR_NEGATIVE,
+    CBOR_BYTES,
+    CBOR_TEXT,
+    CBOR_ARRAY,
+    CBOR_MAP,
+    CBOR_TAG,
+    CBOR_SIMPLE,
+    CBOR_FLOAT,
+} CBOR_TYPE;
+
+typedef struct
+{
+    CBOR_TYPE type;
+    uint64_t argument;          /* Integer argument, or the float bits */
+    int width;                  /* Float width in bytes */
+    double value;               /* Float value */
+    const uint8_t *data;        /* Text and byte strings, definite length */
+    int indefinite;
+} CBOR_ITEM;
+
+typedef struct
+{
+    char key[64];
+    CBOR_ITEM value;
+} CBOR_PAIR;
+
+typedef struct
+{
+    const uint8_t *pointer;
+    const uint8_t *end;
+    int error;
+} CBOR_READER;
+
+static uint64_t cbor_take(CBOR_READER *reader, int bytes)
+{
+    uint64_t value = 0;
+
+    if (reader->end - reader->pointer < bytes)
+    {
+        reader->error = 1;
+        return 0;
+    }
+    while (bytes-- > 0)
+    {
+        value = (value << 8) | *reader->pointer++;
+    }
+    return value;
+}
+
+/* RFC 8949 appendix D */
+static double cbor_half(unsigned half)
+{
+    unsigned exp = (half >> 10) & 0x1f;
+    unsigned mant = half & 0x3ff;
+    double value;
+
+    if (exp == 0)
+    {
+        value = ldexp(mant, -24);
+    }
+    else if (exp != 31)
+    {
+        value = ldexp(mant + 1024, exp - 25);
+    }
+    else
+    {
+        value = (mant == 0) ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/* Head of one data item, the break code is a CBOR_SIMPLE of argument 31 */
+static void cbor_head(CBOR_READER *reader, CBOR_ITEM *item)
+{
+    unsigned initial = (unsigned)cbor_take(reader, 1);
+    unsigned major = initial >> 5;
+    unsigned info = initial & 0x1f;
+    union
+    {
+        float f;
+        uint32_t u;
+    } single;
+    union
+    {
+        double d;
+        uint64_t u;
+    } binary64;
+
+    memset(item, 0, sizeof(*item));
+    item->type = (CBOR_TYPE)major;
+    if (info < 24)
+    {
+        item->argument = info;
+    }
+    else if (info <= 27)
+    {
+        item->width = 1 << (info - 24);
+        item->argument = cbor_take(reader, item->width);
+    }
+    else if (info == 31 && (major == 2 || major == 3 || major == 4 || major == 5 || major == 7))
+    {
+        item->indefinite = 1;
+        item->argument = 31;
+    }
+    else
+    {
+        reader->error = 1;
+    }
+
+    if (major == 7 && info >= 25 && info <= 27)
+    {
+        item->type = CBOR_FLOAT;
+        if (info == 25)
+        {
+            item->value = cbor_half((unsigned)item->argument);
+        }
+        else if (info == 26)
+        {
+            single.u = (uint32_t)item->argument;
+            item->value = single.f;
+        }
+        else
+        {
+            binary64.u = item->argument;
+            item->value = binary64.d;
+        }
+    }
+}
+
+static int cbor_is_break(const CBOR_ITEM *item)
+{
+    return item->type == CBOR_SIMPLE && item->indefinite;
+}
+
+static void cbor_skip(CBOR_READER *reader, const CBOR_ITEM *item);
+
+/* Contents of an item whose head was read: strings are kept, containers and
+   tags are walked to check they are well formed */
+static void cbor_body(CBOR_READER *reader, CBOR_ITEM *item)
+{
+    CBOR_ITEM inner;
+    uint64_t count;
+
+    switch (item->type)
+    {
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if (item->indefinite)
+            {
+                /* Chunks of the same major type, each one definite */
+                for (;;)
+                {
+                    cbor_head(reader, &inner);
+                    if (reader->error || cbor_is_break(&inner))
+                    {
+                        break;
+                    }
+                    if (inner.type != item->type || inner.indefinite)
+                    {
+                        reader->error = 1;
+                        break;
+                    }
+                    if ((uint64_t)(reader->end - reader->pointer) < inner.argument)
+                    {
+                        reader->error = 1;
+                        break;
+                    }
+                    reader->pointer += inner.argument;
+                }
+            }
+            else if ((uint64_t)(reader->end - reader->pointer) < item->argument)
+            {
+                reader->error = 1;
+            }
+            else
+            {
+                item->data = reader->pointer;
+                reader->pointer += item->argument;
+            }
+            break;
+
+        case CBOR_ARRAY:
+        case CBOR_MAP:
+            count = item->argument * (item->type == CBOR_MAP ? 2 : 1);
+            while (!reader->error && (item->indefinite || count-- > 0))
+            {
+                cbor_head(reader, &inner);
+                if (item->indefinite && cbor_is_break(&inner))
+                {
+                    break;
+                }
+                cbor_skip(reader, &inner);
+            }
+            break;
+
+        case CBOR_TAG:
+            cbor_head(reader, &inner);
+            cbor_skip(reader, &inner);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void cbor_skip(CBOR_READER *reader, const CBOR_ITEM *item)
+{
+    CBOR_ITEM copy = *item;
+
+    if (cbor_is_break(item))
+    {
+        reader->error = 1;
+        return;
+    }
+    cbor_body(reader, &copy);
+}
+
+/* Decodes a payload that must be one map with text keys, its pairs or -1 */
+static int cbor_decode_map(const uint8_t *data, size_t length, CBOR_PAIR *pairs, int max)
+{
+    CBOR_READER reader = { data, data + length, 0 };
+    CBOR_ITEM map;
+    CBOR_ITEM key;
+    int count = 0;
+
+    cbor_head(&reader, &map);
+    if (reader.error || map.type != CBOR_MAP)
+    {
+        return -1;
+    }
+    while (!reader.error && (map.indefinite || (uint64_t)count < map.argument))
+    {
+        cbor_head(&reader, &key);
+        if (map.indefinite && cbor_is_break(&key))
+        {
+            break;
+        }
+        if (key.type != CBOR_TEXT || key.indefinite || count == max)
+        {
+            return -1;
+        }
+        cbor_body(&reader, &key);
+        if (reader.error || key.argument >= sizeof(pairs[count].key))
+        {
+            return -1;
+        }
+        memcpy(pairs[count].key, key.data, key.argument);
+        pairs[count].key[key.argument] = 0;
+
+        cbor_head(&reader, &pairs[count].value);
+        if (cbor_is_break(&pairs[count].value))
+        {
+            return -1;
+        }
+        cbor_body(&reader, &pairs[count].value);
+        count++;
+    }
+
+    /* Nothing may follow the map */
+    return (reader.error || reader.pointer != reader.end) ? -1 : count;
+}
+
+static const CBOR_PAIR *cbor_find(const CBOR_PAIR *pairs, int count, const char *key)
+{
+    int index;
+
+    for (index = 0; index < count; index++)
+    {
+        if (strcmp(pairs[index].key, key) == 0)
+        {
+            return &pairs[index];
+        }
+    }
+    return NULL;
+}
+
+// *****************************************************************************
+// Messages
+
+/* A builder on a packet as nx_azure_iot_hub_client_telemetry_message_create
+   returns it: MQTT header room, then the topic. QoS 0, no packet id */
+static UINT message_open(UINT encoding)
+{
+    NX_PACKET *packet;
+    UINT status;
+
+    memset(&builder, 0, sizeof(builder));
+    if ((status = nx_packet_allocate(&testPool, &packet, NX_TCP_PACKET, NX_NO_WAIT)))
+    {
+        return status;
+    }
+    packet->nx_packet_prepend_ptr += NX_AZURE_IOT_PUBLISH_PACKET_START_OFFSET;
+    packet->nx_packet_append_ptr = packet->nx_packet_prepend_ptr;
+    if ((status = nx_packet_data_append(packet, TEST_TOPIC, sizeof(TEST_TOPIC) - 1, &testPool, NX_NO_WAIT)))
+    {
+        nx_packet_release(packet);
+        return status;
+    }
+
+    builder.hub_client_ptr = &hubClient;
+    builder.packet_ptr = packet;
+    builder.wait_option = NX_NO_WAIT;
+    builder.qos = NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS;
+    if ((status = sample_telemetry_builder_qos_set(&builder, NX_AZURE_IOT_MQTT_QOS_0)) == NX_SUCCESS)
+    {
+        status = sample_telemetry_builder_encoding_set(&builder, encoding);
+    }
+    return status;
+}
+
+/* Closes the payload as sample_telemetry_builder_send does, copies it out
+   and releases the packet; the payload length or 0 */
+static ULONG message_close(void)
+{
+    UCHAR mapEnd = 0xFF;
+    ULONG length = 0;
+    UINT status = builder.status;
+
+    if (status == NX_SUCCESS)
+    {
+        if (builder.encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+        {
+            status = nx_packet_data_append(builder.packet_ptr, &mapEnd, 1, &testPool, NX_NO_WAIT);
+        }
+        else
+        {
+            status = nx_azure_iot_json_writer_append_end_object(&builder.json_writer);
+        }
+    }
+    if (status == NX_SUCCESS &&
+        nx_packet_data_extract_offset(builder.packet_ptr, builder.topic_length, payload, TEST_PAYLOAD_MAX,
+                                      &length) != NX_SUCCESS)
+    {
+        length = 0;
+    }
+    payload[length] = 0;
+    sample_telemetry_builder_delete(&builder);
+    return length;
+}
+
+static ULONG message_interval(UINT encoding)
+{
+    UINT index;
+
+    if (message_open(encoding) != NX_SUCCESS)
+    {
+        return 0;
+    }
+    for (index = 0; index < TEST_COUNT(intervalReadings); index++)
+    {
+        if (intervalReadings[index].digits == 0)
+        {
+            sample_telemetry_builder_append_int32(&builder, intervalReadings[index].name,
+                                                  (int32_t)intervalReadings[index].value);
+        }
+        else
+        {
+            sample_telemetry_builder_append_double(&builder, intervalReadings[index].name,
+                                                   intervalReadings[index].value,
+                                                   intervalReadings[index].digits);
+        }
+    }
+    sample_telemetry_builder_append_int32(&builder, "PHT_dt", 5012);
+    return message_close();
+}
+
+// *****************************************************************************
+
+static void test_round_trip(void)
+{
+    static CBOR_PAIR pairs[TEST_ITEMS_MAX];
+    const CBOR_PAIR *pair;
+    ULONG length;
+    int count;
+    UINT index;
+    union
+    {
+        float f;
+        uint32_t u;
+    } expected;
+
+    HOST_TEST_CHECK(message_open(SAMPLE_TELEMETRY_ENCODING_CBOR) == NX_SUCCESS);
+    for (index = 0; index < TEST_COUNT(testInts); index++)
+    {
+        HOST_TEST_CHECK(sample_telemetry_builder_append_int32(&builder, testInts[index].name,
+                                                              testInts[index].value) == NX_SUCCESS);
+    }
+    for (index = 0; index < TEST_COUNT(testDoubles); index++)
+    {
+        HOST_TEST_CHECK(sample_telemetry_builder_append_double(&builder, testDoubles[index].name,
+                                                               testDoubles[index].value,
+                                                               testDoubles[index].digits) == NX_SUCCESS);
+    }
+    length = message_close();
+    HOST_TEST_CHECK(length > 0);
+
+    count = cbor_decode_map(payload, length, pairs, TEST_ITEMS_MAX);
+    HOST_TEST_CHECK(count == (int)(TEST_COUNT(testInts) + TEST_COUNT(testDoubles)));
+
+    for (index = 0; index < TEST_COUNT(testInts); index++)
+    {
+        pair = cbor_find(pairs, count, testInts[index].name);
+        HOST_TEST_CHECK(pair != NULL);
+        if (pair == NULL)
+        {
+            continue;
+        }
+        if (testInts[index].value < 0)
+        {
+            HOST_TEST_CHECK(pair->value.type == CBOR_NEGATIVE);
+            HOST_TEST_CHECK(-1 - (int64_t)pair->value.argument == testInts[index].value);
+        }
+        else
+        {
+            HOST_TEST_CHECK(pair->value.type == CBOR_UNSIGNED);
+            HOST_TEST_CHECK((int64_t)pair->value.argument == testInts[index].value);
+        }
+    }
+
+    for (index = 0; index < TEST_COUNT(testDoubles); index++)
+    {
+        pair = cbor_find(pairs, count, testDoubles[index].name);
+        HOST_TEST_CHECK(pair != NULL);
+        if (pair == NULL)
+        {
+            continue;
+        }
+        expected.f = (float)testDoubles[index].value;
+        HOST_TEST_CHECK(pair->value.type == CBOR_FLOAT && pair->value.width == 4);
+        HOST_TEST_CHECK((uint32_t)pair->value.argument == expected.u);
+        HOST_TEST_CHECK(pair->value.value == (double)expected.f);
+    }
+
+    /* A key over the longest the encoder stages is refused, not truncated */
+    HOST_TEST_CHECK(message_open(SAMPLE_TELEMETRY_ENCODING_CBOR) == NX_SUCCESS);
+    HOST_TEST_CHECK(sample_telemetry_builder_append_int32(&builder,
+                    "a_key_of_forty_nine_characters_is_one_too_long__x", 1) != NX_SUCCESS);
+    HOST_TEST_CHECK(message_close() == 0);
+}
+
+/* Both encodings of one interval hold the same readings */
+static void test_interval(void)
+{
+    static CBOR_PAIR pairs[TEST_ITEMS_MAX];
+    const CBOR_PAIR *pair;
+    cJSON *object;
+    cJSON *item;
+    ULONG length;
+    int count;
+    UINT index;
+
+    length = message_interval(SAMPLE_TELEMETRY_ENCODING_CBOR);
+    count = cbor_decode_map(payload, length, pairs, TEST_ITEMS_MAX);
+    HOST_TEST_CHECK(count == (int)TEST_COUNT(intervalReadings) + 1);
+    for (index = 0; index < TEST_COUNT(intervalReadings); index++)
+    {
+        pair = cbor_find(pairs, count, intervalReadings[index].name);
+        HOST_TEST_CHECK(pair != NULL);
+        if (pair != NULL && intervalReadings[index].digits != 0)
+        {
+            HOST_TEST_CHECK(pair->value.value == (double)(float)intervalReadings[index].value);
+        }
+        else if (pair != NULL)
+        {
+            HOST_TEST_CHECK((double)pair->value.argument == intervalReadings[index].value);
+        }
+    }
+    pair = cbor_find(pairs, count, "PHT_dt");
+    HOST_TEST_CHECK(pair != NULL && pair->value.type == CBOR_UNSIGNED && pair->value.argument == 5012);
+
+    HOST_TEST_CHECK(message_interval(SAMPLE_TELEMETRY_ENCODING_JSON) > 0);
+    object = cJSON_Parse((const char *)payload);
+    HOST_TEST_CHECK(object != NULL);
+    for (index = 0; index < TEST_COUNT(intervalReadings); index++)
+    {
+        item = cJSON_GetObjectItem(object, intervalReadings[index].name);
+        HOST_TEST_CHECK(item != NULL && fabs(item->valuedouble - intervalReadings[index].value) <= 0.005001);
+    }
+    cJSON_Delete(object);
+}
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/* Payload bytes and encode time of one interval per message */
+static void test_benchmark(void)
+{
+    static const char *labels[] = { "json", "cbor" };
+    ULONG bytes[2];
+    uint64_t elapsed;
+    UINT encoding;
+    UINT index;
+
+    for (encoding = SAMPLE_TELEMETRY_ENCODING_JSON; encoding <= SAMPLE_TELEMETRY_ENCODING_CBOR; encoding++)
+    {
+        bytes[encoding] = message_interval(encoding);
+        elapsed = test_now_ns();
+        for (index = 0; index < TEST_ITERATIONS; index++)
+        {
+            message_interval(encoding);
+        }
+        elapsed = test_now_ns() - elapsed;
+        printf("telemetry %s: %u readings, %lu payload bytes, %.0f ns per message\n", labels[encoding],
+               (unsigned)TEST_COUNT(intervalReadings) + 1, bytes[encoding], (double)elapsed / TEST_ITERATIONS);
+    }
+    HOST_TEST_CHECK(bytes[SAMPLE_TELEMETRY_ENCODING_CBOR] < bytes[SAMPLE_TELEMETRY_ENCODING_JSON]);
+}
+
+static void test_entry(ULONG input)
+{
+    test_round_trip();
+    test_interval();
+    test_benchmark();
+    HOST_TEST_CHECK(testPool.nx_packet_pool_available == testPool.nx_packet_pool_total);
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&testPool, "test pool", TEST_PACKET_SIZE, poolArea, sizeof(poolArea));
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
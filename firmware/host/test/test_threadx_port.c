@@ -0,0 +1,207 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_threadx_port.c
+
+  Summary:
+    Runs the kernel on its Linux port through the services the firmware uses.
+
+  Description:
+    Priority preemption, sleeps and timeouts on the tick pthread, semaphores,
+    event flags set from a timer, queues of pointers, pool alignment and
+    deleting and resetting completed threads.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "tx_api.h"
+#include "host_test.h"
+
+#define TEST_STACK_SIZE         2048
+
+static TX_THREAD testThread;
+static TX_THREAD highThread;
+static TX_THREAD peerThread;
+static TX_SEMAPHORE pingSemaphore;
+static TX_SEMAPHORE pongSemaphore;
+static TX_EVENT_FLAGS_GROUP timerFlags;
+static TX_TIMER flagTimer;
+static TX_QUEUE pointerQueue;
+static TX_BYTE_POOL testPool;
+static ULONG pointerQueueMemory[4 * ((sizeof(VOID *) + sizeof(ULONG) - 1) / sizeof(ULONG))];
+static UCHAR testPoolMemory[16 * 1024];
+
+static char order[8];
+static int orderCount;
+static int peerRuns;
+
+static void order_mark(char mark)
+{
+    if (orderCount < (int)sizeof(order) - 1)
+    {
+        order[orderCount++] = mark;
+    }
+}
+
+static unsigned long long host_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void high_entry(ULONG input)
+{
+    (void)input;
+    order_mark('H');
+}
+
+static void peer_entry(ULONG input)
+{
+    int i;
+
+    (void)input;
+    peerRuns++;
+    for (i = 0; i < 1000; i++)
+    {
+        tx_semaphore_get(&pingSemaphore, TX_WAIT_FOREVER);
+        tx_semaphore_put(&pongSemaphore);
+    }
+}
+
+static void flag_timer_entry(ULONG input)
+{
+    tx_event_flags_set(&timerFlags, input, TX_OR);
+}
+
+static void test_preemption(void)
+{
+    /* A higher priority thread made ready runs before the resume returns */
+    orderCount = 0;
+    order_mark('a');
+    tx_thread_resume(&highThread);
+    order_mark('b');
+    order[orderCount] = 0;
+    HOST_TEST_CHECK(orderCount == 3 && order[0] == 'a' && order[1] == 'H' && order[2] == 'b');
+}
+
+static void test_sleep(void)
+{
+    ULONG ticks = tx_time_get();
+    unsigned long long start = host_ms();
+    unsigned long long elapsed;
+
+    tx_thread_sleep(50);
+    elapsed = host_ms() - start;
+    HOST_TEST_CHECK(tx_time_get() - ticks >= 50);
+    HOST_TEST_CHECK(elapsed >= 45 && elapsed < 1000);
+
+    /* A timed wait gives up after its ticks */
+    HOST_TEST_CHECK(tx_semaphore_get(&pingSemaphore, 20) == TX_NO_INSTANCE);
+}
+
+static void test_semaphores(void)
+{
+    int i;
+
+    /* Equal priority peer, every put hands the processor over */
+    for (i = 0; i < 1000; i++)
+    {
+        HOST_TEST_CHECK(tx_semaphore_put(&pingSemaphore) == TX_SUCCESS);
+        HOST_TEST_CHECK(tx_semaphore_get(&pongSemaphore, 100) == TX_SUCCESS);
+    }
+}
+
+static void test_timer_flags(void)
+{
+    ULONG actual = 0;
+
+    tx_timer_create(&flagTimer, "flag timer", flag_timer_entry, 0x5, 10, 0, TX_AUTO_ACTIVATE);
+    HOST_TEST_CHECK(tx_event_flags_get(&timerFlags, 0x4, TX_OR_CLEAR, &actual, 100) == TX_SUCCESS);
+    HOST_TEST_CHECK(actual == 0x5);
+    tx_timer_delete(&flagTimer);
+}
+
+static void test_queue_and_pool(void)
+{
+    VOID *sent;
+    VOID *received = TX_NULL;
+    VOID *block = TX_NULL;
+
+    /* Messages sized from the pointer carry all of it */
+    sent = (VOID *)&testPoolMemory[sizeof(testPoolMemory) - 1];
+    tx_queue_send(&pointerQueue, &sent, TX_NO_WAIT);
+    HOST_TEST_CHECK(tx_queue_receive(&pointerQueue, &received, TX_NO_WAIT) == TX_SUCCESS);
+    HOST_TEST_CHECK(received == sent);
+
+    HOST_TEST_CHECK(tx_byte_allocate(&testPool, &block, 13, TX_NO_WAIT) == TX_SUCCESS);
+    HOST_TEST_CHECK(((unsigned long)block % sizeof(VOID *)) == 0);
+    tx_byte_release(block);
+}
+
+static void test_delete_reset(void)
+{
+    UINT state = 0;
+
+    /* The completed peer restarts after a reset and can then be deleted */
+    tx_thread_sleep(1);
+    tx_thread_info_get(&peerThread, TX_NULL, &state, TX_NULL, TX_NULL, TX_NULL, TX_NULL, TX_NULL, TX_NULL);
+    HOST_TEST_CHECK(state == TX_COMPLETED);
+    HOST_TEST_CHECK(tx_thread_reset(&peerThread) == TX_SUCCESS);
+    HOST_TEST_CHECK(tx_thread_resume(&peerThread) == TX_SUCCESS);
+    test_semaphores();
+    HOST_TEST_CHECK(peerRuns == 2);
+    tx_thread_sleep(1);
+    HOST_TEST_CHECK(tx_thread_delete(&peerThread) == TX_SUCCESS);
+
+    /* A thread that never ran can be terminated and deleted too */
+    HOST_TEST_CHECK(tx_thread_delete(&highThread) == TX_SUCCESS);
+    tx_thread_create(&highThread, "high", high_entry, 0, malloc(TEST_STACK_SIZE), TEST_STACK_SIZE,
+                     5, 5, TX_NO_TIME_SLICE, TX_DONT_START);
+    HOST_TEST_CHECK(tx_thread_terminate(&highThread) == TX_SUCCESS);
+    HOST_TEST_CHECK(tx_thread_delete(&highThread) == TX_SUCCESS);
+    HOST_TEST_CHECK(orderCount == 3);
+}
+
+static void test_entry(ULONG input)
+{
+    (void)input;
+    test_preemption();
+    test_sleep();
+    test_semaphores();
+    HOST_TEST_CHECK(peerRuns == 1);
+    test_timer_flags();
+    test_queue_and_pool();
+    test_delete_reset();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    (void)first_unused_memory;
+    tx_semaphore_create(&pingSemaphore, "ping", 0);
+    tx_semaphore_create(&pongSemaphore, "pong", 0);
+    tx_event_flags_create(&timerFlags, "timer flags");
+    tx_queue_create(&pointerQueue, "pointers", sizeof(pointerQueueMemory) / sizeof(ULONG) / 4,
+                    pointerQueueMemory, sizeof(pointerQueueMemory));
+    tx_byte_pool_create(&testPool, "pool", testPoolMemory, sizeof(testPoolMemory));
+    tx_thread_create(&testThread, "test", test_entry, 0, malloc(TEST_STACK_SIZE), TEST_STACK_SIZE,
+                     10, 10, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&highThread, "high", high_entry, 0, malloc(TEST_STACK_SIZE), TEST_STACK_SIZE,
+                     5, 5, TX_NO_TIME_SLICE, TX_DONT_START);
+    tx_thread_create(&peerThread, "peer", peer_entry, 0, malloc(TEST_STACK_SIZE), TEST_STACK_SIZE,
+                     10, 10, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
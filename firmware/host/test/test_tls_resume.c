@@ -0,0 +1,487 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_tls_resume.c
+
+  Summary:
+    NX Secure TLS session resumption against an OpenSSL server.
+
+  Description:
+    Two openssl s_server processes are started on an RSA certificate of a
+    test CA, one with its session cache and one without. A relay thread
+    accepts NetX TCP connections on the loopback network and forwards them
+    to a server through a host socket. The TLS client is set up with the
+    crypto and ciphersuite tables of the sample, as nx_azure_iot.c does.
+
+    The first connection is a full handshake that stores the session, the
+    second one resumes it, and a server that kept no session makes the
+    client fall back to a full handshake. Application data must go through
+    every time, the server sends back each line reversed. The time and the
+    bytes of a full and of a resumed handshake are printed, and the stack
+    the send of an application data record takes, the bottom of the MQTT
+    publish of the telemetry thread.
+
+    The error checking of the resume call is tested first.
+*******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "nx_secure_tls_api.h"
+#include "nx_azure_iot_ciphersuites.h"
+#include "host_test.h"
+#include "host_stack.h"
+
+#define TEST_STACK_SIZE         16384
+#define TEST_PACKET_SIZE        1568
+#define TEST_POOL_PACKETS       48
+#define TEST_IP_ADDRESS         IP_ADDRESS(10, 0, 0, 2)
+#define TEST_TLS_PORT           4433
+#define TEST_WINDOW_SIZE        8192
+#define TEST_WAIT               (5 * NX_IP_PERIODIC_RATE)
+#define TEST_CERT_SIZE          2048
+#define TEST_MESSAGE            "resumed session\n"
+#define TEST_REPLY              "noisses demuser\n"
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static TX_THREAD relayThread;
+static NX_PACKET_POOL txPool;
+static NX_PACKET_POOL rxPool;
+static NX_IP testIp;
+static NX_TCP_SOCKET clientSocket;
+static NX_TCP_SOCKET relaySocket;
+static NX_SECURE_TLS_SESSION tlsSession;
+static NX_SECURE_X509_CERT trustedCert;
+static NX_SECURE_TLS_RESUME tlsResume;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG relayStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG ipStack[2048 / sizeof(ULONG)];
+static ULONG arpCache[1024 / sizeof(ULONG)];
+static ULONG txPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static ULONG rxPoolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+/* The 10K of the sample are too few for the 64-bit crypto metadata */
+static ULONG tlsMetadata[1024 * 16 / sizeof(ULONG)];
+static UCHAR tlsPacketBuffer[1024 * 7];
+
+static char workDir[] = "/tmp/test_tls_resume_XXXXXX";
+static UCHAR certDer[TEST_CERT_SIZE];
+static UINT certDerLength;
+static pid_t serverPid[2];
+static unsigned short serverPort[2];
+
+/* Server port the relay connects the next connection to, bytes it forwarded */
+static volatile unsigned short relayPort;
+static volatile ULONG relayToServer;
+static volatile ULONG relayToClient;
+
+extern VOID nx_driver_harmony(NX_IP_DRIVER *driver_req_ptr);
+extern void nx_driver_rx_packet_pool_set(NX_PACKET_POOL *pool_ptr);
+
+static void servers_stop(void)
+{
+    char command[sizeof(workDir) + 16];
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (serverPid[i] > 0)
+        {
+            kill(serverPid[i], SIGTERM);
+            waitpid(serverPid[i], NULL, 0);
+        }
+    }
+    snprintf(command, sizeof(command), "rm -rf %s", workDir);
+    (void)system(command);
+}
+
+static int server_reachable(unsigned short port)
+{
+    struct sockaddr_in address;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int reachable;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    reachable = connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+    close(fd);
+    return reachable;
+}
+
+/* Starts openssl s_server on the certificate of workDir, false on failure */
+static bool server_start(int index, bool cache)
+{
+    char port[8];
+    char cert[sizeof(workDir) + 16];
+    char key[sizeof(workDir) + 16];
+    int tries;
+
+    snprintf(port, sizeof(port), "%u", serverPort[index]);
+    snprintf(cert, sizeof(cert), "%s/cert.pem", workDir);
+    snprintf(key, sizeof(key), "%s/key.pem", workDir);
+
+    serverPid[index] = fork();
+    if (serverPid[index] == 0)
+    {
+        /* s_server reports every connection on its output */
+        int null = open("/dev/null", O_WRONLY);
+
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl(TEST_OPENSSL, TEST_OPENSSL, "s_server", "-accept", port, "-cert", cert, "-key", key,
+              "-tls1_2", "-rev", "-quiet", cache ? NULL : "-no_cache", NULL);
+        _exit(127);
+    }
+    if (serverPid[index] < 0)
+    {
+        return false;
+    }
+    for (tries = 0; tries < 100; tries++)
+    {
+        if (server_reachable(serverPort[index]))
+        {
+            return true;
+        }
+        usleep(50000);
+    }
+    return false;
+}
+
+/* RSA certificate of the servers, signed by a test CA whose DER form is the
+   trusted certificate: NX Secure rejects a self-signed server certificate */
+static bool certificate_create(void)
+{
+    char command[16 * sizeof(workDir) + 512];
+    FILE *der;
+
+    if (mkdtemp(workDir) == NULL)
+    {
+        return false;
+    }
+    snprintf(command, sizeof(command),
+             "cd %s && ( "
+             "%s req -x509 -newkey rsa:2048 -nodes -sha256 -days 2 -subj /CN=test-ca "
+             "-keyout ca-key.pem -out ca.pem && "
+             "%s req -newkey rsa:2048 -nodes -sha256 -subj /CN=localhost -keyout key.pem -out cert.csr && "
+             "%s x509 -req -in cert.csr -CA ca.pem -CAkey ca-key.pem -CAcreateserial -sha256 -days 2 "
+             "-out cert.pem && "
+             "%s x509 -in ca.pem -outform DER -out ca.der ) >/dev/null 2>&1",
+             workDir, TEST_OPENSSL, TEST_OPENSSL, TEST_OPENSSL, TEST_OPENSSL);
+    if (system(command) != 0)
+    {
+        return false;
+    }
+    snprintf(command, sizeof(command), "%s/ca.der", workDir);
+    der = fopen(command, "rb");
+    if (der == NULL)
+    {
+        return false;
+    }
+    certDerLength = (UINT)fread(certDer, 1, sizeof(certDer), der);
+    fclose(der);
+    return certDerLength > 0 && certDerLength < sizeof(certDer);
+}
+
+/* Connects to the server the test asked for, -1 on failure */
+static int relay_connect(void)
+{
+    struct sockaddr_in address;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(relayPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+/* Forwards one connection both ways until either side closes it */
+static void relay_forward(int fd)
+{
+    UCHAR buffer[TEST_PACKET_SIZE - NX_TCP_PACKET];
+    NX_PACKET *packet;
+    NX_PACKET *next;
+    ssize_t length;
+    bool idle;
+
+    for (;;)
+    {
+        idle = true;
+
+        if (nx_tcp_socket_receive(&relaySocket, &packet, NX_NO_WAIT) == NX_SUCCESS)
+        {
+            for (next = packet; next != NX_NULL; next = next -> nx_packet_next)
+            {
+                length = next -> nx_packet_append_ptr - next -> nx_packet_prepend_ptr;
+                relayToServer += (ULONG)length;
+                if (send(fd, next -> nx_packet_prepend_ptr, (size_t)length, MSG_NOSIGNAL) != length)
+                {
+                    nx_packet_release(packet);
+                    return;
+                }
+            }
+            nx_packet_release(packet);
+            idle = false;
+        }
+        else if (relaySocket.nx_tcp_socket_state != NX_TCP_ESTABLISHED)
+        {
+            return;
+        }
+
+        length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length == 0 || (length < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            return;
+        }
+        if (length > 0)
+        {
+            relayToClient += (ULONG)length;
+            if (nx_packet_allocate(&txPool, &packet, NX_TCP_PACKET, TEST_WAIT) != NX_SUCCESS)
+            {
+                return;
+            }
+            if (nx_packet_data_append(packet, buffer, (ULONG)length, &txPool, TEST_WAIT) != NX_SUCCESS ||
+                nx_tcp_socket_send(&relaySocket, packet, TEST_WAIT) != NX_SUCCESS)
+            {
+                nx_packet_release(packet);
+                return;
+            }
+            idle = false;
+        }
+
+        /* The servers run in their own processes, give them the processor */
+        if (idle)
+        {
+            tx_thread_sleep(1);
+        }
+    }
+}
+
+static void relay_entry(ULONG input)
+{
+    int fd;
+
+    nx_tcp_socket_create(&testIp, &relaySocket, "relay socket", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+                         0x80, TEST_WINDOW_SIZE, NX_NULL, NX_NULL);
+    nx_tcp_server_socket_listen(&testIp, TEST_TLS_PORT, &relaySocket, 1, NX_NULL);
+
+    for (;;)
+    {
+        if (nx_tcp_server_socket_accept(&relaySocket, NX_WAIT_FOREVER) == NX_SUCCESS)
+        {
+            fd = relay_connect();
+            if (fd >= 0)
+            {
+                relay_forward(fd);
+                close(fd);
+            }
+            nx_tcp_socket_disconnect(&relaySocket, TEST_WAIT);
+        }
+        nx_tcp_server_socket_unaccept(&relaySocket);
+        nx_tcp_server_socket_relisten(&testIp, TEST_TLS_PORT, &relaySocket);
+    }
+}
+
+static NX_PACKET *sendPacket;
+static UINT sendStatus;
+static uint32_t sendStack;
+
+static void tls_send(void *argument)
+{
+    NX_PARAMETER_NOT_USED(argument);
+    sendStatus = nx_secure_tls_session_send(&tlsSession, sendPacket, TEST_WAIT);
+}
+
+/* One connection as the MQTT client makes it: session set up, started, one
+   line exchanged, ended and deleted. The handshake time in us, 0 on failure */
+static uint64_t tls_connect(unsigned short port, ULONG *handshakeBytes)
+{
+    static const char message[] = TEST_MESSAGE;
+    UCHAR reply[sizeof(message)];
+    NX_PACKET *packet;
+    ULONG length = 0;
+    uint64_t start;
+    uint64_t elapsed = 0;
+    uint32_t stack;
+
+    relayPort = port;
+    relayToServer = 0;
+    relayToClient = 0;
+
+    if (_nx_secure_tls_session_create_ext(&tlsSession,
+                                          _nx_azure_iot_tls_supported_crypto,
+                                          _nx_azure_iot_tls_supported_crypto_size,
+                                          _nx_azure_iot_tls_ciphersuite_map,
+                                          _nx_azure_iot_tls_ciphersuite_map_size,
+                                          (UCHAR *)tlsMetadata, sizeof(tlsMetadata)) != NX_SUCCESS)
+    {
+        return 0;
+    }
+    nx_secure_tls_trusted_certificate_add(&tlsSession, &trustedCert);
+    nx_secure_tls_session_packet_buffer_set(&tlsSession, tlsPacketBuffer, sizeof(tlsPacketBuffer));
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(&tlsSession, &tlsResume) == NX_SUCCESS);
+
+    if (nx_tcp_client_socket_bind(&clientSocket, NX_ANY_PORT, NX_NO_WAIT) == NX_SUCCESS)
+    {
+        if (nx_tcp_client_socket_connect(&clientSocket, TEST_IP_ADDRESS, TEST_TLS_PORT, TEST_WAIT) == NX_SUCCESS)
+        {
+            start = SYS_TIME_Counter64Get();
+            if (nx_secure_tls_session_start(&tlsSession, &clientSocket, TEST_WAIT) == NX_SUCCESS)
+            {
+                elapsed = SYS_TIME_Counter64Get() - start;
+                *handshakeBytes = relayToServer + relayToClient;
+
+                /* The server sends the line back reversed */
+                HOST_TEST_CHECK(nx_secure_tls_packet_allocate(&tlsSession, &txPool, &packet, TEST_WAIT) == NX_SUCCESS);
+                HOST_TEST_CHECK(nx_packet_data_append(packet, (VOID *)message, sizeof(message) - 1,
+                                                      &txPool, TEST_WAIT) == NX_SUCCESS);
+                sendPacket = packet;
+                stack = HOST_STACK_used(tls_send, NX_NULL) - HOST_STACK_used(NX_NULL, NX_NULL);
+                sendStack = (stack > sendStack) ? stack : sendStack;
+                HOST_TEST_CHECK(sendStatus == NX_SUCCESS);
+                HOST_TEST_CHECK(nx_secure_tls_session_receive(&tlsSession, &packet, TEST_WAIT) == NX_SUCCESS);
+                nx_packet_data_retrieve(packet, reply, &length);
+                nx_packet_release(packet);
+                HOST_TEST_CHECK(length == sizeof(TEST_REPLY) - 1);
+                HOST_TEST_CHECK(memcmp(reply, TEST_REPLY, sizeof(TEST_REPLY) - 1) == 0);
+
+                nx_secure_tls_session_end(&tlsSession, TEST_WAIT);
+            }
+            nx_tcp_socket_disconnect(&clientSocket, TEST_WAIT);
+        }
+        nx_tcp_client_socket_unbind(&clientSocket);
+    }
+    nx_secure_tls_session_delete(&tlsSession);
+    return elapsed;
+}
+
+static void test_parameters(void)
+{
+    NX_SECURE_TLS_SESSION session;
+    NX_SECURE_TLS_RESUME resume;
+
+    memset(&session, 0, sizeof(session));
+    memset(&resume, 0, sizeof(resume));
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(NX_NULL, &resume) == NX_PTR_ERROR);
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(&session, &resume) == NX_SECURE_TLS_SESSION_UNINITIALIZED);
+
+    HOST_TEST_CHECK(_nx_secure_tls_session_create_ext(&session,
+                                                      _nx_azure_iot_tls_supported_crypto,
+                                                      _nx_azure_iot_tls_supported_crypto_size,
+                                                      _nx_azure_iot_tls_ciphersuite_map,
+                                                      _nx_azure_iot_tls_ciphersuite_map_size,
+                                                      (UCHAR *)tlsMetadata, sizeof(tlsMetadata)) == NX_SUCCESS);
+    resume.nx_secure_tls_resume_session_id_length = NX_SECURE_TLS_RESUME_SESSION_ID_SIZE + 1;
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(&session, &resume) == NX_INVALID_PARAMETERS);
+    resume.nx_secure_tls_resume_session_id_length = 0;
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(&session, &resume) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_secure_tls_session_resume_set(&session, NX_NULL) == NX_SUCCESS);
+    nx_secure_tls_session_delete(&session);
+}
+
+static void test_resume(void)
+{
+    ULONG fullBytes = 0;
+    ULONG resumedBytes = 0;
+    ULONG fallbackBytes = 0;
+    uint64_t full;
+    uint64_t resumed;
+    uint64_t fallback;
+
+    HOST_TEST_CHECK(nx_secure_x509_certificate_initialize(&trustedCert, certDer, (USHORT)certDerLength,
+                                                          NX_NULL, 0, NX_NULL, 0,
+                                                          NX_SECURE_X509_KEY_TYPE_NONE) == NX_SUCCESS);
+    HOST_TEST_CHECK(nx_tcp_socket_create(&testIp, &clientSocket, "client socket", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+                                         0x80, TEST_WINDOW_SIZE, NX_NULL, NX_NULL) == NX_SUCCESS);
+
+    /* Nothing cached: full handshake, the session is stored */
+    full = tls_connect(serverPort[0], &fullBytes);
+    HOST_TEST_CHECK(full != 0);
+    HOST_TEST_CHECK(tlsResume.nx_secure_tls_resume_misses == 1 && tlsResume.nx_secure_tls_resume_hits == 0);
+    HOST_TEST_CHECK(tlsResume.nx_secure_tls_resume_session_id_length == NX_SECURE_TLS_RESUME_SESSION_ID_SIZE);
+
+    /* The server resumes it */
+    resumed = tls_connect(serverPort[0], &resumedBytes);
+    HOST_TEST_CHECK(resumed != 0);
+    HOST_TEST_CHECK(tlsResume.nx_secure_tls_resume_misses == 1 && tlsResume.nx_secure_tls_resume_hits == 1);
+
+    /* A server without the session: full handshake again */
+    fallback = tls_connect(serverPort[1], &fallbackBytes);
+    HOST_TEST_CHECK(fallback != 0);
+    HOST_TEST_CHECK(tlsResume.nx_secure_tls_resume_misses == 2 && tlsResume.nx_secure_tls_resume_hits == 1);
+
+    printf("tls resume: full handshake %llu us %lu bytes, resumed %llu us %lu bytes, fallback %llu us %lu bytes\n",
+           (unsigned long long)full, fullBytes, (unsigned long long)resumed, resumedBytes,
+           (unsigned long long)fallback, fallbackBytes);
+    printf("tls resume: application data record send %u stack bytes\n", sendStack);
+}
+
+static void test_entry(ULONG input)
+{
+    ULONG status = 0;
+
+    HOST_TEST_CHECK(nx_ip_status_check(&testIp, NX_IP_ADDRESS_RESOLVED, &status, TEST_WAIT) == NX_SUCCESS);
+
+    test_parameters();
+    test_resume();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_secure_tls_initialize();
+    nx_packet_pool_create(&txPool, "tx pool", TEST_PACKET_SIZE, txPoolArea, sizeof(txPoolArea));
+    nx_packet_pool_create(&rxPool, "rx pool", TEST_PACKET_SIZE, rxPoolArea, sizeof(rxPoolArea));
+    nx_driver_rx_packet_pool_set(&rxPool);
+    HOST_TEST_CHECK(nx_ip_create(&testIp, "test ip", TEST_IP_ADDRESS, 0xFFFFFF00UL, &txPool, nx_driver_harmony,
+                                 ipStack, sizeof(ipStack), NX_DEMO_IP_THREAD_PRIORITY) == NX_SUCCESS);
+    nx_arp_enable(&testIp, arpCache, sizeof(arpCache));
+    nx_tcp_enable(&testIp);
+
+    tx_thread_create(&relayThread, "relay", relay_entry, 0, relayStack, sizeof(relayStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    /* The servers are host processes, started before the kernel takes over */
+    serverPort[0] = (unsigned short)(20000 + getpid() % 20000);
+    serverPort[1] = serverPort[0] + 1;
+    atexit(servers_stop);
+    if (!certificate_create() || !server_start(0, true) || !server_start(1, false))
+    {
+        fprintf(stderr, "cannot start the OpenSSL test servers\n");
+        return 1;
+    }
+
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,545 @@
+/*******************************************************************************
+  Host Unit Test
+
+  File Name:
+    test_twin_parse.c
+
+  Summary:
+    Device twin parser of the sample over twin documents split into packets.
+
+  Description:
+    Twin documents shaped as IoT Hub sends them to the sample, the full
+    document fetched on connect and desired properties patches, are laid
+    out over NX_PACKET chains cut at every packet size the json reader
+    takes, down to one byte per packet. sample_twin_desired_parse must apply
+    the same writable properties, with the same acknowledgements and
+    $version, however the document is cut. Nested values, the reported
+    section, unknown and over-long names and values out of range or of the
+    wrong type are part of the documents. A chain longer than the reader
+    takes is refused.
+
+    The documents are then mutated at random, bytes replaced, dropped,
+    repeated or cut, and parsed on random chains: whatever the parser
+    returns, a value it sets must be in range and acknowledged.
+
+    The time and stack of a full document parse are printed, with the part
+    of the stack taken by the C library's sscanf, which converts doubles.
+*******************************************************************************/
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "definitions.h"
+#include "nx_api.h"
+#include "nx_azure_iot.h"
+#include "sample_twin.h"
+#include "host_test.h"
+#include "host_stack.h"
+
+#define TEST_STACK_SIZE         16384
+#define TEST_PACKET_SIZE        1536
+#define TEST_POOL_PACKETS       (NX_AZURE_IOT_READER_MAX_LIST + 8)
+#define TEST_DOCUMENT_MAX       1400
+#define TEST_FUZZ_RUNS          200000
+#define TEST_ITERATIONS         20000
+#define TEST_LED_MODES          4
+
+TX_BYTE_POOL byte_pool_0;
+
+static TX_THREAD testThread;
+static NX_PACKET_POOL testPool;
+static ULONG testStack[TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG poolArea[(TEST_PACKET_SIZE + sizeof(NX_PACKET)) * TEST_POOL_PACKETS / sizeof(ULONG)];
+static UCHAR mutated[TEST_DOCUMENT_MAX];
+static uint32_t randomState = 0x12345678;
+
+// *****************************************************************************
+// The writable properties of the sample, the values they were set to
+
+#define TEST_FIELD_COUNT        4
+
+static const CHAR *testFieldNames[TEST_FIELD_COUNT] =
+{
+    "WFI32IoT_temperature",
+    "ALT2_pressure",
+    "PHT_humidity",
+    "VAV_pressure",
+};
+
+typedef struct
+{
+    UINT set;                   /* One bit per index */
+    double values[TEST_FIELD_COUNT];
+} TEST_VALUES;
+
+static TEST_VALUES testValues[5];
+
+static const CHAR *test_field_name(UINT field)
+{
+    return testFieldNames[field];
+}
+
+static VOID test_set(UINT property, UINT index, double value)
+{
+    testValues[property].set |= 1u << index;
+    testValues[property].values[index] = value;
+}
+
+static VOID test_interval_set(UINT index, double value)       { test_set(0, index, value); }
+static VOID test_led_set(UINT index, double value)            { test_set(1, index, value); }
+static VOID test_heartbeat_set(UINT index, double value)      { test_set(2, index, value); }
+static VOID test_deadband_set(UINT index, double value)       { test_set(3, index, value); }
+static VOID test_deadband_percent_set(UINT index, double value) { test_set(4, index, value); }
+
+static double test_get(UINT index)
+{
+    NX_PARAMETER_NOT_USED(index);
+    return 0;
+}
+
+/* As sample_azure_iot_embedded_sdk.c has them */
+static const SAMPLE_TWIN_PROPERTY testProperties[] =
+{
+    {"telemetryInterval",  NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, 86400, 0, test_interval_set, test_get},
+    {"led_y",              NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, TEST_LED_MODES - 1, 0, test_led_set, test_get},
+    {"telemetryHeartbeat", NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, 86400, 0, test_heartbeat_set, test_get},
+    {"_deadband",          NX_TRUE,  SAMPLE_TWIN_TYPE_DOUBLE,  0, FLT_MAX, 4, test_deadband_set, test_get},
+    {"_deadbandPercent",   NX_TRUE,  SAMPLE_TWIN_TYPE_DOUBLE,  0, 100, 2, test_deadband_percent_set, test_get},
+};
+#define TEST_PROPERTY_COUNT     (sizeof(testProperties) / sizeof(testProperties[0]))
+
+static const SAMPLE_TWIN_TABLE testTable =
+{
+    testProperties, TEST_PROPERTY_COUNT, TEST_FIELD_COUNT, test_field_name
+};
+
+// *****************************************************************************
+// Twin documents
+
+typedef struct
+{
+    const char *name;
+    UINT full;
+    const char *json;
+    UINT status;                /* Of the parse */
+    ULONG version;
+    ULONG accepted[TEST_PROPERTY_COUNT];
+    ULONG rejected[TEST_PROPERTY_COUNT];
+    double values[TEST_PROPERTY_COUNT][TEST_FIELD_COUNT];
+} TEST_DOCUMENT;
+
+static const TEST_DOCUMENT testDocuments[] =
+{
+    {
+        "full, as on first connect", NX_TRUE,
+        "{\"desired\":{\"telemetryInterval\":10,\"$version\":1},\"reported\":{\"$version\":1}}",
+        NX_AZURE_IOT_SUCCESS, 1, { 1 }, { 0 }, { { 10 } },
+    },
+    {
+        "full, acknowledged and reported properties", NX_TRUE,
+        "{\"desired\":{\"telemetryInterval\":30,\"led_y\":2,\"telemetryHeartbeat\":900,"
+        "\"WFI32IoT_temperature_deadband\":0.25,\"ALT2_pressure_deadbandPercent\":1.5,"
+        "\"VAV_pressure_deadband\":0.0125,\"$version\":17},"
+        "\"reported\":{\"led_r\":1,\"led_g\":3,"
+        "\"telemetryInterval\":{\"ac\":200,\"av\":16,\"ad\":\"Property updated\",\"value\":60},"
+        "\"led_y\":{\"ac\":200,\"av\":16,\"value\":1},"
+        "\"telemetryHeartbeat\":{\"ac\":200,\"av\":16,\"value\":600},"
+        "\"WFI32IoT_temperature_deadband\":{\"ac\":200,\"av\":16,\"value\":0.5},"
+        "\"ALT2_pressure_deadbandPercent\":{\"ac\":400,\"av\":15,\"ad\":\"Invalid value\",\"value\":0},"
+        "\"serialNumber\":\"0123ABCDEF\",\"firmware\":{\"version\":\"3.1.0\",\"build\":[2026,10,17]},"
+        "\"ipAddress\":\"192.168.1.37\",\"$version\":248}}",
+        NX_AZURE_IOT_SUCCESS, 17, { 1, 1, 1, (1 << 0) | (1 << 3), 1 << 1 }, { 0 },
+        { { 30 }, { 2 }, { 900 }, { 0.25, 0, 0, 0.0125 }, { 0, 1.5 } },
+    },
+    {
+        "full, reported section first", NX_TRUE,
+        "{\"reported\":{\"led_r\":1,\"telemetryInterval\":{\"ac\":200,\"av\":3,\"value\":5},\"$version\":9},"
+        "\"desired\":{\"$version\":4,\"led_y\":3}}",
+        NX_AZURE_IOT_SUCCESS, 4, { 0, 1 }, { 0 }, { { 0 }, { 3 } },
+    },
+    {
+        "patch", NX_FALSE,
+        "{\"telemetryInterval\":5,\"$version\":18}",
+        NX_AZURE_IOT_SUCCESS, 18, { 1 }, { 0 }, { { 5 } },
+    },
+    {
+        "patch, nested, unknown and over-long names", NX_FALSE,
+        "{\"thermostat\":{\"targetTemperature\":21.5,\"modes\":[\"eco\",{\"night\":true}]},"
+        "\"PHT_humidity_deadband\":2,"
+        "\"WFI32IoT_temperature_deadbandPercentWithAFarTooLongNameForTheTable\":5,"
+        "\"humidity_deadband\":3,\"_deadband\":4,"
+        "\"escaped\\u0022name\":1,\"led_y\":1,\"$version\":19}",
+        NX_AZURE_IOT_SUCCESS, 19, { 0, 1, 0, 1 << 2 }, { 0 }, { { 0 }, { 1 }, { 0 }, { 0, 0, 2 } },
+    },
+    {
+        "patch, rejected values", NX_FALSE,
+        "{\"telemetryInterval\":-1,\"led_y\":4,\"telemetryHeartbeat\":\"900\",\"VAV_pressure_deadband\":-0.5,"
+        "\"ALT2_pressure_deadbandPercent\":100.5,\"PHT_humidity_deadbandPercent\":null,"
+        "\"WFI32IoT_temperature_deadband\":1e3,\"$version\":20}",
+        NX_AZURE_IOT_SUCCESS, 20, { 0, 0, 0, 1 << 0 }, { 1, 1, 1, 1 << 3, (1 << 1) | (1 << 2) },
+        { { 0 }, { 0 }, { 0 }, { 1000 } },
+    },
+    {
+        "patch, last value of a repeated property", NX_FALSE,
+        "{\"led_y\":9,\"led_y\":2,\"telemetryInterval\":86401,\"telemetryInterval\":60,\"$version\":21}",
+        NX_AZURE_IOT_SUCCESS, 21, { 1, 1 }, { 0 }, { { 60 }, { 2 } },
+    },
+    {
+        "full, no desired section", NX_TRUE,
+        "{\"reported\":{\"led_r\":1,\"$version\":2}}",
+        NX_AZURE_IOT_NOT_FOUND, 0, { 0 }, { 0 }, { { 0 } },
+    },
+    {
+        "patch, truncated", NX_FALSE,
+        "{\"telemetryInterval\":15,\"led_y\":",
+        NX_AZURE_IOT_SDK_CORE_ERROR, 0, { 1 }, { 0 }, { { 15 } },
+    },
+};
+#define TEST_DOCUMENT_COUNT     (sizeof(testDocuments) / sizeof(testDocuments[0]))
+
+// *****************************************************************************
+
+static uint32_t test_random(void)
+{
+    /* xorshift32 */
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/* The document over a chain of packets of the given sizes, the last one
+   taking the rest */
+static NX_PACKET *chain_build(const UCHAR *json, UINT length, const UINT *sizes, UINT count)
+{
+    NX_PACKET *head = NX_NULL;
+    NX_PACKET *last = NX_NULL;
+    NX_PACKET *packet;
+    UINT size;
+    UINT i;
+
+    for (i = 0; i < count; i++)
+    {
+        size = (i + 1 < count) ? sizes[i] : length;
+        if (nx_packet_allocate(&testPool, &packet, NX_RECEIVE_PACKET, NX_NO_WAIT) != NX_SUCCESS)
+        {
+            HOST_TEST_CHECK(0);
+            break;
+        }
+        memcpy(packet->nx_packet_prepend_ptr, json, size);
+        packet->nx_packet_append_ptr = packet->nx_packet_prepend_ptr + size;
+        json += size;
+        length -= size;
+        if (head == NX_NULL)
+        {
+            head = packet;
+        }
+        else
+        {
+            last->nx_packet_next = packet;
+        }
+        last = packet;
+        head->nx_packet_length += size;
+    }
+    if (head != NX_NULL)
+    {
+        head->nx_packet_last = last;
+    }
+    return head;
+}
+
+/* Sizes of count packets holding length bytes, as even as can be */
+static void chain_even(UINT length, UINT count, UINT *sizes)
+{
+    UINT i;
+
+    for (i = 0; i < count; i++)
+    {
+        sizes[i] = length / count + (i < length % count);
+    }
+}
+
+/* Sizes of 1 to NX_AZURE_IOT_READER_MAX_LIST packets at random */
+static UINT chain_random(UINT length, UINT *sizes)
+{
+    UINT count = 1 + test_random() % NX_AZURE_IOT_READER_MAX_LIST;
+    UINT left = length;
+    UINT i;
+
+    for (i = 0; i + 1 < count; i++)
+    {
+        sizes[i] = left ? test_random() % (left + 1) : 0;
+        left -= sizes[i];
+    }
+    sizes[count - 1] = left;
+    return count;
+}
+
+static UINT document_parse(const TEST_DOCUMENT *document, const UCHAR *json, UINT length,
+                           const UINT *sizes, UINT count, SAMPLE_TWIN_ACKS *acks, ULONG *version)
+{
+    NX_PACKET *packet;
+    UINT status;
+
+    memset(testValues, 0, sizeof(testValues));
+    memset(acks, 0, sizeof(*acks));
+    *version = 0;
+    if ((packet = chain_build(json, length, sizes, count)) == NX_NULL)
+    {
+        return NX_NOT_SUCCESSFUL;
+    }
+    status = sample_twin_desired_parse(&testTable, packet, document->full, acks, version);
+    nx_packet_release(packet);
+    return status;
+}
+
+static int document_check(const TEST_DOCUMENT *document, UINT status, const SAMPLE_TWIN_ACKS *acks, ULONG version)
+{
+    UINT property;
+    UINT index;
+    int ok = (status == document->status) && (version == document->version);
+
+    for (property = 0; property < TEST_PROPERTY_COUNT; property++)
+    {
+        ok &= (acks->accepted[property] == document->accepted[property]);
+        ok &= (acks->rejected[property] == document->rejected[property]);
+        ok &= (testValues[property].set == document->accepted[property]);
+        for (index = 0; index < TEST_FIELD_COUNT; index++)
+        {
+            if (document->accepted[property] & (1u << index))
+            {
+                ok &= (fabs(testValues[property].values[index] - document->values[property][index]) <=
+                       1e-9 * fabs(document->values[property][index]));
+            }
+        }
+    }
+    return ok;
+}
+
+static void test_documents(void)
+{
+    UINT sizes[NX_AZURE_IOT_READER_MAX_LIST + 1];
+    SAMPLE_TWIN_ACKS acks;
+    ULONG version;
+    UINT status;
+    UINT length;
+    UINT count;
+    UINT d;
+
+    for (d = 0; d < TEST_DOCUMENT_COUNT; d++)
+    {
+        const TEST_DOCUMENT *document = &testDocuments[d];
+        int failures = 0;
+
+        length = strlen(document->json);
+        HOST_TEST_CHECK(length <= TEST_DOCUMENT_MAX);
+
+        /* Every packet count the reader takes, and cuts at every offset */
+        for (count = 1; count <= NX_AZURE_IOT_READER_MAX_LIST; count++)
+        {
+            chain_even(length, count, sizes);
+            status = document_parse(document, (const UCHAR *)document->json, length, sizes, count, &acks, &version);
+            failures += !document_check(document, status, &acks, version);
+        }
+        for (sizes[0] = 0; sizes[0] <= length; sizes[0]++)
+        {
+            chain_even(length - sizes[0], 2, &sizes[1]);
+            status = document_parse(document, (const UCHAR *)document->json, length, sizes, 3, &acks, &version);
+            failures += !document_check(document, status, &acks, version);
+        }
+        if (failures)
+        {
+            fprintf(stderr, "%s: %d chains parsed wrong\n", document->name, failures);
+        }
+        HOST_TEST_CHECK(failures == 0);
+    }
+
+    /* One packet more than the reader takes */
+    length = strlen(testDocuments[1].json);
+    chain_even(length, NX_AZURE_IOT_READER_MAX_LIST + 1, sizes);
+    HOST_TEST_CHECK(document_parse(&testDocuments[1], (const UCHAR *)testDocuments[1].json, length, sizes,
+                                   NX_AZURE_IOT_READER_MAX_LIST + 1, &acks, &version) ==
+                    NX_AZURE_IOT_INSUFFICIENT_BUFFER_SPACE);
+    HOST_TEST_CHECK(testValues[0].set == 0);
+}
+
+/* A document with bytes replaced, dropped, repeated or cut */
+static UINT document_mutate(const char *json)
+{
+    static const char alphabet[] = "{}[]\":,.-+eE0123456789 \\tnulfrsa$_";
+    UINT length = strlen(json);
+    UINT mutations = 1 + test_random() % 4;
+    UINT offset;
+    UINT size;
+
+    memcpy(mutated, json, length);
+    while (mutations--)
+    {
+        if (length == 0)
+        {
+            break;
+        }
+        offset = test_random() % length;
+        switch (test_random() % 4)
+        {
+            case 0:
+                mutated[offset] = (test_random() & 1) ? alphabet[test_random() % (sizeof(alphabet) - 1)]
+                                                      : (UCHAR)test_random();
+                break;
+            case 1:
+                size = 1 + test_random() % (length - offset);
+                memmove(&mutated[offset], &mutated[offset + size], length - offset - size);
+                length -= size;
+                break;
+            case 2:
+                size = 1 + test_random() % (length - offset);
+                if (length + size <= sizeof(mutated))
+                {
+                    memmove(&mutated[offset + size], &mutated[offset], length - offset);
+                    length += size;
+                }
+                break;
+            default:
+                length = offset;
+                break;
+        }
+    }
+    return length;
+}
+
+static void test_fuzz(void)
+{
+    UINT sizes[NX_AZURE_IOT_READER_MAX_LIST];
+    SAMPLE_TWIN_ACKS acks;
+    ULONG version;
+    UINT property;
+    UINT index;
+    UINT length;
+    UINT count;
+    UINT run;
+    int failures = 0;
+
+    for (run = 0; run < TEST_FUZZ_RUNS; run++)
+    {
+        const TEST_DOCUMENT *document = &testDocuments[test_random() % TEST_DOCUMENT_COUNT];
+
+        length = document_mutate(document->json);
+        count = chain_random(length, sizes);
+        document_parse(document, mutated, length, sizes, count, &acks, &version);
+
+        /* Accepted values were set and are in range. A property repeated in
+           the document can be set, then rejected */
+        for (property = 0; property < TEST_PROPERTY_COUNT; property++)
+        {
+            failures += (acks.accepted[property] & ~testValues[property].set) != 0;
+            failures += ((acks.accepted[property] | acks.rejected[property]) >> TEST_FIELD_COUNT) != 0;
+            failures += (acks.accepted[property] & acks.rejected[property]) != 0;
+            for (index = 0; index < TEST_FIELD_COUNT; index++)
+            {
+                if (testValues[property].set & (1u << index))
+                {
+                    failures += (testValues[property].values[index] < testProperties[property].min) ||
+                                (testValues[property].values[index] > testProperties[property].max);
+                }
+            }
+        }
+    }
+    HOST_TEST_CHECK(failures == 0);
+    HOST_TEST_CHECK(testPool.nx_packet_pool_available == testPool.nx_packet_pool_total);
+}
+
+static NX_PACKET *speedPacket;
+
+static void speed_parse(void *argument)
+{
+    SAMPLE_TWIN_ACKS acks;
+    ULONG version = 0;
+
+    NX_PARAMETER_NOT_USED(argument);
+    memset(&acks, 0, sizeof(acks));
+    sample_twin_desired_parse(&testTable, speedPacket, NX_TRUE, &acks, &version);
+}
+
+/* az_json_token_get_double converts with the C library's sscanf, which
+   the target does with its own library */
+static void speed_sscanf(void *argument)
+{
+    double value;
+
+    NX_PARAMETER_NOT_USED(argument);
+    sscanf("21.5", "%lf", &value);
+}
+
+static void test_speed(void)
+{
+    const TEST_DOCUMENT *document = &testDocuments[1];
+    UINT length = strlen(document->json);
+    UINT sizes[NX_AZURE_IOT_READER_MAX_LIST];
+    uint64_t elapsed[2];
+    uint32_t stack = 0;
+    uint32_t library;
+    UINT counts[2] = { 1, NX_AZURE_IOT_READER_MAX_LIST };
+    UINT run;
+    UINT i;
+
+    for (i = 0; i < 2; i++)
+    {
+        chain_even(length, counts[i], sizes);
+        speedPacket = chain_build((const UCHAR *)document->json, length, sizes, counts[i]);
+        elapsed[i] = test_now_ns();
+        for (run = 0; run < TEST_ITERATIONS; run++)
+        {
+            speed_parse(NX_NULL);
+        }
+        elapsed[i] = test_now_ns() - elapsed[i];
+        if (i == 0)
+        {
+            stack = HOST_STACK_used(speed_parse, NX_NULL) - HOST_STACK_used(NX_NULL, NX_NULL);
+        }
+        nx_packet_release(speedPacket);
+    }
+    library = HOST_STACK_used(speed_sscanf, NX_NULL) - HOST_STACK_used(NX_NULL, NX_NULL);
+
+    printf("twin parse: %u byte full document, %llu ns in 1 packet, %llu ns in %u packets, "
+           "%u stack bytes, %u of them in sscanf\n",
+           length, (unsigned long long)(elapsed[0] / TEST_ITERATIONS),
+           (unsigned long long)(elapsed[1] / TEST_ITERATIONS), counts[1], stack, library);
+}
+
+static void test_entry(ULONG input)
+{
+    test_documents();
+    test_fuzz();
+    test_speed();
+    exit(HOST_TEST_RESULT());
+}
+
+void tx_application_define(void *first_unused_memory)
+{
+    tx_byte_pool_create(&byte_pool_0, "byte pool 0", first_unused_memory, TX_LINUX_MEMORY_SIZE);
+
+    nx_system_initialize();
+    nx_packet_pool_create(&testPool, "test pool", TEST_PACKET_SIZE, poolArea, sizeof(poolArea));
+    tx_thread_create(&testThread, "test", test_entry, 0, testStack, sizeof(testStack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int main(void)
+{
+    tx_kernel_enter();
+    return 1;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -211,6 +211,8 @@ char default_primary_key[128]     =   "mujHRQMx8dUsZETtlWxSonGZ24++L69c8KjIvZDT+
 extern uint8_t* _WDRV_PIC32MZW_Task_Stk_Ptr;
 
 extern APP_CONNECT_STATUS appConnectStatus;
+/* Lets the Azure IoT sample hold off hub reconnects while Wi-Fi is down */
+extern void sample_wifi_notify(void);
 
 // *****************************************************************************
 // *****************************************************************************
@@ -260,11 +262,13 @@ static void wifiConnectCallback(DRV_HANDLE handle, WDRV_PIC32MZW_ASSOC_HANDLE as
     switch (currentState) {
         case WDRV_PIC32MZW_CONN_STATE_DISCONNECTED:
             appConnectStatus.wifi = false;
+            sample_wifi_notify();
             SYS_CONSOLE_MESSAGE("WiFi Reconnecting\r\n");            
             app_pic32mz_w1Data.appPic32mzW1State = APP_STATE_RECONNECT;
             break;
         case WDRV_PIC32MZW_CONN_STATE_CONNECTED:
             appConnectStatus.wifi = true;            
+            sample_wifi_notify();
             GPIO_RA14_Clear();
 #ifdef WFI32_IoT_BOARD            
             GPIO_RA13_Set();
@@ -277,6 +281,7 @@ static void wifiConnectCallback(DRV_HANDLE handle, WDRV_PIC32MZW_ASSOC_HANDLE as
             break;
         case WDRV_PIC32MZW_CONN_STATE_FAILED:
             appConnectStatus.wifi = false;
+            sample_wifi_notify();
             SYS_CONSOLE_MESSAGE("WiFi connection failed\r\n");
             app_pic32mz_w1Data.appPic32mzW1State = APP_STATE_RECONNECT;        
             break;
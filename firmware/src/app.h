@@ -55,6 +55,10 @@
 #include "app_sensors.h"
 #include "app_status.h"
 #include "app_switch.h"
+#include "app_journal.h"
+#include "app_identity.h"
+#include "app_format.h"
+#include "app_clock.h"
 #include "az_util.h"
 
 #ifdef CLICK_ALTITUDE2
@@ -0,0 +1,120 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include "app_aggregate.h"
+
+#define APP_AGGREGATE_ONE               (1L << APP_AGGREGATE_FRAC_BITS)
+#define APP_AGGREGATE_LIMIT             (INT32_MAX >> APP_AGGREGATE_FRAC_BITS)
+
+/* Saturates to the Q19.12 range, rounds to nearest */
+static int32_t APP_AGGREGATE_toFixed(float value)
+{
+    if (value >= APP_AGGREGATE_LIMIT)
+    {
+        return APP_AGGREGATE_LIMIT * APP_AGGREGATE_ONE;
+    }
+    if (value <= -APP_AGGREGATE_LIMIT)
+    {
+        return -APP_AGGREGATE_LIMIT * APP_AGGREGATE_ONE;
+    }
+    value *= APP_AGGREGATE_ONE;
+    return (int32_t)((value < 0) ? (value - 0.5f) : (value + 0.5f));
+}
+
+static float APP_AGGREGATE_toFloat(int64_t value)
+{
+    return (float)value / APP_AGGREGATE_ONE;
+}
+
+void APP_AGGREGATE_reset(APP_AGGREGATE_WINDOW *window)
+{
+    window->count = 0;
+    window->offset = 0;
+    window->min = INT32_MAX;
+    window->max = INT32_MIN;
+    window->sum = 0;
+    window->sumSquares = 0;
+}
+
+void APP_AGGREGATE_add(APP_AGGREGATE_WINDOW *window, float value)
+{
+    int32_t sample;
+    int64_t delta;
+
+    if (window->count >= APP_AGGREGATE_SAMPLES_MAX)
+    {
+        return;
+    }
+
+    sample = APP_AGGREGATE_toFixed(value);
+    if (window->count == 0)
+    {
+        window->offset = sample;
+    }
+    if (sample < window->min)
+    {
+        window->min = sample;
+    }
+    if (sample > window->max)
+    {
+        window->max = sample;
+    }
+
+    delta = (int64_t)sample - window->offset;
+    if (delta > APP_AGGREGATE_DELTA_MAX)
+    {
+        delta = APP_AGGREGATE_DELTA_MAX;
+    }
+    else if (delta < -APP_AGGREGATE_DELTA_MAX)
+    {
+        delta = -APP_AGGREGATE_DELTA_MAX;
+    }
+    window->sum += delta;
+    window->sumSquares += delta * delta;
+    window->count++;
+}
+
+bool APP_AGGREGATE_summary(const APP_AGGREGATE_WINDOW *window, APP_AGGREGATE_SUMMARY *summary)
+{
+    int64_t count = window->count;
+    int64_t quotient;
+    int64_t remainder;
+    int64_t squares;
+
+    if (count == 0)
+    {
+        return false;
+    }
+
+    /* sumSquares - sum^2 / count without forming sum^2: with
+       sum = quotient * count + remainder it is
+       sumSquares - quotient * sum - remainder * quotient - remainder^2 / count */
+    quotient = window->sum / count;
+    remainder = window->sum % count;
+    squares = window->sumSquares - quotient * window->sum - remainder * quotient -
+            (remainder * remainder) / count;
+    if (squares < 0)
+    {
+        squares = 0;
+    }
+
+    summary->count = window->count;
+    summary->min = APP_AGGREGATE_toFloat(window->min);
+    summary->max = APP_AGGREGATE_toFloat(window->max);
+    summary->mean = APP_AGGREGATE_toFloat(window->offset) +
+            (float)window->sum / window->count / APP_AGGREGATE_ONE;
+    summary->variance = (float)squares / window->count / APP_AGGREGATE_ONE / APP_AGGREGATE_ONE;
+
+    return true;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,93 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_aggregate.h
+
+  Summary:
+    Streaming min/max/mean/variance of a sensor value over a window.
+
+  Description:
+    Samples are converted to signed fixed-point with APP_AGGREGATE_FRAC_BITS
+    fractional bits and folded into a window in constant time and space, so a
+    sensor can be sampled much faster than telemetry is sent and only the
+    window summary has to go up.
+
+    The sums are kept relative to the first sample of the window, which keeps
+    them small for the usual slowly moving signal and avoids the cancellation
+    of the textbook sum of squares formula. The summary is converted back to
+    float only when it is taken.
+
+    A window is not thread safe, the caller serializes APP_AGGREGATE_add and
+    the reads of the window.
+*******************************************************************************/
+
+#ifndef _APP_AGGREGATE_H
+#define _APP_AGGREGATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+/* Q19.12: +/-524287 with a resolution of 0.00024 */
+#define APP_AGGREGATE_FRAC_BITS         (12)
+/* Samples beyond this are ignored until the window is reset, more than 10
+   minutes at 100 Hz */
+#define APP_AGGREGATE_SAMPLES_MAX       (65535)
+/* Largest distance from the first sample of the window, in Q19.12, that goes
+   into the mean and variance: +/-2048. 65535 squares of 2^23 stay below 2^62,
+   so neither the sum of squares nor the summary arithmetic overflows 64 bits.
+   It covers the pressure clicks in Pa and the temperatures; a sample further
+   out still sets min or max but is clamped to the bound for the mean and the
+   variance */
+#define APP_AGGREGATE_DELTA_MAX         (2048L << APP_AGGREGATE_FRAC_BITS)
+
+// *****************************************************************************
+
+typedef struct
+{
+    uint32_t count;
+    int32_t offset;         /* First sample of the window */
+    int32_t min;
+    int32_t max;
+    int64_t sum;            /* Of (sample - offset) */
+    int64_t sumSquares;     /* Of (sample - offset)^2 */
+} APP_AGGREGATE_WINDOW;
+
+typedef struct
+{
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float variance;         /* Population variance of the window */
+} APP_AGGREGATE_SUMMARY;
+
+// *****************************************************************************
+
+void APP_AGGREGATE_reset(APP_AGGREGATE_WINDOW *window);
+void APP_AGGREGATE_add(APP_AGGREGATE_WINDOW *window, float value);
+bool APP_AGGREGATE_summary(const APP_AGGREGATE_WINDOW *window, APP_AGGREGATE_SUMMARY *summary);
+
+#endif /* _APP_AGGREGATE_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
+
@@ -0,0 +1,127 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include "app_clock.h"
+#include "definitions.h"
+
+typedef struct
+{
+    bool synced;
+    uint64_t baseCounter;   /* SYS_TIME counter at the last sync */
+    uint64_t baseUs;        /* Unix time at baseCounter */
+    int32_t driftPpb;       /* Correction of the counter rate */
+    int64_t slewUs;         /* Offset slewed in from baseCounter on */
+    uint64_t slewSpanUs;    /* over this much time */
+} APP_CLOCK_STATE;
+
+static APP_CLOCK_STATE appClock;
+
+/* Unix time of a counter value under a copy of the state */
+static uint64_t APP_CLOCK_extrapolate(const APP_CLOCK_STATE *state, uint64_t counter, int64_t *elapsedUs)
+{
+    int64_t elapsed;
+    int64_t slew;
+
+    elapsed = (int64_t)((counter - state->baseCounter) / (SYS_TIME_FrequencyGet() / 1000000));
+    slew = state->slewUs;
+    if ((uint64_t)elapsed < state->slewSpanUs)
+    {
+        slew = slew * elapsed / (int64_t)state->slewSpanUs;
+    }
+    if (elapsedUs != NULL)
+    {
+        *elapsedUs = elapsed;
+    }
+
+    return state->baseUs + elapsed + (elapsed * state->driftPpb) / 1000000000 + slew;
+}
+
+static void APP_CLOCK_stateGet(APP_CLOCK_STATE *state)
+{
+    OSAL_CRITSECT_DATA_TYPE status;
+
+    status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    *state = appClock;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+}
+
+void APP_CLOCK_sync(uint64_t unixUs)
+{
+    OSAL_CRITSECT_DATA_TYPE status;
+    APP_CLOCK_STATE state;
+    uint64_t counter;
+    uint64_t localUs;
+    int64_t elapsedUs;
+    int64_t offsetUs;
+    int64_t drift;
+
+    APP_CLOCK_stateGet(&state);
+    counter = SYS_TIME_Counter64Get();
+    localUs = APP_CLOCK_extrapolate(&state, counter, &elapsedUs);
+    offsetUs = (int64_t)(unixUs - localUs);
+
+    if (!state.synced || (offsetUs > APP_CLOCK_STEP_US) || (offsetUs < -APP_CLOCK_STEP_US))
+    {
+        state.baseUs = unixUs;
+        state.slewUs = 0;
+        state.slewSpanUs = 0;
+    }
+    else
+    {
+        /* What the last slew did not absorb is the drift of the counter */
+        if (elapsedUs >= APP_CLOCK_DRIFT_MIN_INTERVAL_US)
+        {
+            drift = state.driftPpb + (offsetUs * 1000000000 / elapsedUs) / 2;
+            if (drift > APP_CLOCK_DRIFT_MAX_PPB)
+            {
+                drift = APP_CLOCK_DRIFT_MAX_PPB;
+            }
+            if (drift < -APP_CLOCK_DRIFT_MAX_PPB)
+            {
+                drift = -APP_CLOCK_DRIFT_MAX_PPB;
+            }
+            state.driftPpb = (int32_t)drift;
+        }
+
+        /* Continue from the current reading so the clock does not jump */
+        state.baseUs = localUs;
+        state.slewUs = offsetUs;
+        state.slewSpanUs = (uint64_t)((offsetUs < 0) ? -offsetUs : offsetUs) * 1000000 / APP_CLOCK_SLEW_PPM;
+    }
+    state.baseCounter = counter;
+    state.synced = true;
+
+    status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    appClock = state;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+}
+
+bool APP_CLOCK_isSynced(void)
+{
+    return appClock.synced;
+}
+
+uint64_t APP_CLOCK_unixUsGet(void)
+{
+    APP_CLOCK_STATE state;
+
+    APP_CLOCK_stateGet(&state);
+    if (!state.synced)
+    {
+        return 0;
+    }
+
+    return APP_CLOCK_extrapolate(&state, SYS_TIME_Counter64Get(), NULL);
+}
+
+int32_t APP_CLOCK_driftPpbGet(void)
+{
+    return appClock.driftPpb;
+}
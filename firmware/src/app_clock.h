@@ -0,0 +1,68 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_clock.h
+
+  Summary:
+    SNTP disciplined wall clock with sub-tick resolution.
+
+  Description:
+    Unix time is extrapolated from the 64 bit SYS_TIME counter (the core timer),
+    so readings are stamped to the microsecond instead of the 1 ms RTOS tick.
+
+    Every SNTP update disciplines the clock. An offset above APP_CLOCK_STEP_US
+    steps it, a smaller one is slewed in at APP_CLOCK_SLEW_PPM so the clock
+    never runs backwards. The residual offset left over after a slew is taken
+    as the drift of the crystal, which is estimated and corrected in parts per
+    billion between updates.
+
+    The clock is safe to read from any thread, APP_CLOCK_sync is called from
+    one thread only (the SNTP client).
+*******************************************************************************/
+
+#ifndef _APP_CLOCK_H
+#define _APP_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+/* Offsets above this step the clock instead of slewing it */
+#define APP_CLOCK_STEP_US               (1000000)
+/* Rate at which a smaller offset is slewed in, 500 us per second */
+#define APP_CLOCK_SLEW_PPM              (500)
+/* Drift estimates are limited to the tolerance of the crystal */
+#define APP_CLOCK_DRIFT_MAX_PPB         (200000)
+/* Updates closer together than this are too noisy for a drift estimate */
+#define APP_CLOCK_DRIFT_MIN_INTERVAL_US (60000000)
+
+// *****************************************************************************
+
+void APP_CLOCK_sync(uint64_t unixUs);
+bool APP_CLOCK_isSynced(void);
+/* Microseconds since the Unix epoch, 0 until the first sync */
+uint64_t APP_CLOCK_unixUsGet(void);
+int32_t APP_CLOCK_driftPpbGet(void);
+
+#endif /* _APP_CLOCK_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
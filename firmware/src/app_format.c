@@ -0,0 +1,126 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include "app_format.h"
+
+#define APP_FORMAT_MANTISSA_BITS        (23)
+#define APP_FORMAT_EXPONENT_BIAS        (127)
+/* 24 bit mantissa times 10^APP_FORMAT_DIGITS_MAX stays below 2^44, it can be
+   shifted left by up to 19 bits without overflowing 63 bits */
+#define APP_FORMAT_SHIFT_LEFT_MAX       (19)
+
+static const uint32_t APP_FORMAT_pow10[APP_FORMAT_DIGITS_MAX + 1] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000
+};
+
+size_t APP_FORMAT_fixed(char *buffer, size_t size, float value, uint8_t digits)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits;
+    uint32_t exponent;
+    uint64_t scaled;
+    uint64_t remainder;
+    uint64_t half;
+    int32_t shift;
+    char text[APP_FORMAT_FIXED_SIZE];
+    size_t count = 0;
+    size_t length;
+    size_t index;
+
+    if (digits > APP_FORMAT_DIGITS_MAX)
+    {
+        return 0;
+    }
+
+    bits.f = value;
+    exponent = (bits.u >> APP_FORMAT_MANTISSA_BITS) & 0xFF;
+    scaled = bits.u & ((1UL << APP_FORMAT_MANTISSA_BITS) - 1);
+    if (exponent == 0xFF)
+    {
+        /* Infinity or NaN */
+        return 0;
+    }
+    if (exponent == 0)
+    {
+        /* Subnormal */
+        shift = 1 - APP_FORMAT_EXPONENT_BIAS - APP_FORMAT_MANTISSA_BITS;
+    }
+    else
+    {
+        scaled |= (1UL << APP_FORMAT_MANTISSA_BITS);
+        shift = (int32_t)exponent - APP_FORMAT_EXPONENT_BIAS - APP_FORMAT_MANTISSA_BITS;
+    }
+
+    /* value * 10^digits = mantissa * 10^digits * 2^shift, exact in 64 bits */
+    scaled *= APP_FORMAT_pow10[digits];
+    if (shift >= 0)
+    {
+        if (shift > APP_FORMAT_SHIFT_LEFT_MAX)
+        {
+            return 0;
+        }
+        scaled <<= shift;
+    }
+    else if (shift > -64)
+    {
+        shift = -shift;
+        remainder = scaled & ((1ULL << shift) - 1);
+        half = 1ULL << (shift - 1);
+        scaled >>= shift;
+        /* Round half to even, like printf does on the exact binary value */
+        if ((remainder > half) || ((remainder == half) && (scaled & 1)))
+        {
+            scaled++;
+        }
+    }
+    else
+    {
+        /* Far below half of the last digit */
+        scaled = 0;
+    }
+
+    /* Digits in reverse, at least one integer digit */
+    do
+    {
+        if (count == digits && digits != 0)
+        {
+            text[count++] = '.';
+        }
+        text[count++] = (char)('0' + (scaled % 10));
+        scaled /= 10;
+    } while ((scaled != 0) || (count <= digits));
+
+    if (bits.u >> 31)
+    {
+        text[count++] = '-';
+    }
+
+    if (count >= size)
+    {
+        return 0;
+    }
+
+    length = count;
+    for (index = 0; index < length; index++)
+    {
+        buffer[index] = text[--count];
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+/*******************************************************************************
+ End of File
+ */
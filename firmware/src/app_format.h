@@ -0,0 +1,60 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_format.h
+
+  Summary:
+    Fixed-point decimal formatting of sensor values.
+
+  Description:
+    APP_FORMAT_fixed prints a single precision value with a fixed number of
+    fractional digits, the same text printf("%.*f") gives, using integer
+    arithmetic only. The value is split into its binary mantissa and
+    exponent, scaled by the power of ten exactly and rounded half to even on
+    the exact remainder, so no soft-float operation and no printf float
+    support is involved.
+
+    Values whose scaled magnitude does not fit 64 bits, infinities and NaN
+    are not formatted, the caller falls back to its generic path.
+*******************************************************************************/
+
+#ifndef _APP_FORMAT_H
+#define _APP_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+#define APP_FORMAT_DIGITS_MAX           (6)
+/* Sign, 20 integer digits, point, fractional digits and terminator */
+#define APP_FORMAT_FIXED_SIZE           (24 + APP_FORMAT_DIGITS_MAX)
+
+// *****************************************************************************
+
+/* Returns the length of the text written to buffer (terminated), 0 if the
+   value can not be formatted or does not fit */
+size_t APP_FORMAT_fixed(char *buffer, size_t size, float value, uint8_t digits);
+
+#endif /* _APP_FORMAT_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
+
@@ -0,0 +1,428 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include <string.h>
+#include "app_identity.h"
+
+#define APP_IDENTITY_PAGE_SIZE          DRV_SST26_PAGE_SIZE
+#define APP_IDENTITY_SECTOR_SIZE        DRV_SST26_ERASE_BUFFER_SIZE
+#define APP_IDENTITY_MAGIC              0x43535044  /* "DPSC" */
+#define APP_IDENTITY_MAGIC_INVALID      0x00000000
+
+#define APP_IDENTITY_FNV_OFFSET         0x811C9DC5
+#define APP_IDENTITY_FNV_PRIME          0x01000193
+
+/* Retries when the shared DRV_MEMORY request queue is full */
+#define APP_IDENTITY_QUEUE_RETRIES      50
+
+/* FAT layout: sector size of the media manager, the partition table and
+   the signature of sector 0, and the BPB fields of a volume boot sector */
+#define APP_IDENTITY_FS_SECTOR_SIZE     SYS_FS_MEDIA_MAX_BLOCK_SIZE
+#define APP_IDENTITY_MBR_PARTITION      446
+#define APP_IDENTITY_MBR_SIGNATURE      510
+#define APP_IDENTITY_BPB_SECTOR_SIZE    11
+#define APP_IDENTITY_BPB_SECTORS_16     19
+#define APP_IDENTITY_BPB_SECTORS_32     32
+
+#if (DRV_MEMORY_FS_RESERVED_SIZE < (APP_IDENTITY_AREA_SIZE + (2 * DRV_SST26_ERASE_BUFFER_SIZE)))
+#error "DRV_MEMORY_FS_RESERVED_SIZE must hold the identity sector and two journal sectors"
+#endif
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t key;           /* APP_IDENTITY_key of the provisioning configuration */
+    uint16_t hostnameLength;
+    uint16_t deviceIdLength;
+    uint32_t check;         /* FNV-1a of the entry, check excluded */
+    uint8_t hostname[APP_IDENTITY_HOSTNAME_MAX];
+    uint8_t deviceId[APP_IDENTITY_DEVICE_ID_MAX];
+} APP_IDENTITY_ENTRY;
+
+typedef enum
+{
+    APP_IDENTITY_OP_READ = 0,
+    APP_IDENTITY_OP_WRITE,
+    APP_IDENTITY_OP_ERASE,
+} APP_IDENTITY_OP;
+
+typedef struct
+{
+    DRV_HANDLE handle;
+    OSAL_SEM_DECLARE(xferSem);
+    volatile bool xferError;
+    uint32_t readBlockSize;
+    /* Byte address of the identity sector */
+    uint32_t address;
+    /* Byte address of the DRV_MEMORY_FS_RESERVED_SIZE area */
+    uint32_t reservedAddress;
+} APP_IDENTITY_DATA;
+
+static APP_IDENTITY_DATA appIdentity;
+static uint8_t appIdentityPage[APP_IDENTITY_PAGE_SIZE] CACHE_ALIGN;
+
+static uint32_t APP_IDENTITY_fnv(uint32_t hash, const uint8_t *bytes, uint32_t length)
+{
+    while (length-- > 0)
+    {
+        hash ^= *bytes++;
+        hash *= APP_IDENTITY_FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t APP_IDENTITY_checksum(const APP_IDENTITY_ENTRY *entry)
+{
+    uint32_t hash;
+
+    hash = APP_IDENTITY_fnv(APP_IDENTITY_FNV_OFFSET, (const uint8_t *)entry, offsetof(APP_IDENTITY_ENTRY, check));
+    return APP_IDENTITY_fnv(hash, entry->hostname, sizeof(entry->hostname) + sizeof(entry->deviceId));
+}
+
+static void APP_IDENTITY_transferHandler(DRV_MEMORY_EVENT event,
+        DRV_MEMORY_COMMAND_HANDLE commandHandle, uintptr_t context)
+{
+    appIdentity.xferError = (event != DRV_MEMORY_EVENT_COMMAND_COMPLETE);
+    OSAL_SEM_Post(&appIdentity.xferSem);
+}
+
+/* Run one request on appIdentityPage and wait for it to complete */
+static bool APP_IDENTITY_transfer(APP_IDENTITY_OP op, uint32_t address)
+{
+    DRV_MEMORY_COMMAND_HANDLE commandHandle = DRV_MEMORY_COMMAND_HANDLE_INVALID;
+    uint32_t retry;
+
+    for (retry = 0; retry < APP_IDENTITY_QUEUE_RETRIES; retry++)
+    {
+        switch (op)
+        {
+            case APP_IDENTITY_OP_READ:
+                DRV_MEMORY_AsyncRead(appIdentity.handle, &commandHandle, appIdentityPage,
+                        address / appIdentity.readBlockSize, APP_IDENTITY_PAGE_SIZE / appIdentity.readBlockSize);
+                break;
+            case APP_IDENTITY_OP_WRITE:
+                DRV_MEMORY_AsyncWrite(appIdentity.handle, &commandHandle, appIdentityPage,
+                        address / APP_IDENTITY_PAGE_SIZE, 1);
+                break;
+            case APP_IDENTITY_OP_ERASE:
+                DRV_MEMORY_AsyncErase(appIdentity.handle, &commandHandle,
+                        address / APP_IDENTITY_SECTOR_SIZE, 1);
+                break;
+        }
+        if (commandHandle != DRV_MEMORY_COMMAND_HANDLE_INVALID)
+        {
+            break;
+        }
+        tx_thread_sleep(1);
+    }
+
+    if (commandHandle == DRV_MEMORY_COMMAND_HANDLE_INVALID)
+    {
+        return false;
+    }
+
+    OSAL_SEM_Pend(&appIdentity.xferSem, OSAL_WAIT_FOREVER);
+    return !appIdentity.xferError;
+}
+
+static bool APP_IDENTITY_open(void)
+{
+    SYS_MEDIA_GEOMETRY *geometry;
+    uint32_t mediaSize;
+
+    appIdentity.handle = DRV_MEMORY_Open(DRV_MEMORY_INDEX_0, DRV_IO_INTENT_READWRITE);
+    if (appIdentity.handle == DRV_HANDLE_INVALID)
+    {
+        APP_IDENTITY_PRNT("Memory driver open failed\r\n");
+        return false;
+    }
+
+    geometry = DRV_MEMORY_GeometryGet(appIdentity.handle);
+    if ((geometry == NULL) ||
+        (geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_WRITE_ENTRY].blockSize != APP_IDENTITY_PAGE_SIZE) ||
+        (geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].blockSize != APP_IDENTITY_SECTOR_SIZE))
+    {
+        APP_IDENTITY_PRNT("Unexpected media geometry\r\n");
+        DRV_MEMORY_Close(appIdentity.handle);
+        return false;
+    }
+    appIdentity.readBlockSize = geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY].blockSize;
+    mediaSize = geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].numBlocks * APP_IDENTITY_SECTOR_SIZE;
+    appIdentity.address = mediaSize - APP_IDENTITY_AREA_SIZE;
+    appIdentity.reservedAddress = mediaSize - DRV_MEMORY_FS_RESERVED_SIZE;
+
+    if (OSAL_SEM_Create(&appIdentity.xferSem, OSAL_SEM_TYPE_BINARY, 1, 0) != OSAL_RESULT_TRUE)
+    {
+        DRV_MEMORY_Close(appIdentity.handle);
+        return false;
+    }
+    DRV_MEMORY_TransferHandlerSet(appIdentity.handle, APP_IDENTITY_transferHandler, 0);
+    return true;
+}
+
+static void APP_IDENTITY_close(void)
+{
+    OSAL_SEM_Delete(&appIdentity.xferSem);
+    DRV_MEMORY_Close(appIdentity.handle);
+}
+
+/* Read the entry into appIdentityPage, NULL if it holds none */
+static APP_IDENTITY_ENTRY *APP_IDENTITY_read(void)
+{
+    APP_IDENTITY_ENTRY *entry = (APP_IDENTITY_ENTRY *)appIdentityPage;
+
+    if (!APP_IDENTITY_transfer(APP_IDENTITY_OP_READ, appIdentity.address))
+    {
+        return NULL;
+    }
+    if ((entry->magic != APP_IDENTITY_MAGIC) || (entry->check != APP_IDENTITY_checksum(entry)) ||
+        (entry->hostnameLength > APP_IDENTITY_HOSTNAME_MAX) || (entry->deviceIdLength > APP_IDENTITY_DEVICE_ID_MAX))
+    {
+        return NULL;
+    }
+    return entry;
+}
+
+static uint32_t APP_IDENTITY_le(const uint8_t *bytes, uint32_t length)
+{
+    uint32_t value = 0;
+
+    while (length-- > 0)
+    {
+        value = (value << 8) | bytes[length];
+    }
+    return value;
+}
+
+/* Sector size of the volume boot sector held in appIdentityPage, 0 if it is none */
+static uint32_t APP_IDENTITY_bootSectorSize(void)
+{
+    uint32_t sectorSize = APP_IDENTITY_le(&appIdentityPage[APP_IDENTITY_BPB_SECTOR_SIZE], 2);
+
+    if ((appIdentityPage[0] != 0xEB) && (appIdentityPage[0] != 0xE9))
+    {
+        return 0;
+    }
+    if ((sectorSize < 512) || (sectorSize > 4096) || ((sectorSize & (sectorSize - 1)) != 0))
+    {
+        return 0;
+    }
+    return sectorSize;
+}
+
+/* End of the FAT volume in bytes, 0 if the media holds none. The volume
+   is either at sector 0 or in the first partition of a partition table,
+   as SYS_FS_DriveFormat lays it out */
+static bool APP_IDENTITY_volumeEnd(uint64_t *end)
+{
+    uint64_t start = 0;
+    uint32_t sectorSize;
+    uint32_t sectors;
+    const uint8_t *partition;
+
+    *end = 0;
+    if (!APP_IDENTITY_transfer(APP_IDENTITY_OP_READ, 0))
+    {
+        return false;
+    }
+
+    if (APP_IDENTITY_bootSectorSize() == 0)
+    {
+        /* The partition table and the signature are in the second page */
+        if (!APP_IDENTITY_transfer(APP_IDENTITY_OP_READ, APP_IDENTITY_PAGE_SIZE))
+        {
+            return false;
+        }
+        partition = &appIdentityPage[APP_IDENTITY_MBR_PARTITION - APP_IDENTITY_PAGE_SIZE];
+        if ((APP_IDENTITY_le(&appIdentityPage[APP_IDENTITY_MBR_SIGNATURE - APP_IDENTITY_PAGE_SIZE], 2) != 0xAA55) ||
+            (partition[4] == 0))
+        {
+            return true;
+        }
+
+        start = (uint64_t)APP_IDENTITY_le(&partition[8], 4) * APP_IDENTITY_FS_SECTOR_SIZE;
+        if (start >= appIdentity.reservedAddress)
+        {
+            /* The partition starts in the reserved area, its boot sector at least is there */
+            *end = start + APP_IDENTITY_FS_SECTOR_SIZE;
+            return true;
+        }
+        if (!APP_IDENTITY_transfer(APP_IDENTITY_OP_READ, (uint32_t)start))
+        {
+            return false;
+        }
+        if (APP_IDENTITY_bootSectorSize() == 0)
+        {
+            return true;
+        }
+    }
+
+    sectorSize = APP_IDENTITY_bootSectorSize();
+    sectors = APP_IDENTITY_le(&appIdentityPage[APP_IDENTITY_BPB_SECTORS_16], 2);
+    if (sectors == 0)
+    {
+        sectors = APP_IDENTITY_le(&appIdentityPage[APP_IDENTITY_BPB_SECTORS_32], 4);
+    }
+    *end = start + ((uint64_t)sectors * sectorSize);
+    return true;
+}
+
+/* With the driver open: the reserved area is clear of the FAT volume */
+static bool APP_IDENTITY_reservedCheck(void)
+{
+    uint64_t end;
+
+    if (APP_IDENTITY_volumeEnd(&end) && (end <= appIdentity.reservedAddress))
+    {
+        return true;
+    }
+    APP_IDENTITY_PRNT("FAT volume reaches into the reserved area, format the drive again\r\n");
+    return false;
+}
+
+bool APP_IDENTITY_reservedFree(void)
+{
+    bool reservedFree;
+
+    if (!APP_IDENTITY_open())
+    {
+        return false;
+    }
+
+    reservedFree = APP_IDENTITY_reservedCheck();
+
+    APP_IDENTITY_close();
+    return reservedFree;
+}
+
+uint32_t APP_IDENTITY_key(const uint8_t *idScope, uint32_t idScopeLength,
+        const uint8_t *registrationId, uint32_t registrationIdLength)
+{
+    uint32_t hash;
+    uint8_t separator = 0;
+
+    hash = APP_IDENTITY_fnv(APP_IDENTITY_FNV_OFFSET, idScope, idScopeLength);
+    hash = APP_IDENTITY_fnv(hash, &separator, 1);
+    return APP_IDENTITY_fnv(hash, registrationId, registrationIdLength);
+}
+
+bool APP_IDENTITY_load(uint32_t key, uint8_t *hostname, uint32_t *hostnameLength,
+        uint8_t *deviceId, uint32_t *deviceIdLength)
+{
+    APP_IDENTITY_ENTRY *entry;
+    bool found = false;
+
+    if (!APP_IDENTITY_open())
+    {
+        return false;
+    }
+    if (!APP_IDENTITY_reservedCheck())
+    {
+        APP_IDENTITY_close();
+        return false;
+    }
+
+    entry = APP_IDENTITY_read();
+    if ((entry != NULL) && (entry->key == key) &&
+        (entry->hostnameLength <= *hostnameLength) && (entry->deviceIdLength <= *deviceIdLength))
+    {
+        memcpy(hostname, entry->hostname, entry->hostnameLength);
+        memcpy(deviceId, entry->deviceId, entry->deviceIdLength);
+        *hostnameLength = entry->hostnameLength;
+        *deviceIdLength = entry->deviceIdLength;
+        found = true;
+    }
+
+    APP_IDENTITY_close();
+    return found;
+}
+
+bool APP_IDENTITY_store(uint32_t key, const uint8_t *hostname, uint32_t hostnameLength,
+        const uint8_t *deviceId, uint32_t deviceIdLength)
+{
+    APP_IDENTITY_ENTRY *entry;
+    bool stored;
+
+    if ((hostnameLength > APP_IDENTITY_HOSTNAME_MAX) || (deviceIdLength > APP_IDENTITY_DEVICE_ID_MAX))
+    {
+        APP_IDENTITY_PRNT("Assignment too long to cache\r\n");
+        return false;
+    }
+
+    if (!APP_IDENTITY_open())
+    {
+        return false;
+    }
+    if (!APP_IDENTITY_reservedCheck())
+    {
+        APP_IDENTITY_close();
+        return false;
+    }
+
+    /* Re-provisioning mostly hands out the same hub, spare the erase */
+    entry = APP_IDENTITY_read();
+    if ((entry != NULL) && (entry->key == key) &&
+        (entry->hostnameLength == hostnameLength) && (memcmp(entry->hostname, hostname, hostnameLength) == 0) &&
+        (entry->deviceIdLength == deviceIdLength) && (memcmp(entry->deviceId, deviceId, deviceIdLength) == 0))
+    {
+        APP_IDENTITY_close();
+        return true;
+    }
+
+    entry = (APP_IDENTITY_ENTRY *)appIdentityPage;
+    memset(appIdentityPage, 0xFF, sizeof(appIdentityPage));
+    entry->magic = APP_IDENTITY_MAGIC;
+    entry->key = key;
+    entry->hostnameLength = (uint16_t)hostnameLength;
+    entry->deviceIdLength = (uint16_t)deviceIdLength;
+    memcpy(entry->hostname, hostname, hostnameLength);
+    memcpy(entry->deviceId, deviceId, deviceIdLength);
+    entry->check = APP_IDENTITY_checksum(entry);
+
+    stored = APP_IDENTITY_transfer(APP_IDENTITY_OP_ERASE, appIdentity.address) &&
+             APP_IDENTITY_transfer(APP_IDENTITY_OP_WRITE, appIdentity.address);
+    if (!stored)
+    {
+        APP_IDENTITY_PRNT("Store failed\r\n");
+    }
+
+    APP_IDENTITY_close();
+    return stored;
+}
+
+bool APP_IDENTITY_invalidate(void)
+{
+    APP_IDENTITY_ENTRY *entry;
+    bool invalidated = true;
+
+    if (!APP_IDENTITY_open())
+    {
+        return false;
+    }
+    if (!APP_IDENTITY_reservedCheck())
+    {
+        APP_IDENTITY_close();
+        return false;
+    }
+
+    /* Bits only go from 1 to 0, clearing the magic needs no erase */
+    if ((entry = APP_IDENTITY_read()) != NULL)
+    {
+        entry->magic = APP_IDENTITY_MAGIC_INVALID;
+        invalidated = APP_IDENTITY_transfer(APP_IDENTITY_OP_WRITE, appIdentity.address);
+    }
+
+    APP_IDENTITY_close();
+    return invalidated;
+}
+
+/*******************************************************************************
+ End of File
+ */
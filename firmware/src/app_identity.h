@@ -0,0 +1,81 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_identity.h
+
+  Summary:
+    Flash cache of the IoT Hub assignment returned by DPS.
+
+  Description:
+    The hub hostname and device ID assigned by the Device Provisioning
+    Service are kept in the last erase sector of the DRV_MEMORY_FS_RESERVED_SIZE
+    area of the SST26, the telemetry journal uses the rest of that area.
+    The entry carries a key computed from the ID scope and registration ID
+    it was provisioned with, so a changed cloud configuration misses the
+    cache and provisioning runs again.
+
+    The sector is only erased when a different assignment is stored, an
+    entry is invalidated in place.
+
+    A FAT volume formatted before the area was reserved spans the whole
+    SST26. APP_IDENTITY_reservedFree reads the end of the volume from its
+    boot sector, the cache and the journal stay off while it reaches into
+    the area.
+
+    The cache opens the memory driver for each call, it is meant for the
+    connection setup and is not thread safe.
+*******************************************************************************/
+
+#ifndef _APP_IDENTITY_H
+#define _APP_IDENTITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "definitions.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+#define APP_IDENTITY_PRNT(fmt,...) SYS_CONSOLE_PRINT("[IDENTITY] "fmt, ##__VA_ARGS__)
+
+/* Top of the reserved area used by the cache, the journal takes the rest */
+#define APP_IDENTITY_AREA_SIZE          DRV_SST26_ERASE_BUFFER_SIZE
+
+/* An entry fills one flash page */
+#define APP_IDENTITY_HOSTNAME_MAX       (112)
+#define APP_IDENTITY_DEVICE_ID_MAX      (128)
+
+// *****************************************************************************
+
+uint32_t APP_IDENTITY_key(const uint8_t *idScope, uint32_t idScopeLength,
+        const uint8_t *registrationId, uint32_t registrationIdLength);
+/* The lengths hold the buffer sizes on entry and the lengths read on return */
+bool APP_IDENTITY_load(uint32_t key, uint8_t *hostname, uint32_t *hostnameLength,
+        uint8_t *deviceId, uint32_t *deviceIdLength);
+bool APP_IDENTITY_store(uint32_t key, const uint8_t *hostname, uint32_t hostnameLength,
+        const uint8_t *deviceId, uint32_t deviceIdLength);
+bool APP_IDENTITY_invalidate(void);
+/* False if the FAT volume overlaps the reserved area, or it cannot be read */
+bool APP_IDENTITY_reservedFree(void);
+
+#endif /* _APP_IDENTITY_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
+
@@ -0,0 +1,588 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include <string.h>
+#include "app_journal.h"
+#include "app_identity.h"
+
+#define APP_JOURNAL_PAGE_SIZE           DRV_SST26_PAGE_SIZE
+#define APP_JOURNAL_SECTOR_SIZE         DRV_SST26_ERASE_BUFFER_SIZE
+/* The last sector of the reserved area holds the DPS cache */
+#define APP_JOURNAL_SECTORS             ((DRV_MEMORY_FS_RESERVED_SIZE - APP_IDENTITY_AREA_SIZE) / APP_JOURNAL_SECTOR_SIZE)
+#define APP_JOURNAL_SLOT_SIZE           sizeof(APP_JOURNAL_RECORD)
+#define APP_JOURNAL_SLOTS               (APP_JOURNAL_SECTOR_SIZE / APP_JOURNAL_SLOT_SIZE)
+#define APP_JOURNAL_SLOTS_PER_PAGE      (APP_JOURNAL_PAGE_SIZE / APP_JOURNAL_SLOT_SIZE)
+/* Slot 0 of every sector holds the sector header */
+#define APP_JOURNAL_FIRST_SLOT          1
+
+#define APP_JOURNAL_MARKER_ERASED       0xFF
+#define APP_JOURNAL_MARKER_VALID        0xA5
+#define APP_JOURNAL_MARKER_CONSUMED     0x00
+#define APP_JOURNAL_MARKER_SECTOR       0x5A
+#define APP_JOURNAL_MAGIC               0x4C4E524A  /* "JRNL" */
+
+/* Retries when the shared DRV_MEMORY request queue is full */
+#define APP_JOURNAL_QUEUE_RETRIES       50
+
+#if (APP_JOURNAL_SECTORS < 2)
+#error "DRV_MEMORY_FS_RESERVED_SIZE must hold at least two erase sectors for the journal besides the DPS cache"
+#endif
+
+typedef struct
+{
+    uint8_t marker;
+    uint8_t reserved[3];
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t eraseCount;
+} APP_JOURNAL_SECTOR_HEADER;
+
+typedef enum
+{
+    APP_JOURNAL_OP_READ = 0,
+    APP_JOURNAL_OP_WRITE,
+    APP_JOURNAL_OP_ERASE,
+} APP_JOURNAL_OP;
+
+typedef struct
+{
+    bool ready;
+    DRV_HANDLE handle;
+    OSAL_SEM_DECLARE(xferSem);
+    volatile bool xferError;
+    /* Byte address of the first journal sector */
+    uint32_t baseAddress;
+    uint32_t readBlockSize;
+    /* Next slot to write */
+    uint32_t headSector;
+    uint32_t headSlot;
+    uint32_t headSequence;
+    /* Oldest slot that may hold a pending record */
+    uint32_t tailSector;
+    uint32_t tailSlot;
+    uint32_t recordSequence;
+    uint32_t pending;
+    uint32_t dropped;
+    /* Byte address of the page held in appJournalPage, 0xFFFFFFFF if none */
+    uint32_t pageAddress;
+    uint32_t eraseCount[APP_JOURNAL_SECTORS];
+} APP_JOURNAL_DATA;
+
+static APP_JOURNAL_DATA appJournal;
+static uint8_t appJournalPage[APP_JOURNAL_PAGE_SIZE] CACHE_ALIGN;
+
+static void APP_JOURNAL_transferHandler(DRV_MEMORY_EVENT event,
+        DRV_MEMORY_COMMAND_HANDLE commandHandle, uintptr_t context)
+{
+    appJournal.xferError = (event != DRV_MEMORY_EVENT_COMMAND_COMPLETE);
+    OSAL_SEM_Post(&appJournal.xferSem);
+}
+
+/* Run one request on appJournalPage and wait for it to complete */
+static bool APP_JOURNAL_transfer(APP_JOURNAL_OP op, uint32_t address, uint32_t length)
+{
+    DRV_MEMORY_COMMAND_HANDLE commandHandle = DRV_MEMORY_COMMAND_HANDLE_INVALID;
+    uint32_t retry;
+
+    for (retry = 0; retry < APP_JOURNAL_QUEUE_RETRIES; retry++)
+    {
+        switch (op)
+        {
+            case APP_JOURNAL_OP_READ:
+                DRV_MEMORY_AsyncRead(appJournal.handle, &commandHandle, appJournalPage,
+                        address / appJournal.readBlockSize, length / appJournal.readBlockSize);
+                break;
+            case APP_JOURNAL_OP_WRITE:
+                DRV_MEMORY_AsyncWrite(appJournal.handle, &commandHandle, appJournalPage,
+                        address / APP_JOURNAL_PAGE_SIZE, 1);
+                break;
+            case APP_JOURNAL_OP_ERASE:
+                DRV_MEMORY_AsyncErase(appJournal.handle, &commandHandle,
+                        address / APP_JOURNAL_SECTOR_SIZE, 1);
+                break;
+        }
+        if (commandHandle != DRV_MEMORY_COMMAND_HANDLE_INVALID)
+        {
+            break;
+        }
+        tx_thread_sleep(1);
+    }
+
+    if (commandHandle == DRV_MEMORY_COMMAND_HANDLE_INVALID)
+    {
+        return false;
+    }
+
+    OSAL_SEM_Pend(&appJournal.xferSem, OSAL_WAIT_FOREVER);
+    return !appJournal.xferError;
+}
+
+static uint32_t APP_JOURNAL_slotAddress(uint32_t sector, uint32_t slot)
+{
+    return appJournal.baseAddress + (sector * APP_JOURNAL_SECTOR_SIZE) + (slot * APP_JOURNAL_SLOT_SIZE);
+}
+
+/* Bring the page holding a slot into appJournalPage */
+static APP_JOURNAL_RECORD *APP_JOURNAL_slotLoad(uint32_t sector, uint32_t slot)
+{
+    uint32_t pageAddress = APP_JOURNAL_slotAddress(sector, slot) & ~(APP_JOURNAL_PAGE_SIZE - 1);
+
+    if (appJournal.pageAddress != pageAddress)
+    {
+        appJournal.pageAddress = 0xFFFFFFFF;
+        if (!APP_JOURNAL_transfer(APP_JOURNAL_OP_READ, pageAddress, APP_JOURNAL_PAGE_SIZE))
+        {
+            return NULL;
+        }
+        appJournal.pageAddress = pageAddress;
+    }
+
+    return (APP_JOURNAL_RECORD *)&appJournalPage[(slot % APP_JOURNAL_SLOTS_PER_PAGE) * APP_JOURNAL_SLOT_SIZE];
+}
+
+/* Program appJournalPage back. Bits only go from 1 to 0, so rewriting the
+   unchanged slots of the page is harmless */
+static bool APP_JOURNAL_pageStore(void)
+{
+    if (!APP_JOURNAL_transfer(APP_JOURNAL_OP_WRITE, appJournal.pageAddress, APP_JOURNAL_PAGE_SIZE))
+    {
+        /* The buffer no longer matches the flash */
+        appJournal.pageAddress = 0xFFFFFFFF;
+        return false;
+    }
+    return true;
+}
+
+static uint8_t APP_JOURNAL_checksum(const APP_JOURNAL_RECORD *record)
+{
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint8_t sum = 0;
+    uint32_t index;
+
+    for (index = 0; index < sizeof(APP_JOURNAL_RECORD); index++)
+    {
+        if ((index != offsetof(APP_JOURNAL_RECORD, marker)) && (index != offsetof(APP_JOURNAL_RECORD, check)))
+        {
+            sum += bytes[index];
+        }
+    }
+    return (uint8_t)~sum;
+}
+
+static bool APP_JOURNAL_isValid(const APP_JOURNAL_RECORD *record)
+{
+    return (record->marker == APP_JOURNAL_MARKER_VALID) && (record->check == APP_JOURNAL_checksum(record));
+}
+
+static bool APP_JOURNAL_isErased(const APP_JOURNAL_RECORD *record)
+{
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint32_t index;
+
+    for (index = 0; index < sizeof(APP_JOURNAL_RECORD); index++)
+    {
+        if (bytes[index] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool APP_JOURNAL_headerRead(uint32_t sector, APP_JOURNAL_SECTOR_HEADER *header)
+{
+    APP_JOURNAL_RECORD *slot = APP_JOURNAL_slotLoad(sector, 0);
+
+    if (slot == NULL)
+    {
+        return false;
+    }
+    memcpy(header, slot, sizeof(APP_JOURNAL_SECTOR_HEADER));
+    return (header->marker == APP_JOURNAL_MARKER_SECTOR) && (header->magic == APP_JOURNAL_MAGIC);
+}
+
+/* Erase a sector and stamp it as the newest one */
+static bool APP_JOURNAL_sectorStart(uint32_t sector, uint32_t sequence)
+{
+    APP_JOURNAL_SECTOR_HEADER header;
+
+    appJournal.pageAddress = 0xFFFFFFFF;
+    if (!APP_JOURNAL_transfer(APP_JOURNAL_OP_ERASE, APP_JOURNAL_slotAddress(sector, 0), APP_JOURNAL_SECTOR_SIZE))
+    {
+        return false;
+    }
+    appJournal.eraseCount[sector]++;
+
+    memset(&header, 0xFF, sizeof(header));
+    header.marker = APP_JOURNAL_MARKER_SECTOR;
+    header.magic = APP_JOURNAL_MAGIC;
+    header.sequence = sequence;
+    header.eraseCount = appJournal.eraseCount[sector];
+
+    memset(appJournalPage, 0xFF, sizeof(appJournalPage));
+    memcpy(appJournalPage, &header, sizeof(header));
+    appJournal.pageAddress = APP_JOURNAL_slotAddress(sector, 0);
+
+    return APP_JOURNAL_pageStore();
+}
+
+/* Pending records of a sector from a slot on, used when it gets dropped */
+static uint32_t APP_JOURNAL_countValid(uint32_t sector, uint32_t slot)
+{
+    APP_JOURNAL_RECORD *record;
+    uint32_t count = 0;
+
+    for (; slot < APP_JOURNAL_SLOTS; slot++)
+    {
+        if ((record = APP_JOURNAL_slotLoad(sector, slot)) == NULL)
+        {
+            break;
+        }
+        if (APP_JOURNAL_isValid(record))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Move the head to the next sector, dropping the oldest one if it is still pending */
+static bool APP_JOURNAL_headAdvance(void)
+{
+    uint32_t next = (appJournal.headSector + 1) % APP_JOURNAL_SECTORS;
+    uint32_t lost;
+
+    if ((appJournal.pending > 0) && (next == appJournal.tailSector))
+    {
+        lost = APP_JOURNAL_countValid(appJournal.tailSector, appJournal.tailSlot);
+        appJournal.dropped += lost;
+        appJournal.pending -= (lost < appJournal.pending) ? lost : appJournal.pending;
+        appJournal.tailSector = (next + 1) % APP_JOURNAL_SECTORS;
+        appJournal.tailSlot = APP_JOURNAL_FIRST_SLOT;
+        APP_JOURNAL_PRNT("Full, dropped %u oldest records\r\n", lost);
+    }
+
+    if (!APP_JOURNAL_sectorStart(next, appJournal.headSequence + 1))
+    {
+        return false;
+    }
+
+    appJournal.headSector = next;
+    appJournal.headSlot = APP_JOURNAL_FIRST_SLOT;
+    appJournal.headSequence++;
+
+    if (appJournal.pending == 0)
+    {
+        appJournal.tailSector = appJournal.headSector;
+        appJournal.tailSlot = appJournal.headSlot;
+    }
+    return true;
+}
+
+/* Scan the sectors to rebuild head, tail and the pending count */
+static bool APP_JOURNAL_recover(void)
+{
+    APP_JOURNAL_SECTOR_HEADER header;
+    APP_JOURNAL_RECORD *record;
+    bool valid[APP_JOURNAL_SECTORS];
+    bool found = false;
+    bool tailFound = false;
+    uint32_t sector;
+    uint32_t slot;
+    uint32_t index;
+
+    for (sector = 0; sector < APP_JOURNAL_SECTORS; sector++)
+    {
+        valid[sector] = APP_JOURNAL_headerRead(sector, &header);
+        appJournal.eraseCount[sector] = valid[sector] ? header.eraseCount : 0;
+        if (valid[sector] && (!found || (header.sequence > appJournal.headSequence)))
+        {
+            found = true;
+            appJournal.headSector = sector;
+            appJournal.headSequence = header.sequence;
+        }
+    }
+
+    if (!found)
+    {
+        APP_JOURNAL_PRNT("Formatting %u sectors\r\n", APP_JOURNAL_SECTORS);
+        appJournal.headSector = 0;
+        appJournal.headSequence = 1;
+        appJournal.headSlot = APP_JOURNAL_FIRST_SLOT;
+        appJournal.tailSector = appJournal.headSector;
+        appJournal.tailSlot = appJournal.headSlot;
+        return APP_JOURNAL_sectorStart(appJournal.headSector, appJournal.headSequence);
+    }
+
+    /* Sectors are taken round-robin, so walking the ring from the one after
+       the head visits them oldest first */
+    for (index = 1; index <= APP_JOURNAL_SECTORS; index++)
+    {
+        sector = (appJournal.headSector + index) % APP_JOURNAL_SECTORS;
+        if (!valid[sector])
+        {
+            continue;
+        }
+
+        for (slot = APP_JOURNAL_FIRST_SLOT; slot < APP_JOURNAL_SLOTS; slot++)
+        {
+            if ((record = APP_JOURNAL_slotLoad(sector, slot)) == NULL)
+            {
+                return false;
+            }
+            if (sector == appJournal.headSector)
+            {
+                if (APP_JOURNAL_isErased(record))
+                {
+                    continue;
+                }
+                appJournal.headSlot = slot + 1;
+            }
+            if (record->marker != APP_JOURNAL_MARKER_ERASED)
+            {
+                appJournal.recordSequence = record->sequence + 1;
+            }
+            if (!APP_JOURNAL_isValid(record))
+            {
+                continue;
+            }
+            if (!tailFound)
+            {
+                tailFound = true;
+                appJournal.tailSector = sector;
+                appJournal.tailSlot = slot;
+            }
+            appJournal.pending++;
+        }
+    }
+
+    if (appJournal.headSlot < APP_JOURNAL_FIRST_SLOT)
+    {
+        appJournal.headSlot = APP_JOURNAL_FIRST_SLOT;
+    }
+    if (!tailFound)
+    {
+        appJournal.tailSector = appJournal.headSector;
+        appJournal.tailSlot = appJournal.headSlot;
+    }
+    return true;
+}
+
+bool APP_JOURNAL_init(void)
+{
+    SYS_MEDIA_GEOMETRY *geometry;
+    uint32_t mediaSize;
+    uint32_t maxErase = 0;
+    uint32_t sector;
+
+    memset(&appJournal, 0, sizeof(appJournal));
+    appJournal.pageAddress = 0xFFFFFFFF;
+
+    /* Formatting the sectors would erase clusters of an older FAT volume */
+    if (!APP_IDENTITY_reservedFree())
+    {
+        return false;
+    }
+
+    /* The journal client sees the full media, the file system clients only
+       the part below DRV_MEMORY_FS_RESERVED_SIZE */
+    appJournal.handle = DRV_MEMORY_Open(DRV_MEMORY_INDEX_0, DRV_IO_INTENT_READWRITE);
+    if (appJournal.handle == DRV_HANDLE_INVALID)
+    {
+        APP_JOURNAL_PRNT("Memory driver open failed\r\n");
+        return false;
+    }
+
+    geometry = DRV_MEMORY_GeometryGet(appJournal.handle);
+    if ((geometry == NULL) ||
+        (geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_WRITE_ENTRY].blockSize != APP_JOURNAL_PAGE_SIZE) ||
+        (geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].blockSize != APP_JOURNAL_SECTOR_SIZE))
+    {
+        APP_JOURNAL_PRNT("Unexpected media geometry\r\n");
+        DRV_MEMORY_Close(appJournal.handle);
+        return false;
+    }
+    appJournal.readBlockSize = geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_READ_ENTRY].blockSize;
+    mediaSize = geometry->geometryTable[SYS_MEDIA_GEOMETRY_TABLE_ERASE_ENTRY].numBlocks * APP_JOURNAL_SECTOR_SIZE;
+    appJournal.baseAddress = mediaSize - DRV_MEMORY_FS_RESERVED_SIZE;
+
+    if (OSAL_SEM_Create(&appJournal.xferSem, OSAL_SEM_TYPE_BINARY, 1, 0) != OSAL_RESULT_TRUE)
+    {
+        DRV_MEMORY_Close(appJournal.handle);
+        return false;
+    }
+    DRV_MEMORY_TransferHandlerSet(appJournal.handle, APP_JOURNAL_transferHandler, 0);
+
+    if (!APP_JOURNAL_recover())
+    {
+        APP_JOURNAL_PRNT("Recovery failed\r\n");
+        OSAL_SEM_Delete(&appJournal.xferSem);
+        DRV_MEMORY_Close(appJournal.handle);
+        return false;
+    }
+
+    for (sector = 0; sector < APP_JOURNAL_SECTORS; sector++)
+    {
+        if (appJournal.eraseCount[sector] > maxErase)
+        {
+            maxErase = appJournal.eraseCount[sector];
+        }
+    }
+    APP_JOURNAL_PRNT("%u records pending, %u sectors at 0x%08x, max erase count %u\r\n",
+            appJournal.pending, APP_JOURNAL_SECTORS, appJournal.baseAddress, maxErase);
+
+    appJournal.ready = true;
+    return true;
+}
+
+bool APP_JOURNAL_append(uint8_t field, uint8_t group, uint32_t timestamp, float value)
+{
+    APP_JOURNAL_RECORD *slot;
+    APP_JOURNAL_RECORD record;
+
+    if (!appJournal.ready)
+    {
+        return false;
+    }
+
+    if ((appJournal.headSlot >= APP_JOURNAL_SLOTS) && !APP_JOURNAL_headAdvance())
+    {
+        return false;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.marker = APP_JOURNAL_MARKER_VALID;
+    record.field = field;
+    record.group = group;
+    record.timestamp = timestamp;
+    record.value = value;
+    record.sequence = appJournal.recordSequence;
+    record.check = APP_JOURNAL_checksum(&record);
+
+    if ((slot = APP_JOURNAL_slotLoad(appJournal.headSector, appJournal.headSlot)) == NULL)
+    {
+        return false;
+    }
+    memcpy(slot, &record, sizeof(record));
+
+    /* The slot is taken even if programming fails half way */
+    appJournal.headSlot++;
+    if (!APP_JOURNAL_pageStore())
+    {
+        return false;
+    }
+
+    appJournal.recordSequence++;
+    appJournal.pending++;
+    return true;
+}
+
+uint32_t APP_JOURNAL_peek(APP_JOURNAL_RECORD *records, uint32_t maxRecords)
+{
+    APP_JOURNAL_RECORD *record;
+    uint32_t sector = appJournal.tailSector;
+    uint32_t slot = appJournal.tailSlot;
+    uint32_t count = 0;
+
+    if (!appJournal.ready)
+    {
+        return 0;
+    }
+
+    while ((count < maxRecords) && (count < appJournal.pending) &&
+           !((sector == appJournal.headSector) && (slot == appJournal.headSlot)))
+    {
+        if (slot >= APP_JOURNAL_SLOTS)
+        {
+            sector = (sector + 1) % APP_JOURNAL_SECTORS;
+            slot = APP_JOURNAL_FIRST_SLOT;
+            continue;
+        }
+        if ((record = APP_JOURNAL_slotLoad(sector, slot)) == NULL)
+        {
+            break;
+        }
+        if (APP_JOURNAL_isValid(record))
+        {
+            records[count++] = *record;
+        }
+        slot++;
+    }
+    return count;
+}
+
+bool APP_JOURNAL_consume(uint32_t count)
+{
+    APP_JOURNAL_RECORD *record;
+    uint32_t pageAddress;
+    bool dirty = false;
+
+    if (!appJournal.ready)
+    {
+        return false;
+    }
+
+    while ((count > 0) && (appJournal.pending > 0) &&
+           !((appJournal.tailSector == appJournal.headSector) && (appJournal.tailSlot == appJournal.headSlot)))
+    {
+        if (appJournal.tailSlot >= APP_JOURNAL_SLOTS)
+        {
+            appJournal.tailSector = (appJournal.tailSector + 1) % APP_JOURNAL_SECTORS;
+            appJournal.tailSlot = APP_JOURNAL_FIRST_SLOT;
+            continue;
+        }
+
+        /* One program per page for all the records consumed in it */
+        pageAddress = APP_JOURNAL_slotAddress(appJournal.tailSector, appJournal.tailSlot) & ~(APP_JOURNAL_PAGE_SIZE - 1);
+        if (dirty && (pageAddress != appJournal.pageAddress))
+        {
+            if (!APP_JOURNAL_pageStore())
+            {
+                return false;
+            }
+            dirty = false;
+        }
+
+        if ((record = APP_JOURNAL_slotLoad(appJournal.tailSector, appJournal.tailSlot)) == NULL)
+        {
+            return false;
+        }
+        if (APP_JOURNAL_isValid(record))
+        {
+            record->marker = APP_JOURNAL_MARKER_CONSUMED;
+            dirty = true;
+            appJournal.pending--;
+            count--;
+        }
+        appJournal.tailSlot++;
+    }
+
+    if (dirty && !APP_JOURNAL_pageStore())
+    {
+        return false;
+    }
+
+    if (appJournal.pending == 0)
+    {
+        appJournal.tailSector = appJournal.headSector;
+        appJournal.tailSlot = appJournal.headSlot;
+    }
+    return true;
+}
+
+uint32_t APP_JOURNAL_pending(void)
+{
+    return appJournal.pending;
+}
+
+uint32_t APP_JOURNAL_dropped(void)
+{
+    return appJournal.dropped;
+}
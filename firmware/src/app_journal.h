@@ -0,0 +1,83 @@
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_journal.h
+
+  Summary:
+    Store-and-forward journal for telemetry readings taken while offline.
+
+  Description:
+    Readings are appended as fixed size binary records to a ring of erase
+    sectors at the top of the SST26 flash, in the DRV_MEMORY_FS_RESERVED_SIZE
+    area that is hidden from the FAT volume, below the DPS cache sector.
+    Records are read back in order once the hub connection is up again and
+    marked consumed in place, so the journal survives a reset.
+
+    Sectors are used round-robin and only erased when the head wraps onto
+    them, which spreads the erase cycles evenly over the area. Each sector
+    starts with a header holding its sequence number and erase count. When
+    the journal is full the oldest sector is dropped.
+
+    APP_JOURNAL_init fails without touching the flash when the FAT volume
+    reaches into the reserved area, see APP_IDENTITY_reservedFree.
+
+    The journal is not thread safe, it is owned by the telemetry thread.
+*******************************************************************************/
+
+#ifndef _APP_JOURNAL_H
+#define _APP_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "definitions.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+
+#define APP_JOURNAL_PRNT(fmt,...) SYS_CONSOLE_PRINT("[JOURNAL] "fmt, ##__VA_ARGS__)
+
+// *****************************************************************************
+
+/* One reading, 16 bytes so records never straddle a flash page */
+typedef struct
+{
+    uint8_t marker;         /* APP_JOURNAL_MARKER_xxx, programmed to consumed in place */
+    uint8_t field;          /* Application defined telemetry field id */
+    uint8_t check;          /* Checksum of the record, marker excluded */
+    uint8_t group;          /* Reading group counter, wraps; tells apart groups taken in the same second */
+    uint32_t timestamp;     /* Unix time of the reading, 0 if unknown */
+    float value;
+    uint32_t sequence;      /* Record counter, keeps counting across sectors */
+} APP_JOURNAL_RECORD;
+
+// *****************************************************************************
+
+bool APP_JOURNAL_init(void);
+bool APP_JOURNAL_append(uint8_t field, uint8_t group, uint32_t timestamp, float value);
+uint32_t APP_JOURNAL_peek(APP_JOURNAL_RECORD *records, uint32_t maxRecords);
+bool APP_JOURNAL_consume(uint32_t count);
+uint32_t APP_JOURNAL_pending(void);
+uint32_t APP_JOURNAL_dropped(void);
+
+#endif /* _APP_JOURNAL_H */
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+/*******************************************************************************
+ End of File
+ */
+
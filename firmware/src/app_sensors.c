@@ -15,20 +15,296 @@ extern APP_DATA app_pic32mz_w1Data;
 
 APP_SENSORS_DATA APP_SENSORS_data;
 
+/* Scheduler state, all I2C traffic goes through the scheduler thread */
+typedef struct
+{
+    TX_THREAD thread;
+    TX_SEMAPHORE wake;
+    /* Single transaction handed over by APP_SENSORS_xferRun */
+    TX_MUTEX runMutex;
+    TX_SEMAPHORE runDone;
+    APP_SENSORS_XFER * volatile runXfer;
+    bool runResult;
+    APP_SENSORS_JOB *jobs;
+} APP_SENSORS_SCHED;
+
+static APP_SENSORS_SCHED APP_SENSORS_sched;
+static ULONG APP_SENSORS_schedStack[APP_SENSORS_SCHED_STACK_SIZE / sizeof(ULONG)];
+
+#define APP_SENSORS_MS_TO_TICKS(ms)     (((ms) + TX_TICK_PERIOD_MS - 1) / TX_TICK_PERIOD_MS)
+/* True once tick a has been reached, safe across the tick counter wrap */
+#define APP_SENSORS_TICK_REACHED(now, a) ((LONG)((now) - (a)) >= 0)
+
+/* The driver blocks on a semaphore that the I2C interrupt releases, so only
+   the scheduler thread waits for the bus */
+static bool APP_SENSORS_xferExecute(APP_SENSORS_XFER *xfer)
+{
+    if (xfer->txSize == 0)
+    {
+        return DRV_I2C_ReadTransfer(APP_SENSORS_data.i2c.i2cHandle,
+                xfer->addr, xfer->rxBuffer, xfer->rxSize);
+    }
+    if (xfer->rxSize == 0)
+    {
+        return DRV_I2C_WriteTransfer(APP_SENSORS_data.i2c.i2cHandle,
+                xfer->addr, xfer->txBuffer, xfer->txSize);
+    }
+    return DRV_I2C_WriteReadTransfer(APP_SENSORS_data.i2c.i2cHandle,
+            xfer->addr, xfer->txBuffer, xfer->txSize, xfer->rxBuffer, xfer->rxSize);
+}
+
+static void APP_SENSORS_jobStep(APP_SENSORS_JOB *job)
+{
+    float values[APP_SENSORS_JOB_VALUES_MAX];
+    OSAL_CRITSECT_DATA_TYPE status;
+    uint8_t index;
+
+    if (!APP_SENSORS_xferExecute(&job->xfers[job->xferIndex]))
+    {
+        job->errorCount++;
+        job->active = false;
+        return;
+    }
+
+    if ((job->xferIndex == 0) && (job->ready != NULL) && !job->ready(job))
+    {
+        job->active = false;
+        return;
+    }
+
+    if (++job->xferIndex < job->xferCount)
+    {
+        job->dueTick = tx_time_get() + APP_SENSORS_MS_TO_TICKS(job->xfers[job->xferIndex].delayMs);
+        return;
+    }
+
+    job->active = false;
+    if (job->decode(job, values))
+    {
+        status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+        memcpy(job->values, values, sizeof(job->values));
+        for (index = 0; index < job->aggregateCount; index++)
+        {
+            APP_AGGREGATE_add(&job->aggregate[index], values[index]);
+        }
+        job->sampleCount++;
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+    }
+}
+
+static void APP_SENSORS_schedulerTask(ULONG input)
+{
+    APP_SENSORS_JOB *job;
+    ULONG now;
+    ULONG wait;
+    ULONG next;
+    bool ran;
+
+    while (1)
+    {
+        if (APP_SENSORS_sched.runXfer != NULL)
+        {
+            APP_SENSORS_sched.runResult = APP_SENSORS_xferExecute(APP_SENSORS_sched.runXfer);
+            APP_SENSORS_sched.runXfer = NULL;
+            tx_semaphore_put(&APP_SENSORS_sched.runDone);
+        }
+
+        /* Start the jobs whose slot on the timeline has come. The start time
+           moves by whole periods so sampling does not drift; a slot is
+           skipped when the previous cycle has not finished yet */
+        now = tx_time_get();
+        for (job = APP_SENSORS_sched.jobs; job != NULL; job = job->next)
+        {
+            if (!APP_SENSORS_TICK_REACHED(now, job->startTick))
+            {
+                continue;
+            }
+            if (job->active)
+            {
+                job->overrunCount++;
+            }
+            else
+            {
+                job->active = true;
+                job->xferIndex = 0;
+                job->dueTick = now + APP_SENSORS_MS_TO_TICKS(job->xfers[0].delayMs);
+            }
+            job->startTick += APP_SENSORS_MS_TO_TICKS(job->periodMs);
+            if (APP_SENSORS_TICK_REACHED(now, job->startTick))
+            {
+                job->startTick = now + APP_SENSORS_MS_TO_TICKS(job->periodMs);
+            }
+        }
+
+        /* One due transaction per job and round, so jobs interleave */
+        ran = false;
+        for (job = APP_SENSORS_sched.jobs; job != NULL; job = job->next)
+        {
+            if (job->active && APP_SENSORS_TICK_REACHED(tx_time_get(), job->dueTick))
+            {
+                APP_SENSORS_jobStep(job);
+                ran = true;
+            }
+        }
+        if (ran)
+        {
+            continue;
+        }
+
+        /* Sleep until the next transaction or job start is due */
+        now = tx_time_get();
+        wait = TX_WAIT_FOREVER;
+        for (job = APP_SENSORS_sched.jobs; job != NULL; job = job->next)
+        {
+            next = job->active ? job->dueTick : job->startTick;
+            next = APP_SENSORS_TICK_REACHED(now, next) ? 0 : (next - now);
+            if (next < wait)
+            {
+                wait = next;
+            }
+        }
+        if (wait > 0)
+        {
+            tx_semaphore_get(&APP_SENSORS_sched.wake, wait);
+        }
+    }
+}
+
+bool APP_SENSORS_jobAdd(APP_SENSORS_JOB *job)
+{
+    OSAL_CRITSECT_DATA_TYPE status;
+
+    if ((job == NULL) || (job->xferCount == 0) || (job->decode == NULL) || (job->periodMs == 0))
+    {
+        return false;
+    }
+
+    job->active = false;
+    job->sampleCount = 0;
+    job->readCount = 0;
+    job->errorCount = 0;
+    job->overrunCount = 0;
+    job->startTick = tx_time_get();
+
+    status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    job->next = APP_SENSORS_sched.jobs;
+    APP_SENSORS_sched.jobs = job;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+    tx_semaphore_ceiling_put(&APP_SENSORS_sched.wake, 1);
+    return true;
+}
+
+/* Copy the latest sample of a job, false if there is none since the last call */
+bool APP_SENSORS_jobRead(APP_SENSORS_JOB *job, float *values)
+{
+    OSAL_CRITSECT_DATA_TYPE status;
+    bool isNew;
+
+    if (job == NULL)
+    {
+        return false;
+    }
+
+    status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    isNew = (job->sampleCount != job->readCount);
+    if (isNew)
+    {
+        memcpy(values, job->values, sizeof(job->values));
+        job->readCount = job->sampleCount;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+    return isNew;
+}
+
+/* Fold every sample of the first count values into windows[], must be
+   called before the job is added */
+bool APP_SENSORS_jobAggregate(APP_SENSORS_JOB *job, APP_AGGREGATE_WINDOW *windows, uint8_t count)
+{
+    uint8_t index;
+
+    if ((job == NULL) || (count > APP_SENSORS_JOB_VALUES_MAX))
+    {
+        return false;
+    }
+    for (index = 0; index < count; index++)
+    {
+        APP_AGGREGATE_reset(&windows[index]);
+    }
+    job->aggregate = windows;
+    job->aggregateCount = count;
+
+    return true;
+}
+
+/* Summaries of the windows since the previous call, the windows restart.
+   False if no sample was taken in between */
+bool APP_SENSORS_jobSummary(APP_SENSORS_JOB *job, APP_AGGREGATE_SUMMARY *summaries)
+{
+    APP_AGGREGATE_WINDOW windows[APP_SENSORS_JOB_VALUES_MAX];
+    OSAL_CRITSECT_DATA_TYPE status;
+    uint8_t index;
+
+    if ((job == NULL) || (job->aggregateCount == 0))
+    {
+        return false;
+    }
+
+    status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    for (index = 0; index < job->aggregateCount; index++)
+    {
+        windows[index] = job->aggregate[index];
+        APP_AGGREGATE_reset(&job->aggregate[index]);
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+
+    for (index = 0; index < job->aggregateCount; index++)
+    {
+        if (!APP_AGGREGATE_summary(&windows[index], &summaries[index]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Run a single transaction on the scheduler thread and wait for it.
+   Must not be called from a job callback */
+bool APP_SENSORS_xferRun(APP_SENSORS_XFER *xfer)
+{
+    bool result;
+
+    tx_mutex_get(&APP_SENSORS_sched.runMutex, TX_WAIT_FOREVER);
+    APP_SENSORS_sched.runXfer = xfer;
+    tx_semaphore_ceiling_put(&APP_SENSORS_sched.wake, 1);
+    tx_semaphore_get(&APP_SENSORS_sched.runDone, TX_WAIT_FOREVER);
+    result = APP_SENSORS_sched.runResult;
+    tx_mutex_put(&APP_SENSORS_sched.runMutex);
+
+    return result;
+}
+
+static bool APP_SENSORS_transfer(uint8_t addr, uint8_t txSize, void *rxBuffer, uint8_t rxSize)
+{
+    APP_SENSORS_XFER xfer = {addr, APP_SENSORS_data.i2c.txBuffer, txSize, rxBuffer, rxSize, 0};
+
+    return APP_SENSORS_xferRun(&xfer);
+}
+
 void APP_SENSORS_writeByte(uint8_t addr, uint8_t val)
 {
     APP_SENSORS_data.i2c.txBuffer[0] = (uint8_t)val;
     
-    DRV_I2C_WriteTransfer(APP_SENSORS_data.i2c.i2cHandle,
-            addr, (void*)APP_SENSORS_data.i2c.txBuffer, 1);
+    APP_SENSORS_transfer(addr, 1, NULL, 0);
 }
 
 void APP_SENSORS_write(uint8_t addr, uint8_t *buffer, uint8_t size)
 {
     memcpy(APP_SENSORS_data.i2c.txBuffer, buffer, size);
     
-    DRV_I2C_WriteTransfer(APP_SENSORS_data.i2c.i2cHandle,
-            addr, (void*)APP_SENSORS_data.i2c.txBuffer, size);
+    APP_SENSORS_transfer(addr, size, NULL, 0);
 }
 
 void APP_SENSORS_writeWord_MSB_b4_LSB(uint8_t addr, uint16_t reg, uint16_t val)
@@ -37,8 +313,7 @@ void APP_SENSORS_writeWord_MSB_b4_LSB(uint8_t addr, uint16_t reg, uint16_t val)
     APP_SENSORS_data.i2c.txBuffer[1] = (uint8_t)(val >> 8);
     APP_SENSORS_data.i2c.txBuffer[2] = (uint8_t)(val & 0x00FF);
     
-    DRV_I2C_WriteTransfer(APP_SENSORS_data.i2c.i2cHandle,
-            addr, (void*)APP_SENSORS_data.i2c.txBuffer, 3);
+    APP_SENSORS_transfer(addr, 3, NULL, 0);
 }
 
 void APP_SENSORS_writeWord_LSB_b4_MSB(uint8_t addr, uint16_t reg, uint16_t val)
@@ -47,37 +322,82 @@ void APP_SENSORS_writeWord_LSB_b4_MSB(uint8_t addr, uint16_t reg, uint16_t val)
     APP_SENSORS_data.i2c.txBuffer[1] = (uint8_t)(val & 0x00FF);
     APP_SENSORS_data.i2c.txBuffer[2] = (uint8_t)(val >> 8);
     
-    DRV_I2C_WriteTransfer(APP_SENSORS_data.i2c.i2cHandle,
-            addr, (void*)APP_SENSORS_data.i2c.txBuffer, 3);
+    APP_SENSORS_transfer(addr, 3, NULL, 0);
 }
 
 void APP_SENSORS_justRead(uint8_t addr, uint8_t size)
 {
-    DRV_I2C_ReadTransfer(APP_SENSORS_data.i2c.i2cHandle, 
-            addr, (void*)&APP_SENSORS_data.i2c.rxBuffBytes, size);
+    APP_SENSORS_transfer(addr, 0, (void*)&APP_SENSORS_data.i2c.rxBuffBytes, size);
 }
 
 void APP_SENSORS_writeReadBytes(uint8_t addr, uint16_t reg, uint8_t size)
 {
     APP_SENSORS_data.i2c.txBuffer[0] = (uint8_t)reg;
     
-    DRV_I2C_WriteReadTransfer(APP_SENSORS_data.i2c.i2cHandle, 
-            addr, 
-            (void*)APP_SENSORS_data.i2c.txBuffer, 1, 
-            (void*)&APP_SENSORS_data.i2c.rxBuffBytes, size);
+    APP_SENSORS_transfer(addr, 1, (void*)&APP_SENSORS_data.i2c.rxBuffBytes, size);
 }
 
 void APP_SENSORS_writeReadWords(uint8_t addr, uint16_t reg, uint8_t size)
 {
     APP_SENSORS_data.i2c.txBuffer[0] = (uint8_t)reg;
     
-    DRV_I2C_WriteReadTransfer(APP_SENSORS_data.i2c.i2cHandle, 
-            addr, 
-            (void*)APP_SENSORS_data.i2c.txBuffer, 1, 
-            (void*)&APP_SENSORS_data.i2c.rxBuffWords, size);
+    APP_SENSORS_transfer(addr, 1, (void*)&APP_SENSORS_data.i2c.rxBuffWords, size);
 }
 
- 
+static float APP_SENSORS_mcp9808Temperature(uint16_t word)
+{
+    uint8_t upperByte = (uint8_t)(word >> 8);
+    uint8_t lowerByte = ((uint8_t)(word & 0x00FF));
+    upperByte = upperByte & 0x1F;
+    if ((upperByte & 0x10) == 0x10)
+    {   // Ta < 0 degC
+        upperByte = upperByte & 0x0F;       // Clear sign bit
+        return 256.0 - ((upperByte * 16.0) + lowerByte/16.0);
+    }
+    return ((upperByte * 16) + lowerByte/16);
+}
+
+static uint32_t APP_SENSORS_opt3001Light(uint16_t word)
+{
+    uint16_t m = word & 0x0FFF;
+    uint16_t e = (word & 0xF000) >> 12;
+    return (m*pow(2,e))/100;
+}
+
+#ifdef WFI32_IoT_BOARD
+/* MCP9808 temperature and OPT3001 light, sampled by the scheduler */
+static uint8_t APP_SENSORS_onboardTx[2] = {MCP9808_REG_TAMBIENT, OPT3001_REG_RESULT};
+static uint8_t APP_SENSORS_onboardRx[2][2];
+static APP_SENSORS_XFER APP_SENSORS_onboardXfers[2] =
+{
+    {MCP9808_I2C_ADDRESS, &APP_SENSORS_onboardTx[0], 1, APP_SENSORS_onboardRx[0], 2, 0},
+    {OPT3001_I2C_ADDRESS, &APP_SENSORS_onboardTx[1], 1, APP_SENSORS_onboardRx[1], 2, 0},
+};
+
+static bool APP_SENSORS_onboardDecode(APP_SENSORS_JOB *job, float *values)
+{
+    values[APP_SENSORS_ONBOARD_TEMPERATURE] = APP_SENSORS_mcp9808Temperature(
+            (APP_SENSORS_onboardRx[0][0] << 8) | APP_SENSORS_onboardRx[0][1]);
+    values[APP_SENSORS_ONBOARD_LIGHT] = APP_SENSORS_opt3001Light(
+            (APP_SENSORS_onboardRx[1][0] << 8) | APP_SENSORS_onboardRx[1][1]);
+    return true;
+}
+
+static APP_SENSORS_JOB APP_SENSORS_onboard =
+{
+    .name = "onboard",
+    .xfers = APP_SENSORS_onboardXfers,
+    .xferCount = 2,
+    .periodMs = APP_SENSORS_SAMPLE_PERIOD_MS,
+    .decode = APP_SENSORS_onboardDecode,
+};
+
+APP_SENSORS_JOB *APP_SENSORS_onboardJob(void)
+{
+    return &APP_SENSORS_onboard;
+}
+#endif /* WFI32_IoT_BOARD */
+
 void APP_SENSORS_process(uint8_t addr, uint8_t reg)
 {       
     APP_SENSORS_data.i2c.rxBuffWords[0] = (APP_SENSORS_data.i2c.rxBuffWords[0] << 8) | (APP_SENSORS_data.i2c.rxBuffWords[0] >> 8);
@@ -87,18 +407,7 @@ void APP_SENSORS_process(uint8_t addr, uint8_t reg)
         case MCP9808_I2C_ADDRESS:
             if (reg == MCP9808_REG_TAMBIENT)
             {
-                uint8_t upperByte = (uint8_t)(APP_SENSORS_data.i2c.rxBuffWords[0] >> 8);
-                uint8_t lowerByte = ((uint8_t)(APP_SENSORS_data.i2c.rxBuffWords[0] & 0x00FF));
-                upperByte = upperByte & 0x1F;
-                if ((upperByte & 0x10) == 0x10)
-                {   // Ta < 0 degC
-                    upperByte = upperByte & 0x0F;       // Clear sign bit
-                    APP_SENSORS_data.mcp9808.temperature = 256.0 - ((upperByte * 16.0) + lowerByte/16.0);
-                }
-                else
-                {
-                    APP_SENSORS_data.mcp9808.temperature = ((upperByte * 16) + lowerByte/16);
-                }
+                APP_SENSORS_data.mcp9808.temperature = APP_SENSORS_mcp9808Temperature(APP_SENSORS_data.i2c.rxBuffWords[0]);
                 //APP_CTRL_DBG(SYS_ERROR_INFO, "MCP9808 Temperature %d (C)\r\n", sensorsData.mcp9808.temperature);                
             }
             else if (reg == MCP9808_REG_DEVICE_ID)
@@ -110,9 +419,7 @@ void APP_SENSORS_process(uint8_t addr, uint8_t reg)
         case OPT3001_I2C_ADDRESS:
             if (reg == OPT3001_REG_RESULT)
             {
-                uint16_t m = APP_SENSORS_data.i2c.rxBuffWords[0] & 0x0FFF;
-                uint16_t e = (APP_SENSORS_data.i2c.rxBuffWords[0] & 0xF000) >> 12;
-                APP_SENSORS_data.opt3001.light = (m*pow(2,e))/100;
+                APP_SENSORS_data.opt3001.light = APP_SENSORS_opt3001Light(APP_SENSORS_data.i2c.rxBuffWords[0]);
                 //APP_CTRL_DBG(SYS_ERROR_INFO, "OPT3001 Light %d (lux)\r\n", sensorsData.opt3001.light); 
             }
             else if (reg == OPT3001_REG_DEVICE_ID)
@@ -142,6 +449,16 @@ void APP_SENSORS_init(void)
     {
         APP_SENSORS_DBG(SYS_ERROR_ERROR, "Failed to open I2C driver for reading sensors!\r\n");
     }
+
+    memset(&APP_SENSORS_sched, 0, sizeof(APP_SENSORS_sched));
+    tx_semaphore_create(&APP_SENSORS_sched.wake, "Sensors Wake", 0);
+    tx_semaphore_create(&APP_SENSORS_sched.runDone, "Sensors Run", 0);
+    tx_mutex_create(&APP_SENSORS_sched.runMutex, "Sensors Run", TX_INHERIT);
+    tx_thread_create(&APP_SENSORS_sched.thread, "Sensors Scheduler",
+            APP_SENSORS_schedulerTask, 0,
+            APP_SENSORS_schedStack, sizeof(APP_SENSORS_schedStack),
+            APP_SENSORS_SCHED_PRIORITY, APP_SENSORS_SCHED_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START);
 #ifdef WFI32_IoT_BOARD
     memset(&APP_SENSORS_data.mcp9808, 0, sizeof(APP_SENSORS_data.mcp9808));
     memset(&APP_SENSORS_data.opt3001, 0, sizeof(APP_SENSORS_data.opt3001));
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include "definitions.h"
+#include "app_aggregate.h"
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
@@ -78,6 +79,15 @@ extern "C" {
 
 #define APP_CTRL_ADC_VREF                (3.3f)
 #define APP_CTRL_ADC_MAX_COUNT           (4095)
+/* Sensor scheduler thread */
+#define APP_SENSORS_SCHED_STACK_SIZE     (2048)
+#define APP_SENSORS_SCHED_PRIORITY       (10)
+
+/* Default sampling period of the sensor jobs, independent of the telemetry interval */
+#define APP_SENSORS_SAMPLE_PERIOD_MS     (1000)
+
+#define APP_SENSORS_JOB_VALUES_MAX       (4)
+
 // *****************************************************************************
 /* I2C Operations */
 typedef struct
@@ -88,6 +98,63 @@ typedef struct
     uint16_t rxBuffWords[64];
 } APP_SENSORS_I2C;
 
+/* One I2C transaction: write txSize bytes then read rxSize bytes, either one may be 0 */
+typedef struct
+{
+    uint8_t addr;
+    uint8_t *txBuffer;
+    uint8_t txSize;
+    uint8_t *rxBuffer;
+    uint8_t rxSize;
+    /* Wait after the previous transaction of the job, e.g. for a conversion */
+    uint16_t delayMs;
+} APP_SENSORS_XFER;
+
+struct _APP_SENSORS_JOB;
+
+/* Called by the scheduler after the first transaction, false ends the cycle without a sample */
+typedef bool (*APP_SENSORS_JOB_READY)(struct _APP_SENSORS_JOB *job);
+
+/* Called by the scheduler after the last transaction to turn the rx buffers into values,
+   false drops the sample */
+typedef bool (*APP_SENSORS_JOB_DECODE)(struct _APP_SENSORS_JOB *job, float *values);
+
+/* Sampling job: a fixed sequence of transactions run every periodMs on the
+   scheduler timeline. Transactions of different jobs are interleaved, so a
+   job waiting for a conversion does not hold up the others. Every job owns
+   its transaction buffers */
+typedef struct _APP_SENSORS_JOB
+{
+    const char *name;
+    APP_SENSORS_XFER *xfers;
+    uint8_t xferCount;
+    uint32_t periodMs;
+    APP_SENSORS_JOB_READY ready;
+    APP_SENSORS_JOB_DECODE decode;
+    uintptr_t context;
+
+    /* Scheduler state */
+    bool active;
+    uint8_t xferIndex;
+    uint32_t startTick;
+    uint32_t dueTick;
+
+    /* Latest sample, see APP_SENSORS_jobRead */
+    float values[APP_SENSORS_JOB_VALUES_MAX];
+    uint32_t sampleCount;
+    uint32_t readCount;
+
+    /* Optional windows for the first aggregateCount values, every sample is
+       folded in, see APP_SENSORS_jobSummary */
+    APP_AGGREGATE_WINDOW *aggregate;
+    uint8_t aggregateCount;
+
+    uint32_t errorCount;
+    uint32_t overrunCount;
+
+    struct _APP_SENSORS_JOB *next;
+} APP_SENSORS_JOB;
+
 /* MCP9808 Structure */
 typedef struct
 {
@@ -115,6 +182,18 @@ typedef struct
 // *****************************************************************************
 
 void APP_SENSORS_init(void);
+bool APP_SENSORS_jobAdd(APP_SENSORS_JOB *job);
+bool APP_SENSORS_jobRead(APP_SENSORS_JOB *job, float *values);
+bool APP_SENSORS_jobAggregate(APP_SENSORS_JOB *job, APP_AGGREGATE_WINDOW *windows, uint8_t count);
+bool APP_SENSORS_jobSummary(APP_SENSORS_JOB *job, APP_AGGREGATE_SUMMARY *summaries);
+bool APP_SENSORS_xferRun(APP_SENSORS_XFER *xfer);
+#ifdef WFI32_IoT_BOARD
+/* Values of the MCP9808/OPT3001 job */
+#define APP_SENSORS_ONBOARD_TEMPERATURE  0
+#define APP_SENSORS_ONBOARD_LIGHT        1
+APP_SENSORS_JOB *APP_SENSORS_onboardJob(void);
+#endif
+/* Blocking helpers for the click init code, they share APP_SENSORS_data.i2c */
 void APP_SENSORS_writeByte(uint8_t addr, uint8_t val);
 void APP_SENSORS_write(uint8_t addr, uint8_t *buffer, uint8_t size);
 void APP_SENSORS_writeWord_MSB_b4_LSB(uint8_t addr, uint16_t reg, uint16_t val);
@@ -11,6 +11,8 @@
 #include "app_switch.h"
 #include "az_util.h"
 
+static APP_SWITCH_CALLBACK APP_SWITCH_callback;
+
 static void SWITCH1_InterruptHandler(GPIO_PIN pin, uintptr_t context)
 {
     if (SWITCH1_Get() == APP_SWITCH_PRESSED)
@@ -18,6 +20,10 @@ static void SWITCH1_InterruptHandler(GPIO_PIN pin, uintptr_t context)
         button_press_data.sw1_press_count++;
         button_press_data.flag.sw1 = true;
         LED_RED_Toggle();
+        if (APP_SWITCH_callback != NULL)
+        {
+            APP_SWITCH_callback();
+        }
     }
 }
 
@@ -28,6 +34,10 @@ static void SWITCH2_InterruptHandler(GPIO_PIN pin, uintptr_t context)
         button_press_data.sw2_press_count++;
         button_press_data.flag.sw2 = true;
         LED_RED_Toggle();
+        if (APP_SWITCH_callback != NULL)
+        {
+            APP_SWITCH_callback();
+        }
     }
 }
 
@@ -40,3 +50,8 @@ void APP_SWITCH_init(void)
     SWITCH2_InterruptEnable();
     button_press_data.sw2_press_count = 0;
 }
+
+void APP_SWITCH_callbackRegister(APP_SWITCH_CALLBACK callback)
+{
+    APP_SWITCH_callback = callback;
+}
@@ -33,8 +33,12 @@ extern "C" {
 #define APP_SWITCH_PRESSED  0
 #define APP_SWITCH_RELEASED 1
     
+/* Called from the switch interrupt after a press was recorded */
+typedef void (*APP_SWITCH_CALLBACK)(void);
+
 // *****************************************************************************
 void APP_SWITCH_init(void);
+void APP_SWITCH_callbackRegister(APP_SWITCH_CALLBACK callback);
 // *****************************************************************************
     
 #endif /* _APP_SWITCH_H */
@@ -1,5 +1,6 @@
 
 #include "az_util.h"
+#include "app_format.h"
 
 #define debug_printError printf
 #define debug_printInfo printf
@@ -195,8 +196,17 @@ az_result append_json_property_float(
     az_span         property_name_span,
     float           property_val)
 {
+    char   buffer[APP_FORMAT_FIXED_SIZE];
+    size_t length;
+
     RETURN_ERR_IF_FAILED(az_json_writer_append_property_name(jw, property_name_span));
-    RETURN_ERR_IF_FAILED(az_json_writer_append_double(jw, (double)property_val, 5));
+    length = APP_FORMAT_fixed(buffer, sizeof(buffer), property_val, 5);
+    if (length == 0)
+    {
+        RETURN_ERR_IF_FAILED(az_json_writer_append_double(jw, (double)property_val, 5));
+        return AZ_OK;
+    }
+    RETURN_ERR_IF_FAILED(az_json_writer_append_json_text(jw, az_span_create((uint8_t*)buffer, (int32_t)length)));
     return AZ_OK;
 }
 
@@ -209,9 +219,8 @@ az_result append_json_property_double(
     az_span         property_name_span,
     double          property_val)
 {
-    RETURN_ERR_IF_FAILED(az_json_writer_append_property_name(jw, property_name_span));
-    RETURN_ERR_IF_FAILED(az_json_writer_append_double(jw, property_val, 5));
-    return AZ_OK;
+    /* Sensor readings, single precision is all they carry */
+    return append_json_property_float(jw, property_name_span, (float)property_val);
 }
 
 /**********************************************
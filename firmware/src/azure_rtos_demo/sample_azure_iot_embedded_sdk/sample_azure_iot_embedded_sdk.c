@@ -9,6 +9,9 @@
 /*                                                                        */
 /**************************************************************************/
 #include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
 
 #include "nx_api.h"
 #include "nx_azure_iot_hub_client.h"
@@ -19,6 +22,8 @@
 #include "nx_azure_iot_cert.h"
 #include "nx_azure_iot_ciphersuites.h"
 #include "sample_config.h"
+#include "sample_telemetry.h"
+#include "sample_twin.h"
 
 /* Definitions and function prototypes required by the application */
 #include "app.h"
@@ -36,11 +41,9 @@ static ULONG nx_azure_iot_thread_stack[NX_AZURE_IOT_STACK_SIZE / sizeof(ULONG)];
 /* Define the prototypes for AZ IoT.  */
 static NX_AZURE_IOT                                 nx_azure_iot;
 
-volatile bool bPropertyTIFound = false;
 volatile uint32_t AZ_telemetryInterval = AZ_TELEMETRYINTERVAL_DEFAULT;
 volatile uint32_t AZ_systemRebootTimer = 0;
 
-volatile bool bPropertyYLEDFound = false;
 /* External variables used by the application  */
 extern APP_CONNECT_STATUS appConnectStatus;
 //extern APP_SENSORS_DATA APP_SENSORS_data;
@@ -75,6 +78,9 @@ static SAMPLE_CLIENT                                client;
 #ifdef ENABLE_DPS_SAMPLE
 #define prov_client client.prov_client
 #endif /* ENABLE_DPS_SAMPLE */
+
+/* Time source handed over to nx_azure_iot_create */
+static UINT (*sample_unix_time_get)(ULONG *unix_time);
  
 /* Using X509 certificate authenticate to connect to IoT Hub,
    set the device certificate as your device.  */
@@ -92,7 +98,21 @@ extern UINT g_registration_id_length;
 #ifdef ENABLE_DPS_SAMPLE
 static UCHAR sample_iothub_hostname[SAMPLE_MAX_BUFFER];
 static UCHAR sample_iothub_device_id[SAMPLE_MAX_BUFFER];
+#ifdef ENABLE_DPS_CACHE
+/* The hub info came from the flash cache, not from DPS */
+static UINT sample_dps_cached;
+/* The client was dropped with a rejected assignment and waits for DPS */
+static UINT sample_iothub_reprovision;
+#endif /* ENABLE_DPS_CACHE */
+#endif /* ENABLE_DPS_SAMPLE */
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+/* TLS sessions offered on the next connection to the same endpoint, in RAM only  */
+static NX_SECURE_TLS_RESUME sample_iothub_tls_resume;
+#ifdef ENABLE_DPS_SAMPLE
+static NX_SECURE_TLS_RESUME sample_dps_tls_resume;
 #endif /* ENABLE_DPS_SAMPLE */
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 
 /* Define sample threads.  */
 #ifndef DISABLE_TELEMETRY_SAMPLE
@@ -113,8 +133,151 @@ extern vavpress_return_value_t VAVPRESS_status;
 extern vavpress_sensor_param_data_t VAVPRESS_param_data;
 extern vavpress_el_signature_data_t VAVPRESS_el_signature_data;
 #endif /* CLICK_VAVPRESS */
+/* Sensor scheduler jobs of the detected sensors, NX_NULL if not detected */
+#ifdef WFI32IOT_SENSORS
+static APP_SENSORS_JOB *onboard_job;
+#endif /* WFI32IOT_SENSORS */
+#ifdef CLICK_ALTITUDE2
+static APP_SENSORS_JOB *altitude2_job;
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT
+static APP_SENSORS_JOB *pht_job;
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+static APP_SENSORS_JOB *temphum14_job;
+#endif /* CLICK_TEMPHUM14 */
+#ifdef CLICK_ULTRALOWPRESS
+static APP_SENSORS_JOB *ulp_job;
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+static APP_SENSORS_JOB *vav_job;
+#endif /* CLICK_VAVPRESS */
+static TX_TIMER sample_telemetry_timer;
+/* Readings taken by the dispatcher, sent by the telemetry thread */
+static SAMPLE_TELEMETRY_RING telemetry_ring;
+/* Group being filled by the dispatcher, NX_NULL when the ring is full */
+static SAMPLE_TELEMETRY_SAMPLE *telemetry_sample_ptr;
 static TX_THREAD sample_telemetry_thread;
-static ULONG sample_telemetry_thread_stack[SAMPLE_STACK_SIZE / sizeof(ULONG)];
+static ULONG sample_telemetry_thread_stack[SAMPLE_TELEMETRY_STACK_SIZE / sizeof(ULONG)];
+/* Telemetry message being serialized in place by the telemetry thread */
+static SAMPLE_TELEMETRY_BUILDER telemetry_builder;
+/* tx_time_get() when the group being sent was taken */
+static ULONG telemetry_tick;
+/* Unix time in ms of the first group of the open message, 0 if unknown */
+static uint64_t telemetry_base_ms;
+/* The group being sent is batched behind others and is telemetry_delta_ms
+   younger than telemetry_base_ms */
+static UINT telemetry_delta_pending;
+static int32_t telemetry_delta_ms;
+/* Fields of the sensors with a group in the open message, a bit per field */
+static ULONG telemetry_message_sensors;
+
+/* Telemetry fields, the index is the id the journal keeps for a reading */
+typedef enum
+{
+    TELEMETRY_FIELD_WFI32IOT_TEMPERATURE = 0,
+    TELEMETRY_FIELD_WFI32IOT_LIGHT,
+    TELEMETRY_FIELD_WFI32CURIOSITY_TEMPERATURE,
+    TELEMETRY_FIELD_ALT2_TEMPERATURE,
+    TELEMETRY_FIELD_ALT2_PRESSURE,
+    TELEMETRY_FIELD_ALT2_ALTITUDE,
+    TELEMETRY_FIELD_PHT_TEMPERATURE,
+    TELEMETRY_FIELD_PHT_PRESSURE,
+    TELEMETRY_FIELD_PHT_HUMIDITY,
+    TELEMETRY_FIELD_TEMPHUM14_TEMPERATURE,
+    TELEMETRY_FIELD_TEMPHUM14_HUMIDITY,
+    TELEMETRY_FIELD_ULP_TEMPERATURE,
+    TELEMETRY_FIELD_ULP_PRESSURE,
+    TELEMETRY_FIELD_VAV_TEMPERATURE,
+    TELEMETRY_FIELD_VAV_PRESSURE,
+    TELEMETRY_FIELD_ULP_PRESSURE_MIN,
+    TELEMETRY_FIELD_ULP_PRESSURE_MAX,
+    TELEMETRY_FIELD_ULP_PRESSURE_STDDEV,
+    TELEMETRY_FIELD_VAV_PRESSURE_MIN,
+    TELEMETRY_FIELD_VAV_PRESSURE_MAX,
+    TELEMETRY_FIELD_VAV_PRESSURE_STDDEV,
+    TELEMETRY_FIELD_COUNT
+} TELEMETRY_FIELD;
+
+/* Name and number of fractional digits of each field, 0 sends an integer */
+static const struct
+{
+    const CHAR *name;
+    UINT        fractional_digits;
+} telemetry_fields[TELEMETRY_FIELD_COUNT] =
+{
+    [TELEMETRY_FIELD_WFI32IOT_TEMPERATURE]       = {"WFI32IoT_temperature", 2},
+    [TELEMETRY_FIELD_WFI32IOT_LIGHT]             = {"WFI32IoT_light", 0},
+    [TELEMETRY_FIELD_WFI32CURIOSITY_TEMPERATURE] = {"WFI32Curiosity_temperature", 2},
+    [TELEMETRY_FIELD_ALT2_TEMPERATURE]           = {"ALT2_temperature", 2},
+    [TELEMETRY_FIELD_ALT2_PRESSURE]              = {"ALT2_pressure", 2},
+    [TELEMETRY_FIELD_ALT2_ALTITUDE]              = {"ALT2_altitude", 2},
+    [TELEMETRY_FIELD_PHT_TEMPERATURE]            = {"PHT_temperature", 2},
+    [TELEMETRY_FIELD_PHT_PRESSURE]               = {"PHT_pressure", 2},
+    [TELEMETRY_FIELD_PHT_HUMIDITY]               = {"PHT_humidity", 2},
+    [TELEMETRY_FIELD_TEMPHUM14_TEMPERATURE]      = {"TEMPHUM14_temperature", 2},
+    [TELEMETRY_FIELD_TEMPHUM14_HUMIDITY]         = {"TEMPHUM14_humidity", 2},
+    [TELEMETRY_FIELD_ULP_TEMPERATURE]            = {"ULP_temperature", 2},
+    [TELEMETRY_FIELD_ULP_PRESSURE]               = {"ULP_pressure", 2},
+    [TELEMETRY_FIELD_VAV_TEMPERATURE]            = {"VAV_temperature", 2},
+    [TELEMETRY_FIELD_VAV_PRESSURE]               = {"VAV_pressure", 4},
+    [TELEMETRY_FIELD_ULP_PRESSURE_MIN]           = {"ULP_pressure_min", 2},
+    [TELEMETRY_FIELD_ULP_PRESSURE_MAX]           = {"ULP_pressure_max", 2},
+    [TELEMETRY_FIELD_ULP_PRESSURE_STDDEV]        = {"ULP_pressure_stddev", 2},
+    [TELEMETRY_FIELD_VAV_PRESSURE_MIN]           = {"VAV_pressure_min", 4},
+    [TELEMETRY_FIELD_VAV_PRESSURE_MAX]           = {"VAV_pressure_max", 4},
+    [TELEMETRY_FIELD_VAV_PRESSURE_STDDEV]        = {"VAV_pressure_stddev", 4},
+};
+
+#ifdef TELEMETRY_EXCEPTION_ENABLE
+/* Max silence of a field in seconds, 0 sends every reading. Set by the device twin */
+static volatile UINT telemetry_heartbeat;
+
+/* Per field deadbands (set by the device twin) and last value sent */
+static struct
+{
+    float deadband;
+    float deadband_percent;
+    double last_value;
+    ULONG last_tick;
+    UCHAR reported;
+} telemetry_exception[TELEMETRY_FIELD_COUNT];
+#endif /* TELEMETRY_EXCEPTION_ENABLE */
+
+#ifdef PNP_CERTIFICATION_TESTING
+/* Latest readings of the per-sensor certification messages, taken by the
+   dispatcher and sent by the telemetry thread */
+typedef struct
+{
+    float ALT2_temperature, ALT2_pressure, ALT2_altitude;
+    float PHT_temperature, PHT_pressure, PHT_humidity;
+    float TEMPHUM14_temperature, TEMPHUM14_humidity;
+    float ULP_temperature, ULP_pressure;
+    float VAV_temperature, VAV_pressure;
+} TELEMETRY_CERTIFICATION;
+static TELEMETRY_CERTIFICATION telemetry_certification;
+static volatile UINT telemetry_certification_pending;
+#endif /* PNP_CERTIFICATION_TESTING */
+
+#ifdef TELEMETRY_JOURNAL_ENABLE
+/* Readings of the current group go to the journal, the hub was unreachable when it started */
+static UINT telemetry_offline;
+/* Unix time of the current group, 0 if unknown */
+static ULONG telemetry_timestamp;
+/* Counter of the current group, splits groups of the same second in the journal */
+static UCHAR telemetry_group;
+/* Readings of the open message, journaled if it does not go out */
+#define TELEMETRY_UNSENT_MAX                (4 * SAMPLE_TELEMETRY_GROUP_MAX)
+static struct
+{
+    UCHAR field;
+    UCHAR group;
+    ULONG timestamp;
+    float value;
+} telemetry_unsent[TELEMETRY_UNSENT_MAX];
+static UINT telemetry_unsent_count;
+static APP_JOURNAL_RECORD telemetry_journal_records[TELEMETRY_JOURNAL_BATCH_MAX];
+#endif /* TELEMETRY_JOURNAL_ENABLE */
 #endif /* DISABLE_TELEMETRY_SAMPLE */
 
 #ifndef DISABLE_C2D_SAMPLE
@@ -156,14 +319,49 @@ static ULONG sample_device_twin_thread_stack[SAMPLE_STACK_SIZE / sizeof(ULONG)];
 
 #ifndef DISABLE_APP_CTRL_SAMPLE
 extern button_press_data_t button_press_data;
-static TX_THREAD sample_app_ctrl_thread;
-static ULONG sample_app_ctrl_thread_stack[SAMPLE_STACK_SIZE / sizeof(ULONG)];
 #endif /* DISABLE_APP_CTRL_SAMPLE */
 
-#ifndef DISABLE_PERIOD_TIMER_SAMPLE
-static TX_THREAD sample_period_timer_thread;
-static ULONG sample_period_timer_thread_stack[SAMPLE_STACK_SIZE / sizeof(ULONG)];
-#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
+/* Events of the sample dispatcher, the thread of sample_entry waits on them
+   instead of the telemetry, application control and period timer threads
+   polling on their own. It only samples and posts, anything that goes over
+   the network is signalled to the telemetry or the connection thread */
+#define SAMPLE_EVENT_TELEMETRY      ((ULONG)0x00000001)
+#define SAMPLE_EVENT_INTERVAL       ((ULONG)0x00000002)
+#define SAMPLE_EVENT_BUTTON         ((ULONG)0x00000004)
+#define SAMPLE_EVENT_TICK           ((ULONG)0x00000008)
+#define SAMPLE_EVENT_CONNECTION     ((ULONG)0x00000010)
+#define SAMPLE_EVENT_RECONNECT      ((ULONG)0x00000020)
+#define SAMPLE_EVENT_REPORTED       ((ULONG)0x00000040)
+#define SAMPLE_EVENT_METHOD         ((ULONG)0x00000080)
+#define SAMPLE_EVENT_ALL            (SAMPLE_EVENT_TELEMETRY | SAMPLE_EVENT_INTERVAL | SAMPLE_EVENT_TICK)
+/* Events of the connection thread, connects may block for SAMPLE_CONNECT_WAIT */
+#define SAMPLE_EVENT_NETWORK        (SAMPLE_EVENT_CONNECTION | SAMPLE_EVENT_RECONNECT | \
+                                     SAMPLE_EVENT_REPORTED | SAMPLE_EVENT_METHOD)
+/* State flag, not an event: set while the hub client is connected, the C2D,
+   direct method and device twin threads wait on it */
+#define SAMPLE_EVENT_CONNECTED      ((ULONG)0x80000000)
+/* Not a dispatcher event: readings are in the ring, the telemetry thread waits on it */
+#define SAMPLE_EVENT_UPLINK         ((ULONG)0x40000000)
+/* Events of the telemetry thread, button presses go out as telemetry */
+#define SAMPLE_EVENT_TELEMETRY_THREAD (SAMPLE_EVENT_UPLINK | SAMPLE_EVENT_BUTTON)
+static TX_EVENT_FLAGS_GROUP sample_events;
+static UCHAR sample_events_created;
+
+/* Connects and disconnects the hub client */
+static TX_THREAD sample_connection_thread;
+static ULONG sample_connection_thread_stack[SAMPLE_CONNECTION_STACK_SIZE / sizeof(ULONG)];
+/* Hub reconnect backoff, see SAMPLE_RECONNECT_BACKOFF_MIN_SECONDS */
+static TX_TIMER sample_reconnect_timer;
+static UINT sample_reconnect_attempt;
+static UCHAR sample_reconnect_pending;
+static ULONG sample_jitter_state;
+/* Incremented on every connect, the device twin thread resyncs on a change */
+static volatile UINT sample_connection_count;
+
+#if !defined(DISABLE_APP_CTRL_SAMPLE) || !defined(DISABLE_PERIOD_TIMER_SAMPLE)
+/* LED refresh and reboot countdown */
+static TX_TIMER sample_tick_timer;
+#endif /* !DISABLE_APP_CTRL_SAMPLE || !DISABLE_PERIOD_TIMER_SAMPLE */
 
 void sample_entry(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr, UINT (*unix_time_callback)(ULONG *unix_time));
 #ifdef ENABLE_DPS_SAMPLE
@@ -172,9 +370,15 @@ static UINT sample_dps_entry(UCHAR **iothub_hostname, UINT *iothub_hostname_leng
 #endif /* ENABLE_DPS_SAMPLE */
 
 #ifndef DISABLE_TELEMETRY_SAMPLE
+static VOID sample_telemetry_init(VOID);
+static VOID sample_telemetry_send(VOID);
 static void sample_telemetry_thread_entry(ULONG parameter);
 #endif /* DISABLE_TELEMETRY_SAMPLE */
 
+#ifndef DISABLE_APP_CTRL_SAMPLE
+static VOID sample_button_events_send(VOID);
+#endif /* DISABLE_APP_CTRL_SAMPLE */
+
 #ifndef DISABLE_C2D_SAMPLE
 static void sample_c2d_thread_entry(ULONG parameter);
 #endif /* DISABLE_C2D_SAMPLE */
@@ -187,13 +391,8 @@ static void sample_direct_method_thread_entry(ULONG parameter);
 static void sample_device_twin_thread_entry(ULONG parameter);
 #endif /* DISABLE_DEVICE_TWIN_SAMPLE */
 
-#ifndef DISABLE_APP_CTRL_SAMPLE
-static void sample_app_ctrl_thread_entry(ULONG parameter);
-#endif /* DISABLE_APP_CTRL_SAMPLE */
-
-#ifndef DISABLE_PERIOD_TIMER_SAMPLE
-static void sample_period_timer_thread_entry(ULONG parameter);
-#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
+static void sample_connection_thread_entry(ULONG parameter);
+static VOID sample_dispatch(VOID);
 
 static VOID printf_packet(NX_PACKET *packet_ptr)
 {
@@ -204,14 +403,23 @@ static VOID printf_packet(NX_PACKET *packet_ptr)
         packet_ptr = packet_ptr -> nx_packet_next;
     }
 }
-static VOID sprintf_packet(char* buf, NX_PACKET *packet_ptr)
+static VOID sprintf_packet(char* buf, UINT size, NX_PACKET *packet_ptr)
 {
-    while (packet_ptr != NX_NULL)
+UINT length = 0;
+UINT chunk;
+
+    while ((packet_ptr != NX_NULL) && (length + 1 < size))
     {
-        sprintf(buf, "%.*s", (INT)(packet_ptr -> nx_packet_append_ptr - packet_ptr -> nx_packet_prepend_ptr),
-               (CHAR *)packet_ptr -> nx_packet_prepend_ptr);
+        chunk = (UINT)(packet_ptr -> nx_packet_append_ptr - packet_ptr -> nx_packet_prepend_ptr);
+        if (chunk > size - 1 - length)
+        {
+            chunk = size - 1 - length;
+        }
+        memcpy(&buf[length], packet_ptr -> nx_packet_prepend_ptr, chunk);
+        length += chunk;
         packet_ptr = packet_ptr -> nx_packet_next;
     }
+    buf[length] = 0;
 }
 static bool find_property_value(char*buf, const char* param, char*retStr )
 {
@@ -238,113 +446,310 @@ static bool find_property_value(char*buf, const char* param, char*retStr )
     }
 }
 
-#define PROPERTY_TELEMETRY_INTERVAL "\"telemetryInterval\""
-#define PROPERTY_LEDY "\"led_y\""
-#define PROPERTY_VERSION_FIELD "\"$version\""
+#ifndef DISABLE_DEVICE_TWIN_SAMPLE
+#ifdef WFI32_IoT_BOARD
+#define SAMPLE_TWIN_LED                     APP_LED_YELLOW
+#else
+#define SAMPLE_TWIN_LED                     APP_LED_RED
+#endif
 
-/* static int parse_packet_data(char* packetData, char* responseProperty, int responseSize)
- 
-   packetData is a JSON (input) character array from proper write
-   responseProperty is the (output) char array to return the response data
-   responseSize (input) is the size of responseProperty array
-   property_version (output) is the version from the packet.
-  
-   returns responseLength (int), with the size of response.  Will return 0 if no data was found
- */
-static int parse_packet_data(char* packetData, char* responseProperty, int responseSize)
-{    
-    
-    char propertyValue[30];
-    char tempStr[60];
-    int responseLength = 0;
-    
-    memset(responseProperty, 0, responseSize);
-    responseProperty[0] = '{';
-    bPropertyTIFound = find_property_value(packetData, PROPERTY_TELEMETRY_INTERVAL, propertyValue);
-    if(bPropertyTIFound == true)
-    {
-        //printf("%s = %s\r\n", PROPERTY_TELEMETRY_INTERVAL, propertyValue);
-        AZ_telemetryInterval = atoi(propertyValue);
-        sprintf(tempStr, "%s: %s", PROPERTY_TELEMETRY_INTERVAL, propertyValue);
-        responseLength += strlen(tempStr);
-        strcat(responseProperty, tempStr);            
-    } 
-    
-    bPropertyYLEDFound = find_property_value(packetData, PROPERTY_LEDY, propertyValue);
-    if(bPropertyYLEDFound == true)
+static VOID sample_twin_interval_set(UINT index, double value)
+{
+    NX_PARAMETER_NOT_USED(index);
+    AZ_telemetryInterval = (uint32_t)value;
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_INTERVAL, TX_OR);
+}
+
+static double sample_twin_interval_get(UINT index)
+{
+    NX_PARAMETER_NOT_USED(index);
+    return(AZ_telemetryInterval);
+}
+
+static VOID sample_twin_led_set(UINT index, double value)
+{
+    NX_PARAMETER_NOT_USED(index);
+    appLedCtrl[SAMPLE_TWIN_LED].mode = (APP_LED_MODE)value;
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_TICK, TX_OR);
+}
+
+static double sample_twin_led_get(UINT index)
+{
+    NX_PARAMETER_NOT_USED(index);
+    return(appLedCtrl[SAMPLE_TWIN_LED].mode);
+}
+
+#if defined(TELEMETRY_EXCEPTION_ENABLE) && !defined(DISABLE_TELEMETRY_SAMPLE)
+static VOID sample_twin_heartbeat_set(UINT index, double value)
+{
+    NX_PARAMETER_NOT_USED(index);
+    telemetry_heartbeat = (UINT)value;
+}
+
+static double sample_twin_heartbeat_get(UINT index)
+{
+    NX_PARAMETER_NOT_USED(index);
+    return(telemetry_heartbeat);
+}
+
+static VOID sample_twin_deadband_set(UINT index, double value)
+{
+    telemetry_exception[index].deadband = (float)value;
+}
+
+static double sample_twin_deadband_get(UINT index)
+{
+    return(telemetry_exception[index].deadband);
+}
+
+static VOID sample_twin_deadband_percent_set(UINT index, double value)
+{
+    telemetry_exception[index].deadband_percent = (float)value;
+}
+
+static double sample_twin_deadband_percent_get(UINT index)
+{
+    return(telemetry_exception[index].deadband_percent);
+}
+#endif /* TELEMETRY_EXCEPTION_ENABLE && !DISABLE_TELEMETRY_SAMPLE */
+
+/* Writable properties, a new one only needs an entry here and in the device model */
+static const SAMPLE_TWIN_PROPERTY sample_twin_properties[] =
+{
+    {"telemetryInterval",  NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, 86400, 0,
+     sample_twin_interval_set, sample_twin_interval_get},
+    {"led_y",              NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, APP_LED_MODE_INVALID - 1, 0,
+     sample_twin_led_set, sample_twin_led_get},
+#if defined(TELEMETRY_EXCEPTION_ENABLE) && !defined(DISABLE_TELEMETRY_SAMPLE)
+    {"telemetryHeartbeat", NX_FALSE, SAMPLE_TWIN_TYPE_INTEGER, 0, 86400, 0,
+     sample_twin_heartbeat_set, sample_twin_heartbeat_get},
+    {"_deadband",          NX_TRUE,  SAMPLE_TWIN_TYPE_DOUBLE,  0, FLT_MAX, 4,
+     sample_twin_deadband_set, sample_twin_deadband_get},
+    {"_deadbandPercent",   NX_TRUE,  SAMPLE_TWIN_TYPE_DOUBLE,  0, 100, 2,
+     sample_twin_deadband_percent_set, sample_twin_deadband_percent_get},
+#endif /* TELEMETRY_EXCEPTION_ENABLE && !DISABLE_TELEMETRY_SAMPLE */
+};
+#define SAMPLE_TWIN_PROPERTY_COUNT          (sizeof(sample_twin_properties) / sizeof(sample_twin_properties[0]))
+
+#if defined(TELEMETRY_EXCEPTION_ENABLE) && !defined(DISABLE_TELEMETRY_SAMPLE)
+static const CHAR *sample_twin_field_name(UINT field)
+{
+    return(telemetry_fields[field].name);
+}
+
+static const SAMPLE_TWIN_TABLE sample_twin_table =
+{
+    sample_twin_properties, SAMPLE_TWIN_PROPERTY_COUNT, TELEMETRY_FIELD_COUNT, sample_twin_field_name
+};
+#else
+static const SAMPLE_TWIN_TABLE sample_twin_table =
+{
+    sample_twin_properties, SAMPLE_TWIN_PROPERTY_COUNT, 0, NX_NULL
+};
+#endif /* TELEMETRY_EXCEPTION_ENABLE && !DISABLE_TELEMETRY_SAMPLE */
+
+/* Acknowledge the properties of one twin update in a single reported
+   properties message, rejected ones with 400 and the value kept */
+static UINT sample_twin_ack_send(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, const SAMPLE_TWIN_ACKS *acks_ptr,
+                                 ULONG version)
+{
+NX_AZURE_IOT_JSON_WRITER json_writer;
+NX_PACKET *packet_ptr;
+CHAR name[SAMPLE_TWIN_NAME_MAX];
+UINT name_length;
+UINT response_status;
+UINT request_id;
+UINT status;
+UINT index;
+UINT i;
+const SAMPLE_TWIN_PROPERTY *property_ptr;
+UINT rejected;
+double value;
+
+    if ((status = nx_azure_iot_hub_client_reported_properties_create(hub_client_ptr,
+                                                                     &packet_ptr, NX_WAIT_FOREVER)))
+    {
+        return(status);
+    }
+
+    if ((status = nx_azure_iot_json_writer_init(&json_writer, packet_ptr, NX_WAIT_FOREVER)) ||
+        (status = nx_azure_iot_json_writer_append_begin_object(&json_writer)))
+    {
+        nx_packet_release(packet_ptr);
+        return(status);
+    }
+
+    for (i = 0; i < SAMPLE_TWIN_PROPERTY_COUNT; i++)
     {
-        if(responseLength>0)
+        property_ptr = &sample_twin_properties[i];
+        for (index = 0; index < 32; index++)
         {
-            strcat(responseProperty,", ");
+            if (((acks_ptr -> accepted[i] | acks_ptr -> rejected[i]) & (1UL << index)) == 0)
+            {
+                continue;
+            }
+
+            rejected = (acks_ptr -> rejected[i] & (1UL << index)) ? NX_TRUE : NX_FALSE;
+            name_length = sample_twin_property_name(&sample_twin_table, i, index, name, sizeof(name));
+            value = property_ptr -> get(index);
+            if ((status = nx_azure_iot_hub_client_reported_properties_status_begin(hub_client_ptr, &json_writer,
+                                                                                   (UCHAR *)name, name_length,
+                                                                                   rejected ? 400 : 200, version,
+                                                                                   rejected ? (UCHAR *)"Invalid value" : NX_NULL,
+                                                                                   rejected ? sizeof("Invalid value") - 1 : 0)) ||
+                (status = (property_ptr -> fractional_digits == 0) ?
+                          nx_azure_iot_json_writer_append_int32(&json_writer, (int32_t)value) :
+                          nx_azure_iot_json_writer_append_double(&json_writer, value,
+                                                                 (INT)property_ptr -> fractional_digits)) ||
+                (status = nx_azure_iot_hub_client_reported_properties_status_end(hub_client_ptr, &json_writer)))
+            {
+                nx_packet_release(packet_ptr);
+                return(status);
+            }
         }
-        //printf("%s = %s\r\n", PROPERTY_LEDY, propertyValue);
-#ifdef WFI32_IoT_BOARD        
-        appLedCtrl[APP_LED_YELLOW].mode = atoi(propertyValue);
-#else
-        appLedCtrl[APP_LED_RED].mode = atoi(propertyValue);
-#endif        
-        sprintf(tempStr, "%s: %s", PROPERTY_LEDY, propertyValue);
-        responseLength += strlen(tempStr);
-        strcat(responseProperty, tempStr);            
     }
-    
 
-    strcat(responseProperty, "}");
-    return strlen(responseProperty);
+    if ((status = nx_azure_iot_json_writer_append_end_object(&json_writer)))
+    {
+        nx_packet_release(packet_ptr);
+        return(status);
+    }
+
+    if ((status = nx_azure_iot_hub_client_reported_properties_send(hub_client_ptr,
+                                                                   packet_ptr, &request_id,
+                                                                   &response_status, NX_NULL,
+                                                                   (5 * NX_IP_PERIODIC_RATE))))
+    {
+        nx_packet_release(packet_ptr);
+        return(status);
+    }
+
+    if ((response_status < 200) || (response_status >= 300))
+    {
+        printf("device twin report properties failed with code : %d\r\n", response_status);
+    }
+
+    return(NX_AZURE_IOT_SUCCESS);
 }
 
-static VOID sample_send_integer_write_proterty_response(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, 
-                                                        UCHAR* property_name_ptr, UINT property_name_len, int propertyIntValue,
-                                                        UINT status, ULONG version, UCHAR *description_ptr,
-                                                        UINT description_len)
+/* Apply a twin update and acknowledge the writable properties it contains */
+static VOID sample_twin_update(NX_PACKET *packet_ptr, UINT full_document)
 {
-    NX_AZURE_IOT_JSON_WRITER json_writer;
-    NX_PACKET *packet_ptr;
-    UINT response_status;
-    UINT request_id;
+SAMPLE_TWIN_ACKS acks;
+CHAR name[SAMPLE_TWIN_NAME_MAX];
+ULONG version = 0;
+UINT pending = NX_FALSE;
+UINT status;
+UINT index;
+UINT i;
 
-    if (nx_azure_iot_hub_client_reported_properties_create(hub_client_ptr,
-                                                           &packet_ptr, NX_WAIT_FOREVER))
+    memset(&acks, 0, sizeof(acks));
+    if ((status = sample_twin_desired_parse(&sample_twin_table, packet_ptr, full_document, &acks, &version)))
     {
-        printf("Failed to build reported response\r\n");
-        return;
+
+        /* Still acknowledge what was applied before the error.  */
+        printf("device twin parse failed!: error code = 0x%08x\r\n", status);
     }
 
-    if (nx_azure_iot_json_writer_init(&json_writer, packet_ptr, NX_WAIT_FOREVER))
+    for (i = 0; i < SAMPLE_TWIN_PROPERTY_COUNT; i++)
+    {
+        for (index = 0; index < 32; index++)
+        {
+            if ((acks.accepted[i] | acks.rejected[i]) & (1UL << index))
+            {
+                sample_twin_property_name(&sample_twin_table, i, index, name, sizeof(name));
+                printf("Desired property %s %s\r\n", name,
+                       (acks.accepted[i] & (1UL << index)) ? "applied" : "rejected");
+                pending = NX_TRUE;
+            }
+        }
+    }
+    if (pending == NX_FALSE)
     {
-        printf("Failed to build reported response\r\n");
-        nx_packet_release(packet_ptr);
         return;
     }
 
-    if (nx_azure_iot_json_writer_append_begin_object(&json_writer) ||
-        nx_azure_iot_hub_client_reported_properties_status_begin(hub_client_ptr, &json_writer, 
-                                                                 property_name_ptr,
-                                                                 property_name_len-1,
-                                                                 status, version,
-                                                                 description_ptr, description_len) ||
-        nx_azure_iot_json_writer_append_int32(&json_writer,
-                                               propertyIntValue) ||
-        nx_azure_iot_hub_client_reported_properties_status_end(hub_client_ptr, &json_writer) ||
-        nx_azure_iot_json_writer_append_end_object(&json_writer))
+    if ((status = sample_twin_ack_send(&iothub_client, &acks, version)))
     {
-        printf("Failed to build reported response\r\n");
-        nx_packet_release(packet_ptr);
+        printf("device twin acknowledge failed!: error code = 0x%08x\r\n", status);
     }
-    else
+}
+#endif /* DISABLE_DEVICE_TWIN_SAMPLE */
+
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+/* Reported LED states. The shadow holds the values the hub last acknowledged,
+   only the entries that differ from it are sent, in one patch */
+typedef struct
+{
+    const CHAR *name;
+    UINT        name_length;
+    UINT        led;
+} SAMPLE_REPORTED_PROPERTY;
+
+static const SAMPLE_REPORTED_PROPERTY sample_reported_properties[] =
+{
+    {sample_prop_name_LED_red,    sizeof(sample_prop_name_LED_red) - 1,    APP_LED_RED},
+    {sample_prop_name_LED_green,  sizeof(sample_prop_name_LED_green) - 1,  APP_LED_GREEN},
+#ifdef WFI32_IoT_BOARD
+    {sample_prop_name_LED_yellow, sizeof(sample_prop_name_LED_yellow) - 1, APP_LED_YELLOW},
+    {sample_prop_name_LED_blue,   sizeof(sample_prop_name_LED_blue) - 1,   APP_LED_BLUE},
+#endif /* WFI32_IoT_BOARD */
+};
+#define SAMPLE_REPORTED_PROPERTY_COUNT      (sizeof(sample_reported_properties) / sizeof(sample_reported_properties[0]))
+
+static int32_t sample_reported_shadow[SAMPLE_REPORTED_PROPERTY_COUNT];
+/* Bit per shadow entry holding an acknowledged value */
+static ULONG sample_reported_valid;
+/* Reported properties $version of the last acknowledged patch */
+static ULONG sample_reported_version;
+static TX_TIMER sample_reported_timer;
+static UCHAR sample_reported_pending;
+
+/* Bit per reported property that differs from the shadow */
+static ULONG sample_reported_changes(int32_t *values)
+{
+ULONG changes = 0;
+UINT i;
+
+    for (i = 0; i < SAMPLE_REPORTED_PROPERTY_COUNT; i++)
     {
-        if (nx_azure_iot_hub_client_reported_properties_send(hub_client_ptr,
-                                                             packet_ptr, &request_id,
-                                                             &response_status, NX_NULL,
-                                                             (5 * NX_IP_PERIODIC_RATE)))
+        values[i] = (int32_t)appLedCtrl[sample_reported_properties[i].led].mode;
+        if (((sample_reported_valid & (1UL << i)) == 0) || (values[i] != sample_reported_shadow[i]))
         {
-            printf("Failed to send reported response\r\n");
-            nx_packet_release(packet_ptr);
+            changes |= (1UL << i);
         }
     }
+
+    return(changes);
+}
+
+/* Send the reported properties after ticks unless a send is already due */
+static VOID sample_reported_schedule(ULONG ticks)
+{
+    if (sample_reported_pending)
+    {
+        return;
+    }
+
+    sample_reported_pending = NX_TRUE;
+    tx_timer_deactivate(&sample_reported_timer);
+    tx_timer_change(&sample_reported_timer, ticks, 0);
+    tx_timer_activate(&sample_reported_timer);
+}
+
+/* Start the coalescing window on a change, later changes join the same patch */
+static VOID sample_reported_check(VOID)
+{
+int32_t values[SAMPLE_REPORTED_PROPERTY_COUNT];
+
+    if (sample_reported_changes(values))
+    {
+        sample_reported_schedule(SAMPLE_REPORTED_COALESCE_PERIOD);
+    }
 }
 
-static void sample_reported_properties_send_action(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr)
+/* Send the changed reported properties in one patch, retried on failure */
+static VOID sample_reported_properties_send(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr)
 {
 UINT status = 0;
 UINT response_status;
@@ -352,7 +757,17 @@ UINT request_id;
 NX_AZURE_IOT_JSON_WRITER json_writer;
 NX_PACKET *packet_ptr;
 ULONG reported_property_version;
+int32_t values[SAMPLE_REPORTED_PROPERTY_COUNT];
+ULONG changes;
+UINT i;
 
+    sample_reported_pending = NX_FALSE;
+    if ((changes = sample_reported_changes(values)) == 0)
+    {
+        return;
+    }
+
+    /* The next tick or telemetry interval after the reconnect starts over.  */
     if ((appConnectStatus.wifi == false) || (appConnectStatus.cloud == false)) 
     {
         return;
@@ -362,6 +777,7 @@ ULONG reported_property_version;
                                                                      &packet_ptr, NX_WAIT_FOREVER)))
     {
         printf("Failed create reported properties: error code = 0x%08x\r\n", status);
+        sample_reported_schedule(SAMPLE_REPORTED_RETRY_PERIOD);
         return;
     }
     
@@ -369,32 +785,27 @@ ULONG reported_property_version;
     {
         printf("Failed init json writer: error code = 0x%08x\r\n", status);
         nx_packet_release(packet_ptr);
+        sample_reported_schedule(SAMPLE_REPORTED_RETRY_PERIOD);
         return;
     }
 
-    if ((status = nx_azure_iot_json_writer_append_begin_object(&json_writer)) ||
-        (status = nx_azure_iot_json_writer_append_property_with_int32_value(&json_writer,
-                                                                             (const UCHAR *)sample_prop_name_LED_red,
-                                                                             sizeof(sample_prop_name_LED_red) - 1,
-                                                                             appLedCtrl[APP_LED_RED].mode)) ||
-        (status = nx_azure_iot_json_writer_append_property_with_int32_value(&json_writer,
-                                                                             (const UCHAR *)sample_prop_name_LED_green,
-                                                                             sizeof(sample_prop_name_LED_green) - 1,
-                                                                             appLedCtrl[APP_LED_GREEN].mode)) ||
-#ifdef WFI32_IoT_BOARD            
-        (status = nx_azure_iot_json_writer_append_property_with_int32_value(&json_writer,
-                                                                             (const UCHAR *)sample_prop_name_LED_yellow,
-                                                                             sizeof(sample_prop_name_LED_yellow) - 1,
-                                                                             appLedCtrl[APP_LED_YELLOW].mode)) ||
-        (status = nx_azure_iot_json_writer_append_property_with_int32_value(&json_writer,
-                                                                             (const UCHAR *)sample_prop_name_LED_blue,
-                                                                             sizeof(sample_prop_name_LED_blue) - 1,
-                                                                             appLedCtrl[APP_LED_BLUE].mode)) ||
-#endif            
+    status = nx_azure_iot_json_writer_append_begin_object(&json_writer);
+    for (i = 0; (status == NX_AZURE_IOT_SUCCESS) && (i < SAMPLE_REPORTED_PROPERTY_COUNT); i++)
+    {
+        if (changes & (1UL << i))
+        {
+            status = nx_azure_iot_json_writer_append_property_with_int32_value(&json_writer,
+                                                                               (const UCHAR *)sample_reported_properties[i].name,
+                                                                               sample_reported_properties[i].name_length,
+                                                                               values[i]);
+        }
+    }
+    if ((status) ||
         (status = nx_azure_iot_json_writer_append_end_object(&json_writer)))
     {
         printf("Build reported property failed: error code = 0x%08x\r\n", status);
         nx_packet_release(packet_ptr);
+        sample_reported_schedule(SAMPLE_REPORTED_RETRY_PERIOD);
         return;
     }
  
@@ -406,15 +817,30 @@ ULONG reported_property_version;
     {
         printf("Reported properties failed!: error code = 0x%08x\r\n", status);
         nx_packet_release(packet_ptr);
+        sample_reported_schedule(SAMPLE_REPORTED_RETRY_PERIOD);
         return;
     }
 
     if ((response_status < 200) || (response_status >= 300))
     {
         printf("Reported properties failed with code : %d\r\n", response_status);
+        sample_reported_schedule(SAMPLE_REPORTED_RETRY_PERIOD);
         return;
     }
+
+    for (i = 0; i < SAMPLE_REPORTED_PROPERTY_COUNT; i++)
+    {
+        if (changes & (1UL << i))
+        {
+            sample_reported_shadow[i] = values[i];
+        }
+    }
+    sample_reported_valid |= changes;
+    sample_reported_version = reported_property_version;
+    printf("Reported properties version %lu\r\n", sample_reported_version);
 }
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
+
 static VOID connection_status_callback(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT status)
 {
     NX_PARAMETER_NOT_USED(hub_client_ptr);
@@ -422,15 +848,138 @@ static VOID connection_status_callback(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
     {
         printf("Disconnected from Azure IoT Hub!!!: error code = 0x%08x\r\n", status);
         appConnectStatus.cloud = false;
+        tx_event_flags_set(&sample_events, ~SAMPLE_EVENT_CONNECTED, TX_AND);
+
+        /* The connection thread schedules the reconnect.  */
+        tx_event_flags_set(&sample_events, SAMPLE_EVENT_CONNECTION, TX_OR);
     }
     else
     {
         printf("Connected to Azure IoT Hub!!!\r\n");
         appConnectStatus.cloud = true;
+        sample_connection_count++;
+        tx_event_flags_set(&sample_events, SAMPLE_EVENT_CONNECTED, TX_OR);
         LED_GREEN_On();
     }
 }
 
+/* Wi-Fi link change, called from wifiConnectCallback in app.c */
+void sample_wifi_notify(void)
+{
+    if (sample_events_created)
+    {
+        tx_event_flags_set(&sample_events, SAMPLE_EVENT_CONNECTION, TX_OR);
+    }
+}
+
+#if !defined(DISABLE_C2D_SAMPLE) || !defined(DISABLE_DIRECT_METHOD_SAMPLE) || !defined(DISABLE_DEVICE_TWIN_SAMPLE)
+/* Block the calling thread until the hub client is connected */
+static VOID sample_connected_wait(VOID)
+{
+ULONG events;
+
+    tx_event_flags_get(&sample_events, SAMPLE_EVENT_CONNECTED, TX_OR, &events, TX_WAIT_FOREVER);
+}
+#endif /* !DISABLE_C2D_SAMPLE || !DISABLE_DIRECT_METHOD_SAMPLE || !DISABLE_DEVICE_TWIN_SAMPLE */
+
+#if defined(ENABLE_DPS_SAMPLE) && defined(ENABLE_DPS_CACHE)
+/* Cache key of the current provisioning configuration */
+static uint32_t sample_dps_cache_key(VOID)
+{
+#ifdef USE_X509_WITH_ECC608
+    return(APP_IDENTITY_key((const uint8_t *)ID_SCOPE, strlen(ID_SCOPE),
+                            g_registration_id, g_registration_id_length));
+#else
+    return(APP_IDENTITY_key((const uint8_t *)ID_SCOPE, strlen(ID_SCOPE),
+                            (const uint8_t *)REGISTRATION_ID, strlen(REGISTRATION_ID)));
+#endif /* USE_X509_WITH_ECC608 */
+}
+
+static UINT sample_dps_cache_load(UCHAR **iothub_hostname, UINT *iothub_hostname_length,
+                                  UCHAR **iothub_device_id, UINT *iothub_device_id_length)
+{
+uint32_t hostname_length = sizeof(sample_iothub_hostname);
+uint32_t device_id_length = sizeof(sample_iothub_device_id);
+
+    if (!APP_IDENTITY_load(sample_dps_cache_key(), sample_iothub_hostname, &hostname_length,
+                           sample_iothub_device_id, &device_id_length))
+    {
+        return(NX_FALSE);
+    }
+
+    *iothub_hostname = sample_iothub_hostname;
+    *iothub_hostname_length = hostname_length;
+    *iothub_device_id = sample_iothub_device_id;
+    *iothub_device_id_length = device_id_length;
+    return(NX_TRUE);
+}
+
+/* Connect failures that mean the cached assignment is stale: the hub answered
+   and refused the device. DNS and socket errors are left to the network, a
+   cache dropped on every outage would send each reconnect through DPS */
+static UINT sample_dps_cache_rejected(UINT status)
+{
+    switch (status)
+    {
+        case NXD_MQTT_ERROR_IDENTIFYIER_REJECTED:
+        case NXD_MQTT_ERROR_BAD_USERNAME_PASSWORD:
+        case NXD_MQTT_ERROR_NOT_AUTHORIZED:
+            return(NX_TRUE);
+        default:
+            return(NX_FALSE);
+    }
+}
+#endif /* ENABLE_DPS_SAMPLE && ENABLE_DPS_CACHE */
+
+static UINT sample_initialize_iothub(NX_AZURE_IOT_HUB_CLIENT *iothub_client_ptr);
+
+/* Connect the hub client, on the connection thread. A cached assignment the
+   hub refuses is dropped and the client provisioned again through DPS, on the
+   first connect as on any reconnect. When that fails the client stays down and
+   the next call starts over from DPS */
+static UINT sample_connect(UINT clean_session)
+{
+UINT status;
+
+#if defined(ENABLE_DPS_SAMPLE) && defined(ENABLE_DPS_CACHE)
+    if (sample_iothub_reprovision == NX_FALSE)
+    {
+        status = nx_azure_iot_hub_client_connect(&iothub_client, clean_session, SAMPLE_CONNECT_WAIT);
+        if ((status == NX_AZURE_IOT_SUCCESS) || (sample_dps_cached == NX_FALSE) ||
+            (sample_dps_cache_rejected(status) == NX_FALSE))
+        {
+            return(status);
+        }
+
+        /* A hub that no longer takes the cached assignment gets a fresh one from DPS.  */
+        printf("Cached IoT Hub assignment rejected: error code = 0x%08x\r\n", status);
+        APP_IDENTITY_invalidate();
+        nx_azure_iot_hub_client_deinitialize(&iothub_client);
+        sample_iothub_reprovision = NX_TRUE;
+    }
+
+    if ((status = sample_initialize_iothub(&iothub_client)))
+    {
+        printf("Failed to initialize iothub client: error code = 0x%08x\r\n", status);
+        return(status);
+    }
+    sample_iothub_reprovision = NX_FALSE;
+
+    /* Another hub, nothing to resume.  */
+    clean_session = NX_TRUE;
+#endif /* ENABLE_DPS_SAMPLE && ENABLE_DPS_CACHE */
+
+    return(nx_azure_iot_hub_client_connect(&iothub_client, clean_session, SAMPLE_CONNECT_WAIT));
+}
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+static VOID sample_tls_resume_print(const CHAR *endpoint, const NX_SECURE_TLS_RESUME *resume_ptr)
+{
+    printf("%s TLS sessions: %lu resumed, %lu full handshakes\r\n", endpoint,
+           resume_ptr -> nx_secure_tls_resume_hits, resume_ptr -> nx_secure_tls_resume_misses);
+}
+
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 static UINT sample_initialize_iothub(NX_AZURE_IOT_HUB_CLIENT *iothub_client_ptr)
 {
 UINT status;
@@ -447,6 +996,16 @@ UINT iothub_device_id_length = sizeof(DEVICE_ID) - 1;
 #endif /* ENABLE_DPS_SAMPLE */
 
 #ifdef ENABLE_DPS_SAMPLE
+#ifdef ENABLE_DPS_CACHE
+
+    /* Reuse the hub assigned on an earlier boot.  */
+    if ((sample_dps_cached = sample_dps_cache_load(&iothub_hostname, &iothub_hostname_length,
+                                                   &iothub_device_id, &iothub_device_id_length)))
+    {
+        printf("Using cached IoT Hub assignment.\r\n");
+    }
+    else
+#endif /* ENABLE_DPS_CACHE */
 
     /* Run DPS.  */
     if ((status = sample_dps_entry(&iothub_hostname, &iothub_hostname_length,
@@ -455,6 +1014,13 @@ UINT iothub_device_id_length = sizeof(DEVICE_ID) - 1;
         printf("Failed on sample_dps_entry!: error code = 0x%08x\r\n", status);
         return(status);
     }
+#ifdef ENABLE_DPS_CACHE
+    else if (!APP_IDENTITY_store(sample_dps_cache_key(), iothub_hostname, iothub_hostname_length,
+                                 iothub_device_id, iothub_device_id_length))
+    {
+        printf("IoT Hub assignment not cached, DPS runs again on next boot\r\n");
+    }
+#endif /* ENABLE_DPS_CACHE */
 #endif /* ENABLE_DPS_SAMPLE */
 
     printf("IoTHub Host Name: %.*s; Device ID: %.*s.\r\n",
@@ -526,6 +1092,14 @@ UINT iothub_device_id_length = sizeof(DEVICE_ID) - 1;
     }
 #endif /* USE_DEVICE_CERTIFICATE */
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* Resume the TLS session of the previous connection.  */
+    else if ((status = nx_azure_iot_hub_client_tls_resume_set(iothub_client_ptr, &sample_iothub_tls_resume)))
+    {
+        printf("Failed on nx_azure_iot_hub_client_tls_resume_set!: error code = 0x%08x\r\n", status);
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
     /* Set connection status callback.  */
     else if ((status = nx_azure_iot_hub_client_connection_status_callback_set(iothub_client_ptr,
                                                                               connection_status_callback)))
@@ -551,6 +1125,12 @@ UINT iothub_device_id_length = sizeof(DEVICE_ID) - 1;
     }
 #endif /* DISABLE_DEVICE_TWIN_SAMPLE */
 
+    /* QoS 1 publishes wait for a PUBACK to free a slot instead of failing.  */
+    else if ((status = sample_telemetry_window_attach(iothub_client_ptr)))
+    {
+        printf("Telemetry window attach failed!: error code = 0x%08x\r\n", status);
+    }
+
     if (status)
     {
         nx_azure_iot_hub_client_deinitialize(iothub_client_ptr);
@@ -568,11 +1148,17 @@ static void log_callback(az_log_classification classification, UCHAR *msg, UINT
     }
 }
 
+/* Timer expiration, signals the dispatcher or the connection thread */
+static VOID sample_timer_entry(ULONG events)
+{
+    tx_event_flags_set(&sample_events, events, TX_OR);
+}
+
 void sample_entry(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr, UINT (*unix_time_callback)(ULONG *unix_time))
 {
 UINT status = 0;
-UINT loop = NX_TRUE;
 
+    sample_unix_time_get = unix_time_callback;
     nx_azure_iot_log_init(log_callback);
 
     /* Create Azure IoT handler.  */
@@ -619,26 +1205,70 @@ UINT loop = NX_TRUE;
         return;
     }
 
-    if (nx_azure_iot_hub_client_connect(&iothub_client, NX_TRUE, NX_WAIT_FOREVER))
+    /* Create the dispatcher events before the connection status callback and
+       the threads that signal them.  */
+    if ((status = tx_event_flags_create(&sample_events, "Sample Events")))
     {
-        printf("Failed on nx_azure_iot_hub_client_connect!\r\n");
+        printf("Failed to create sample events!: error code = 0x%08x\r\n", status);
         nx_azure_iot_hub_client_deinitialize(&iothub_client);
         nx_azure_iot_delete(&nx_azure_iot);
         return;
     }
+    sample_events_created = NX_TRUE;
+    if ((status = tx_timer_create(&sample_reconnect_timer, "Sample Reconnect Timer",
+                                  sample_timer_entry, SAMPLE_EVENT_RECONNECT,
+                                  1, 0, TX_NO_ACTIVATE)))
+    {
+        printf("Failed to create reconnect timer!: error code = 0x%08x\r\n", status);
+    }
 
-#ifndef DISABLE_TELEMETRY_SAMPLE
-
-    /* Create Telemetry sample thread.  */
-    if ((status = tx_thread_create(&sample_telemetry_thread, "Sample Telemetry Thread",
-                                   sample_telemetry_thread_entry, 0,
-                                   (UCHAR *)sample_telemetry_thread_stack, SAMPLE_STACK_SIZE,
+    /* The first connect goes through the connection thread like any reconnect,
+       sampling starts meanwhile and journals while the hub is unreachable.  */
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_RECONNECT, TX_OR);
+    if ((status = tx_thread_create(&sample_connection_thread, "Sample Connection Thread",
+                                   sample_connection_thread_entry, 0,
+                                   (UCHAR *)sample_connection_thread_stack, SAMPLE_CONNECTION_STACK_SIZE,
                                    SAMPLE_THREAD_PRIORITY, SAMPLE_THREAD_PRIORITY,
                                    1, TX_AUTO_START)))
     {
-        printf("Failed to create telemetry sample thread!: error code = 0x%08x\r\n", status);
+        printf("Failed to create connection thread!: error code = 0x%08x\r\n", status);
     }
-#endif /* DISABLE_TELEMETRY_SAMPLE */
+
+#ifndef DISABLE_TELEMETRY_SAMPLE
+    if ((status = tx_timer_create(&sample_telemetry_timer, "Sample Telemetry Timer",
+                                  sample_timer_entry, SAMPLE_EVENT_TELEMETRY,
+                                  NX_IP_PERIODIC_RATE, NX_IP_PERIODIC_RATE, TX_NO_ACTIVATE)))
+    {
+        printf("Failed to create telemetry timer!: error code = 0x%08x\r\n", status);
+    }
+
+    /* Create the telemetry thread, it sends what the dispatcher puts in the ring.  */
+    sample_telemetry_ring_init(&telemetry_ring);
+    if ((status = tx_thread_create(&sample_telemetry_thread, "Sample Telemetry Thread",
+                                   sample_telemetry_thread_entry, 0,
+                                   (UCHAR *)sample_telemetry_thread_stack, SAMPLE_TELEMETRY_STACK_SIZE,
+                                   SAMPLE_THREAD_PRIORITY, SAMPLE_THREAD_PRIORITY,
+                                   1, TX_AUTO_START)))
+    {
+        printf("Failed to create telemetry sample thread!: error code = 0x%08x\r\n", status);
+    }
+#endif /* DISABLE_TELEMETRY_SAMPLE */
+#if !defined(DISABLE_APP_CTRL_SAMPLE) || !defined(DISABLE_PERIOD_TIMER_SAMPLE)
+    if ((status = tx_timer_create(&sample_tick_timer, "Sample Tick Timer",
+                                  sample_timer_entry, SAMPLE_EVENT_TICK,
+                                  SAMPLE_TICK_PERIOD, SAMPLE_TICK_PERIOD, TX_AUTO_ACTIVATE)))
+    {
+        printf("Failed to create tick timer!: error code = 0x%08x\r\n", status);
+    }
+#endif /* !DISABLE_APP_CTRL_SAMPLE || !DISABLE_PERIOD_TIMER_SAMPLE */
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+    if ((status = tx_timer_create(&sample_reported_timer, "Sample Reported Timer",
+                                  sample_timer_entry, SAMPLE_EVENT_REPORTED,
+                                  SAMPLE_REPORTED_COALESCE_PERIOD, 0, TX_NO_ACTIVATE)))
+    {
+        printf("Failed to create reported properties timer!: error code = 0x%08x\r\n", status);
+    }
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
 
 #ifndef DISABLE_C2D_SAMPLE
 
@@ -679,37 +1309,10 @@ UINT loop = NX_TRUE;
     }
 #endif /* DISABLE_DEVICE_TWIN_SAMPLE */
 
-#ifndef DISABLE_APP_CTRL_SAMPLE
-
-    /* Create Device twin sample thread.  */
-    if ((status = tx_thread_create(&sample_app_ctrl_thread, "Sample Application Control Thread",
-                                   sample_app_ctrl_thread_entry, 0,
-                                   (UCHAR *)sample_app_ctrl_thread_stack, SAMPLE_STACK_SIZE,
-                                   SAMPLE_THREAD_PRIORITY, SAMPLE_THREAD_PRIORITY,
-                                   1, TX_AUTO_START)))
-    {
-        printf("Failed to create application LED sample thread!: error code = 0x%08x\r\n", status);
-    }
-#endif /* DISABLE_APP_CTRL_SAMPLE */
-
-#ifndef DISABLE_PERIOD_TIMER_SAMPLE
 
-    /* Create Device twin sample thread.  */
-    if ((status = tx_thread_create(&sample_period_timer_thread, "Sample Period Timer Thread",
-                                   sample_period_timer_thread_entry, 0,
-                                   (UCHAR *)sample_period_timer_thread_stack, SAMPLE_STACK_SIZE,
-                                   SAMPLE_THREAD_PRIORITY, SAMPLE_THREAD_PRIORITY,
-                                   1, TX_AUTO_START)))
-    {
-        printf("Failed to create period timer sample thread!: error code = 0x%08x\r\n", status);
-    }
-#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
-    
-    /* Simply loop in sample.  */
-    while (loop)
-    {
-        tx_thread_sleep(NX_IP_PERIODIC_RATE);
-    }
+    /* Sampling, LEDs and the reboot countdown run on this thread, it never
+       waits on the network.  */
+    sample_dispatch();
 }
 
 #ifdef ENABLE_DPS_SAMPLE
@@ -719,6 +1322,11 @@ static UINT sample_dps_entry(UCHAR **iothub_hostname, UINT *iothub_hostname_leng
 UINT status;
 
     printf("Start Provisioning Client...\r\n");
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* DPS may assign another hub, which would only refuse the cached session.  */
+    sample_iothub_tls_resume.nx_secure_tls_resume_session_id_length = 0;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
   
     /* Initialize IoT provisioning client.  */
 #ifdef USE_X509_WITH_ECC608
@@ -797,6 +1405,13 @@ UINT status;
         printf("Failed on nx_azure_iot_provisioning_client_registration_payload_set!: error code = 0x%08x\r\n", status);
     }
 #endif
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* Resume the TLS session of the previous registration.  */
+    else if ((status = nx_azure_iot_provisioning_client_tls_resume_set(&prov_client, &sample_dps_tls_resume)))
+    {
+        printf("Failed on nx_azure_iot_provisioning_client_tls_resume_set!: error code = 0x%08x\r\n", status);
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
     /* Register device */
     else if ((status = nx_azure_iot_provisioning_client_register(&prov_client, NX_WAIT_FOREVER)))
     {
@@ -861,9 +1476,11 @@ void send_telemetry_message(ULONG parameter, UCHAR *message, UINT mesg_length)
         nx_azure_iot_hub_client_telemetry_message_delete(packet_ptr);
         return;
     }
- 
-    if (nx_azure_iot_hub_client_telemetry_send(&iothub_client, packet_ptr,
-                                               (UCHAR *)message, mesg_length, NX_WAIT_FOREVER))
+
+    /* Shares the QoS 1 window with the built telemetry.  */
+    if ((status = sample_telemetry_window_wait(&iothub_client, NX_WAIT_FOREVER)) ||
+        (status = nx_azure_iot_hub_client_telemetry_send(&iothub_client, packet_ptr,
+                                                         (UCHAR *)message, mesg_length, NX_WAIT_FOREVER)))
     {
         printf("Telemetry message send failed!: error code = 0x%08x\r\n", status);
         nx_azure_iot_hub_client_telemetry_message_delete(packet_ptr);
@@ -872,289 +1489,935 @@ void send_telemetry_message(ULONG parameter, UCHAR *message, UINT mesg_length)
     printf("%s\r\n", message);   
 }
 
-void send_button_event(ULONG parameter, UINT number, UINT count)
+#ifdef TELEMETRY_JOURNAL_ENABLE
+static VOID telemetry_journal_append(UINT field, UINT group, ULONG timestamp, double value)
 {
-    CHAR buffer[TELEMETRY_MSGLEN_MAX];
-    UINT buffer_length;
+    if (!APP_JOURNAL_append((uint8_t)field, (uint8_t)group, (uint32_t)timestamp, (float)value))
+    {
+        printf("Telemetry journal append failed!\r\n");
+    }
+}
 
-    NX_PARAMETER_NOT_USED(parameter);
-       
-    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"button_event\": {\"button_name\": \"SW%u\", \"press_count\": %u}}", number, count);
-    send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"total_press_count\": %u}", (button_press_data.sw1_press_count + button_press_data.sw2_press_count));
-    send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+/* Journal the readings of a message that did not go out, the drain sends
+   them once the hub takes messages again */
+static VOID telemetry_unsent_journal(VOID)
+{
+UINT index;
+
+    if (telemetry_unsent_count == 0)
+    {
+        return;
+    }
+
+    for (index = 0; index < telemetry_unsent_count; index++)
+    {
+        telemetry_journal_append(telemetry_unsent[index].field, telemetry_unsent[index].group,
+                                 telemetry_unsent[index].timestamp, telemetry_unsent[index].value);
+    }
+    printf("Telemetry message not sent, %u readings journaled\r\n", telemetry_unsent_count);
+    telemetry_unsent_count = 0;
 }
+#endif /* TELEMETRY_JOURNAL_ENABLE */
 
-void sample_telemetry_thread_entry(ULONG parameter)
+/* Send the pending telemetry message (if any) */
+static VOID telemetry_flush(VOID)
 {
-    CHAR buffer[TELEMETRY_MSGLEN_MAX];
-    UINT buffer_length;
-    UCHAR loop = NX_TRUE;
-#ifdef CLICK_ALTITUDE2 
-    UINT index_a;
-    static ALTITUDE2_Data altitude2;
-    float ALT2_temperature, ALT2_pressure, ALT2_altitude;
-#endif /* CLICK_ALTITUDE2 */
-#ifdef CLICK_PHT 
-    UINT index_b;
-    static PHT_Data pht;
-    float PHT_temperature, PHT_pressure, PHT_humidity;
-#endif /* CLICK_PHT */
-#ifdef CLICK_TEMPHUM14
-    uint32_t HTU31_serialNumber;
-    float TEMPHUM14_temperature;
-    float TEMPHUM14_humidity;
-#endif /* CLICK_ULTRALOWPRESS */
-#ifdef CLICK_ULTRALOWPRESS
-    uint32_t SM8436_serialNumber;
-    float ULP_temperature;
-    float ULP_pressure = 0.0;
-#endif /* CLICK_ULTRALOWPRESS */
-#ifdef CLICK_VAVPRESS
-    float VAV_temperature;
-    float VAV_pressure = 0.0;
-#endif /* CLICK_VAVPRESS */
-    NX_PARAMETER_NOT_USED(parameter);
+    UINT status;
 
-    APP_SENSORS_init();
-    
-    tx_thread_sleep(AZ_telemetryInterval * NX_IP_PERIODIC_RATE);
+    if (telemetry_builder.packet_ptr == NX_NULL)
+    {
+#ifdef TELEMETRY_JOURNAL_ENABLE
 
-#ifdef CLICK_ALTITUDE2
-    printf("<ALT2 Click> Initializing MS5607...\r\n");
-    ALTITUDE2_status = ALTITUDE2_init(&altitude2);
-    if (ALTITUDE2_status == ALTITUDE2_OK)
+        /* The message could not be created.  */
+        telemetry_unsent_journal();
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+        return;
+    }
+
+    if ((status = sample_telemetry_builder_send(&telemetry_builder)))
     {
-        for (index_a = 1; index_a < (ALTITUDE2_COEFFS_MAX+1); index_a++)
+        printf("Telemetry message send failed!: error code = 0x%08x\r\n", status);
+#ifdef TELEMETRY_JOURNAL_ENABLE
+        telemetry_unsent_journal();
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+    }
+#ifdef TELEMETRY_JOURNAL_ENABLE
+    telemetry_unsent_count = 0;
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+}
+
+/* Set the creation time of the open message, ISO 8601 with milliseconds */
+static UINT telemetry_ctime_add(uint64_t timestamp_ms)
+{
+time_t creation_time = (time_t)(timestamp_ms / 1000);
+CHAR creation_time_str[sizeof("YYYY-MM-DDTHH:MM:SS.mmmZ")];
+UINT length;
+
+    length = (UINT)strftime(creation_time_str, sizeof(creation_time_str), "%Y-%m-%dT%H:%M:%S", gmtime(&creation_time));
+    snprintf(&creation_time_str[length], sizeof(creation_time_str) - length, ".%03uZ", (UINT)(timestamp_ms % 1000));
+    return(sample_telemetry_builder_property_add(&telemetry_builder, "$.ctime", creation_time_str));
+}
+
+/* Append the offset of a batched group from the creation time of the message,
+   named after the sensor of its first reading, e.g. "PHT_dt" */
+static VOID telemetry_delta_append(UINT field)
+{
+const CHAR *name = telemetry_fields[field].name;
+const CHAR *end = strchr(name, '_');
+CHAR delta_name[24];
+
+    snprintf(delta_name, sizeof(delta_name), "%.*s_dt", (INT)((end != NX_NULL) ? (end - name) : strlen(name)), name);
+    sample_telemetry_builder_append_int32(&telemetry_builder, delta_name, telemetry_delta_ms);
+}
+
+/* Fields of the sensors of a group as a mask of telemetry_fields, the sensor
+   being the name up to its first '_' as for the "_dt" offset */
+static ULONG telemetry_sensor_fields(const SAMPLE_TELEMETRY_SAMPLE *sample_ptr)
+{
+ULONG fields = 0;
+const CHAR *name;
+size_t length;
+UINT index;
+UINT field;
+
+    for (index = 0; index < sample_ptr -> count; index++)
+    {
+        name = telemetry_fields[sample_ptr -> fields[index]].name;
+        length = strcspn(name, "_");
+        for (field = 0; field < TELEMETRY_FIELD_COUNT; field++)
         {
-            printf("<ALT2 Click> [PROM] C%d = %d\r\n", index_a, altitude2.data_prom[index_a-1]);
-            tx_thread_sleep(100);
+            if ((strncmp(telemetry_fields[field].name, name, length) == 0) &&
+                ((telemetry_fields[field].name[length] == '_') || (telemetry_fields[field].name[length] == '\0')))
+            {
+                fields |= (1UL << field);
+            }
         }
     }
-    else
+
+    return(fields);
+}
+
+/* Make sure a telemetry message is open with room for one more group of
+   readings, at most TELEMETRY_MSGLEN_MAX bytes.
+   With TELEMETRY_BATCH_ENABLE the groups of one interval share a message and a
+   new one is started when the next group could exceed TELEMETRY_BATCH_PAYLOAD_MAX,
+   or when the message already has a group of the same sensor: a ring that
+   backed up holds several intervals, and their keys must not repeat */
+static VOID telemetry_group_begin(const SAMPLE_TELEMETRY_SAMPLE *sample_ptr)
+{
+    UINT status;
+    ULONG sensor_fields = telemetry_sensor_fields(sample_ptr);
+
+    telemetry_tick = sample_ptr -> tick;
+    telemetry_delta_pending = NX_FALSE;
+#ifdef TELEMETRY_JOURNAL_ENABLE
+    telemetry_timestamp = (ULONG)(sample_ptr -> timestamp_ms / 1000);
+    telemetry_group++;
+
+    /* While disconnected the readings go to the flash journal  */
+    telemetry_offline = (appConnectStatus.cloud == false);
+    if (telemetry_offline)
     {
-        printf("<ALT2 Click> MS5607 was not detected\r\n");          
-    }    
-    tx_thread_sleep(100);
-#endif /* CLICK_ALTITUDE2 */
-#ifdef CLICK_PHT
-    printf("<PHT Click> Initializing MS8607...\r\n");
-    PHT_status = PHT_init(&pht);
-    if (PHT_status == PHT_OK)
+        return;
+    }
+
+    /* Room to keep the whole group should the message fail.  */
+    if ((telemetry_unsent_count + SAMPLE_TELEMETRY_GROUP_MAX) > TELEMETRY_UNSENT_MAX)
     {
-        for (index_b = 1; index_b < (PHT_COEFFS_MAX+1); index_b++)
+        telemetry_flush();
+    }
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+
+#ifdef TELEMETRY_BATCH_ENABLE
+    if (((sample_telemetry_builder_payload_length(&telemetry_builder) + TELEMETRY_MSGLEN_MAX) > TELEMETRY_BATCH_PAYLOAD_MAX) ||
+        (telemetry_message_sensors & sensor_fields))
+    {
+        telemetry_flush();
+    }
+#endif /* TELEMETRY_BATCH_ENABLE */
+
+    if (telemetry_builder.packet_ptr != NX_NULL)
+    {
+        telemetry_message_sensors |= sensor_fields;
+
+        /* Only the offset from the creation time of the message goes out.  */
+        if ((telemetry_base_ms != 0) && (sample_ptr -> timestamp_ms != telemetry_base_ms))
         {
-            printf("<PHT Click> [PROM] C%d = %d\r\n", index_b, pht.data_prom[index_b-1]);
-            tx_thread_sleep(100);
+            telemetry_delta_ms = (int32_t)(sample_ptr -> timestamp_ms - telemetry_base_ms);
+            telemetry_delta_pending = NX_TRUE;
         }
+        return;
     }
-    else
+
+    if ((status = sample_telemetry_builder_create(&telemetry_builder, &iothub_client, NX_WAIT_FOREVER)))
     {
-        printf("<PHT Click> MS8607 was not detected\r\n");          
-    }    
-    tx_thread_sleep(100);
-#endif /* CLICK_PHT */
-#ifdef CLICK_TEMPHUM14
-    printf("<TEMPHUM14 Click> Initializing HTU31...\r\n");
-    HTU31_serialNumber = TEMPHUM14_init(TEMPHUM14_I2C_SLAVE_ADDR_GND);
-    if (HTU31_serialNumber != 0)
+        printf("Telemetry message create failed!: error code = 0x%08x\r\n", status);
+        return;
+    }
+
+    if ((status = sample_telemetry_builder_qos_set(&telemetry_builder, TELEMETRY_QOS)))
     {
-        printf("<TEMPHUM14 Click> * Serial Number = %u\r\n", HTU31_serialNumber);    
+        printf("Telemetry qos set failed!: error code = 0x%08x\r\n", status);
+        sample_telemetry_builder_delete(&telemetry_builder);
+        return;
     }
-    else
+
+#ifdef TELEMETRY_ENCODING_CBOR
+    if ((status = sample_telemetry_builder_encoding_set(&telemetry_builder, SAMPLE_TELEMETRY_ENCODING_CBOR)))
     {
-        printf("<TEMPHUM14 Click> HTU31 not detected\r\n");          
+        printf("Telemetry encoding set failed!: error code = 0x%08x\r\n", status);
+        sample_telemetry_builder_delete(&telemetry_builder);
+        return;
     }
-    tx_thread_sleep(100);
-#endif /* CLICK_ULTRALOWPRESS */
-#ifdef CLICK_ULTRALOWPRESS
-    printf("<ULP Click> Initializing SM8436...\r\n");
-    SM8436_serialNumber = ULTRALOWPRESS_init();
-    if (ULTRALOWPRESS_status == ULTRALOWPRESS_OK)
+#endif /* TELEMETRY_ENCODING_CBOR */
+
+    /* Add properties to telemetry message.  */
+    for (int index = 0; index < MAX_PROPERTY_COUNT; index++)
     {
-        printf("<ULP Click> * Serial Number = %u\r\n", SM8436_serialNumber);    
+        if ((status = sample_telemetry_builder_property_add(&telemetry_builder,
+                                                            sample_properties[index][0],
+                                                            sample_properties[index][1])))
+        {
+            printf("Telemetry property add failed!: error code = 0x%08x\r\n", status);
+            sample_telemetry_builder_delete(&telemetry_builder);
+            return;
+        }
     }
-    else
+
+    telemetry_message_sensors = sensor_fields;
+
+    /* The first group of the message is stamped by its creation time.  */
+    telemetry_base_ms = sample_ptr -> timestamp_ms;
+    if ((telemetry_base_ms != 0) && (status = telemetry_ctime_add(telemetry_base_ms)))
     {
-        printf("<ULP Click> SM8436 not detected\r\n");          
+        printf("Telemetry property add failed!: error code = 0x%08x\r\n", status);
+        sample_telemetry_builder_delete(&telemetry_builder);
+        return;
     }
-    tx_thread_sleep(100);
-#endif /* CLICK_ULTRALOWPRESS */
-#ifdef CLICK_VAVPRESS
-    printf("<VAV Click> Initializing LMIS025B...\r\n");
-    VAVPRESS_init();
-    if (VAVPRESS_status == VAVPRESS_OK)
+}
+
+/* Close a group of readings; sends it right away unless batching */
+static VOID telemetry_group_end(VOID)
+{
+#ifndef TELEMETRY_BATCH_ENABLE
+    telemetry_flush();
+#endif /* TELEMETRY_BATCH_ENABLE */
+}
+
+/* Append one reading to the open telemetry message */
+static VOID telemetry_field_append(UINT field, double value)
+{
+    if (telemetry_fields[field].fractional_digits == 0)
     {
-        printf("<VAV Click> Retrieving Electronic Signature Data...\r\n");
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Part Number: %.11s\r\n", VAVPRESS_el_signature_data.part_number);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Firmware Version: %.3f\r\n", VAVPRESS_el_signature_data.firmware_version);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Pressure Range: %d Pa\r\n", VAVPRESS_el_signature_data.pressure_range);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Lot Number: %.7s\r\n", VAVPRESS_el_signature_data.lot_number);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Output Type: %c\r\n", VAVPRESS_el_signature_data.output_type);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Scale Factor: %d\r\n", VAVPRESS_el_signature_data.scale_factor);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Calibration ID: %.2s\r\n", VAVPRESS_el_signature_data.calibration_id);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Week Number: %d\r\n", VAVPRESS_el_signature_data.week_number);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Year Number: %d\r\n", VAVPRESS_el_signature_data.year_number);
-        tx_thread_sleep(100);
-        printf("<VAV Click> * Sequence Number: %d\r\n", VAVPRESS_el_signature_data.sequence_number);
+        sample_telemetry_builder_append_int32(&telemetry_builder, telemetry_fields[field].name, (int32_t)value);
     }
     else
     {
-        printf("<VAV Click> LMIS025B not detected\r\n");          
+        sample_telemetry_builder_append_double(&telemetry_builder, telemetry_fields[field].name, value,
+                                               telemetry_fields[field].fractional_digits);
     }
-    tx_thread_sleep(100);
-#endif /* CLICK_VAVPRESS */
+}
 
-    /* Loop to send telemetry messages */
-    while (loop)
+#ifdef TELEMETRY_EXCEPTION_ENABLE
+/* Report by exception: false if the reading is within the deadband of the
+   last value sent for the field and the field was sent within the heartbeat */
+static UINT telemetry_exception_check(UINT field, double value)
+{
+ULONG now = telemetry_tick;
+UINT heartbeat = telemetry_heartbeat;
+double threshold;
+
+    if (heartbeat == 0)
     {
-#ifdef WFI32IOT_SENSORS
-        //printf("\r\n<WFI32-IoT> Reading temperature & light sensors...\r\n");
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                "{\"WFI32IoT_temperature\": %.2f, \"WFI32IoT_light\": %u}",
-                APP_SENSORS_readTemperature(), APP_SENSORS_readLight() );
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-#endif /* WFI32IOT_SENSORS */
-#ifdef WFI32CURIOSITY_SENSORS
-        //printf("\r\n<WFI32-IoT> Reading temperature & light sensors...\r\n");
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                "{\"WFI32Curiosity_temperature\": %.2f}",
-                APP_SENSORS_readTemperature());
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-#endif /* WFI32CURIOSITY_SENSORS */
-#ifdef CLICK_ALTITUDE2
-        if (ALTITUDE2_status == ALTITUDE2_OK)
-        {
-            ALTITUDE2_readData(&altitude2, &ALT2_temperature, &ALT2_pressure, &ALT2_altitude);
-            buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                    "{\"ALT2_temperature\": %.2f, \"ALT2_pressure\": %.2f, \"ALT2_altitude\": %.2f}",
-                    ALT2_temperature, ALT2_pressure, ALT2_altitude );                
-            send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-        }
-#endif /* CLICK_ALTITUDE2 */
-#ifdef CLICK_PHT
-        if (PHT_status == PHT_OK)
-        {
-            PHT_getTemperaturePressure(&pht, &PHT_temperature, &PHT_pressure);            
-            PHT_getRelativeHumidity(&PHT_humidity);
-            buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                    "{\"PHT_temperature\": %.2f, \"PHT_pressure\": %.2f, \"PHT_humidity\": %.2f}",
-                    PHT_temperature, PHT_pressure, PHT_humidity );                 
-            send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-        }
-#endif /* CLICK_PHT */
-#ifdef CLICK_TEMPHUM14
-        if (HTU31_serialNumber != 0)
+        return(NX_TRUE);
+    }
+
+    if (telemetry_exception[field].reported &&
+        ((now - telemetry_exception[field].last_tick) < (heartbeat * NX_IP_PERIODIC_RATE)))
+    {
+        threshold = fabs(telemetry_exception[field].last_value) * telemetry_exception[field].deadband_percent / 100.0;
+        if (threshold < telemetry_exception[field].deadband)
         {
-            TEMPHUM14_setConversion( TEMPHUM14_I2C_SLAVE_ADDR_GND, 
-                    TEMPHUM14_CONVERSION_HUM_OSR_0_020, TEMPHUM14_CONVERSION_TEMP_0_040 );
-            TEMPHUM14_getTemperatureHumidity (TEMPHUM14_I2C_SLAVE_ADDR_GND, 
-                    &TEMPHUM14_temperature, &TEMPHUM14_humidity );
-            buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                    "{\"TEMPHUM14_temperature\": %.2f, \"TEMPHUM14_humidity\": %.2f}",
-                    TEMPHUM14_temperature, TEMPHUM14_humidity);              
-            send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+            threshold = telemetry_exception[field].deadband;
         }
-#endif /* CLICK_TEMPHUM14 */
-#ifdef CLICK_ULTRALOWPRESS
-        if (ULTRALOWPRESS_status == ULTRALOWPRESS_OK)
+        if (fabs(value - telemetry_exception[field].last_value) <= threshold)
         {
-            if (ULTRALOWPRESS_isReady())
-            {
-                //printf("\r\n<ULP Click> STATUS [ %x ] ", APP_SENSORS_data.i2c.rxBuffBytes[0]);
-                ULTRALOWPRESS_clearStatus();
-                ULP_temperature = ULTRALOWPRESS_getTemperature();
-                //printf("DSP_T [ %x ] ", APP_SENSORS_data.i2c.rxBuffBytes[0]);
-                ULP_pressure = ULTRALOWPRESS_getPressure();     
-                //printf("DSP_S [ %x ]\r\n", APP_SENSORS_data.i2c.rxBuffBytes[0]);
-                buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                        "{\"ULP_temperature\": %.2f, \"ULP_pressure\": %.2f}",
-                        ULP_temperature, ULP_pressure );                
-                send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-                if (ULP_pressure > ALARM_PRESSURE_PA)
-                {
-                    appConnectStatus.alarm = true;
-                }
-            }
-            else
-            {
-                //printf("\r\n<ULP Click> SM8436 is not ready...\r\n");
-            }
-            if (ULP_pressure < ALARM_PRESSURE_PA)
-            {
-                appConnectStatus.alarm = false; 
-            }
-            //tx_thread_sleep(500);
+            return(NX_FALSE);
         }
-#endif /* CLICK_ULTRALOWPRESS */
-#ifdef CLICK_VAVPRESS
-        if (VAVPRESS_status == VAVPRESS_OK)
+    }
+
+    telemetry_exception[field].reported = NX_TRUE;
+    telemetry_exception[field].last_value = value;
+    telemetry_exception[field].last_tick = now;
+    return(NX_TRUE);
+}
+#endif /* TELEMETRY_EXCEPTION_ENABLE */
+
+/* Add one reading to the current group */
+static VOID telemetry_append(UINT field, double value)
+{
+#ifdef TELEMETRY_EXCEPTION_ENABLE
+    if (!telemetry_exception_check(field, value))
+    {
+        return;
+    }
+#endif /* TELEMETRY_EXCEPTION_ENABLE */
+
+#ifdef TELEMETRY_JOURNAL_ENABLE
+    if (telemetry_offline)
+    {
+        telemetry_journal_append(field, telemetry_group, telemetry_timestamp, value);
+        return;
+    }
+
+    if (telemetry_unsent_count < TELEMETRY_UNSENT_MAX)
+    {
+        telemetry_unsent[telemetry_unsent_count].field = (UCHAR)field;
+        telemetry_unsent[telemetry_unsent_count].group = telemetry_group;
+        telemetry_unsent[telemetry_unsent_count].timestamp = telemetry_timestamp;
+        telemetry_unsent[telemetry_unsent_count].value = (float)value;
+        telemetry_unsent_count++;
+    }
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+
+    if (telemetry_delta_pending)
+    {
+        telemetry_delta_pending = NX_FALSE;
+        telemetry_delta_append(field);
+    }
+    telemetry_field_append(field, value);
+}
+
+#if defined(PNP_CERTIFICATION_TESTING) || defined(CLICK_VAVPRESS)
+/* Fixed-point text of a reading for the hand built messages, keeps float
+   support out of printf */
+static const CHAR *telemetry_fixed(CHAR *buffer, float value, UINT fractional_digits)
+{
+    if (APP_FORMAT_fixed(buffer, APP_FORMAT_FIXED_SIZE, value, (uint8_t)fractional_digits) == 0)
+    {
+        return("null");
+    }
+    return(buffer);
+}
+#endif /* PNP_CERTIFICATION_TESTING || CLICK_VAVPRESS */
+
+/* Start a group of readings taken now, dropped if the ring is full */
+static VOID telemetry_sample_begin(VOID)
+{
+ULONG seconds;
+
+    if ((telemetry_sample_ptr = sample_telemetry_ring_reserve(&telemetry_ring)) == NX_NULL)
+    {
+        return;
+    }
+
+    telemetry_sample_ptr -> tick = tx_time_get();
+    if ((telemetry_sample_ptr -> timestamp_ms = APP_CLOCK_unixUsGet() / 1000) != 0)
+    {
+        return;
+    }
+
+    /* SNTP never answered, fall back to the default time of the sample entry.  */
+    if ((sample_unix_time_get != NX_NULL) && (sample_unix_time_get(&seconds) == NX_SUCCESS))
+    {
+        telemetry_sample_ptr -> timestamp_ms = (uint64_t)seconds * 1000;
+    }
+}
+
+/* Add one reading to the group being taken */
+static VOID telemetry_sample_add(UINT field, double value)
+{
+    if ((telemetry_sample_ptr == NX_NULL) || (telemetry_sample_ptr -> count >= SAMPLE_TELEMETRY_GROUP_MAX))
+    {
+        return;
+    }
+
+    telemetry_sample_ptr -> fields[telemetry_sample_ptr -> count] = (UCHAR)field;
+    telemetry_sample_ptr -> values[telemetry_sample_ptr -> count] = (float)value;
+    telemetry_sample_ptr -> count++;
+}
+
+/* Hand the group over to the telemetry thread */
+static VOID telemetry_sample_end(VOID)
+{
+    if (telemetry_sample_ptr == NX_NULL)
+    {
+        return;
+    }
+
+    sample_telemetry_ring_commit(&telemetry_ring);
+    telemetry_sample_ptr = NX_NULL;
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_UPLINK, TX_OR);
+}
+
+/* Add the spread of a window, its mean goes out under the plain field name */
+static VOID telemetry_spread_append(UINT min, UINT max, UINT stddev, const APP_AGGREGATE_SUMMARY *summary)
+{
+    telemetry_sample_add(min, summary -> min);
+    telemetry_sample_add(max, summary -> max);
+    telemetry_sample_add(stddev, sqrt(summary -> variance));
+}
+
+#ifdef TELEMETRY_JOURNAL_ENABLE
+/* Send the readings journaled while offline, one message per group with the
+   original reading time as creation time. At most TELEMETRY_JOURNAL_DRAIN_MAX
+   messages go out per interval so the backlog does not hold up live telemetry */
+static VOID telemetry_journal_drain(VOID)
+{
+UINT status;
+UINT message;
+UINT count;
+UINT index;
+
+    for (message = 0; message < TELEMETRY_JOURNAL_DRAIN_MAX; message++)
+    {
+        if (appConnectStatus.cloud == false)
+        {
+            return;
+        }
+
+        if ((count = APP_JOURNAL_peek(telemetry_journal_records, TELEMETRY_JOURNAL_BATCH_MAX)) == 0)
         {
-            if (VAVPRESS_getSensorReadings(&VAVPRESS_param_data, &VAV_pressure, &VAV_temperature) == VAVPRESS_OK)
+            return;
+        }
+
+        /* Readings of one group share their group counter, groups taken in
+           the same second or before SNTP (timestamp 0) only differ there */
+        for (index = 1; index < count; index++)
+        {
+            if ((telemetry_journal_records[index].group != telemetry_journal_records[0].group) ||
+                (telemetry_journal_records[index].timestamp != telemetry_journal_records[0].timestamp))
             {
-                //printf("\r\n<VAV Click> Extended data readout ( pressure | temperature ) = [ %x (%i) | %x (%i) ]\r\n",
-                        //APP_SENSORS_data.i2c.rxBuffBytes[0], VAVPRESS_2sCompToDecimal(APP_SENSORS_data.i2c.rxBuffBytes[0]),
-                        //APP_SENSORS_data.i2c.rxBuffBytes[1], VAVPRESS_2sCompToDecimal(APP_SENSORS_data.i2c.rxBuffBytes[1])
-                      //);
-                //tx_thread_sleep(500);               
-                buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-                        "{\"VAV_temperature\": %.2f, \"VAV_pressure\": %.4f}",
-                        VAV_temperature, VAV_pressure);              
-                send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
-                if (VAV_pressure > ALARM_PRESSURE_PA)
-                {
-                    appConnectStatus.alarm = true;
-                }
+                break;
             }
-            if (VAV_pressure < ALARM_PRESSURE_PA)
+        }
+        count = index;
+
+        if ((status = sample_telemetry_builder_create(&telemetry_builder, &iothub_client, NX_WAIT_FOREVER)))
+        {
+            printf("Telemetry message create failed!: error code = 0x%08x\r\n", status);
+            return;
+        }
+
+#ifdef TELEMETRY_ENCODING_CBOR
+        if ((status = sample_telemetry_builder_encoding_set(&telemetry_builder, SAMPLE_TELEMETRY_ENCODING_CBOR)))
+        {
+            printf("Telemetry encoding set failed!: error code = 0x%08x\r\n", status);
+            sample_telemetry_builder_delete(&telemetry_builder);
+            return;
+        }
+#endif /* TELEMETRY_ENCODING_CBOR */
+
+        if (telemetry_journal_records[0].timestamp != 0)
+        {
+            if ((status = telemetry_ctime_add((uint64_t)telemetry_journal_records[0].timestamp * 1000)))
             {
-                appConnectStatus.alarm = false; 
+                printf("Telemetry property add failed!: error code = 0x%08x\r\n", status);
+                sample_telemetry_builder_delete(&telemetry_builder);
+                return;
             }
         }
+
+        for (index = 0; index < count; index++)
+        {
+            /* Ids from a newer firmware are dropped */
+            if (telemetry_journal_records[index].field < TELEMETRY_FIELD_COUNT)
+            {
+                telemetry_field_append(telemetry_journal_records[index].field,
+                                       telemetry_journal_records[index].value);
+            }
+        }
+
+        if ((status = sample_telemetry_builder_send(&telemetry_builder)))
+        {
+            printf("Journaled telemetry send failed!: error code = 0x%08x\r\n", status);
+            return;
+        }
+
+        APP_JOURNAL_consume(count);
+    }
+}
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+
+void send_button_event(ULONG parameter, UINT number, UINT count)
+{
+    CHAR buffer[TELEMETRY_MSGLEN_MAX];
+    UINT buffer_length;
+
+    NX_PARAMETER_NOT_USED(parameter);
+       
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+            "{\"button_event\": {\"button_name\": \"SW%u\", \"press_count\": %u}}", number, count);
+    send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+            "{\"total_press_count\": %u}", (button_press_data.sw1_press_count + button_press_data.sw2_press_count));
+    send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+}
+
+/* Detect the sensors and hand them over to the sensor scheduler */
+static VOID sample_telemetry_init(VOID)
+{
+#ifdef CLICK_VAVPRESS
+    CHAR fixed[1][APP_FORMAT_FIXED_SIZE];
 #endif /* CLICK_VAVPRESS */
-#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
-        sample_reported_properties_send_action(&iothub_client);
-#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
-#ifdef PNP_CERTIFICATION_TESTING
-        send_button_event(parameter, 1, button_press_data.sw1_press_count);
+#ifdef CLICK_ALTITUDE2 
+    UINT index_a;
+    static ALTITUDE2_Data altitude2;
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT 
+    UINT index_b;
+    static PHT_Data pht;
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+    uint32_t HTU31_serialNumber;
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_ULTRALOWPRESS
+    uint32_t SM8436_serialNumber;
+    static APP_AGGREGATE_WINDOW ulp_windows[2];
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+    static APP_AGGREGATE_WINDOW vav_windows[2];
+#endif /* CLICK_VAVPRESS */
+
+    APP_SENSORS_init();
+
+    /* Give the connection time to settle before the first sensor traffic */
+    tx_thread_sleep(AZ_telemetryInterval * NX_IP_PERIODIC_RATE);
+
+#ifdef CLICK_ALTITUDE2
+    printf("<ALT2 Click> Initializing MS5607...\r\n");
+    ALTITUDE2_status = ALTITUDE2_init(&altitude2);
+    if (ALTITUDE2_status == ALTITUDE2_OK)
+    {
+        for (index_a = 1; index_a < (ALTITUDE2_COEFFS_MAX+1); index_a++)
+        {
+            printf("<ALT2 Click> [PROM] C%d = %d\r\n", index_a, altitude2.data_prom[index_a-1]);
+            tx_thread_sleep(100);
+        }
+    }
+    else
+    {
+        printf("<ALT2 Click> MS5607 was not detected\r\n");          
+    }    
+    tx_thread_sleep(100);
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT
+    printf("<PHT Click> Initializing MS8607...\r\n");
+    PHT_status = PHT_init(&pht);
+    if (PHT_status == PHT_OK)
+    {
+        for (index_b = 1; index_b < (PHT_COEFFS_MAX+1); index_b++)
+        {
+            printf("<PHT Click> [PROM] C%d = %d\r\n", index_b, pht.data_prom[index_b-1]);
+            tx_thread_sleep(100);
+        }
+    }
+    else
+    {
+        printf("<PHT Click> MS8607 was not detected\r\n");          
+    }    
+    tx_thread_sleep(100);
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+    printf("<TEMPHUM14 Click> Initializing HTU31...\r\n");
+    HTU31_serialNumber = TEMPHUM14_init(TEMPHUM14_I2C_SLAVE_ADDR_GND);
+    if (HTU31_serialNumber != 0)
+    {
+        printf("<TEMPHUM14 Click> * Serial Number = %u\r\n", HTU31_serialNumber);    
+    }
+    else
+    {
+        printf("<TEMPHUM14 Click> HTU31 not detected\r\n");          
+    }
+    tx_thread_sleep(100);
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_ULTRALOWPRESS
+    printf("<ULP Click> Initializing SM8436...\r\n");
+    SM8436_serialNumber = ULTRALOWPRESS_init();
+    if (ULTRALOWPRESS_status == ULTRALOWPRESS_OK)
+    {
+        printf("<ULP Click> * Serial Number = %u\r\n", SM8436_serialNumber);    
+    }
+    else
+    {
+        printf("<ULP Click> SM8436 not detected\r\n");          
+    }
+    tx_thread_sleep(100);
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+    printf("<VAV Click> Initializing LMIS025B...\r\n");
+    VAVPRESS_init();
+    if (VAVPRESS_status == VAVPRESS_OK)
+    {
+        printf("<VAV Click> Retrieving Electronic Signature Data...\r\n");
         tx_thread_sleep(100);
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"ALT2_temperature\": %.2f, \"ALT2_pressure\": %.2f, \"ALT2_altitude\": %.2f}",
-            ALT2_temperature, ALT2_pressure, ALT2_altitude );                
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+        printf("<VAV Click> * Part Number: %.11s\r\n", VAVPRESS_el_signature_data.part_number);
         tx_thread_sleep(100);
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"PHT_temperature\": %.2f, \"PHT_pressure\": %.2f, \"PHT_humidity\": %.2f}",
-            PHT_temperature, PHT_pressure, PHT_humidity );                 
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+        printf("<VAV Click> * Firmware Version: %s\r\n",
+               telemetry_fixed(fixed[0], VAVPRESS_el_signature_data.firmware_version, 3));
         tx_thread_sleep(100);
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"TEMPHUM14_temperature\": %.2f, \"TEMPHUM14_humidity\": %.2f}",
-            TEMPHUM14_temperature, TEMPHUM14_humidity);              
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+        printf("<VAV Click> * Pressure Range: %d Pa\r\n", VAVPRESS_el_signature_data.pressure_range);
         tx_thread_sleep(100);
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"ULP_temperature\": %.2f, \"ULP_pressure\": %.2f}",
-            ULP_temperature, ULP_pressure );                
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+        printf("<VAV Click> * Lot Number: %.7s\r\n", VAVPRESS_el_signature_data.lot_number);
+        tx_thread_sleep(100);
+        printf("<VAV Click> * Output Type: %c\r\n", VAVPRESS_el_signature_data.output_type);
         tx_thread_sleep(100);
-        buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
-            "{\"VAV_temperature\": %.2f, \"VAV_pressure\": %.2f}",
-            VAV_temperature, VAV_pressure);              
-        send_telemetry_message(parameter, (UCHAR *)buffer, buffer_length);
+        printf("<VAV Click> * Scale Factor: %d\r\n", VAVPRESS_el_signature_data.scale_factor);
+        tx_thread_sleep(100);
+        printf("<VAV Click> * Calibration ID: %.2s\r\n", VAVPRESS_el_signature_data.calibration_id);
+        tx_thread_sleep(100);
+        printf("<VAV Click> * Week Number: %d\r\n", VAVPRESS_el_signature_data.week_number);
+        tx_thread_sleep(100);
+        printf("<VAV Click> * Year Number: %d\r\n", VAVPRESS_el_signature_data.year_number);
+        tx_thread_sleep(100);
+        printf("<VAV Click> * Sequence Number: %d\r\n", VAVPRESS_el_signature_data.sequence_number);
+    }
+    else
+    {
+        printf("<VAV Click> LMIS025B not detected\r\n");          
+    }
+    tx_thread_sleep(100);
+#endif /* CLICK_VAVPRESS */
+
+    /* Hand the detected sensors over to the sensor scheduler, it samples them
+       on its own timeline and sample_telemetry_send picks up the latest readings */
+#ifdef WFI32IOT_SENSORS
+    onboard_job = APP_SENSORS_onboardJob();
+    APP_SENSORS_jobAdd(onboard_job);
+#endif /* WFI32IOT_SENSORS */
+#ifdef CLICK_ALTITUDE2
+    if (ALTITUDE2_status == ALTITUDE2_OK)
+    {
+        altitude2_job = ALTITUDE2_sampleJob(&altitude2);
+        APP_SENSORS_jobAdd(altitude2_job);
+    }
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT
+    if (PHT_status == PHT_OK)
+    {
+        pht_job = PHT_sampleJob(&pht);
+        APP_SENSORS_jobAdd(pht_job);
+    }
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+    if (HTU31_serialNumber != 0)
+    {
+        temphum14_job = TEMPHUM14_sampleJob(TEMPHUM14_I2C_SLAVE_ADDR_GND,
+                TEMPHUM14_CONVERSION_HUM_OSR_0_020, TEMPHUM14_CONVERSION_TEMP_0_040);
+        APP_SENSORS_jobAdd(temphum14_job);
+    }
+#endif /* CLICK_TEMPHUM14 */
+#ifdef CLICK_ULTRALOWPRESS
+    if (ULTRALOWPRESS_status == ULTRALOWPRESS_OK)
+    {
+        ulp_job = ULTRALOWPRESS_sampleJob();
+        ulp_job -> periodMs = TELEMETRY_PRESSURE_PERIOD_MS;
+        APP_SENSORS_jobAggregate(ulp_job, ulp_windows, 2);
+        APP_SENSORS_jobAdd(ulp_job);
+    }
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+    if (VAVPRESS_status == VAVPRESS_OK)
+    {
+        vav_job = VAVPRESS_sampleJob(&VAVPRESS_param_data);
+        vav_job -> periodMs = TELEMETRY_PRESSURE_PERIOD_MS;
+        APP_SENSORS_jobAggregate(vav_job, vav_windows, 2);
+        APP_SENSORS_jobAdd(vav_job);
+    }
+#endif /* CLICK_VAVPRESS */
+
+#ifdef TELEMETRY_JOURNAL_ENABLE
+    if (!APP_JOURNAL_init())
+    {
+        printf("Telemetry journal not available, offline readings are lost\r\n");
+    }
+#endif /* TELEMETRY_JOURNAL_ENABLE */
+}
+
+/* Take the latest readings into the ring, run by the dispatcher once per telemetry interval */
+static VOID sample_telemetry_send(VOID)
+{
+    float values[APP_SENSORS_JOB_VALUES_MAX];
+#if defined(CLICK_ULTRALOWPRESS) || defined(CLICK_VAVPRESS)
+    APP_AGGREGATE_SUMMARY summaries[APP_SENSORS_JOB_VALUES_MAX];
+#endif /* CLICK_ULTRALOWPRESS || CLICK_VAVPRESS */
+    /* The latest readings are kept from one interval to the next */
+#ifdef CLICK_ALTITUDE2 
+    static float ALT2_temperature, ALT2_pressure, ALT2_altitude;
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT 
+    static float PHT_temperature, PHT_pressure, PHT_humidity;
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+    static float TEMPHUM14_temperature;
+    static float TEMPHUM14_humidity;
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_ULTRALOWPRESS
+    static float ULP_temperature;
+    static float ULP_pressure = 0.0;
+    static float ULP_pressure_max = 0.0;
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+    static float VAV_temperature;
+    static float VAV_pressure = 0.0;
+    static float VAV_pressure_max = 0.0;
+#endif /* CLICK_VAVPRESS */
+
+#ifdef WFI32IOT_SENSORS
+    //printf("\r\n<WFI32-IoT> Reading temperature & light sensors...\r\n");
+    if (APP_SENSORS_jobRead(onboard_job, values))
+    {
+        telemetry_sample_begin();
+        telemetry_sample_add(TELEMETRY_FIELD_WFI32IOT_TEMPERATURE, values[APP_SENSORS_ONBOARD_TEMPERATURE]);
+        telemetry_sample_add(TELEMETRY_FIELD_WFI32IOT_LIGHT, (int32_t)values[APP_SENSORS_ONBOARD_LIGHT]);
+        telemetry_sample_end();
+    }
+#endif /* WFI32IOT_SENSORS */
+#ifdef WFI32CURIOSITY_SENSORS
+    //printf("\r\n<WFI32-IoT> Reading temperature & light sensors...\r\n");
+    telemetry_sample_begin();
+    telemetry_sample_add(TELEMETRY_FIELD_WFI32CURIOSITY_TEMPERATURE, APP_SENSORS_readTemperature());
+    telemetry_sample_end();
+#endif /* WFI32CURIOSITY_SENSORS */
+#ifdef CLICK_ALTITUDE2
+    if (APP_SENSORS_jobRead(altitude2_job, values))
+    {
+        ALT2_temperature = values[ALTITUDE2_JOB_TEMPERATURE];
+        ALT2_pressure = values[ALTITUDE2_JOB_PRESSURE];
+        ALT2_altitude = values[ALTITUDE2_JOB_ALTITUDE];
+        telemetry_sample_begin();
+        telemetry_sample_add(TELEMETRY_FIELD_ALT2_TEMPERATURE, ALT2_temperature);
+        telemetry_sample_add(TELEMETRY_FIELD_ALT2_PRESSURE, ALT2_pressure);
+        telemetry_sample_add(TELEMETRY_FIELD_ALT2_ALTITUDE, ALT2_altitude);
+        telemetry_sample_end();
+    }
+#endif /* CLICK_ALTITUDE2 */
+#ifdef CLICK_PHT
+    if (APP_SENSORS_jobRead(pht_job, values))
+    {
+        PHT_temperature = values[PHT_JOB_TEMPERATURE];
+        PHT_pressure = values[PHT_JOB_PRESSURE];
+        PHT_humidity = values[PHT_JOB_HUMIDITY];
+        telemetry_sample_begin();
+        telemetry_sample_add(TELEMETRY_FIELD_PHT_TEMPERATURE, PHT_temperature);
+        telemetry_sample_add(TELEMETRY_FIELD_PHT_PRESSURE, PHT_pressure);
+        telemetry_sample_add(TELEMETRY_FIELD_PHT_HUMIDITY, PHT_humidity);
+        telemetry_sample_end();
+    }
+#endif /* CLICK_PHT */
+#ifdef CLICK_TEMPHUM14
+    if (APP_SENSORS_jobRead(temphum14_job, values))
+    {
+        TEMPHUM14_temperature = values[TEMPHUM14_JOB_TEMPERATURE];
+        TEMPHUM14_humidity = values[TEMPHUM14_JOB_HUMIDITY];
+        telemetry_sample_begin();
+        telemetry_sample_add(TELEMETRY_FIELD_TEMPHUM14_TEMPERATURE, TEMPHUM14_temperature);
+        telemetry_sample_add(TELEMETRY_FIELD_TEMPHUM14_HUMIDITY, TEMPHUM14_humidity);
+        telemetry_sample_end();
+    }
+#endif /* CLICK_TEMPHUM14 */
+#ifdef CLICK_ULTRALOWPRESS
+    if (ULTRALOWPRESS_status == ULTRALOWPRESS_OK)
+    {
+        if (APP_SENSORS_jobSummary(ulp_job, summaries))
+        {
+            ULP_temperature = summaries[ULTRALOWPRESS_JOB_TEMPERATURE].mean;
+            ULP_pressure = summaries[ULTRALOWPRESS_JOB_PRESSURE].mean;
+            ULP_pressure_max = summaries[ULTRALOWPRESS_JOB_PRESSURE].max;
+            telemetry_sample_begin();
+            telemetry_sample_add(TELEMETRY_FIELD_ULP_TEMPERATURE, ULP_temperature);
+            telemetry_sample_add(TELEMETRY_FIELD_ULP_PRESSURE, ULP_pressure);
+            telemetry_spread_append(TELEMETRY_FIELD_ULP_PRESSURE_MIN, TELEMETRY_FIELD_ULP_PRESSURE_MAX,
+                                    TELEMETRY_FIELD_ULP_PRESSURE_STDDEV, &summaries[ULTRALOWPRESS_JOB_PRESSURE]);
+            telemetry_sample_end();
+            if (ULP_pressure_max > ALARM_PRESSURE_PA)
+            {
+                appConnectStatus.alarm = true;
+            }
+        }
+        else
+        {
+            //printf("\r\n<ULP Click> SM8436 is not ready...\r\n");
+        }
+        if (ULP_pressure_max < ALARM_PRESSURE_PA)
+        {
+            appConnectStatus.alarm = false; 
+        }
+        //tx_thread_sleep(500);
+    }
+#endif /* CLICK_ULTRALOWPRESS */
+#ifdef CLICK_VAVPRESS
+    if (VAVPRESS_status == VAVPRESS_OK)
+    {
+        if (APP_SENSORS_jobSummary(vav_job, summaries))
+        {
+            VAV_pressure = summaries[VAVPRESS_JOB_PRESSURE].mean;
+            VAV_pressure_max = summaries[VAVPRESS_JOB_PRESSURE].max;
+            VAV_temperature = summaries[VAVPRESS_JOB_TEMPERATURE].mean;
+            telemetry_sample_begin();
+            telemetry_sample_add(TELEMETRY_FIELD_VAV_TEMPERATURE, VAV_temperature);
+            telemetry_sample_add(TELEMETRY_FIELD_VAV_PRESSURE, VAV_pressure);
+            telemetry_spread_append(TELEMETRY_FIELD_VAV_PRESSURE_MIN, TELEMETRY_FIELD_VAV_PRESSURE_MAX,
+                                    TELEMETRY_FIELD_VAV_PRESSURE_STDDEV, &summaries[VAVPRESS_JOB_PRESSURE]);
+            telemetry_sample_end();
+            if (VAV_pressure_max > ALARM_PRESSURE_PA)
+            {
+                appConnectStatus.alarm = true;
+            }
+        }
+        if (VAV_pressure_max < ALARM_PRESSURE_PA)
+        {
+            appConnectStatus.alarm = false; 
+        }
+    }
+#endif /* CLICK_VAVPRESS */
+#ifdef PNP_CERTIFICATION_TESTING
+
+    /* The per-sensor messages go out on the telemetry thread.  */
+    telemetry_certification.ALT2_temperature = ALT2_temperature;
+    telemetry_certification.ALT2_pressure = ALT2_pressure;
+    telemetry_certification.ALT2_altitude = ALT2_altitude;
+    telemetry_certification.PHT_temperature = PHT_temperature;
+    telemetry_certification.PHT_pressure = PHT_pressure;
+    telemetry_certification.PHT_humidity = PHT_humidity;
+    telemetry_certification.TEMPHUM14_temperature = TEMPHUM14_temperature;
+    telemetry_certification.TEMPHUM14_humidity = TEMPHUM14_humidity;
+    telemetry_certification.ULP_temperature = ULP_temperature;
+    telemetry_certification.ULP_pressure = ULP_pressure;
+    telemetry_certification.VAV_temperature = VAV_temperature;
+    telemetry_certification.VAV_pressure = VAV_pressure;
+    telemetry_certification_pending = NX_TRUE;
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_UPLINK, TX_OR);
+#endif /* PNP_CERTIFICATION_TESTING */
+}
+
+#ifdef PNP_CERTIFICATION_TESTING
+/* One message per sensor with the latest readings, on the telemetry thread */
+static VOID telemetry_certification_send(VOID)
+{
+    CHAR buffer[TELEMETRY_MSGLEN_MAX];
+    UINT buffer_length;
+    CHAR fixed[3][APP_FORMAT_FIXED_SIZE];
+    const TELEMETRY_CERTIFICATION *readings = &telemetry_certification;
+
+    send_button_event(0, 1, button_press_data.sw1_press_count);
+    tx_thread_sleep(100);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+        "{\"ALT2_temperature\": %s, \"ALT2_pressure\": %s, \"ALT2_altitude\": %s}",
+        telemetry_fixed(fixed[0], readings -> ALT2_temperature, 2),
+        telemetry_fixed(fixed[1], readings -> ALT2_pressure, 2),
+        telemetry_fixed(fixed[2], readings -> ALT2_altitude, 2));
+    send_telemetry_message(0, (UCHAR *)buffer, buffer_length);
+    tx_thread_sleep(100);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+        "{\"PHT_temperature\": %s, \"PHT_pressure\": %s, \"PHT_humidity\": %s}",
+        telemetry_fixed(fixed[0], readings -> PHT_temperature, 2),
+        telemetry_fixed(fixed[1], readings -> PHT_pressure, 2),
+        telemetry_fixed(fixed[2], readings -> PHT_humidity, 2));
+    send_telemetry_message(0, (UCHAR *)buffer, buffer_length);
+    tx_thread_sleep(100);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+        "{\"TEMPHUM14_temperature\": %s, \"TEMPHUM14_humidity\": %s}",
+        telemetry_fixed(fixed[0], readings -> TEMPHUM14_temperature, 2),
+        telemetry_fixed(fixed[1], readings -> TEMPHUM14_humidity, 2));
+    send_telemetry_message(0, (UCHAR *)buffer, buffer_length);
+    tx_thread_sleep(100);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+        "{\"ULP_temperature\": %s, \"ULP_pressure\": %s}",
+        telemetry_fixed(fixed[0], readings -> ULP_temperature, 2),
+        telemetry_fixed(fixed[1], readings -> ULP_pressure, 2));
+    send_telemetry_message(0, (UCHAR *)buffer, buffer_length);
+    tx_thread_sleep(100);
+    buffer_length = (UINT)snprintf(buffer, sizeof(buffer),
+        "{\"VAV_temperature\": %s, \"VAV_pressure\": %s}",
+        telemetry_fixed(fixed[0], readings -> VAV_temperature, 2),
+        telemetry_fixed(fixed[1], readings -> VAV_pressure, 2));
+    send_telemetry_message(0, (UCHAR *)buffer, buffer_length);
+}
 #endif /* PNP_CERTIFICATION_TESTING */
-        tx_thread_sleep(AZ_telemetryInterval * NX_IP_PERIODIC_RATE);
+
+#ifndef TX_DISABLE_STACK_FILLING
+/* Deepest use of a thread stack so far, the part below it still holds the
+   pattern tx_thread_create filled the stack with */
+static ULONG sample_thread_stack_used(TX_THREAD *thread_ptr)
+{
+ULONG *word_ptr = (ULONG *)thread_ptr -> tx_thread_stack_start;
+ULONG *end_ptr = (ULONG *)thread_ptr -> tx_thread_stack_end;
+
+    while ((word_ptr < end_ptr) && (*word_ptr == TX_STACK_FILL))
+    {
+        word_ptr++;
+    }
+
+    return((ULONG)((UCHAR *)(thread_ptr -> tx_thread_stack_end) + 1 - (UCHAR *)word_ptr));
+}
+#endif /* TX_DISABLE_STACK_FILLING */
+
+/* Send the readings of the ring, batched per wake-up, then the journal backlog.
+   A slow send only delays this thread, the dispatcher keeps taking readings */
+static void sample_telemetry_thread_entry(ULONG parameter)
+{
+UCHAR loop = NX_TRUE;
+ULONG events;
+ULONG dropped = 0;
+#ifndef TX_DISABLE_STACK_FILLING
+ULONG stack_used = 0;
+#endif /* TX_DISABLE_STACK_FILLING */
+SAMPLE_TELEMETRY_SAMPLE *sample_ptr;
+UINT index;
+
+    NX_PARAMETER_NOT_USED(parameter);
+
+    while (loop)
+    {
+        if (tx_event_flags_get(&sample_events, SAMPLE_EVENT_TELEMETRY_THREAD, TX_OR_CLEAR,
+                               &events, TX_WAIT_FOREVER))
+        {
+            break;
+        }
+#ifndef DISABLE_APP_CTRL_SAMPLE
+        if (events & SAMPLE_EVENT_BUTTON)
+        {
+            sample_button_events_send();
+        }
+#endif /* DISABLE_APP_CTRL_SAMPLE */
+
+        while ((sample_ptr = sample_telemetry_ring_peek(&telemetry_ring)) != NX_NULL)
+        {
+            telemetry_group_begin(sample_ptr);
+            for (index = 0; index < sample_ptr -> count; index++)
+            {
+                telemetry_append(sample_ptr -> fields[index], sample_ptr -> values[index]);
+            }
+            telemetry_group_end();
+            sample_telemetry_ring_release(&telemetry_ring);
+        }
+        telemetry_flush();
+
+        if (telemetry_ring.dropped != dropped)
+        {
+            dropped = telemetry_ring.dropped;
+            printf("Telemetry ring full: %lu of %lu groups dropped, high water %lu\r\n",
+                   dropped, telemetry_ring.produced + dropped, telemetry_ring.high_water);
+        }
+#ifndef TX_DISABLE_STACK_FILLING
+        if (sample_thread_stack_used(&sample_telemetry_thread) > stack_used)
+        {
+            stack_used = sample_thread_stack_used(&sample_telemetry_thread);
+            printf("Telemetry stack high water: %lu of %u bytes\r\n",
+                   stack_used, SAMPLE_TELEMETRY_STACK_SIZE);
+        }
+#endif /* TX_DISABLE_STACK_FILLING */
+#ifdef PNP_CERTIFICATION_TESTING
+        if (telemetry_certification_pending)
+        {
+            telemetry_certification_pending = NX_FALSE;
+            telemetry_certification_send();
+        }
+#endif /* PNP_CERTIFICATION_TESTING */
+#ifdef TELEMETRY_JOURNAL_ENABLE
+        telemetry_journal_drain();
+#endif /* TELEMETRY_JOURNAL_ENABLE */
     }
 }
 #endif /* DISABLE_TELEMETRY_SAMPLE */
@@ -1173,8 +2436,13 @@ void sample_c2d_thread_entry(ULONG parameter)
     /* Loop to receive c2d message.  */
     while (loop)
     {
-        if ((status = nx_azure_iot_hub_client_cloud_message_receive(&iothub_client, &packet_ptr, NX_WAIT_FOREVER)))
+        sample_connected_wait();
+        if ((status = nx_azure_iot_hub_client_cloud_message_receive(&iothub_client, &packet_ptr, SAMPLE_RECEIVE_WAIT)))
         {
+            if ((status == NX_AZURE_IOT_NO_PACKET) || (status == NX_AZURE_IOT_DISCONNECTED))
+            {
+                continue;
+            }
             printf("C2D receive failed!: error code = 0x%08x\r\n", status);
             break;
         }
@@ -1188,53 +2456,211 @@ void sample_c2d_thread_entry(ULONG parameter)
                    (INT)property_buf_size, property_buf);
         }
 
-        printf("Receive message: ");
-        printf_packet(packet_ptr);
-        printf("\r\n");
+        printf("Receive message: ");
+        printf_packet(packet_ptr);
+        printf("\r\n");
+
+        nx_packet_release(packet_ptr);
+    }
+}
+#endif /* DISABLE_C2D_SAMPLE */
+
+#ifndef DISABLE_DIRECT_METHOD_SAMPLE
+/* Method name lookup slots, a power of two above the number of methods */
+#define SAMPLE_METHOD_BUCKETS               (8)
+/* Handler status of a call completed later by its deferred function */
+#define SAMPLE_METHOD_DEFERRED              (0)
+
+/* Direct method call, from the pool until the response is sent. The context
+   points into packet_ptr, which is held until then */
+typedef struct SAMPLE_METHOD_CALL_STRUCT
+{
+    NX_PACKET  *packet_ptr;
+    VOID       *context_ptr;
+    USHORT      context_length;
+    UINT        status;
+    VOID      (*deferred)(struct SAMPLE_METHOD_CALL_STRUCT *call_ptr);
+    UINT        response_length;
+    CHAR        request[SAMPLE_METHOD_PAYLOAD_MAX];
+    CHAR        response[SAMPLE_METHOD_PAYLOAD_MAX];
+} SAMPLE_METHOD_CALL;
+
+/* Direct method. The handler sets the response of the call and returns its
+   status, or sets deferred and returns SAMPLE_METHOD_DEFERRED to have the
+   connection thread complete it with sample_method_respond */
+typedef struct
+{
+    const CHAR *name;
+    UINT      (*handler)(SAMPLE_METHOD_CALL *call_ptr);
+} SAMPLE_METHOD;
+
+static TX_BLOCK_POOL sample_method_pool;
+static ULONG sample_method_pool_memory[(SAMPLE_METHOD_POOL_COUNT *
+                                        (sizeof(SAMPLE_METHOD_CALL) + sizeof(VOID *)) + sizeof(ULONG) - 1) /
+                                       sizeof(ULONG)];
+/* Deferred calls, one pointer per message */
+static TX_QUEUE sample_method_queue;
+static ULONG sample_method_queue_memory[SAMPLE_METHOD_POOL_COUNT *
+                                        ((sizeof(SAMPLE_METHOD_CALL *) + sizeof(ULONG) - 1) / sizeof(ULONG))];
+/* Index + 1 into sample_methods by name hash, 0 when empty */
+static UCHAR sample_method_buckets[SAMPLE_METHOD_BUCKETS];
+
+int reboot_command(char* payload)
+{
+    int payload_size = strlen(payload);
+    int delay = 0;
+    // example payload: "PT5S", quotes are transmitted.  
+    // So 'P' is character 1 in string instead of 0 
+    if(payload_size >= 5 && payload[1] == 'P' && payload[2] == 'T' && payload[payload_size-2] == 'S')
+    {  // payload is expected format, convert delay to integer
+        payload[payload_size-2] = 0;
+        delay = (uint32_t) atoi(&payload[3]);
+        payload[payload_size-2] = 'S';
+        printf("Reboot in %d seconds...\r\n", delay);
+    }
+    else
+    {
+        printf("Invalid reboot payload: expected format \"PT<x>S\" (where 'x' = # of seconds)\r\n");
+    }
+    return delay;
+}
+
+void sendMsg_command(char* payload)
+{
+    #define PROPERTY_MSG_TEXT  "\"sendMsgString\""
+    bool bPropertyFound;
+    char propertyValue[64];
+  
+    bPropertyFound = find_property_value(payload, PROPERTY_MSG_TEXT, propertyValue);
+    if(bPropertyFound == true)
+    {
+        printf("Message received from cloud: %s\r\n", propertyValue);
+    }
+    else
+    {
+        printf("unexpected object data for sendMsg method\r\n");
+    }
+}
+
+/* Send the response of a call and return it to the pool, from any thread */
+static VOID sample_method_respond(SAMPLE_METHOD_CALL *call_ptr)
+{
+UINT status;
+
+    if ((status = nx_azure_iot_hub_client_direct_method_message_response(&iothub_client, call_ptr -> status,
+                                                                         call_ptr -> context_ptr,
+                                                                         call_ptr -> context_length,
+                                                                         (UCHAR *)call_ptr -> response,
+                                                                         call_ptr -> response_length,
+                                                                         SAMPLE_METHOD_RESPONSE_WAIT)))
+    {
+
+        /* On a disconnect the call times out at the caller.  */
+        printf("Direct method response failed!: error code = 0x%08x\r\n", status);
+    }
+
+    nx_packet_release(call_ptr -> packet_ptr);
+    tx_block_release(call_ptr);
+}
+
+/* Runs on the connection thread, the dispatcher counts AZ_systemRebootTimer down */
+static VOID sample_method_reboot_deferred(SAMPLE_METHOD_CALL *call_ptr)
+{
+    AZ_systemRebootTimer = reboot_command(call_ptr -> request);
+    call_ptr -> status = 200;
+    call_ptr -> response_length = (UINT)snprintf(call_ptr -> response, sizeof(call_ptr -> response),
+                                                 "%.*s, \"delay\" :%d}",
+                                                 (INT)(sizeof(method_response_payload) - 2), method_response_payload,
+                                                 (INT)AZ_systemRebootTimer);
+    printf("%s\r\n", call_ptr -> response);
+    sample_method_respond(call_ptr);
+}
+
+static UINT sample_method_reboot(SAMPLE_METHOD_CALL *call_ptr)
+{
+    call_ptr -> deferred = sample_method_reboot_deferred;
+    return(SAMPLE_METHOD_DEFERRED);
+}
+
+static UINT sample_method_send_msg(SAMPLE_METHOD_CALL *call_ptr)
+{
+    sendMsg_command(call_ptr -> request);
+    call_ptr -> response_length = (UINT)snprintf(call_ptr -> response, sizeof(call_ptr -> response),
+                                                 "%s", method_response_payload);
+    return(200);
+}
+
+/* Direct methods, a new one only needs an entry here and in the device model */
+static const SAMPLE_METHOD sample_methods[] =
+{
+    {"reboot",  sample_method_reboot},
+    {"sendMsg", sample_method_send_msg},
+};
+#define SAMPLE_METHOD_COUNT                 (sizeof(sample_methods) / sizeof(sample_methods[0]))
+
+/* FNV-1a of a method name */
+static ULONG sample_method_hash(const UCHAR *name, UINT name_length)
+{
+ULONG hash = 2166136261UL;
 
-        nx_packet_release(packet_ptr);
+    while (name_length--)
+    {
+        hash = (hash ^ *name++) * 16777619UL;
     }
-}
-#endif /* DISABLE_C2D_SAMPLE */
 
-#ifndef DISABLE_DIRECT_METHOD_SAMPLE
+    return(hash);
+}
 
-int reboot_command(char* payload)
+static VOID sample_method_buckets_build(VOID)
 {
-    int payload_size = strlen(payload);
-    int delay = 0;
-    // example payload: "PT5S", quotes are transmitted.  
-    // So 'P' is character 1 in string instead of 0 
-    if(payload[1] == 'P' && payload[2] == 'T' && payload[payload_size-2] == 'S')
-    {  // payload is expected format, convert delay to integer
-        payload[payload_size-2] = 0;
-        delay = (uint32_t) atoi(&payload[3]);
-        payload[payload_size-2] = 'S';
-        printf("Reboot in %d seconds...\r\n", delay);
-    }
-    else
+UINT bucket;
+UINT i;
+
+    for (i = 0; i < SAMPLE_METHOD_COUNT; i++)
     {
-        printf("Invalid reboot payload: expected format \"PT<x>S\" (where 'x' = # of seconds)\r\n");
+        bucket = (UINT)sample_method_hash((const UCHAR *)sample_methods[i].name, strlen(sample_methods[i].name));
+        while (sample_method_buckets[bucket & (SAMPLE_METHOD_BUCKETS - 1)])
+        {
+            bucket++;
+        }
+        sample_method_buckets[bucket & (SAMPLE_METHOD_BUCKETS - 1)] = (UCHAR)(i + 1);
     }
-    return delay;
 }
 
-void sendMsg_command(char* payload)
+/* Method of a name, NX_NULL if it is not registered */
+static const SAMPLE_METHOD *sample_method_find(const UCHAR *name, UINT name_length)
 {
-    #define PROPERTY_MSG_TEXT  "\"sendMsgString\""
-    bool bPropertyFound;
-    char propertyValue[64];
-  
-    bPropertyFound = find_property_value(payload, PROPERTY_MSG_TEXT, propertyValue);
-    if(bPropertyFound == true)
+const SAMPLE_METHOD *method_ptr;
+UINT bucket = (UINT)sample_method_hash(name, name_length);
+UINT probes;
+
+    for (probes = 0; probes < SAMPLE_METHOD_BUCKETS; probes++, bucket++)
     {
-        printf("Message received from cloud: %s\r\n", propertyValue);
+        if (sample_method_buckets[bucket & (SAMPLE_METHOD_BUCKETS - 1)] == 0)
+        {
+            break;
+        }
+        method_ptr = &sample_methods[sample_method_buckets[bucket & (SAMPLE_METHOD_BUCKETS - 1)] - 1];
+        if ((strlen(method_ptr -> name) == name_length) && (memcmp(method_ptr -> name, name, name_length) == 0))
+        {
+            return(method_ptr);
+        }
     }
-    else
+
+    return(NX_NULL);
+}
+
+/* Complete the deferred calls, on the connection thread */
+static VOID sample_method_deferred_run(VOID)
+{
+SAMPLE_METHOD_CALL *call_ptr;
+
+    while (tx_queue_receive(&sample_method_queue, &call_ptr, TX_NO_WAIT) == TX_SUCCESS)
     {
-        printf("unexpected object data for sendMsg method\r\n");
+        call_ptr -> deferred(call_ptr);
     }
 }
+
 void sample_direct_method_thread_entry(ULONG parameter)
 {
     UCHAR loop = NX_TRUE;
@@ -1244,220 +2670,469 @@ void sample_direct_method_thread_entry(ULONG parameter)
     const UCHAR *method_name_ptr;
     USHORT context_length;
     VOID *context_ptr;
-    char command[32];
-    char payload[64];
-    char response[64];
-    int response_size;
+    const SAMPLE_METHOD *method_ptr;
+    SAMPLE_METHOD_CALL *call_ptr;
     NX_PARAMETER_NOT_USED(parameter);
 
+    sample_method_buckets_build();
+    if ((status = tx_block_pool_create(&sample_method_pool, "Sample Method Pool", sizeof(SAMPLE_METHOD_CALL),
+                                       sample_method_pool_memory, sizeof(sample_method_pool_memory))) ||
+        (status = tx_queue_create(&sample_method_queue, "Sample Method Queue",
+                                  sizeof(sample_method_queue_memory) / sizeof(ULONG) / SAMPLE_METHOD_POOL_COUNT,
+                                  sample_method_queue_memory, sizeof(sample_method_queue_memory))))
+    {
+        printf("Direct method pool create failed!: error code = 0x%08x\r\n", status);
+        return;
+    }
+
     /* Loop to receive direct method message.  */
     while (loop)
     {
+        sample_connected_wait();
         if ((status = nx_azure_iot_hub_client_direct_method_message_receive(&iothub_client,
                                                                             &method_name_ptr, &method_name_length,
                                                                             &context_ptr, &context_length,
-                                                                            &packet_ptr, NX_WAIT_FOREVER)))
+                                                                            &packet_ptr, SAMPLE_RECEIVE_WAIT)))
         {
+            if ((status == NX_AZURE_IOT_NO_PACKET) || (status == NX_AZURE_IOT_DISCONNECTED))
+            {
+                continue;
+            }
             printf("Direct method receive failed!: error code = 0x%08x\r\n", status);
             break;
         }
         printf("Receive method call: %.*s, with payload:", (INT)method_name_length, (CHAR *)method_name_ptr);
-        sprintf_packet(payload, packet_ptr);
-        printf("%s\r\n", payload);
-
-        memset(command, 0, sizeof(command));
-        memcpy(command, method_name_ptr, method_name_length);
-
-        strcpy(response, method_response_payload);
-        response_size = strlen(response);
-        if (strcmp(command, "reboot") == 0)
-        {  // if command is reboot, process payload to gather delay
-            AZ_systemRebootTimer = reboot_command(payload);
-            sprintf(&response[response_size-1], ", \"delay\" :%d}", AZ_systemRebootTimer);
-            response_size = strlen(response);
-            printf("%s\r\n", response);
+
+        /* A burst beyond the pool is turned away instead of queued.  */
+        if (tx_block_allocate(&sample_method_pool, (VOID **)&call_ptr, TX_NO_WAIT))
+        {
+            printf(" dropped, too many calls in progress\r\n");
+            if ((status = nx_azure_iot_hub_client_direct_method_message_response(&iothub_client, 503,
+                                                                                 context_ptr, context_length,
+                                                                                 NX_NULL, 0,
+                                                                                 SAMPLE_METHOD_RESPONSE_WAIT)))
+            {
+                printf("Direct method response failed!: error code = 0x%08x\r\n", status);
+            }
+            nx_packet_release(packet_ptr);
+            continue;
+        }
+
+        call_ptr -> packet_ptr = packet_ptr;
+        call_ptr -> context_ptr = context_ptr;
+        call_ptr -> context_length = context_length;
+        call_ptr -> deferred = NX_NULL;
+        call_ptr -> response_length = 0;
+        sprintf_packet(call_ptr -> request, sizeof(call_ptr -> request), packet_ptr);
+        printf("%s\r\n", call_ptr -> request);
+
+        if ((method_ptr = sample_method_find(method_name_ptr, method_name_length)) == NX_NULL)
+        {
+            call_ptr -> status = 404;
+            call_ptr -> response_length = (UINT)snprintf(call_ptr -> response, sizeof(call_ptr -> response),
+                                                         "{\"status\": \"Unknown method\"}");
         }
-        if (strcmp(command, "sendMsg") == 0)
-        {  // if command is sendMsg, pull text from object and print to terminal
-            sendMsg_command(payload);       
+        else
+        {
+            call_ptr -> status = method_ptr -> handler(call_ptr);
         }
-        if ((status = nx_azure_iot_hub_client_direct_method_message_response(&iothub_client, 200 /* method status */,
-                                                                             context_ptr, context_length,
-                                                                             (UCHAR *)response, response_size,
-                                                                             NX_WAIT_FOREVER)))
+
+        if (call_ptr -> deferred)
         {
-            printf("Direct method response failed!: error code = 0x%08x\r\n", status);
-            nx_packet_release(packet_ptr);
-            break;
+            tx_queue_send(&sample_method_queue, &call_ptr, TX_NO_WAIT);
+            tx_event_flags_set(&sample_events, SAMPLE_EVENT_METHOD, TX_OR);
+            continue;
         }
 
-        nx_packet_release(packet_ptr);
+        sample_method_respond(call_ptr);
     }
 }
 #endif /* DISABLE_DIRECT_METHOD_SAMPLE */
 
 #ifndef DISABLE_DEVICE_TWIN_SAMPLE
-void sample_device_twin_thread_entry(ULONG parameter)
+/* Fetch the full twin document and report the current properties */
+static UINT sample_device_twin_sync(VOID)
 {
-    UCHAR loop = NX_TRUE;
     NX_PACKET *packet_ptr;
+#ifdef SAMPLE_TWIN_DOCUMENT_DUMP
+    NX_PACKET *print_ptr;
+    UINT offset;
+    UINT length;
+#endif /* SAMPLE_TWIN_DOCUMENT_DUMP */
     UINT status = 0;
-    UINT response_status;
 
-    ULONG reported_property_version;
-    char responseProperty[120];
-    int responsePropertyLen;
-    char receivedProperties[300];
-    char propertyValue[30];
-    
-    bool bPropertyFound;
-
-    NX_PARAMETER_NOT_USED(parameter);
-
-    init_twin_data(&twin_properties);
-    
     if ((status = nx_azure_iot_hub_client_device_twin_properties_request(&iothub_client, NX_WAIT_FOREVER)))
     {
         printf("device twin document request failed!: error code = 0x%08x\r\n", status);
-        return;
+        return(status);
     }
 
-    if ((status = nx_azure_iot_hub_client_device_twin_properties_receive(&iothub_client, &packet_ptr, NX_WAIT_FOREVER)))
+    if ((status = nx_azure_iot_hub_client_device_twin_properties_receive(&iothub_client, &packet_ptr, SAMPLE_RECEIVE_WAIT)))
     {
         printf("device twin document receive failed!: error code = 0x%08x\r\n", status);
-        return;
+        return(status);
     }
     
+#ifdef SAMPLE_TWIN_DOCUMENT_DUMP
+    /* Print in slices, the console drops long bursts.  */
     printf("Receive twin properties :");
-    sprintf_packet(receivedProperties, packet_ptr);
-    int rxProp_size = strlen(receivedProperties);
-    int txIndex = 0;
-    while(rxProp_size > 100)
-    {       
-        printf("%.*s", 100, &receivedProperties[txIndex]);
-        rxProp_size -= 100;
-        txIndex += 100;
-        tx_thread_sleep(100);        
-    }
-    printf("%.*s\r\n", rxProp_size, &receivedProperties[txIndex]);
-    tx_thread_sleep(100);
-    
-    responsePropertyLen = parse_packet_data(receivedProperties, responseProperty, sizeof(responseProperty));
-
+    for (print_ptr = packet_ptr; print_ptr != NX_NULL; print_ptr = print_ptr -> nx_packet_next)
+    {
+        length = (UINT)(print_ptr -> nx_packet_append_ptr - print_ptr -> nx_packet_prepend_ptr);
+        for (offset = 0; offset < length; offset += 100)
+        {
+            printf("%.*s", (INT)(((length - offset) > 100) ? 100 : (length - offset)),
+                   (CHAR *)&print_ptr -> nx_packet_prepend_ptr[offset]);
+            tx_thread_sleep(100);
+        }
+    }
+    printf("\r\n");
+#else
+    printf("Receive twin properties: %lu bytes\r\n", (ULONG)packet_ptr -> nx_packet_length);
+#endif /* SAMPLE_TWIN_DOCUMENT_DUMP */
 
+    /* Desired properties set while the device was offline are applied and acknowledged here.  */
+    sample_twin_update(packet_ptr, NX_TRUE);
     nx_packet_release(packet_ptr);
 
-    sample_reported_properties_send_action(&iothub_client);
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+    /* The connection thread sends what changed while the device was offline.  */
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_REPORTED, TX_OR);
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+void sample_device_twin_thread_entry(ULONG parameter)
+{
+    UCHAR loop = NX_TRUE;
+    NX_PACKET *packet_ptr;
+    UINT status = 0;
+    UINT synced_connection = 0;
+
+    NX_PARAMETER_NOT_USED(parameter);
+
+    init_twin_data(&twin_properties);
     
     /* Loop to receive device twin message.  */
     while (loop)
     {
+        sample_connected_wait();
+
+        /* Desired properties may have changed while disconnected, fetch the
+           whole document again after every connect.  */
+        if (synced_connection != sample_connection_count)
+        {
+            synced_connection = sample_connection_count;
+            if ((status = sample_device_twin_sync()))
+            {
+                synced_connection = 0;
+                if ((status != NX_AZURE_IOT_NO_PACKET) && (status != NX_AZURE_IOT_DISCONNECTED))
+                {
+                    break;
+                }
+            }
+            continue;
+        }
+
         if ((status = nx_azure_iot_hub_client_device_twin_desired_properties_receive(&iothub_client, &packet_ptr,
-                                                                                     NX_WAIT_FOREVER)))
+                                                                                     SAMPLE_RECEIVE_WAIT)))
         {
+            if ((status == NX_AZURE_IOT_NO_PACKET) || (status == NX_AZURE_IOT_DISCONNECTED))
+            {
+                continue;
+            }
             printf("Receive desired property receive failed!: error code = 0x%08x\r\n", status);
             break;
         }
 
         printf("Receive desired property call: ");
-        // todo decode packet.....
-
-        sprintf_packet(receivedProperties, packet_ptr);
-        printf("%s\r\n", receivedProperties);
-        
-        responsePropertyLen = parse_packet_data(receivedProperties, responseProperty, sizeof(responseProperty));
-        bPropertyFound = find_property_value(receivedProperties, PROPERTY_VERSION_FIELD, propertyValue);
-        if(bPropertyFound == true)
-        {
-            reported_property_version = atoi(propertyValue);
-        }
-        else
-        {   // if version property not found, set to 0 for functions below.
-            reported_property_version = 0;
-        }
-        if (responsePropertyLen > 2)
+        printf_packet(packet_ptr);
+        printf("\r\n");
+
+        sample_twin_update(packet_ptr, NX_FALSE);
+        nx_packet_release(packet_ptr);
+    }
+}
+#endif /* DISABLE_DEVICE_TWIN_SAMPLE */
+
+#ifndef DISABLE_APP_CTRL_SAMPLE
+/* Called from the switch interrupt */
+static VOID sample_button_notify(VOID)
+{
+    tx_event_flags_set(&sample_events, SAMPLE_EVENT_BUTTON, TX_OR);
+}
+
+/* Send the presses as telemetry, on the telemetry thread */
+static VOID sample_button_events_send(VOID)
+{
+    if (button_press_data.flag.sw1 == true)
+    {
+        send_button_event(0, 1, button_press_data.sw1_press_count);
+        button_press_data.flag.sw1 = false;  
+    }
+    if (button_press_data.flag.sw2 == true)
+    {
+        send_button_event(0, 2, button_press_data.sw2_press_count);
+        button_press_data.flag.sw2 = false;  
+    }
+}
+#endif /* DISABLE_APP_CTRL_SAMPLE */
+
+#ifndef DISABLE_PERIOD_TIMER_SAMPLE
+/* Count down AZ_systemRebootTimer seconds on the dispatcher tick */
+static VOID sample_reboot_tick(VOID)
+{
+static UINT ticks;
+
+    if (AZ_systemRebootTimer == 0)
+    {
+        ticks = 0;
+        return;
+    }
+    if (++ticks < (NX_IP_PERIODIC_RATE / SAMPLE_TICK_PERIOD))
+    {
+        return;
+    }
+    ticks = 0;
+
+    AZ_systemRebootTimer--;
+    if (AZ_systemRebootTimer == 0)
+    {
+        printf("AZURE: Rebooting...");
+        SYS_RESET_SoftwareReset();
+    }
+}
+#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
+
+#ifndef DISABLE_TELEMETRY_SAMPLE
+/* (Re)start the telemetry timer with the current AZ_telemetryInterval */
+static VOID sample_telemetry_timer_set(VOID)
+{
+ULONG ticks = AZ_telemetryInterval * NX_IP_PERIODIC_RATE;
+
+    if (ticks == 0)
+    {
+        ticks = NX_IP_PERIODIC_RATE;
+    }
+
+    tx_timer_deactivate(&sample_telemetry_timer);
+    tx_timer_change(&sample_telemetry_timer, ticks, ticks);
+    tx_timer_activate(&sample_telemetry_timer);
+}
+#endif /* DISABLE_TELEMETRY_SAMPLE */
+
+/* Random number below range, from a xorshift32 seeded once by the hardware RNG.
+   NX_RAND is the unseeded rand() of the C library and would hand every device
+   the same sequence of backoff delays.  */
+static ULONG sample_jitter(ULONG range)
+{
+CRYPT_RNG_CTX rng;
+
+    if (sample_jitter_state == 0)
+    {
+        if (CRYPT_RNG_Initialize(&rng) >= 0)
         {
-            response_status = 200;
+            CRYPT_RNG_BlockGenerate(&rng, (unsigned char *)&sample_jitter_state, sizeof(sample_jitter_state));
+            CRYPT_RNG_Deinitialize(&rng);
         }
-        printf("%s\r\n", responseProperty);
-        nx_packet_release(packet_ptr);
-        
-        if(bPropertyTIFound)
+        sample_jitter_state ^= tx_time_get();
+        if (sample_jitter_state == 0)
         {
-            sample_send_integer_write_proterty_response(&iothub_client, (UCHAR*)"telemetryInterval", (UINT)sizeof("telemetryInterval"), AZ_telemetryInterval,response_status,reported_property_version, NX_NULL,NX_NULL);
-            bPropertyTIFound = false;
+            sample_jitter_state = 0x2545F491;
         }
-        if(bPropertyYLEDFound)
+    }
+
+    sample_jitter_state ^= sample_jitter_state << 13;
+    sample_jitter_state ^= sample_jitter_state >> 17;
+    sample_jitter_state ^= sample_jitter_state << 5;
+
+    return(sample_jitter_state % range);
+}
+
+/* Arm the reconnect timer for the current attempt */
+static VOID sample_reconnect_schedule(VOID)
+{
+ULONG window = SAMPLE_RECONNECT_BACKOFF_MIN_SECONDS;
+ULONG ticks;
+UINT attempt;
+
+    for (attempt = 0; (attempt < sample_reconnect_attempt) && (window < SAMPLE_RECONNECT_BACKOFF_MAX_SECONDS); attempt++)
+    {
+        window <<= 1;
+    }
+    if (window > SAMPLE_RECONNECT_BACKOFF_MAX_SECONDS)
+    {
+        window = SAMPLE_RECONNECT_BACKOFF_MAX_SECONDS;
+    }
+
+    /* Full jitter, anywhere in the window.  */
+    ticks = sample_jitter(window * NX_IP_PERIODIC_RATE) + 1;
+    printf("Reconnecting to Azure IoT Hub in %lu ms\r\n", ticks * 1000 / NX_IP_PERIODIC_RATE);
+
+    tx_timer_deactivate(&sample_reconnect_timer);
+    tx_timer_change(&sample_reconnect_timer, ticks, 0);
+    tx_timer_activate(&sample_reconnect_timer);
+    sample_reconnect_pending = NX_TRUE;
+}
+
+/* Follow the Wi-Fi and hub connection states, retry is set when the
+   reconnect timer expired */
+static VOID sample_connection_update(UINT retry)
+{
+UINT status;
+
+    if (appConnectStatus.wifi == false)
+    {
+
+        /* Nothing to reconnect over, wait for wifiConnectCallback.  */
+        tx_timer_deactivate(&sample_reconnect_timer);
+        sample_reconnect_pending = NX_FALSE;
+
+        /* Drop the session now rather than on the MQTT keep alive, the link
+           may come back with another address.  */
+        if (appConnectStatus.cloud)
         {
-#ifdef WFI32_IoT_BOARD            
-            sample_send_integer_write_proterty_response(&iothub_client, (UCHAR*)"led_y", (UINT)sizeof("led_y"), appLedCtrl[APP_LED_YELLOW].mode,response_status,reported_property_version, NX_NULL,NX_NULL);
-#else
-            sample_send_integer_write_proterty_response(&iothub_client, (UCHAR*)"led_y", (UINT)sizeof("led_y"), appLedCtrl[APP_LED_RED].mode,response_status,reported_property_version, NX_NULL,NX_NULL);
-#endif            
-            bPropertyYLEDFound = false;
+            nx_azure_iot_hub_client_disconnect(&iothub_client);
+            appConnectStatus.cloud = false;
+            tx_event_flags_set(&sample_events, ~SAMPLE_EVENT_CONNECTED, TX_AND);
+            printf("Wi-Fi lost, disconnected from Azure IoT Hub\r\n");
         }
-        if ((response_status < 200) || (response_status >= 300))
+        return;
+    }
+
+    if (appConnectStatus.cloud)
+    {
+        sample_reconnect_attempt = 0;
+        return;
+    }
+
+    if (retry == NX_FALSE)
+    {
+        if (sample_reconnect_pending == NX_FALSE)
         {
-            printf("device twin report properties failed with code : %d\r\n", response_status);
-            break;
+            sample_reconnect_schedule();
         }
+        return;
     }
+
+    sample_reconnect_pending = NX_FALSE;
+
+    /* C2D, direct method and device twin topics are subscribed again by the
+       connect. A connect that times out after SAMPLE_CONNECT_WAIT backs off
+       like a refused one, not all failures reach the connection status callback.  */
+    if ((status = sample_connect((sample_connection_count == 0) ? NX_TRUE : NX_FALSE)) &&
+        (status != NX_AZURE_IOT_ALREADY_CONNECTED))
+    {
+        printf("Failed on nx_azure_iot_hub_client_connect!: error code = 0x%08x\r\n", status);
+        sample_reconnect_attempt++;
+        sample_reconnect_schedule();
+        return;
+    }
+
+    sample_reconnect_attempt = 0;
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    sample_tls_resume_print("IoTHub", &sample_iothub_tls_resume);
+#ifdef ENABLE_DPS_SAMPLE
+    sample_tls_resume_print("DPS", &sample_dps_tls_resume);
+#endif /* ENABLE_DPS_SAMPLE */
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 }
-#endif /* DISABLE_DEVICE_TWIN_SAMPLE */
 
-#ifndef DISABLE_APP_CTRL_SAMPLE
-void sample_app_ctrl_thread_entry(ULONG parameter)
+/* Connect, reconnect and drop the hub session on events, and send what the
+   other threads post: reported properties and deferred direct method calls.
+   A connect can take up to SAMPLE_CONNECT_WAIT in DNS, TCP and TLS, it runs
+   here instead of on the dispatcher so that sampling keeps its period */
+static void sample_connection_thread_entry(ULONG parameter)
 {
-    UCHAR loop = NX_TRUE;
+UINT status;
+ULONG events;
+UCHAR loop = NX_TRUE;
 
     NX_PARAMETER_NOT_USED(parameter);
 
-    APP_LED_init();
-    APP_SWITCH_init();
-
     while (loop)
     {
-        APP_LED_refresh();
-        APP_STATUS_update();
+        if ((status = tx_event_flags_get(&sample_events, SAMPLE_EVENT_NETWORK, TX_OR_CLEAR,
+                                         &events, TX_WAIT_FOREVER)))
+        {
+            printf("Connection events get failed!: error code = 0x%08x\r\n", status);
+            break;
+        }
 
-        if (button_press_data.flag.sw1 == true)
+        if (events & (SAMPLE_EVENT_CONNECTION | SAMPLE_EVENT_RECONNECT))
+        {
+            sample_connection_update((events & SAMPLE_EVENT_RECONNECT) ? NX_TRUE : NX_FALSE);
+        }
+#ifndef DISABLE_DIRECT_METHOD_SAMPLE
+        if (events & SAMPLE_EVENT_METHOD)
         {
-            send_button_event(parameter, 1, button_press_data.sw1_press_count);
-            button_press_data.flag.sw1 = false;  
+            sample_method_deferred_run();
         }
-        if (button_press_data.flag.sw2 == true)
+#endif /* DISABLE_DIRECT_METHOD_SAMPLE */
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+        if (events & SAMPLE_EVENT_REPORTED)
         {
-            send_button_event(parameter, 2, button_press_data.sw2_press_count);
-            button_press_data.flag.sw2 = false;  
+            sample_reported_properties_send(&iothub_client);
         }
-        
-        tx_thread_sleep(NX_IP_PERIODIC_RATE/2);
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
     }
 }
-#endif /* DISABLE_APP_CTRL_SAMPLE */
 
-#ifndef DISABLE_PERIOD_TIMER_SAMPLE
-void sample_period_timer_thread_entry(ULONG parameter)
+/* Run the work of the sample on events, the thread sleeps in between */
+static VOID sample_dispatch(VOID)
 {
-    UCHAR loop = NX_TRUE;
+UINT status;
+ULONG events;
+UCHAR loop = NX_TRUE;
 
-    NX_PARAMETER_NOT_USED(parameter);
+#ifndef DISABLE_APP_CTRL_SAMPLE
+    APP_LED_init();
+    APP_SWITCH_init();
+    APP_SWITCH_callbackRegister(sample_button_notify);
+#endif /* DISABLE_APP_CTRL_SAMPLE */
+#ifndef DISABLE_TELEMETRY_SAMPLE
+    sample_telemetry_init();
+    sample_telemetry_timer_set();
+#endif /* DISABLE_TELEMETRY_SAMPLE */
 
     while (loop)
     {
-        if (AZ_systemRebootTimer)
+        if ((status = tx_event_flags_get(&sample_events, SAMPLE_EVENT_ALL, TX_OR_CLEAR,
+                                         &events, TX_WAIT_FOREVER)))
         {
-            AZ_systemRebootTimer--;
-            if (AZ_systemRebootTimer == 0)
-            {
-                printf("AZURE: Rebooting...");
-                SYS_RESET_SoftwareReset();
-            }
+            printf("Sample events get failed!: error code = 0x%08x\r\n", status);
+            break;
+        }
+
+        if (events & SAMPLE_EVENT_TICK)
+        {
+#ifndef DISABLE_APP_CTRL_SAMPLE
+            APP_LED_refresh();
+            APP_STATUS_update();
+#endif /* DISABLE_APP_CTRL_SAMPLE */
+#ifndef DISABLE_PERIOD_TIMER_SAMPLE
+            sample_reboot_tick();
+#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+            sample_reported_check();
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
+        }
+#ifndef DISABLE_TELEMETRY_SAMPLE
+        if (events & SAMPLE_EVENT_INTERVAL)
+        {
+            sample_telemetry_timer_set();
+        }
+        if (events & SAMPLE_EVENT_TELEMETRY)
+        {
+            sample_telemetry_send();
+#ifdef SEND_LED_PROPERTIES_WITH_TELEMETRY
+            sample_reported_check();
+#endif /* SEND_LED_PROPERTIES_WITH_TELEMETRY */
         }
-        tx_thread_sleep(NX_IP_PERIODIC_RATE);
+#endif /* DISABLE_TELEMETRY_SAMPLE */
     }
 }
-#endif /* DISABLE_PERIOD_TIMER_SAMPLE */
 
 UINT azureGlue_crypto_hmac_256_calculate(UCHAR *key, UINT key_length, const UCHAR *input, UINT input_length, UCHAR *output)
 {
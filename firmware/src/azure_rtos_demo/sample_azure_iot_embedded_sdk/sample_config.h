@@ -26,18 +26,100 @@ extern   "C" {
 #define ID_SCOPE                       default_id_scope
 #define REGISTRATION_ID                default_registration_id
 #define SAMPLE_MAX_BUFFER              (256)
+/* Keep the hub assignment from DPS in flash and skip provisioning on boot   */
+/* while ID scope and registration ID are unchanged and the hub accepts it.  */
+#define ENABLE_DPS_CACHE
             
     
 #define DEVICE_SYMMETRIC_KEY           default_primary_key           
     
 #define NX_AZURE_IOT_STACK_SIZE                (2048)
 #define NX_AZURE_IOT_THREAD_PRIORITY           (4) 
+/* C2D, direct method and device twin threads. The deepest is the twin     */
+/* parse: on the host build it takes 720 bytes of its own (test_twin_parse) */
+/* plus what the C library's sscanf needs for a double property, 3.5 KB in  */
+/* glibc; measure the board's library before cutting this.                 */
 #define SAMPLE_STACK_SIZE                      (2048)
 #define SAMPLE_THREAD_PRIORITY                 (16)
+/* Telemetry thread, sends the readings the dispatcher takes. Its deepest */
+/* path is a QoS 1 publish through MQTT and TLS. On the host build        */
+/* (firmware/host) the builder takes 760 bytes for an interval            */
+/* (bench_telemetry, 3112 when it snprintf'd the readings) and the TLS    */
+/* record send under the publish 936 bytes (test_tls_resume). The thread  */
+/* logs its high water mark, keep a quarter of the stack free above the   */
+/* figure seen on the board.                                              */
+#define SAMPLE_TELEMETRY_STACK_SIZE            (2048)
+/* Dispatcher tick for the LED refresh and the reboot countdown, in ticks */
+#define SAMPLE_TICK_PERIOD                     (NX_IP_PERIODIC_RATE / 2)
 #define MAX_PROPERTY_COUNT                     (2)
 
+/* Reconnect to IoT Hub after a drop, attempt n waits a random time of up to  */
+/* min(MAX, MIN * 2^n) seconds (full jitter) so that devices dropped together */
+/* by an AP reboot or a hub failover do not come back in lockstep.            */
+#define SAMPLE_RECONNECT_BACKOFF_MIN_SECONDS   (2)
+#define SAMPLE_RECONNECT_BACKOFF_MAX_SECONDS   (300)
+/* Wait of one connect attempt, DNS, TCP and TLS included, in ticks. The     */
+/* connection thread runs it with its own stack, TLS needs the larger one.   */
+#define SAMPLE_CONNECT_WAIT                    (30 * NX_IP_PERIODIC_RATE)
+#define SAMPLE_CONNECTION_STACK_SIZE           (4096)
+/* Receive wait of the C2D, direct method and device twin threads, in ticks */
+#define SAMPLE_RECEIVE_WAIT                    (60 * NX_IP_PERIODIC_RATE)
+
+/* LED states are reported when they differ from the values the hub last     */
+/* acknowledged, changes within the coalesce period go out in one patch and   */
+/* a failed patch is retried after the retry period, both in ticks.           */
+#define SAMPLE_REPORTED_COALESCE_PERIOD        (2 * NX_IP_PERIODIC_RATE)
+#define SAMPLE_REPORTED_RETRY_PERIOD           (30 * NX_IP_PERIODIC_RATE)
+
+/* Print the device twin document fetched on connect. The console drops long */
+/* bursts so it goes out in throttled slices, adding about 1 s per 100 bytes  */
+/* to the connect path; debug only.                                           */
+/* #define SAMPLE_TWIN_DOCUMENT_DUMP */
+
+/* Direct method calls in progress, further calls are answered with 503, and */
+/* the size of their request and response payloads.                           */
+#define SAMPLE_METHOD_POOL_COUNT               (4)
+#define SAMPLE_METHOD_PAYLOAD_MAX              (64)
+#define SAMPLE_METHOD_RESPONSE_WAIT            (5 * NX_IP_PERIODIC_RATE)
+
 #define AZ_TELEMETRYINTERVAL_DEFAULT           5
 
+/* Merge all sensor readings of one telemetry interval into a single message. */
+/* A new message is started whenever the payload would exceed the max size,  */
+/* or a second reading of the same sensor would repeat its keys.              */
+#define TELEMETRY_BATCH_ENABLE
+#define TELEMETRY_BATCH_PAYLOAD_MAX            (256)
+
+/* Encode the telemetry payload as CBOR instead of JSON, flagged with the     */
+/* application/cbor content type. IoT Central only accepts JSON telemetry,   */
+/* enable it for hubs with a backend that decodes CBOR.                       */
+/* #define TELEMETRY_ENCODING_CBOR */
+
+/* QoS of the live telemetry stream. QoS 0 saves the PUBACK and the copy kept */
+/* for retransmission but loses the messages in flight on a drop; QoS 1 ones  */
+/* are pipelined up to NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH (nx_user.h).     */
+/* The journal backlog is always sent with QoS 1.                             */
+#define TELEMETRY_QOS                          NX_AZURE_IOT_MQTT_QOS_1
+
+/* Keep readings taken while disconnected, or whose message failed to send,  */
+/* in the SST26 flash journal and send them once reconnected, at most         */
+/* TELEMETRY_JOURNAL_DRAIN_MAX messages of up to TELEMETRY_JOURNAL_BATCH_MAX  */
+/* readings per telemetry interval.                                           */
+#define TELEMETRY_JOURNAL_ENABLE
+#define TELEMETRY_JOURNAL_DRAIN_MAX            (2)
+#define TELEMETRY_JOURNAL_BATCH_MAX            (8)
+
+/* Sample the pressure clicks every TELEMETRY_PRESSURE_PERIOD_MS and send the */
+/* mean, min, max and standard deviation of each telemetry interval.          */
+#define TELEMETRY_PRESSURE_PERIOD_MS           (20)
+
+/* Report by exception: once the device twin sets telemetryHeartbeat (s), a   */
+/* reading is only sent when it leaves the deadband around the last value    */
+/* sent for its field, or when the field was silent for telemetryHeartbeat.   */
+/* The deadbands are set per field with <field>_deadband (absolute) and      */
+/* <field>_deadbandPercent (of the last value sent), the larger one applies. */
+#define TELEMETRY_EXCEPTION_ENABLE
+
 /* Use certificate-based authentication with PKCS#11/ECC608 */
 /* Comment out the following 3 definitions to use SAS token authentication */    
     
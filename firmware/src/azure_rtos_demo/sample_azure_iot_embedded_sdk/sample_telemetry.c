@@ -0,0 +1,619 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_telemetry.h"
+#include "app_format.h"
+
+/* CBOR major types and simple values used by the encoder */
+#define SAMPLE_TELEMETRY_CBOR_UNSIGNED          (0 << 5)
+#define SAMPLE_TELEMETRY_CBOR_NEGATIVE          (1 << 5)
+#define SAMPLE_TELEMETRY_CBOR_TEXT              (3 << 5)
+#define SAMPLE_TELEMETRY_CBOR_MAP_INDEFINITE    (0xBF)
+#define SAMPLE_TELEMETRY_CBOR_FLOAT32           (0xFA)
+#define SAMPLE_TELEMETRY_CBOR_BREAK             (0xFF)
+
+/* Longest key, a key/value pair is encoded on the stack before it is appended */
+#define SAMPLE_TELEMETRY_CBOR_KEY_MAX           (48)
+
+/* Orders the slot contents against the index that publishes or frees it */
+#define SAMPLE_TELEMETRY_RING_BARRIER()         __sync_synchronize()
+
+/* Print the part of a packet chain that follows the first offset bytes */
+static VOID sample_telemetry_packet_print(NX_PACKET *packet_ptr, ULONG offset)
+{
+ULONG length;
+
+    while (packet_ptr != NX_NULL)
+    {
+        length = (ULONG)(packet_ptr -> nx_packet_append_ptr - packet_ptr -> nx_packet_prepend_ptr);
+        if (offset < length)
+        {
+            printf("%.*s", (INT)(length - offset), (CHAR *)(packet_ptr -> nx_packet_prepend_ptr + offset));
+            offset = 0;
+        }
+        else
+        {
+            offset -= length;
+        }
+        packet_ptr = packet_ptr -> nx_packet_next;
+    }
+}
+
+/* Encode the head of a CBOR data item, returns its size */
+static UINT sample_telemetry_cbor_head(UCHAR *buffer_ptr, UCHAR major_type, ULONG argument)
+{
+    if (argument < 24)
+    {
+        buffer_ptr[0] = (UCHAR)(major_type | argument);
+        return(1);
+    }
+    if (argument <= 0xFF)
+    {
+        buffer_ptr[0] = (UCHAR)(major_type | 24);
+        buffer_ptr[1] = (UCHAR)argument;
+        return(2);
+    }
+    if (argument <= 0xFFFF)
+    {
+        buffer_ptr[0] = (UCHAR)(major_type | 25);
+        buffer_ptr[1] = (UCHAR)(argument >> 8);
+        buffer_ptr[2] = (UCHAR)argument;
+        return(3);
+    }
+    buffer_ptr[0] = (UCHAR)(major_type | 26);
+    buffer_ptr[1] = (UCHAR)(argument >> 24);
+    buffer_ptr[2] = (UCHAR)(argument >> 16);
+    buffer_ptr[3] = (UCHAR)(argument >> 8);
+    buffer_ptr[4] = (UCHAR)argument;
+    return(5);
+}
+
+/* Encode a text key, returns its size or 0 if it is too long */
+static UINT sample_telemetry_cbor_key(UCHAR *buffer_ptr, const CHAR *name)
+{
+UINT length = strlen(name);
+UINT head_length;
+
+    if (length > SAMPLE_TELEMETRY_CBOR_KEY_MAX)
+    {
+        return(0);
+    }
+
+    head_length = sample_telemetry_cbor_head(buffer_ptr, SAMPLE_TELEMETRY_CBOR_TEXT, length);
+    memcpy(buffer_ptr + head_length, name, length);
+    return(head_length + length);
+}
+
+static UINT sample_telemetry_cbor_append(SAMPLE_TELEMETRY_BUILDER *builder_ptr, const UCHAR *data_ptr, UINT size)
+{
+UINT status;
+
+    if ((status = nx_packet_data_append(builder_ptr -> packet_ptr, (VOID *)data_ptr, size,
+                                        builder_ptr -> packet_ptr -> nx_packet_pool_owner,
+                                        builder_ptr -> wait_option)) == NX_SUCCESS)
+    {
+        builder_ptr -> cbor_length += size;
+    }
+
+    return(status);
+}
+
+#ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
+/* Set from the MQTT thread when a transmit queue slot is freed or the client disconnects */
+#define SAMPLE_TELEMETRY_WINDOW_EVENT           ((ULONG)0x00000001)
+
+static TX_EVENT_FLAGS_GROUP sample_telemetry_window_events;
+static UCHAR sample_telemetry_window_created;
+
+/* Runs on the MQTT thread with the client mutex held */
+static VOID sample_telemetry_window_notify(NXD_MQTT_CLIENT *client_ptr, VOID *context)
+{
+    NX_PARAMETER_NOT_USED(client_ptr);
+    NX_PARAMETER_NOT_USED(context);
+
+    tx_event_flags_set(&sample_telemetry_window_events, SAMPLE_TELEMETRY_WINDOW_EVENT, TX_OR);
+}
+#endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
+
+UINT sample_telemetry_window_attach(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr)
+{
+#ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
+NXD_MQTT_CLIENT *mqtt_client_ptr = &(hub_client_ptr -> nx_azure_iot_hub_client_resource.resource_mqtt);
+UINT status;
+
+    if (sample_telemetry_window_created == NX_FALSE)
+    {
+        if ((status = tx_event_flags_create(&sample_telemetry_window_events, "Sample Telemetry Window")))
+        {
+            return(status);
+        }
+        sample_telemetry_window_created = NX_TRUE;
+    }
+
+    tx_mutex_get(mqtt_client_ptr -> nxd_mqtt_client_mutex_ptr, TX_WAIT_FOREVER);
+    mqtt_client_ptr -> nxd_mqtt_transmit_window_context = hub_client_ptr;
+    mqtt_client_ptr -> nxd_mqtt_transmit_window_notify = sample_telemetry_window_notify;
+    tx_mutex_put(mqtt_client_ptr -> nxd_mqtt_client_mutex_ptr);
+#else
+    NX_PARAMETER_NOT_USED(hub_client_ptr);
+#endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+UINT sample_telemetry_window_wait(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT wait_option)
+{
+#ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
+NXD_MQTT_CLIENT *mqtt_client_ptr = &(hub_client_ptr -> nx_azure_iot_hub_client_resource.resource_mqtt);
+ULONG start = tx_time_get();
+ULONG elapsed;
+ULONG events;
+UINT full;
+UINT connected;
+
+    if (sample_telemetry_window_created == NX_FALSE)
+    {
+        return(NX_AZURE_IOT_SUCCESS);
+    }
+
+    if (wait_option > SAMPLE_TELEMETRY_WINDOW_WAIT)
+    {
+        wait_option = SAMPLE_TELEMETRY_WINDOW_WAIT;
+    }
+
+    for (;;)
+    {
+
+        /* Drop a stale signal before looking, a slot freed after the look signals again.  */
+        tx_event_flags_get(&sample_telemetry_window_events, SAMPLE_TELEMETRY_WINDOW_EVENT, TX_OR_CLEAR,
+                           &events, TX_NO_WAIT);
+
+        tx_mutex_get(mqtt_client_ptr -> nxd_mqtt_client_mutex_ptr, TX_WAIT_FOREVER);
+        full = (mqtt_client_ptr -> message_transmit_queue_depth >= NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH);
+        connected = (hub_client_ptr -> nx_azure_iot_hub_client_state == NX_AZURE_IOT_HUB_CLIENT_STATUS_CONNECTED);
+        tx_mutex_put(mqtt_client_ptr -> nxd_mqtt_client_mutex_ptr);
+
+        if (full == NX_FALSE)
+        {
+            return(NX_AZURE_IOT_SUCCESS);
+        }
+
+        /* Nothing frees a slot before the next connect.  */
+        elapsed = tx_time_get() - start;
+        if ((connected == NX_FALSE) || (elapsed >= wait_option))
+        {
+            return(NX_TX_QUEUE_DEPTH);
+        }
+
+        if (tx_event_flags_get(&sample_telemetry_window_events, SAMPLE_TELEMETRY_WINDOW_EVENT, TX_OR_CLEAR,
+                               &events, wait_option - elapsed))
+        {
+            return(NX_TX_QUEUE_DEPTH);
+        }
+    }
+#else
+    NX_PARAMETER_NOT_USED(hub_client_ptr);
+    NX_PARAMETER_NOT_USED(wait_option);
+
+    return(NX_AZURE_IOT_SUCCESS);
+#endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
+}
+
+/* Close the topic and open the JSON object (CBOR map) on the first appended value */
+static UINT sample_telemetry_payload_start(SAMPLE_TELEMETRY_BUILDER *builder_ptr)
+{
+UINT status;
+NXD_MQTT_CLIENT *mqtt_client_ptr;
+
+    if (builder_ptr -> packet_ptr == NX_NULL)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    if (builder_ptr -> status || builder_ptr -> payload_started)
+    {
+        return(builder_ptr -> status);
+    }
+
+    mqtt_client_ptr = &(builder_ptr -> hub_client_ptr -> nx_azure_iot_hub_client_resource.resource_mqtt);
+
+    /* Same layout nx_azure_iot_hub_client_telemetry_send builds: topic, packet id, payload.
+       QoS 0 publishes have no packet id. Internal addon API, see sample_telemetry.h.  */
+    builder_ptr -> topic_length = builder_ptr -> packet_ptr -> nx_packet_length;
+    if ((builder_ptr -> qos != NX_AZURE_IOT_MQTT_QOS_0) &&
+        (status = nx_azure_iot_mqtt_packet_id_get(mqtt_client_ptr, builder_ptr -> packet_id,
+                                                  builder_ptr -> wait_option)))
+    {
+        printf("Telemetry packet id get failed!: error code = 0x%08x\r\n", status);
+    }
+    else if ((builder_ptr -> qos != NX_AZURE_IOT_MQTT_QOS_0) &&
+             (status = nx_packet_data_append(builder_ptr -> packet_ptr, builder_ptr -> packet_id,
+                                             sizeof(builder_ptr -> packet_id),
+                                             builder_ptr -> packet_ptr -> nx_packet_pool_owner,
+                                             builder_ptr -> wait_option)))
+    {
+        printf("Telemetry packet id append failed!: error code = 0x%08x\r\n", status);
+    }
+    else if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        UCHAR map_begin = SAMPLE_TELEMETRY_CBOR_MAP_INDEFINITE;
+
+        if ((status = sample_telemetry_cbor_append(builder_ptr, &map_begin, 1)))
+        {
+            printf("Telemetry cbor map begin failed!: error code = 0x%08x\r\n", status);
+        }
+    }
+    else if ((status = nx_azure_iot_json_writer_init(&(builder_ptr -> json_writer), builder_ptr -> packet_ptr,
+                                                     builder_ptr -> wait_option)))
+    {
+        printf("Telemetry json writer init failed!: error code = 0x%08x\r\n", status);
+    }
+    else if ((status = nx_azure_iot_json_writer_append_begin_object(&(builder_ptr -> json_writer))))
+    {
+        printf("Telemetry json writer begin object failed!: error code = 0x%08x\r\n", status);
+    }
+
+    builder_ptr -> payload_started = NX_TRUE;
+    builder_ptr -> status = status;
+
+    return(status);
+}
+
+UINT sample_telemetry_builder_create(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                     NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT wait_option)
+{
+UINT status;
+
+    memset(builder_ptr, 0, sizeof(SAMPLE_TELEMETRY_BUILDER));
+
+    if ((status = nx_azure_iot_hub_client_telemetry_message_create(hub_client_ptr, &(builder_ptr -> packet_ptr),
+                                                                   wait_option)))
+    {
+        builder_ptr -> packet_ptr = NX_NULL;
+        return(status);
+    }
+
+    builder_ptr -> hub_client_ptr = hub_client_ptr;
+    builder_ptr -> wait_option = wait_option;
+    builder_ptr -> qos = NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS;
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+UINT sample_telemetry_builder_property_add(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                           const CHAR *name, const CHAR *value)
+{
+    if ((builder_ptr -> packet_ptr == NX_NULL) || builder_ptr -> payload_started)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    return(nx_azure_iot_hub_client_telemetry_property_add(builder_ptr -> packet_ptr,
+                                                          (UCHAR *)name, (USHORT)strlen(name),
+                                                          (UCHAR *)value, (USHORT)strlen(value),
+                                                          builder_ptr -> wait_option));
+}
+
+UINT sample_telemetry_builder_encoding_set(SAMPLE_TELEMETRY_BUILDER *builder_ptr, UINT encoding)
+{
+UINT status;
+
+    if ((builder_ptr -> packet_ptr == NX_NULL) || builder_ptr -> payload_started)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    if (encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        /* Content type system property */
+        if ((status = sample_telemetry_builder_property_add(builder_ptr, "$.ct", "application/cbor")))
+        {
+            return(status);
+        }
+    }
+    else if (encoding != SAMPLE_TELEMETRY_ENCODING_JSON)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    builder_ptr -> encoding = (UCHAR)encoding;
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+UINT sample_telemetry_builder_qos_set(SAMPLE_TELEMETRY_BUILDER *builder_ptr, UINT qos)
+{
+    if ((builder_ptr -> packet_ptr == NX_NULL) || builder_ptr -> payload_started)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    if ((qos != NX_AZURE_IOT_MQTT_QOS_0) && (qos != NX_AZURE_IOT_MQTT_QOS_1))
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    builder_ptr -> qos = (UCHAR)qos;
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+UINT sample_telemetry_builder_append_double(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                            const CHAR *name, double value, UINT fractional_digits)
+{
+UINT status;
+UCHAR buffer[SAMPLE_TELEMETRY_CBOR_KEY_MAX + 10];
+UINT length;
+union
+{
+    float f;
+    ULONG u;
+} single;
+
+    if ((status = sample_telemetry_payload_start(builder_ptr)))
+    {
+        return(status);
+    }
+
+    if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        if ((length = sample_telemetry_cbor_key(buffer, name)) == 0)
+        {
+            builder_ptr -> status = NX_AZURE_IOT_INVALID_PARAMETER;
+            return(builder_ptr -> status);
+        }
+
+        /* The sensors deliver single precision, no need for the 9 byte double */
+        single.f = (float)value;
+        buffer[length++] = SAMPLE_TELEMETRY_CBOR_FLOAT32;
+        buffer[length++] = (UCHAR)(single.u >> 24);
+        buffer[length++] = (UCHAR)(single.u >> 16);
+        buffer[length++] = (UCHAR)(single.u >> 8);
+        buffer[length++] = (UCHAR)single.u;
+
+        builder_ptr -> status = sample_telemetry_cbor_append(builder_ptr, buffer, length);
+        return(builder_ptr -> status);
+    }
+
+    /* Integer fixed-point text for the single precision sensor values, the
+       writer's double conversion is the fallback for what it can not format */
+    if ((fractional_digits <= APP_FORMAT_DIGITS_MAX) &&
+        ((length = APP_FORMAT_fixed((CHAR *)buffer, sizeof(buffer), (float)value, (uint8_t)fractional_digits)) != 0))
+    {
+        if ((builder_ptr -> status =
+                nx_azure_iot_json_writer_append_property_name(&(builder_ptr -> json_writer),
+                                                              (const UCHAR *)name, strlen(name))) == NX_AZURE_IOT_SUCCESS)
+        {
+            builder_ptr -> status =
+                nx_azure_iot_json_writer_append_json_text(&(builder_ptr -> json_writer), buffer, length);
+        }
+        return(builder_ptr -> status);
+    }
+
+    builder_ptr -> status =
+        nx_azure_iot_json_writer_append_property_with_double_value(&(builder_ptr -> json_writer),
+                                                                   (const UCHAR *)name, strlen(name),
+                                                                   value, fractional_digits);
+    return(builder_ptr -> status);
+}
+
+UINT sample_telemetry_builder_append_int32(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                           const CHAR *name, int32_t value)
+{
+UINT status;
+UCHAR buffer[SAMPLE_TELEMETRY_CBOR_KEY_MAX + 10];
+UINT length;
+
+    if ((status = sample_telemetry_payload_start(builder_ptr)))
+    {
+        return(status);
+    }
+
+    if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        if ((length = sample_telemetry_cbor_key(buffer, name)) == 0)
+        {
+            builder_ptr -> status = NX_AZURE_IOT_INVALID_PARAMETER;
+            return(builder_ptr -> status);
+        }
+
+        /* Negative integers are encoded as -1 - argument */
+        if (value < 0)
+        {
+            length += sample_telemetry_cbor_head(buffer + length, SAMPLE_TELEMETRY_CBOR_NEGATIVE,
+                                                 (ULONG)(-1 - value));
+        }
+        else
+        {
+            length += sample_telemetry_cbor_head(buffer + length, SAMPLE_TELEMETRY_CBOR_UNSIGNED, (ULONG)value);
+        }
+
+        builder_ptr -> status = sample_telemetry_cbor_append(builder_ptr, buffer, length);
+        return(builder_ptr -> status);
+    }
+
+    builder_ptr -> status =
+        nx_azure_iot_json_writer_append_property_with_int32_value(&(builder_ptr -> json_writer),
+                                                                  (const UCHAR *)name, strlen(name),
+                                                                  value);
+    return(builder_ptr -> status);
+}
+
+UINT sample_telemetry_builder_payload_length(SAMPLE_TELEMETRY_BUILDER *builder_ptr)
+{
+    if ((builder_ptr -> packet_ptr == NX_NULL) || !builder_ptr -> payload_started)
+    {
+        return(0);
+    }
+
+    if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        return(builder_ptr -> cbor_length);
+    }
+
+    return(nx_azure_iot_json_writer_get_bytes_used(&(builder_ptr -> json_writer)));
+}
+
+UINT sample_telemetry_builder_send(SAMPLE_TELEMETRY_BUILDER *builder_ptr)
+{
+UINT status;
+
+    if (builder_ptr -> packet_ptr == NX_NULL)
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    if (!builder_ptr -> payload_started)
+    {
+        /* Nothing to send.  */
+        sample_telemetry_builder_delete(builder_ptr);
+        return(NX_AZURE_IOT_SUCCESS);
+    }
+
+    if ((status = builder_ptr -> status) == NX_AZURE_IOT_SUCCESS)
+    {
+        if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+        {
+            UCHAR map_end = SAMPLE_TELEMETRY_CBOR_BREAK;
+
+            status = sample_telemetry_cbor_append(builder_ptr, &map_end, 1);
+        }
+        else
+        {
+            status = nx_azure_iot_json_writer_append_end_object(&(builder_ptr -> json_writer));
+        }
+    }
+
+    if (status)
+    {
+        sample_telemetry_builder_delete(builder_ptr);
+        return(status);
+    }
+
+    /* Log the payload before the packet is handed over to MQTT.  */
+    if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_CBOR)
+    {
+        printf("[CBOR telemetry, %u bytes]\r\n", builder_ptr -> cbor_length);
+    }
+    else
+    {
+        sample_telemetry_packet_print(builder_ptr -> packet_ptr,
+                                      builder_ptr -> topic_length +
+                                      ((builder_ptr -> qos != NX_AZURE_IOT_MQTT_QOS_0) ? sizeof(builder_ptr -> packet_id) : 0));
+        printf("\r\n");
+    }
+
+    if ((builder_ptr -> qos != NX_AZURE_IOT_MQTT_QOS_0) &&
+        (status = sample_telemetry_window_wait(builder_ptr -> hub_client_ptr, builder_ptr -> wait_option)))
+    {
+        sample_telemetry_builder_delete(builder_ptr);
+        return(status);
+    }
+
+    /* Internal addon API, see sample_telemetry.h. Takes the packet on success.  */
+    status = nx_azure_iot_publish_mqtt_packet(&(builder_ptr -> hub_client_ptr -> nx_azure_iot_hub_client_resource.resource_mqtt),
+                                              builder_ptr -> packet_ptr, builder_ptr -> topic_length,
+                                              builder_ptr -> packet_id, builder_ptr -> qos,
+                                              builder_ptr -> wait_option);
+    if (status)
+    {
+        sample_telemetry_builder_delete(builder_ptr);
+        return(status);
+    }
+
+    /* Packet is owned by MQTT now.  */
+    if (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_JSON)
+    {
+        nx_azure_iot_json_writer_deinit(&(builder_ptr -> json_writer));
+    }
+    builder_ptr -> packet_ptr = NX_NULL;
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+VOID sample_telemetry_builder_delete(SAMPLE_TELEMETRY_BUILDER *builder_ptr)
+{
+    if (builder_ptr -> packet_ptr == NX_NULL)
+    {
+        return;
+    }
+
+    if (builder_ptr -> payload_started && (builder_ptr -> encoding == SAMPLE_TELEMETRY_ENCODING_JSON))
+    {
+        nx_azure_iot_json_writer_deinit(&(builder_ptr -> json_writer));
+    }
+
+    nx_azure_iot_hub_client_telemetry_message_delete(builder_ptr -> packet_ptr);
+    builder_ptr -> packet_ptr = NX_NULL;
+}
+
+VOID sample_telemetry_ring_init(SAMPLE_TELEMETRY_RING *ring_ptr)
+{
+    memset(ring_ptr, 0, sizeof(SAMPLE_TELEMETRY_RING));
+}
+
+SAMPLE_TELEMETRY_SAMPLE *sample_telemetry_ring_reserve(SAMPLE_TELEMETRY_RING *ring_ptr)
+{
+SAMPLE_TELEMETRY_SAMPLE *sample_ptr;
+ULONG head = ring_ptr -> head;
+
+    if ((head - ring_ptr -> tail) >= SAMPLE_TELEMETRY_RING_SIZE)
+    {
+        ring_ptr -> dropped++;
+        return(NX_NULL);
+    }
+
+    /* Read the slot only after the consumer freed it.  */
+    SAMPLE_TELEMETRY_RING_BARRIER();
+    sample_ptr = &(ring_ptr -> samples[head & (SAMPLE_TELEMETRY_RING_SIZE - 1)]);
+    sample_ptr -> count = 0;
+    return(sample_ptr);
+}
+
+VOID sample_telemetry_ring_commit(SAMPLE_TELEMETRY_RING *ring_ptr)
+{
+ULONG used;
+
+    /* The slot is complete before the consumer can see it.  */
+    SAMPLE_TELEMETRY_RING_BARRIER();
+    ring_ptr -> head++;
+    ring_ptr -> produced++;
+
+    used = ring_ptr -> head - ring_ptr -> tail;
+    if (used > ring_ptr -> high_water)
+    {
+        ring_ptr -> high_water = used;
+    }
+}
+
+SAMPLE_TELEMETRY_SAMPLE *sample_telemetry_ring_peek(SAMPLE_TELEMETRY_RING *ring_ptr)
+{
+ULONG tail = ring_ptr -> tail;
+
+    if (ring_ptr -> head == tail)
+    {
+        return(NX_NULL);
+    }
+
+    /* Read the slot only after the producer published it.  */
+    SAMPLE_TELEMETRY_RING_BARRIER();
+    return(&(ring_ptr -> samples[tail & (SAMPLE_TELEMETRY_RING_SIZE - 1)]));
+}
+
+VOID sample_telemetry_ring_release(SAMPLE_TELEMETRY_RING *ring_ptr)
+{
+
+    /* Done with the slot before the producer can reuse it.  */
+    SAMPLE_TELEMETRY_RING_BARRIER();
+    ring_ptr -> tail++;
+}
@@ -0,0 +1,149 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef SAMPLE_TELEMETRY_H
+#define SAMPLE_TELEMETRY_H
+
+/* Determine if a C++ compiler is being used.  If so, ensure that standard
+   C is used to process the API information.  */
+
+#ifdef __cplusplus
+
+/* Yes, C++ compiler is present.  Use standard C.  */
+extern   "C" {
+
+#endif
+
+#include "nx_api.h"
+#include "nx_azure_iot_hub_client.h"
+#include "nx_azure_iot_json_writer.h"
+
+/* Telemetry builder.
+   The JSON payload is serialized with the NetX json writer straight into the
+   telemetry packet returned by nx_azure_iot_hub_client_telemetry_message_create,
+   so no intermediate buffer is needed and the payload is never copied.
+
+   Usage: create, add system/application properties, append values, send.
+   The first append closes the topic and starts the JSON object, so all
+   properties must be added before it.
+   Append errors are latched in the builder and reported by send, which
+   always releases the packet.
+
+   The payload is JSON unless sample_telemetry_builder_encoding_set selects
+   CBOR (RFC 8949): an indefinite length map with text keys, int32 values as
+   integers and double values as single precision floats. The content type
+   system property tells the hub which one it gets.
+
+   Messages are published with NX_AZURE_IOT_HUB_CLIENT_TELEMETRY_QOS unless
+   sample_telemetry_builder_qos_set selects another one. QoS 0 messages carry
+   no packet id and are neither acknowledged nor kept for retransmission.
+   QoS 1 messages are sent without waiting for the PUBACK of the previous
+   ones; send first waits for room in the transmit window below.
+
+   The builder relies on two internal APIs of the NetX Duo Azure IoT addon,
+   declared under "Internal APIs" in nx_azure_iot.h:
+   nx_azure_iot_mqtt_packet_id_get and nx_azure_iot_publish_mqtt_packet.
+   nx_azure_iot_hub_client_telemetry_send can not be used, it appends the
+   packet id after what the packet already holds, i.e. after a payload
+   written in place. The builder does what telemetry_send does in the same
+   order, so recheck it against that function when the addon is updated.  */
+#define SAMPLE_TELEMETRY_ENCODING_JSON          0
+#define SAMPLE_TELEMETRY_ENCODING_CBOR          1
+
+/* Transmit window.
+   With NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH set, the MQTT client turns a QoS 1
+   publish away with NX_TX_QUEUE_DEPTH while that many wait for their PUBACK.
+   Every QoS 1 publish of the hub client, built or not, calls
+   sample_telemetry_window_wait first; it sleeps until the MQTT thread frees a
+   slot or the client disconnects, at most SAMPLE_TELEMETRY_WINDOW_WAIT ticks.
+   attach hooks the MQTT client after each nx_azure_iot_hub_client_initialize.
+   The wait and the publish that follows are not atomic, QoS 1 publishes must
+   all come from one thread.  */
+#ifndef SAMPLE_TELEMETRY_WINDOW_WAIT
+#define SAMPLE_TELEMETRY_WINDOW_WAIT            (5 * NX_IP_PERIODIC_RATE)
+#endif /* SAMPLE_TELEMETRY_WINDOW_WAIT */
+
+UINT sample_telemetry_window_attach(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr);
+UINT sample_telemetry_window_wait(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT wait_option);
+
+typedef struct SAMPLE_TELEMETRY_BUILDER_STRUCT
+{
+    NX_AZURE_IOT_HUB_CLIENT    *hub_client_ptr;
+    NX_PACKET                  *packet_ptr;
+    NX_AZURE_IOT_JSON_WRITER    json_writer;
+    UINT                        topic_length;
+    UINT                        wait_option;
+    UINT                        status;
+    UCHAR                       packet_id[2];
+    UCHAR                       payload_started;
+    UCHAR                       encoding;
+    UCHAR                       qos;
+    UINT                        cbor_length;
+} SAMPLE_TELEMETRY_BUILDER;
+
+UINT sample_telemetry_builder_create(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                     NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr, UINT wait_option);
+UINT sample_telemetry_builder_property_add(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                           const CHAR *name, const CHAR *value);
+UINT sample_telemetry_builder_encoding_set(SAMPLE_TELEMETRY_BUILDER *builder_ptr, UINT encoding);
+UINT sample_telemetry_builder_qos_set(SAMPLE_TELEMETRY_BUILDER *builder_ptr, UINT qos);
+UINT sample_telemetry_builder_append_double(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                            const CHAR *name, double value, UINT fractional_digits);
+UINT sample_telemetry_builder_append_int32(SAMPLE_TELEMETRY_BUILDER *builder_ptr,
+                                           const CHAR *name, int32_t value);
+UINT sample_telemetry_builder_payload_length(SAMPLE_TELEMETRY_BUILDER *builder_ptr);
+UINT sample_telemetry_builder_send(SAMPLE_TELEMETRY_BUILDER *builder_ptr);
+VOID sample_telemetry_builder_delete(SAMPLE_TELEMETRY_BUILDER *builder_ptr);
+
+/* Sample ring.
+   Fixed size single producer, single consumer queue of reading groups between
+   the thread that takes the readings and the one that sends them. Each side
+   only writes its own index, so neither locks out nor waits on the other.
+
+   The producer fills the slot returned by reserve and publishes it with
+   commit; a full ring returns NX_NULL and the group is counted as dropped,
+   so a stalled uplink shows as gaps instead of delaying the readings.
+   The consumer reads the slot returned by peek and frees it with release.  */
+#define SAMPLE_TELEMETRY_RING_SIZE              (16)    /* Power of two */
+#define SAMPLE_TELEMETRY_GROUP_MAX              (6)
+
+typedef struct SAMPLE_TELEMETRY_SAMPLE_STRUCT
+{
+    uint64_t                    timestamp_ms;           /* Unix time in ms, 0 if unknown */
+    ULONG                       tick;                   /* tx_time_get() when taken */
+    UINT                        count;
+    UCHAR                       fields[SAMPLE_TELEMETRY_GROUP_MAX];
+    float                       values[SAMPLE_TELEMETRY_GROUP_MAX];
+} SAMPLE_TELEMETRY_SAMPLE;
+
+typedef struct SAMPLE_TELEMETRY_RING_STRUCT
+{
+    SAMPLE_TELEMETRY_SAMPLE     samples[SAMPLE_TELEMETRY_RING_SIZE];
+    volatile ULONG              head;                   /* Written by the producer only */
+    volatile ULONG              tail;                   /* Written by the consumer only */
+    ULONG                       produced;
+    ULONG                       dropped;
+    ULONG                       high_water;
+} SAMPLE_TELEMETRY_RING;
+
+VOID sample_telemetry_ring_init(SAMPLE_TELEMETRY_RING *ring_ptr);
+SAMPLE_TELEMETRY_SAMPLE *sample_telemetry_ring_reserve(SAMPLE_TELEMETRY_RING *ring_ptr);
+VOID sample_telemetry_ring_commit(SAMPLE_TELEMETRY_RING *ring_ptr);
+SAMPLE_TELEMETRY_SAMPLE *sample_telemetry_ring_peek(SAMPLE_TELEMETRY_RING *ring_ptr);
+VOID sample_telemetry_ring_release(SAMPLE_TELEMETRY_RING *ring_ptr);
+
+/* Determine if a C++ compiler is being used.  If so, ensure that standard
+   C is used to process the API information.  */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SAMPLE_TELEMETRY_H */
@@ -0,0 +1,219 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_twin.h"
+
+/* Read the desired value of a property, NX_AZURE_IOT_SUCCESS if it was set */
+static UINT sample_twin_property_apply(const SAMPLE_TWIN_PROPERTY *property_ptr, UINT index,
+                                       NX_AZURE_IOT_JSON_READER *reader_ptr)
+{
+UINT status;
+int32_t integer;
+double value;
+
+    if (property_ptr -> type == SAMPLE_TWIN_TYPE_INTEGER)
+    {
+        status = nx_azure_iot_json_reader_token_int32_get(reader_ptr, &integer);
+        value = integer;
+    }
+    else
+    {
+        status = nx_azure_iot_json_reader_token_double_get(reader_ptr, &value);
+    }
+
+    if (status)
+    {
+        return(status);
+    }
+    if ((value < property_ptr -> min) || (value > property_ptr -> max))
+    {
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    property_ptr -> set(index, value);
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+/* Table entry and index of a property name, -1 if it is not writable */
+static INT sample_twin_property_find(const SAMPLE_TWIN_TABLE *table_ptr, const CHAR *name, UINT name_length,
+                                     UINT *index_ptr)
+{
+const SAMPLE_TWIN_PROPERTY *property_ptr;
+const CHAR *field_name;
+UINT prefix_length;
+UINT field;
+UINT i;
+
+    for (i = 0; i < table_ptr -> property_count; i++)
+    {
+        property_ptr = &(table_ptr -> properties[i]);
+        if (property_ptr -> per_field == NX_FALSE)
+        {
+            if (strcmp(name, property_ptr -> name) == 0)
+            {
+                *index_ptr = 0;
+                return((INT)i);
+            }
+            continue;
+        }
+
+        if ((name_length <= strlen(property_ptr -> name)) ||
+            strcmp(&name[name_length - strlen(property_ptr -> name)], property_ptr -> name))
+        {
+            continue;
+        }
+        prefix_length = name_length - strlen(property_ptr -> name);
+        for (field = 0; field < table_ptr -> field_count; field++)
+        {
+            field_name = table_ptr -> field_name(field);
+            if ((strlen(field_name) == prefix_length) && (strncmp(name, field_name, prefix_length) == 0))
+            {
+                *index_ptr = field;
+                return((INT)i);
+            }
+        }
+    }
+
+    return(-1);
+}
+
+/* Name of a table entry and index, returns its length */
+UINT sample_twin_property_name(const SAMPLE_TWIN_TABLE *table_ptr, UINT i, UINT index,
+                               CHAR *name, UINT name_size)
+{
+    if (table_ptr -> properties[i].per_field)
+    {
+        return((UINT)snprintf(name, name_size, "%s%s", table_ptr -> field_name(index),
+                              table_ptr -> properties[i].name));
+    }
+
+    return((UINT)snprintf(name, name_size, "%s", table_ptr -> properties[i].name));
+}
+
+/* Move the reader to the begin of the desired properties: the root object of
+   a desired properties patch, the "desired" object of the full document */
+static UINT sample_twin_desired_find(NX_AZURE_IOT_JSON_READER *reader_ptr, UINT full_document)
+{
+UINT status;
+
+    if ((status = nx_azure_iot_json_reader_next_token(reader_ptr)))
+    {
+        return(status);
+    }
+
+    while (full_document)
+    {
+        if ((status = nx_azure_iot_json_reader_next_token(reader_ptr)))
+        {
+            return(status);
+        }
+        if (nx_azure_iot_json_reader_token_type(reader_ptr) != NX_AZURE_IOT_READER_TOKEN_PROPERTY_NAME)
+        {
+            return(NX_AZURE_IOT_NOT_FOUND);
+        }
+        if (nx_azure_iot_json_reader_token_is_text_equal(reader_ptr, (UCHAR *)"desired", sizeof("desired") - 1))
+        {
+            if ((status = nx_azure_iot_json_reader_next_token(reader_ptr)))
+            {
+                return(status);
+            }
+            break;
+        }
+        if ((status = nx_azure_iot_json_reader_skip_children(reader_ptr)))
+        {
+            return(status);
+        }
+    }
+
+    if (nx_azure_iot_json_reader_token_type(reader_ptr) != NX_AZURE_IOT_READER_TOKEN_BEGIN_OBJECT)
+    {
+        return(NX_AZURE_IOT_INVALID_PACKET);
+    }
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+
+/* Apply the writable properties of a twin update in one pass over the packet
+   chain, no copy of the document is made. acks_ptr gets the properties to
+   acknowledge, version_ptr the $version of the desired properties */
+UINT sample_twin_desired_parse(const SAMPLE_TWIN_TABLE *table_ptr, NX_PACKET *packet_ptr, UINT full_document,
+                               SAMPLE_TWIN_ACKS *acks_ptr, ULONG *version_ptr)
+{
+NX_AZURE_IOT_JSON_READER reader;
+CHAR name[SAMPLE_TWIN_NAME_MAX];
+UINT name_length;
+UINT index;
+UINT status;
+INT i;
+uint32_t version;
+
+    if ((status = nx_azure_iot_json_reader_init(&reader, packet_ptr)))
+    {
+        return(status);
+    }
+
+    if ((status = sample_twin_desired_find(&reader, full_document)) == NX_AZURE_IOT_SUCCESS)
+    {
+        while ((status = nx_azure_iot_json_reader_next_token(&reader)) == NX_AZURE_IOT_SUCCESS)
+        {
+            if (nx_azure_iot_json_reader_token_type(&reader) != NX_AZURE_IOT_READER_TOKEN_PROPERTY_NAME)
+            {
+
+                /* End of the desired properties.  */
+                break;
+            }
+
+            /* Names that do not fit are not in the table.  */
+            if (nx_azure_iot_json_reader_token_string_get(&reader, (UCHAR *)name, sizeof(name) - 1, &name_length))
+            {
+                name_length = 0;
+            }
+            name[name_length] = 0;
+
+            if ((status = nx_azure_iot_json_reader_next_token(&reader)))
+            {
+                break;
+            }
+
+            if (strcmp(name, "$version") == 0)
+            {
+                if (nx_azure_iot_json_reader_token_uint32_get(&reader, &version) == NX_AZURE_IOT_SUCCESS)
+                {
+                    *version_ptr = version;
+                }
+            }
+            else if ((i = sample_twin_property_find(table_ptr, name, name_length, &index)) >= 0)
+            {
+                if (sample_twin_property_apply(&(table_ptr -> properties[i]), index, &reader) == NX_AZURE_IOT_SUCCESS)
+                {
+                    acks_ptr -> accepted[i] |= (1UL << index);
+                    acks_ptr -> rejected[i] &= ~(1UL << index);
+                }
+                else
+                {
+                    acks_ptr -> rejected[i] |= (1UL << index);
+                    acks_ptr -> accepted[i] &= ~(1UL << index);
+                }
+            }
+
+            /* Skip values that are objects or arrays.  */
+            if ((status = nx_azure_iot_json_reader_skip_children(&reader)))
+            {
+                break;
+            }
+        }
+    }
+
+    nx_azure_iot_json_reader_deinit(&reader);
+    return(status);
+}
@@ -0,0 +1,93 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef SAMPLE_TWIN_H
+#define SAMPLE_TWIN_H
+
+/* Determine if a C++ compiler is being used.  If so, ensure that standard
+   C is used to process the API information.  */
+
+#ifdef __cplusplus
+
+/* Yes, C++ compiler is present.  Use standard C.  */
+extern   "C" {
+
+#endif
+
+#include "nx_api.h"
+#include "nx_azure_iot.h"
+#include "nx_azure_iot_json_reader.h"
+
+/* Device twin parser.
+   The desired properties of a twin update are read with the chunked NetX
+   json reader straight from the NX_PACKET chain the hub client returns, in
+   one pass and without a copy of the document. The reader takes chains of
+   up to NX_AZURE_IOT_READER_MAX_LIST packets, longer ones are refused with
+   NX_AZURE_IOT_INSUFFICIENT_BUFFER_SPACE. Writable properties are
+   dispatched through a table: a desired value of the given type within
+   [min, max] is passed to set, get returns the value reported in the
+   acknowledgement with fractional_digits (0 for integers).
+
+   Per field properties are named "<field name><name>", the field names come
+   from field_name and index is the field, otherwise index is 0. A table has
+   at most SAMPLE_TWIN_PROPERTY_MAX entries and 32 fields.
+
+   Only the "desired" object of a full document is read, the root object of
+   a desired properties patch. Values that are objects or arrays and names
+   not in the table are skipped, $version is picked up in the same pass.  */
+
+/* Longest writable property name, "<telemetry field>_deadbandPercent" */
+#define SAMPLE_TWIN_NAME_MAX                (48)
+#define SAMPLE_TWIN_PROPERTY_MAX            (8)
+
+/* Value types of the writable properties */
+#define SAMPLE_TWIN_TYPE_INTEGER            (0)
+#define SAMPLE_TWIN_TYPE_DOUBLE             (1)
+
+typedef struct SAMPLE_TWIN_PROPERTY_STRUCT
+{
+    const CHAR *name;
+    UINT        per_field;
+    UINT        type;
+    double      min;
+    double      max;
+    UINT        fractional_digits;
+    VOID      (*set)(UINT index, double value);
+    double    (*get)(UINT index);
+} SAMPLE_TWIN_PROPERTY;
+
+typedef struct SAMPLE_TWIN_TABLE_STRUCT
+{
+    const SAMPLE_TWIN_PROPERTY *properties;
+    UINT                        property_count;
+    UINT                        field_count;
+    const CHAR               *(*field_name)(UINT field);
+} SAMPLE_TWIN_TABLE;
+
+/* Properties of one twin update to acknowledge, one bit per index */
+typedef struct SAMPLE_TWIN_ACKS_STRUCT
+{
+    ULONG accepted[SAMPLE_TWIN_PROPERTY_MAX];
+    ULONG rejected[SAMPLE_TWIN_PROPERTY_MAX];
+} SAMPLE_TWIN_ACKS;
+
+UINT sample_twin_desired_parse(const SAMPLE_TWIN_TABLE *table_ptr, NX_PACKET *packet_ptr, UINT full_document,
+                               SAMPLE_TWIN_ACKS *acks_ptr, ULONG *version_ptr);
+UINT sample_twin_property_name(const SAMPLE_TWIN_TABLE *table_ptr, UINT i, UINT index,
+                               CHAR *name, UINT name_size);
+
+/* Determine if a C++ compiler is being used.  If so, ensure that standard
+   C is used to process the API information.  */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SAMPLE_TWIN_H */
@@ -14,6 +14,7 @@
 #include "nxd_sntp_client.h"
 
 #include "osal/osal.h"
+#include "app_clock.h"
 //#include "system/int/sys_int.h"
 
 /* Include the sample.  */
@@ -55,6 +56,7 @@ static UINT sntp_server_index;
 #endif /* DEMO_SNTP_SERVER_NAME */
 
 static UINT sntp_time_sync(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr);
+static VOID sntp_time_update_notify(NX_SNTP_TIME_MESSAGE *time_update_ptr, NX_SNTP_TIME *local_time);
 
 #define RUN_AZURE
 #ifdef RUN_AZURE
@@ -160,6 +162,16 @@ UINT    i;
         return(status);
     }
 
+    /* Every update from the server disciplines the application clock.  */
+    status = nx_sntp_client_set_time_update_notify(&sntp_client, sntp_time_update_notify);
+
+    /* Check status.  */
+    if (status)
+    {
+        nx_sntp_client_delete(&sntp_client);
+        return(status);
+    }
+
     /* Set local time to 0 */
     status = nx_sntp_client_set_local_time(&sntp_client, 0, 0);
 
@@ -213,10 +225,7 @@ UINT    i;
 
             /* Time sync successfully.  */
 
-            /* Stop and delete SNTP.  */
-            nx_sntp_client_stop(&sntp_client);
-            nx_sntp_client_delete(&sntp_client);
-
+            /* Keep the client polling, its updates correct the drift of the clock.  */
             return(NX_SUCCESS);
         }
 
@@ -233,12 +242,29 @@ UINT    i;
     /* Return success.  */
     return(NX_NOT_SUCCESSFUL);
 }
+/* Discipline the application clock with an SNTP update.  */
+static VOID sntp_time_update_notify(NX_SNTP_TIME_MESSAGE *time_update_ptr, NX_SNTP_TIME *local_time)
+{
+    NX_PARAMETER_NOT_USED(time_update_ptr);
+
+    /* Convert the NTP seconds and 2^-32 fraction to Unix microseconds.  */
+    APP_CLOCK_sync(((uint64_t)(local_time -> seconds - DEMO_UNIX_TO_NTP_EPOCH_SECOND) * 1000000) +
+                   (((uint64_t)local_time -> fraction * 1000000) >> 32));
+}
 #ifdef RUN_AZURE
 static UINT unix_time_get(ULONG *unix_time)
 {
+uint64_t unix_us = APP_CLOCK_unixUsGet();
 
     /* Return number of seconds since Unix Epoch (1/1/1970 00:00:00).  */
-    *unix_time =  unix_time_base + (tx_time_get() / TX_TIMER_TICKS_PER_SECOND);
+    if (unix_us != 0)
+    {
+        *unix_time = (ULONG)(unix_us / 1000000);
+    }
+    else
+    {
+        *unix_time =  unix_time_base + (tx_time_get() / TX_TIMER_TICKS_PER_SECOND);
+    }
 
     return(NX_SUCCESS);
 }
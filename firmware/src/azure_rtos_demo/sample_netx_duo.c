@@ -23,6 +23,8 @@
 /* Define the ThreadX and NetX object control blocks...  */
 TX_THREAD               thread_0;
 NX_PACKET_POOL          pool_0;
+NX_PACKET_POOL          pool_rx;
+NX_PACKET_POOL          pool_small;
 NX_IP                   ip_0;
 #if (NX_DEMO_ENABLE_DHCP != 0)
 NX_DHCP                 dhcp_0;
@@ -40,6 +42,8 @@ NXD_ADDRESS             ipv6_address;
 ULONG demo_thread_stack[DEMO_STACK_SIZE / sizeof(ULONG)];
 ULONG demo_ip_stack[NX_DEMO_IP_STACK_SIZE / sizeof(ULONG)];
 ULONG demo_pool_stack[NX_DEMO_PACKET_POOL_SIZE / sizeof(ULONG)];
+ULONG demo_rx_pool_stack[NX_DEMO_RX_PACKET_POOL_SIZE / sizeof(ULONG)];
+ULONG demo_small_pool_stack[NX_DEMO_SMALL_PACKET_POOL_SIZE / sizeof(ULONG)];
 ULONG demo_arp_cache_area[NX_DEMO_ARP_CACHE_SIZE / sizeof(ULONG)];
 
 /* Define the counters used in the demo application...  */
@@ -51,6 +55,7 @@ extern  void sample_azure_iot_entry(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_
               
 /***** Substitute your ethernet driver entry function here *********/
 extern  VOID nx_driver_harmony(NX_IP_DRIVER*); 
+extern  void nx_driver_rx_packet_pool_set(NX_PACKET_POOL* pool_ptr);
 
 #if (NX_DEMO_ENABLE_DHCP != 0)
 static void dhcp_wait();
@@ -70,7 +75,7 @@ UINT    status;
     /* Initialize the NetX system.  */
     nx_system_initialize();
     
-    /* Create a packet pool.  */ 
+    /* Create a packet pool for the application: TLS/MQTT, DNS and SNTP.  */ 
     status = nx_packet_pool_create(&pool_0, "NetX Main Packet Pool", 
                                    NX_DEMO_PACKET_SIZE,
                                    demo_pool_stack, sizeof(demo_pool_stack)); 
@@ -79,11 +84,31 @@ UINT    status;
     if (status)
         error_counter++;     
     
+    /* Create the packet pool of the received frames, not shared with TX.  */ 
+    status = nx_packet_pool_create(&pool_rx, "NetX RX Packet Pool", 
+                                   NX_DEMO_PACKET_SIZE,
+                                   demo_rx_pool_stack, sizeof(demo_rx_pool_stack)); 
+                
+    /* Check for packet pool create errors.  */
+    if (status)
+        error_counter++;     
+    
+    /* Create the packet pool of small packets, the IP default one: TCP ACK and control, ARP.  */ 
+    status = nx_packet_pool_create(&pool_small, "NetX Small Packet Pool", 
+                                   NX_DEMO_SMALL_PACKET_SIZE,
+                                   demo_small_pool_stack, sizeof(demo_small_pool_stack)); 
+                
+    /* Check for packet pool create errors.  */
+    if (status)
+        error_counter++;     
+    
+    nx_driver_rx_packet_pool_set(&pool_rx);
+
     /* Create an IP instance.  */
     status = nx_ip_create(&ip_0, "NetX IP Instance 0", 
                           NX_DEMO_IPV4_ADDRESS, 
                           NX_DEMO_IPV4_MASK, 
-                          &pool_0, 
+                          &pool_small, 
                           nx_driver_harmony,
                           (UCHAR *)demo_ip_stack, 
                           sizeof(demo_ip_stack), 
@@ -254,9 +279,9 @@ UINT    dns_server_address_size = 16;
     /* Is the DNS client configured for the host application to create the pecket pool? */
 #if (NX_DNS_CLIENT_USER_CREATE_PACKET_POOL != 0)
 
-    /* Yes, use the packet pool created above which has appropriate payload size
+    /* Yes, use the application packet pool which has appropriate payload size
        for DNS messages. */
-    status = nx_dns_packet_pool_set(&dns_0, ip_0.nx_ip_default_packet_pool);
+    status = nx_dns_packet_pool_set(&dns_0, &pool_0);
     if (status)
     {
         nx_dns_delete(&dns_0);
@@ -36,6 +36,7 @@ ALTITUDE2_RETVAL ALTITUDE2_status;
 // ---------------------------------------------- PRIVATE FUNCTION DECLARATIONS 
 
 static void altitude2_make_conv_comm ( ALTITUDE2_Data *ctx, uint8_t *comm_temp, uint8_t *comm_press );
+static void altitude2_calculate ( ALTITUDE2_Data *ctx, uint32_t *buff_data, float *temp_data, float *press_data, float *altitude_data );
 static void altitude2_i2c_send_comm ( ALTITUDE2_Data *ctx, uint8_t comm_byte, uint32_t *input_data, uint8_t num_bytes );
 static void altitude2_i2c_send_comm_resp ( ALTITUDE2_Data *ctx, uint8_t comm_byte, uint32_t *output_data, uint8_t num_bytes );
 
@@ -116,8 +117,6 @@ void ALTITUDE2_readData( ALTITUDE2_Data *ctx, float *temp_data, float *press_dat
     uint32_t buff_data[ 2 ];
     uint8_t temp_comm;
     uint8_t press_comm;
-    float res_data[ 4 ];
-    float  volatile /*tmp_var, */tmp_var1, tmp_var2;
         
     altitude2_make_conv_comm( ctx, &temp_comm, &press_comm );
     altitude2_i2c_send_comm( ctx, temp_comm, 0, 0 );
@@ -125,6 +124,59 @@ void ALTITUDE2_readData( ALTITUDE2_Data *ctx, float *temp_data, float *press_dat
     altitude2_i2c_send_comm( ctx, press_comm, 0, 0 );
     altitude2_i2c_send_comm_resp( ctx, 0x00, &buff_data[ 1 ], 3 );
     
+    altitude2_calculate( ctx, buff_data, temp_data, press_data, altitude_data );
+}
+
+/* Conversion commands, ADC read command and ADC results of the sampling job */
+static uint8_t altitude2_job_comm[ 3 ];
+static uint8_t altitude2_job_adc[ 2 ][ 3 ];
+static APP_SENSORS_XFER altitude2_job_xfers[ 4 ];
+static APP_SENSORS_JOB altitude2_job;
+
+static bool altitude2_job_decode ( APP_SENSORS_JOB *job, float *values )
+{
+    uint32_t buff_data[ 2 ];
+    uint8_t cnt;
+
+    for( cnt = 0; cnt < 2; cnt++ )
+    {
+        buff_data[ cnt ] = ( altitude2_job_adc[ cnt ][ 0 ] << 16 ) |
+                           ( altitude2_job_adc[ cnt ][ 1 ] << 8 ) |
+                           altitude2_job_adc[ cnt ][ 2 ];
+    }
+    altitude2_calculate( ( ALTITUDE2_Data *)job->context, buff_data,
+                         &values[ ALTITUDE2_JOB_TEMPERATURE ],
+                         &values[ ALTITUDE2_JOB_PRESSURE ],
+                         &values[ ALTITUDE2_JOB_ALTITUDE ] );
+    return true;
+}
+
+APP_SENSORS_JOB *ALTITUDE2_sampleJob( ALTITUDE2_Data *ctx )
+{
+    altitude2_make_conv_comm( ctx, &altitude2_job_comm[ 0 ], &altitude2_job_comm[ 1 ] );
+    altitude2_job_comm[ 2 ] = 0x00;
+
+    /* Start a conversion, read the ADC once it is done, same for pressure */
+    altitude2_job_xfers[ 0 ] = (APP_SENSORS_XFER){ ALTITUDE2_DEVICE_ADDR_1, &altitude2_job_comm[ 0 ], 1, NULL, 0, 0 };
+    altitude2_job_xfers[ 1 ] = (APP_SENSORS_XFER){ ALTITUDE2_DEVICE_ADDR_1, &altitude2_job_comm[ 2 ], 1, altitude2_job_adc[ 0 ], 3, 10 };
+    altitude2_job_xfers[ 2 ] = (APP_SENSORS_XFER){ ALTITUDE2_DEVICE_ADDR_1, &altitude2_job_comm[ 1 ], 1, NULL, 0, 0 };
+    altitude2_job_xfers[ 3 ] = (APP_SENSORS_XFER){ ALTITUDE2_DEVICE_ADDR_1, &altitude2_job_comm[ 2 ], 1, altitude2_job_adc[ 1 ], 3, 10 };
+
+    altitude2_job.name = "ALT2";
+    altitude2_job.xfers = altitude2_job_xfers;
+    altitude2_job.xferCount = 4;
+    altitude2_job.periodMs = APP_SENSORS_SAMPLE_PERIOD_MS;
+    altitude2_job.decode = altitude2_job_decode;
+    altitude2_job.context = ( uintptr_t )ctx;
+
+    return &altitude2_job;
+}
+
+static void altitude2_calculate ( ALTITUDE2_Data *ctx, uint32_t *buff_data, float *temp_data, float *press_data, float *altitude_data )
+{
+    float res_data[ 4 ];
+    float  volatile /*tmp_var, */tmp_var1, tmp_var2;
+
     res_data[ 0 ] = ( float )ctx->data_prom[ 4 ] * 256.0;
     res_data[ 0 ] = ( float )buff_data[ 0 ] - res_data[ 0 ];
     res_data[ 1 ] = res_data[ 0 ] / 8.0;
@@ -201,6 +201,21 @@ uint8_t altitude2_set_ratio( ALTITUDE2_Data *ctx, uint8_t temp_ratio, uint8_t pr
  */
 void ALTITUDE2_readData( ALTITUDE2_Data *ctx, float *temp_data, float *press_data, float *altitude_data );
 
+/* Values of the sampling job */
+#define ALTITUDE2_JOB_TEMPERATURE                     0
+#define ALTITUDE2_JOB_PRESSURE                        1
+#define ALTITUDE2_JOB_ALTITUDE                        2
+
+/**
+ * @brief Sampling job function.
+ * @param ctx                    Click object, initialized.
+ *
+ * @returns                      Job to hand over to APP_SENSORS_jobAdd.
+ * @description This function sets up the sensor scheduler job that performs
+ * the same measurements as ALTITUDE2_readData, see ALTITUDE2_JOB_xxx for the values.
+ */
+struct _APP_SENSORS_JOB *ALTITUDE2_sampleJob( ALTITUDE2_Data *ctx );
+
 
 #ifdef __cplusplus
 }
@@ -63,6 +63,23 @@ static void dev_send_cmd_resp ( PHT_Data *ctx, uint8_t addr, uint8_t cmd_byte, u
  */
 static void dev_make_conv_cmd ( PHT_Data *ctx, uint8_t *cmd_temp, uint8_t *cmd_press );
 
+/**
+ * @brief Calculation function.
+ * @details The function compensates the raw ADC results with the PROM coefficients.
+ * @param[in] buff_data : Raw temperature and pressure ADC results
+ * @param[out] temperature : Temperature (Celsius)
+ * @param[out] pressure : Pressure (mBar)
+ */
+static void dev_calc_temp_press ( PHT_Data *ctx, uint32_t *buff_data, float *temperature, float *pressure );
+
+/**
+ * @brief Calculation function.
+ * @details The function converts the raw humidity result.
+ * @param[in] rx_data : Humidity measurement as read from the sensor
+ * @return Humidity (percentage)
+ */
+static float dev_calc_humidity ( uint8_t *rx_data );
+
 // --------------------------------------------------------- PRIVATE FUNCTIONS 
 
 static void dev_send_cmd ( uint8_t addr, uint8_t cmd_byte )
@@ -117,6 +134,49 @@ static void dev_make_conv_cmd ( PHT_Data *ctx, uint8_t *cmd_temp, uint8_t *cmd_p
     *cmd_press = cmd_byte;
 }
 
+static void dev_calc_temp_press ( PHT_Data *ctx, uint32_t *buff_data, float *temperature, float *pressure )
+{
+    float res_data[ 4 ];
+
+    res_data[ 0 ] = ctx->data_prom[ 4 ] * 256.0;
+    res_data[ 0 ] = buff_data[ 0 ] - res_data[ 0 ];
+    res_data[ 1 ] = res_data[ 0 ] / 8.0;
+    res_data[ 1 ] = res_data[ 1 ] * ( ctx->data_prom[ 5 ] / 1048576.0 );
+    res_data[ 1 ] = res_data[ 1 ] + 2000.0;
+    res_data[ 1 ] /= 100.0;
+    *temperature = res_data[ 1 ];
+
+    res_data[ 2 ] = res_data[ 0 ] / 128.0;
+    res_data[ 2 ] = res_data[ 2 ] * ( ctx->data_prom[ 2 ] / 2097152.0 );
+    res_data[ 2 ] = res_data[ 2 ] + ( ctx->data_prom[ 0 ] / 32.0 );
+    res_data[ 3 ] = res_data[ 0 ] / 32.0;
+    res_data[ 3 ] = res_data[ 3 ] * ( ctx->data_prom[ 3 ] / 65536.0 );
+    res_data[ 3 ] = res_data[ 3 ] + ( ctx->data_prom[ 1 ] * 4.0 );
+    res_data[ 1 ] = buff_data[ 1 ] / 32768.0;
+    res_data[ 1 ] = res_data[ 1 ] * res_data[ 2 ];
+    res_data[ 1 ] = res_data[ 1 ] - res_data[ 3 ];
+    res_data[ 1 ] /= 100.0;
+    *pressure = res_data[ 1 ];
+}
+
+static float dev_calc_humidity ( uint8_t *rx_data )
+{
+    uint16_t rh_val;
+    float rh;
+
+    rh_val = rx_data[ 0 ];
+    rh_val <<= 8;
+    rh_val |= rx_data[ 1 ];
+
+    rh = ( float ) rh_val;
+    rh *= 12500.0;
+    rh /= 65536.0;
+    rh -= 600.0;
+    rh /= 100.0;
+
+    return rh;
+}
+
 // --------------------------------------------------------- PUBLIC FUNCTIONS 
 
 PHT_RETVAL PHT_init ( PHT_Data *ctx )
@@ -193,7 +253,6 @@ void PHT_getTemperaturePressure ( PHT_Data *ctx, float *temperature, float *pres
     uint32_t buff_data[ 2 ];
     uint8_t temp_cmd;
     uint8_t press_cmd;
-    float res_data[ 4 ];
     
     dev_make_conv_cmd( ctx, &temp_cmd, &press_cmd );
     dev_send_cmd( PHT_I2C_SLAVE_ADDR_P_AND_T, temp_cmd );
@@ -201,47 +260,65 @@ void PHT_getTemperaturePressure ( PHT_Data *ctx, float *temperature, float *pres
     dev_send_cmd( PHT_I2C_SLAVE_ADDR_P_AND_T, press_cmd );
     dev_send_cmd_resp( ctx, PHT_I2C_SLAVE_ADDR_P_AND_T, PHT_PT_CMD_ADC_READ, 3, &buff_data[ 1 ] );
 
-    res_data[ 0 ] = ctx->data_prom[ 4 ] * 256.0;
-    res_data[ 0 ] = buff_data[ 0 ] - res_data[ 0 ];
-    res_data[ 1 ] = res_data[ 0 ] / 8.0;
-    res_data[ 1 ] = res_data[ 1 ] * ( ctx->data_prom[ 5 ] / 1048576.0 );
-    res_data[ 1 ] = res_data[ 1 ] + 2000.0;
-    res_data[ 1 ] /= 100.0;
-    *temperature = res_data[ 1 ];
-
-    res_data[ 2 ] = res_data[ 0 ] / 128.0;
-    res_data[ 2 ] = res_data[ 2 ] * ( ctx->data_prom[ 2 ] / 2097152.0 );
-    res_data[ 2 ] = res_data[ 2 ] + ( ctx->data_prom[ 0 ] / 32.0 );
-    res_data[ 3 ] = res_data[ 0 ] / 32.0;
-    res_data[ 3 ] = res_data[ 3 ] * ( ctx->data_prom[ 3 ] / 65536.0 );
-    res_data[ 3 ] = res_data[ 3 ] + ( ctx->data_prom[ 1 ] * 4.0 );
-    res_data[ 1 ] = buff_data[ 1 ] / 32768.0;
-    res_data[ 1 ] = res_data[ 1 ] * res_data[ 2 ];
-    res_data[ 1 ] = res_data[ 1 ] - res_data[ 3 ];
-    res_data[ 1 ] /= 100.0;
-    *pressure = res_data[ 1 ];
+    dev_calc_temp_press( ctx, buff_data, temperature, pressure );
 }
 
 void PHT_getRelativeHumidity ( float *humidity )
 {
-    uint16_t rh_val;
-    float rh;
-   
     APP_SENSORS_writeByte(PHT_I2C_SLAVE_ADDR_RH, PHT_RH_MEASURE_RH_HOLD);
     tx_thread_sleep(20);
     APP_SENSORS_justRead(PHT_I2C_SLAVE_ADDR_RH, 2);
         
-    rh_val = APP_SENSORS_data.i2c.rxBuffBytes[ 0 ];
-    rh_val <<= 8;
-    rh_val |= APP_SENSORS_data.i2c.rxBuffBytes[ 1 ];
+    *humidity = dev_calc_humidity( APP_SENSORS_data.i2c.rxBuffBytes );
+}
 
-    rh = ( float ) rh_val;
-    rh *= 12500.0;
-    rh /= 65536.0;
-    rh -= 600.0;
-    rh /= 100.0;
+/* Commands and raw results of the sampling job */
+static uint8_t pht_job_cmd[ 4 ];
+static uint8_t pht_job_adc[ 2 ][ 3 ];
+static uint8_t pht_job_rh[ 2 ];
+static APP_SENSORS_XFER pht_job_xfers[ 6 ];
+static APP_SENSORS_JOB pht_job;
 
-    *humidity = rh;
+static bool pht_job_decode ( APP_SENSORS_JOB *job, float *values )
+{
+    uint32_t buff_data[ 2 ];
+    uint8_t cnt;
+
+    for( cnt = 0; cnt < 2; cnt++ )
+    {
+        buff_data[ cnt ] = ( pht_job_adc[ cnt ][ 0 ] << 16 ) |
+                           ( pht_job_adc[ cnt ][ 1 ] << 8 ) |
+                           pht_job_adc[ cnt ][ 2 ];
+    }
+    dev_calc_temp_press( ( PHT_Data * )job->context, buff_data,
+                         &values[ PHT_JOB_TEMPERATURE ], &values[ PHT_JOB_PRESSURE ] );
+    values[ PHT_JOB_HUMIDITY ] = dev_calc_humidity( pht_job_rh );
+
+    return true;
+}
+
+APP_SENSORS_JOB *PHT_sampleJob ( PHT_Data *ctx )
+{
+    dev_make_conv_cmd( ctx, &pht_job_cmd[ 0 ], &pht_job_cmd[ 1 ] );
+    pht_job_cmd[ 2 ] = PHT_PT_CMD_ADC_READ;
+    pht_job_cmd[ 3 ] = PHT_RH_MEASURE_RH_HOLD;
+
+    /* Pressure and temperature conversions, then the humidity measurement */
+    pht_job_xfers[ 0 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_P_AND_T, &pht_job_cmd[ 0 ], 1, NULL, 0, 0 };
+    pht_job_xfers[ 1 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_P_AND_T, &pht_job_cmd[ 2 ], 1, pht_job_adc[ 0 ], 3, 10 };
+    pht_job_xfers[ 2 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_P_AND_T, &pht_job_cmd[ 1 ], 1, NULL, 0, 0 };
+    pht_job_xfers[ 3 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_P_AND_T, &pht_job_cmd[ 2 ], 1, pht_job_adc[ 1 ], 3, 10 };
+    pht_job_xfers[ 4 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_RH, &pht_job_cmd[ 3 ], 1, NULL, 0, 0 };
+    pht_job_xfers[ 5 ] = (APP_SENSORS_XFER){ PHT_I2C_SLAVE_ADDR_RH, NULL, 0, pht_job_rh, 2, 20 };
+
+    pht_job.name = "PHT";
+    pht_job.xfers = pht_job_xfers;
+    pht_job.xferCount = 6;
+    pht_job.periodMs = APP_SENSORS_SAMPLE_PERIOD_MS;
+    pht_job.decode = pht_job_decode;
+    pht_job.context = ( uintptr_t )ctx;
+
+    return &pht_job;
 }
 
 // ------------------------------------------------------------------------- END
@@ -221,6 +221,20 @@ void PHT_getTemperaturePressure ( PHT_Data *ctx, float *temperature, float *pres
  */
 void PHT_getRelativeHumidity ( float *humidity );
 
+/* Values of the sampling job */
+#define PHT_JOB_TEMPERATURE                           0
+#define PHT_JOB_PRESSURE                              1
+#define PHT_JOB_HUMIDITY                              2
+
+/**
+ * @brief Sampling job function.
+ * @details The function sets up the sensor scheduler job that performs the
+ * measurements of PHT_getTemperaturePressure and PHT_getRelativeHumidity.
+ * @param[in] ctx : Click context object, initialized.
+ * @return Job to hand over to APP_SENSORS_jobAdd, see PHT_JOB_xxx for the values.
+ */
+struct _APP_SENSORS_JOB *PHT_sampleJob ( PHT_Data *ctx );
+
 #ifdef __cplusplus
 }
 #endif
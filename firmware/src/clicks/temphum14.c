@@ -47,7 +47,7 @@ void temphum14_set_cmd ( uint8_t addr, uint8_t cmd )
     APP_SENSORS_writeByte( addr, cmd );
 }
 
-void TEMPHUM14_setConversion ( uint8_t addr, uint8_t hum_osr, uint8_t temp_osr )
+static uint8_t temphum14_conversion_cmd ( uint8_t hum_osr, uint8_t temp_osr )
 {
     uint8_t tmp;
     
@@ -58,25 +58,21 @@ void TEMPHUM14_setConversion ( uint8_t addr, uint8_t hum_osr, uint8_t temp_osr )
     tmp |= hum_osr;
     tmp |= temp_osr;
 
-    temphum14_set_cmd( addr, tmp );
+    return tmp;
+}
+
+void TEMPHUM14_setConversion ( uint8_t addr, uint8_t hum_osr, uint8_t temp_osr )
+{
+    temphum14_set_cmd( addr, temphum14_conversion_cmd( hum_osr, temp_osr ) );
     tx_thread_sleep(10);
 }
 
-void TEMPHUM14_getTemperatureHumidity ( uint8_t addr, float *temp, float *hum )
+static void temphum14_calculate ( uint8_t *rx_buf, float *temp, float *hum )
 {
-    uint8_t rx_buf[ (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES) ];
     uint16_t tmp;
     float temperature;
     float humidity;
 
-    APP_SENSORS_writeReadBytes( addr, TEMPHUM14_CMD_READ_T_AND_RH, 
-            (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES) );
-
-    for (int index = 0; index <  (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES); index++)
-    {
-        rx_buf[ index ] = APP_SENSORS_data.i2c.rxBuffBytes[ index ];
-    }
-    
     tmp = rx_buf[ 0 ];
     tmp <<= 8;
     tmp |= rx_buf[ 1 ];
@@ -99,6 +95,21 @@ void TEMPHUM14_getTemperatureHumidity ( uint8_t addr, float *temp, float *hum )
     *hum = humidity;
 }
 
+void TEMPHUM14_getTemperatureHumidity ( uint8_t addr, float *temp, float *hum )
+{
+    uint8_t rx_buf[ (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES) ];
+
+    APP_SENSORS_writeReadBytes( addr, TEMPHUM14_CMD_READ_T_AND_RH, 
+            (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES) );
+
+    for (int index = 0; index <  (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES); index++)
+    {
+        rx_buf[ index ] = APP_SENSORS_data.i2c.rxBuffBytes[ index ];
+    }
+    
+    temphum14_calculate( rx_buf, temp, hum );
+}
+
 void TEMPHUM14_softReset ( uint8_t addr )
 {
     temphum14_set_cmd( addr, TEMPHUM14_CMD_RESET );
@@ -201,4 +212,35 @@ uint32_t TEMPHUM14_getSerialNumber ( uint8_t addr ) {
     
     return ser_numb;
 }
+
+/* Commands and raw results of the sampling job */
+static uint8_t temphum14_job_cmd[ 2 ];
+static uint8_t temphum14_job_rx[ (TEMPHUM14_TEMPERATURE_NUMBER_BYTES+TEMPHUM14_HUMIDITY_NUMBER_BYTES) ];
+static APP_SENSORS_XFER temphum14_job_xfers[ 2 ];
+static APP_SENSORS_JOB temphum14_job;
+
+static bool temphum14_job_decode ( APP_SENSORS_JOB *job, float *values )
+{
+    temphum14_calculate( temphum14_job_rx, &values[ TEMPHUM14_JOB_TEMPERATURE ],
+                         &values[ TEMPHUM14_JOB_HUMIDITY ] );
+    return true;
+}
+
+APP_SENSORS_JOB *TEMPHUM14_sampleJob ( uint8_t addr, uint8_t hum_osr, uint8_t temp_osr )
+{
+    temphum14_job_cmd[ 0 ] = temphum14_conversion_cmd( hum_osr, temp_osr );
+    temphum14_job_cmd[ 1 ] = TEMPHUM14_CMD_READ_T_AND_RH;
+
+    temphum14_job_xfers[ 0 ] = (APP_SENSORS_XFER){ addr, &temphum14_job_cmd[ 0 ], 1, NULL, 0, 0 };
+    temphum14_job_xfers[ 1 ] = (APP_SENSORS_XFER){ addr, &temphum14_job_cmd[ 1 ], 1,
+                                                   temphum14_job_rx, sizeof( temphum14_job_rx ), 10 };
+
+    temphum14_job.name = "TH14";
+    temphum14_job.xfers = temphum14_job_xfers;
+    temphum14_job.xferCount = 2;
+    temphum14_job.periodMs = APP_SENSORS_SAMPLE_PERIOD_MS;
+    temphum14_job.decode = temphum14_job_decode;
+
+    return &temphum14_job;
+}
 // ------------------------------------------------------------------------- END
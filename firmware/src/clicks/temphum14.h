@@ -268,6 +268,21 @@ void TEMPHUM14_getDiagnostic ( uint8_t addr, temphum14_diagn_t *diag_data );
  */
 uint32_t TEMPHUM14_getSerialNumber ( uint8_t addr );
 
+/* Values of the sampling job */
+#define TEMPHUM14_JOB_TEMPERATURE                        0
+#define TEMPHUM14_JOB_HUMIDITY                           1
+
+/**
+ * @brief Sampling job function.
+ * @details The function sets up the sensor scheduler job that performs the
+ * measurements of TEMPHUM14_setConversion and TEMPHUM14_getTemperatureHumidity.
+ * @param[in] addr : I2C slave address.
+ * @param[in] hum_osr : Humidity OSR.
+ * @param[in] temp_osr : Temperature OSR.
+ * @return Job to hand over to APP_SENSORS_jobAdd, see TEMPHUM14_JOB_xxx for the values.
+ */
+struct _APP_SENSORS_JOB *TEMPHUM14_sampleJob ( uint8_t addr, uint8_t hum_osr, uint8_t temp_osr );
+
 #ifdef __cplusplus
 }
 #endif
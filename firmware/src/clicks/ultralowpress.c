@@ -57,6 +57,28 @@ uint16_t ULTRALOWPRESS_reorderBytes(uint16_t word)
     return (bytes_swapped);
 }
 
+static bool ULTRALOWPRESS_statusReady(uint16_t status_reg)
+{
+    return ( status_reg & ULTRALOWPRESS_STATUS_TEMP_MASK ) && 
+            ( status_reg & ULTRALOWPRESS_STATUS_PRESS_MASK );
+}
+
+static float ULTRALOWPRESS_temperatureConvert(uint16_t word)
+{
+    int16_t decimal = ULTRALOWPRESS_2sCompToDecimal(word);
+
+    return ( (decimal - ULTRALOWPRESS_B0) / ULTRALOWPRESS_B1 );
+}
+
+static float ULTRALOWPRESS_pressureConvert(uint16_t word)
+{
+    int16_t decimal = ULTRALOWPRESS_2sCompToDecimal(word);
+
+    return ULTRALOWPRESS_P_MIN + ( ( decimal - ULTRALOWPRESS_OUT_MIN ) / 
+            ( ULTRALOWPRESS_OUT_MAX - ULTRALOWPRESS_OUT_MIN ) ) * 
+            ( ULTRALOWPRESS_P_MAX - ULTRALOWPRESS_P_MIN );
+}
+
 uint32_t ULTRALOWPRESS_init(void)
 {
     uint32_t serial_number = 0;
@@ -91,8 +113,7 @@ bool ULTRALOWPRESS_isReady(void)
     APP_SENSORS_writeReadWords(ULTRALOWPRESS_I2CADDR, ULTRALOWPRESS_REG_STATUS, 2);
     status_reg = APP_SENSORS_data.i2c.rxBuffWords[0];
     
-    return ( status_reg & ULTRALOWPRESS_STATUS_TEMP_MASK ) && 
-            ( status_reg & ULTRALOWPRESS_STATUS_PRESS_MASK );
+    return ULTRALOWPRESS_statusReady(status_reg);
 }
 
 void ULTRALOWPRESS_clearStatus (void)
@@ -102,24 +123,63 @@ void ULTRALOWPRESS_clearStatus (void)
 
 float ULTRALOWPRESS_getTemperature(void)
 {
-    int16_t decimal;
-    
     APP_SENSORS_writeReadWords(ULTRALOWPRESS_I2CADDR, ULTRALOWPRESS_REG_TEMP, 2);
-    decimal = ULTRALOWPRESS_2sCompToDecimal(APP_SENSORS_data.i2c.rxBuffWords[0]);
 
-    return ( (decimal - ULTRALOWPRESS_B0) / ULTRALOWPRESS_B1 );
+    return ULTRALOWPRESS_temperatureConvert(APP_SENSORS_data.i2c.rxBuffWords[0]);
 }
 
 float ULTRALOWPRESS_getPressure(void)
 {
-    int16_t decimal;
-
     APP_SENSORS_writeReadWords(ULTRALOWPRESS_I2CADDR, ULTRALOWPRESS_REG_PRESS, 2);
-    decimal = ULTRALOWPRESS_2sCompToDecimal(APP_SENSORS_data.i2c.rxBuffWords[0]);
-    
-    return ULTRALOWPRESS_P_MIN + ( ( decimal - ULTRALOWPRESS_OUT_MIN ) / 
-            ( ULTRALOWPRESS_OUT_MAX - ULTRALOWPRESS_OUT_MIN ) ) * 
-            ( ULTRALOWPRESS_P_MAX - ULTRALOWPRESS_P_MIN );
+
+    return ULTRALOWPRESS_pressureConvert(APP_SENSORS_data.i2c.rxBuffWords[0]);
+}
+
+// Registers, status clear command and raw results of the sampling job.
+// The registers are little endian words (LSB first)
+static uint8_t ULTRALOWPRESS_jobCmd[] = {
+    ULTRALOWPRESS_REG_STATUS,
+    ULTRALOWPRESS_REG_STATUS,
+    (uint8_t)(ULTRALOWPRESS_STATUS_CLEAR & 0x00FF),
+    (uint8_t)(ULTRALOWPRESS_STATUS_CLEAR >> 8),
+    ULTRALOWPRESS_REG_TEMP,
+    ULTRALOWPRESS_REG_PRESS,
+};
+static uint8_t ULTRALOWPRESS_jobRx[3][2];
+static APP_SENSORS_XFER ULTRALOWPRESS_jobXfers[4];
+static APP_SENSORS_JOB ULTRALOWPRESS_job;
+
+#define ULTRALOWPRESS_JOB_WORD(rx) ((uint16_t)((rx)[0] | ((rx)[1] << 8)))
+
+static bool ULTRALOWPRESS_jobReady(APP_SENSORS_JOB *job)
+{
+    return ULTRALOWPRESS_statusReady(ULTRALOWPRESS_JOB_WORD(ULTRALOWPRESS_jobRx[0]));
+}
+
+static bool ULTRALOWPRESS_jobDecode(APP_SENSORS_JOB *job, float *values)
+{
+    values[ULTRALOWPRESS_JOB_TEMPERATURE] = 
+            ULTRALOWPRESS_temperatureConvert(ULTRALOWPRESS_JOB_WORD(ULTRALOWPRESS_jobRx[1]));
+    values[ULTRALOWPRESS_JOB_PRESSURE] = 
+            ULTRALOWPRESS_pressureConvert(ULTRALOWPRESS_JOB_WORD(ULTRALOWPRESS_jobRx[2]));
+    return true;
+}
+
+APP_SENSORS_JOB *ULTRALOWPRESS_sampleJob(void)
+{
+    ULTRALOWPRESS_jobXfers[0] = (APP_SENSORS_XFER){ ULTRALOWPRESS_I2CADDR, &ULTRALOWPRESS_jobCmd[0], 1, ULTRALOWPRESS_jobRx[0], 2, 0 };
+    ULTRALOWPRESS_jobXfers[1] = (APP_SENSORS_XFER){ ULTRALOWPRESS_I2CADDR, &ULTRALOWPRESS_jobCmd[1], 3, NULL, 0, 0 };
+    ULTRALOWPRESS_jobXfers[2] = (APP_SENSORS_XFER){ ULTRALOWPRESS_I2CADDR, &ULTRALOWPRESS_jobCmd[4], 1, ULTRALOWPRESS_jobRx[1], 2, 0 };
+    ULTRALOWPRESS_jobXfers[3] = (APP_SENSORS_XFER){ ULTRALOWPRESS_I2CADDR, &ULTRALOWPRESS_jobCmd[5], 1, ULTRALOWPRESS_jobRx[2], 2, 0 };
+
+    ULTRALOWPRESS_job.name = "ULP";
+    ULTRALOWPRESS_job.xfers = ULTRALOWPRESS_jobXfers;
+    ULTRALOWPRESS_job.xferCount = 4;
+    ULTRALOWPRESS_job.periodMs = APP_SENSORS_SAMPLE_PERIOD_MS;
+    ULTRALOWPRESS_job.ready = ULTRALOWPRESS_jobReady;
+    ULTRALOWPRESS_job.decode = ULTRALOWPRESS_jobDecode;
+
+    return &ULTRALOWPRESS_job;
 }
 
 // ------------------------------------------------------------------------- END
@@ -135,6 +135,18 @@ float ULTRALOWPRESS_getPressure(void);
  */
 float ULTRALOWPRESS_getTemperature(void);
 
+/* Values of the sampling job */
+#define ULTRALOWPRESS_JOB_TEMPERATURE 0
+#define ULTRALOWPRESS_JOB_PRESSURE    1
+
+/**
+ * @brief Sampling job
+ * @details Sets up the sensor scheduler job that checks the status, clears it
+ * and reads temperature and pressure once both are ready.
+ * @return Job to hand over to APP_SENSORS_jobAdd, see ULTRALOWPRESS_JOB_xxx for the values.
+ */
+struct _APP_SENSORS_JOB *ULTRALOWPRESS_sampleJob(void);
+
 #ifdef __cplusplus
 }
 #endif
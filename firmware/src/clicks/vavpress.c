@@ -124,30 +124,61 @@ vavpress_return_value_t VAVPRESS_setDefaultSensorParams(vavpress_sensor_param_da
     return error_flag;
 }
 
-vavpress_return_value_t VAVPRESS_getSensorReadings(vavpress_sensor_param_data_t *param_data, float *diff_press, float *temperatureC)
+static void VAVPRESS_calculate(vavpress_sensor_param_data_t *param_data, uint8_t *rx_buf, float *diff_press, float *temperatureC)
 {
     int16_t word_data, pressure, tempC;
     float tmp;
 
-    APP_SENSORS_justRead(VAVPRESS_I2CADDR_0, EXTENDED_READOUT_NUMBYTES);
-
-    word_data = ( (APP_SENSORS_data.i2c.rxBuffBytes[1] << 8) | APP_SENSORS_data.i2c.rxBuffBytes[0] );
+    word_data = ( (rx_buf[1] << 8) | rx_buf[0] );
     pressure = VAVPRESS_2sCompToDecimal(word_data);
     tmp = ( float ) pressure;
     tmp /= ( float ) param_data->scale_factor_press;
     *diff_press = tmp;
   
-    word_data = ( (APP_SENSORS_data.i2c.rxBuffBytes[3] << 8) | APP_SENSORS_data.i2c.rxBuffBytes[2] );
+    word_data = ( (rx_buf[3] << 8) | rx_buf[2] );
     tempC = VAVPRESS_2sCompToDecimal(word_data);
     tmp = ( float ) tempC;
     tmp -= ( float ) param_data->readout_at_known_temperature;
     tmp /= ( float ) param_data->scale_factor_temp;
     tmp += param_data->known_temperature_c; 
     *temperatureC = tmp;
+}
+
+vavpress_return_value_t VAVPRESS_getSensorReadings(vavpress_sensor_param_data_t *param_data, float *diff_press, float *temperatureC)
+{
+    APP_SENSORS_justRead(VAVPRESS_I2CADDR_0, EXTENDED_READOUT_NUMBYTES);
+
+    VAVPRESS_calculate(param_data, APP_SENSORS_data.i2c.rxBuffBytes, diff_press, temperatureC);
 
     return VAVPRESS_OK;
 }
 
+/* Raw extended readout of the sampling job */
+static uint8_t VAVPRESS_jobRx[EXTENDED_READOUT_NUMBYTES];
+static APP_SENSORS_XFER VAVPRESS_jobXfer;
+static APP_SENSORS_JOB VAVPRESS_job;
+
+static bool VAVPRESS_jobDecode(APP_SENSORS_JOB *job, float *values)
+{
+    VAVPRESS_calculate((vavpress_sensor_param_data_t *)job->context, VAVPRESS_jobRx,
+            &values[VAVPRESS_JOB_PRESSURE], &values[VAVPRESS_JOB_TEMPERATURE]);
+    return true;
+}
+
+APP_SENSORS_JOB *VAVPRESS_sampleJob(vavpress_sensor_param_data_t *param_data)
+{
+    VAVPRESS_jobXfer = (APP_SENSORS_XFER){ VAVPRESS_I2CADDR_0, NULL, 0, VAVPRESS_jobRx, EXTENDED_READOUT_NUMBYTES, 0 };
+
+    VAVPRESS_job.name = "VAV";
+    VAVPRESS_job.xfers = &VAVPRESS_jobXfer;
+    VAVPRESS_job.xferCount = 1;
+    VAVPRESS_job.periodMs = APP_SENSORS_SAMPLE_PERIOD_MS;
+    VAVPRESS_job.decode = VAVPRESS_jobDecode;
+    VAVPRESS_job.context = (uintptr_t)param_data;
+
+    return &VAVPRESS_job;
+}
+
 vavpress_return_value_t VAVPRESS_getElectronicSignature(vavpress_el_signature_data_t *el_signature_data)
 {
     uint8_t rx_buf[EL_SIGNATURE_NUMBYTES];
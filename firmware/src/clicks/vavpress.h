@@ -191,6 +191,19 @@ vavpress_return_value_t VAVPRESS_getSensorReadings(vavpress_sensor_param_data_t
  */
 vavpress_return_value_t VAVPRESS_getElectronicSignature(vavpress_el_signature_data_t *el_signature_data);
 
+/* Values of the sampling job */
+#define VAVPRESS_JOB_PRESSURE    0
+#define VAVPRESS_JOB_TEMPERATURE 1
+
+/**
+ * @brief VAV Press sampling job function.
+ * @details This function sets up the sensor scheduler job that performs the
+ * extended readout of VAVPRESS_getSensorReadings.
+ * @param[in] param_data : Sensor parameters, must stay valid while the job runs.
+ * @return Job to hand over to APP_SENSORS_jobAdd, see VAVPRESS_JOB_xxx for the values.
+ */
+struct _APP_SENSORS_JOB *VAVPRESS_sampleJob(vavpress_sensor_param_data_t *param_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -63,7 +63,7 @@ typedef SYS_FS_MEDIA_COMMAND_STATUS (* CommandStatusGetType)( DRV_HANDLE, SYS_FS
 const SYS_FS_MEDIA_FUNCTIONS memoryMediaFunctions =
 {
     .mediaStatusGet     = DRV_MEMORY_IsAttached,
-    .mediaGeometryGet   = DRV_MEMORY_GeometryGet,
+    .mediaGeometryGet   = DRV_MEMORY_FsGeometryGet,
     .sectorRead         = DRV_MEMORY_AsyncRead,
     .sectorWrite        = DRV_MEMORY_AsyncEraseWrite,
     .eventHandlerset    = DRV_MEMORY_TransferHandlerSet,
@@ -80,6 +80,24 @@
 #define DRV_MEMORY_TOKEN_MAX                            (DRV_MEMORY_TOKEN_MASK >> 16)
 #define DRV_MEMORY_MAKE_HANDLE(token, instance, index)  ((token) << 16 | (instance << 8) | (index))
 
+// *****************************************************************************
+/* MEMORY Driver File System Reserved Size
+
+  Summary:
+    Number of bytes at the end of the media hidden from the file system.
+
+  Description:
+    DRV_MEMORY_FsGeometryGet reports the media without its last
+    DRV_MEMORY_FS_RESERVED_SIZE bytes, so that area can be used as raw storage
+    by other clients. Must be a multiple of the erase block size.
+
+  Remarks:
+    None
+*/
+#ifndef DRV_MEMORY_FS_RESERVED_SIZE
+#define DRV_MEMORY_FS_RESERVED_SIZE                     (0)
+#endif
+
 /* MEMORY Driver operations. */
 typedef enum
 {
@@ -23,9 +23,17 @@
 #include "system/debug/sys_debug.h"
 /*** NetX Configuration ***/
 #define NX_PHYSICAL_HEADER                 (16 + 4 + 40)
+/* Packet pools: full MTU packets for the application (TLS/MQTT, DNS, SNTP), */
+/* full MTU packets for the MAC RX only, so TX can't starve RX, and small    */
+/* packets for the IP default pool: TCP ACK and control, ARP.                */
 #define NX_DEMO_PACKET_SIZE                1568
-#define NX_DEMO_NUMBER_OF_PACKETS          40
+#define NX_DEMO_NUMBER_OF_PACKETS          14
 #define NX_DEMO_PACKET_POOL_SIZE           (((NX_DEMO_PACKET_SIZE) + sizeof(NX_PACKET)) * (NX_DEMO_NUMBER_OF_PACKETS))
+#define NX_DEMO_RX_NUMBER_OF_PACKETS       20
+#define NX_DEMO_RX_PACKET_POOL_SIZE        (((NX_DEMO_PACKET_SIZE) + sizeof(NX_PACKET)) * (NX_DEMO_RX_NUMBER_OF_PACKETS))
+#define NX_DEMO_SMALL_PACKET_SIZE          256
+#define NX_DEMO_SMALL_NUMBER_OF_PACKETS    24
+#define NX_DEMO_SMALL_PACKET_POOL_SIZE     (((NX_DEMO_SMALL_PACKET_SIZE) + sizeof(NX_PACKET)) * (NX_DEMO_SMALL_NUMBER_OF_PACKETS))
 #define NX_DEMO_IP_STACK_SIZE              2048
 #define NX_DEMO_IP_THREAD_PRIORITY         1
 #define NX_DEMO_MAX_PHYSICAL_INTERFACES    1
@@ -37,18 +45,27 @@
 #define NX_DEMO_DISABLE_IPV4               0
 #define NX_DEMO_ENABLE_TCP         1
 #define NX_DEMO_ENABLE_UDP         1
+/* The host build runs on a static address, see firmware/host/CMakeLists.txt */
+#ifndef NX_DEMO_ENABLE_DHCP
 #define NX_DEMO_ENABLE_DHCP            1
 #define NX_DEMO_IPV4_ADDRESS      IP_ADDRESS(0,0,0,0)
 #define NX_DEMO_IPV4_MASK            IP_ADDRESS(0,0,0,0)
 #define NX_DEMO_GATEWAY_ADDRESS        IP_ADDRESS(0,0,0,0)
+#endif
 
 #define NX_DEMO_DISABLE_IPV6       1
 #define NX_DEMO_ENABLE_DNS            1
+#ifndef NX_DEMO_DNS_SERVER_ADDRESS
 #define NX_DEMO_DNS_SERVER_ADDRESS             IP_ADDRESS(0,0,0,0)
+#endif
 #define NX_DNS_CLIENT_USER_CREATE_PACKET_POOL      1
 #define NX_DEMO_ARP_CACHE_SIZE         1024
 /*** Crypto Configuration ***/ 
 #define NX_SECURE_ENABLE       1
+/* Resume the TLS 1.2 session of the previous connection (RFC 5246 session ID). */
+/* host/test/test_tls_resume.c runs the abbreviated handshake, and the        */
+/* fallback to a full one, against an OpenSSL server.                         */
+#define NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
 
 /*** Azure IoT embedded C SDK Configuration ***/
 #define NX_ENABLE_EXTENDED_NOTIFY_SUPPORT
@@ -56,6 +73,8 @@
 #define NXD_MQTT_CLOUD_ENABLE
 #define NXD_MQTT_PING_TIMEOUT_DELAY        500
 #define NXD_MQTT_SOCKET_TIMEOUT            0
+/* QoS 1 publishes in flight, i.e. kept for retransmission until their PUBACK */
+#define NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH  4
 
 #define NX_ENABLE_INTERFACE_CAPABILITY
 
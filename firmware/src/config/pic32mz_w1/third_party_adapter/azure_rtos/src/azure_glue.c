@@ -90,9 +90,11 @@ THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
 
 #define _AZURE_MAC_ACTION_INIT     0    // initialization value for MAC
 
-#define _AZURE_GLUE_SLEEP_MS        1   // time to sleep when waiting for the initialization to complete
+#define _AZURE_GLUE_SLEEP_MS        1   // max time to wait for a MAC event while the MAC initialization completes
+                                        // the MAC ready status is polled, this often
 
 #define _AZURE_MAX_INTERFACES       32   // we have one event of a group per interface
+#define _AZURE_GLUE_EVENTS_ALL      ((ULONG)((1ULL << AZURE_NET_INTERFACES) - 1))
 
 #define _AZURE_DEBUG_MASK_BASIC         0x01
 #define _AZURE_DEBUG_MASK_STATE         0x02
@@ -152,6 +154,8 @@ typedef struct
     AZ_SINGLE_LIST      rxList;         // list of incoming packets
     uint16_t            flags;          // AZURE_MAC_FLAGS value; run time flags
     uint16_t            linkMtu;        // link MTU reported by the mac
+    uint8_t             csumOffloadRx;  // TCPIP_MAC_CHECKSUM_OFFLOAD_FLAGS: RX checksums verified by the mac
+    uint8_t             csumOffloadTx;  // TCPIP_MAC_CHECKSUM_OFFLOAD_FLAGS: TX checksums calculated by the mac
     uint16_t            activeEvents;   // TCPIP_MAC_EVENT: current events
     uint16_t            eventCount;     // event counter
     // debug, stats
@@ -161,6 +165,7 @@ typedef struct
     uint32_t            totErrEventCount; // global error event counter
     uint32_t            errorEvents;    // error event aggregation
     uint32_t            procRxPkts;     // number of processed RX packets
+    uint32_t            rxBursts;       // number of times RX packets were passed to netxd
     uint32_t            chainedPkts;    // number of chained RX packets
     uint32_t            droppedPkts;    // number of chained RX packets
     uint32_t            txPkts;         // number of TX OK packets
@@ -174,8 +179,9 @@ typedef struct
 // use an ordinary array to store RX/TX descriptors
 #define AZURE_GLUE_PKT_SIZE         (((sizeof(TCPIP_MAC_PACKET) + 3) >> 2) << 2)  // packet size, 32 bits round up
 #define AZURE_GLUE_PKT_ITEM_SIZE    (AZURE_GLUE_PKT_SIZE + sizeof(TCPIP_MAC_DATA_SEGMENT))  // complete item size
-#define AZURE_GLUE_PKT_RX_ARRAY_ITEMS       NX_DEMO_NUMBER_OF_PACKETS  // (TCPIP_GMAC_RX_DESCRIPTORS_COUNT_QUE0 + 32)
-#define AZURE_GLUE_PKT_TX_ARRAY_ITEMS       NX_DEMO_NUMBER_OF_PACKETS // (TCPIP_GMAC_TX_DESCRIPTORS_COUNT_QUE0 + 32)
+#define AZURE_GLUE_PKT_RX_ARRAY_ITEMS       NX_DEMO_RX_NUMBER_OF_PACKETS  // (TCPIP_GMAC_RX_DESCRIPTORS_COUNT_QUE0 + 32)
+// any netx packet can be sent, RX ones too (ICMP echo replies)
+#define AZURE_GLUE_PKT_TX_ARRAY_ITEMS       (NX_DEMO_NUMBER_OF_PACKETS + NX_DEMO_RX_NUMBER_OF_PACKETS + NX_DEMO_SMALL_NUMBER_OF_PACKETS) // (TCPIP_GMAC_TX_DESCRIPTORS_COUNT_QUE0 + 32)
 static uint32_t azure_glue_rx_pkt_array[(AZURE_GLUE_PKT_RX_ARRAY_ITEMS * AZURE_GLUE_PKT_ITEM_SIZE) / sizeof(uint32_t)];
 static uint32_t azure_glue_tx_pkt_array[(AZURE_GLUE_PKT_TX_ARRAY_ITEMS * AZURE_GLUE_PKT_ITEM_SIZE) / sizeof(uint32_t)];
 
@@ -185,6 +191,7 @@ typedef enum
 {
     AZURE_GLUE_INI_FLAG_NONE            = 0x00,
     AZURE_GLUE_INI_FLAG_POOL_CREATED    = 0x01,
+    AZURE_GLUE_INI_FLAG_EVENTS_CREATED  = 0x02,
 
     // ...
 
@@ -194,7 +201,7 @@ typedef enum
 typedef enum
 {
     AZURE_GLUE_ACTION_NONE            = 0x00,     // no action taken
-    AZURE_GLUE_ACTION_SLEEP           = 0x01,     // sleep needed after this function
+    AZURE_GLUE_ACTION_SLEEP           = 0x01,     // wait for a MAC event after this function
 
     // ...
 
@@ -206,15 +213,11 @@ typedef struct _tag_AZURE_GLUE_DCPT
     uint16_t            currState;          // AZURE_GLUE_STATE: current task state
     uint16_t            nNets;              // number of interfaces in this run
     TX_BYTE_POOL*       allocH;             // pool handle for general allocation stuff
-    AZ_SINGLE_LIST      rxPktList;          // list of TCPIP_MAC_PACKET packets for RX
-    AZ_SINGLE_LIST      txPktList;          // list of TCPIP_MAC_PACKET packets for TX
+    AZ_NODE_POOL        rxPktPool;          // pool of TCPIP_MAC_PACKET packets for RX
+    AZ_NODE_POOL        txPktPool;          // pool of TCPIP_MAC_PACKET packets for TX
     uint32_t            rxAllocBuffs;       // # of global RX allocated netx buffers; no info per interface!
     uint32_t            rxReleaseBuffs;     // # of global RX released netx buffers; no info per interface!
     uint32_t            rxReleaseError;     // # of global errors for RX released netx buffers
-    uint32_t            txAllocPkts;        // # of global TX allocated MAC packets
-    uint32_t            txReleasePkts;      // # of global TX released MAC packets
-    uint32_t            rxAllocPkts;        // # of global RX allocated MAC packets
-    uint32_t            rxReleasePkts;      // # of global RX released MAC packets
     uint32_t            rxAllocPktError;    // # of pkt allocation errors
     uint32_t            txAllocPktError;    // # of pkt allocation errors
     uint32_t            rxAllocNetxError;   // # of netx buffers allocation errors
@@ -225,6 +228,7 @@ typedef struct _tag_AZURE_GLUE_DCPT
     uint32_t            netxTxIfError;      // # of netx TX requests for wrong interface index (?)
 
     AZURE_MAC_DCPT      macDcpt[AZURE_NET_INTERFACES];  // descriptors per interface
+    TX_EVENT_FLAGS_GROUP macEvents;         // one flag per interface, set by the MAC event callback
     uint8_t             iniFlags;           // AZURE_GLUE_INI_FLAGS value 
     uint8_t             runAction;          // AZURE_GLUE_ACTIONS value 
     uint16_t            maxRxFrame;         // maximum RX frame across all MACs/interfaces
@@ -259,8 +263,8 @@ static const AZURE_STATE_FUNC   azure_state_func_tbl[] =
 // local prototypes
 static AZURE_GLUE_INIT_RES _Azure_CreateResources(AZURE_GLUE_DCPT* pGDcpt);
 
-static void     _Azure_CreatePktLists(AZURE_GLUE_DCPT* pGDcpt);
-static void     _Azure_InitPktList(AZ_SINGLE_LIST *pList, uint32_t* pItemArray, size_t arrayItems, size_t itemSize);
+static void     _Azure_CreatePktPools(AZURE_GLUE_DCPT* pGDcpt);
+static void     _Azure_InitPktPool(AZ_NODE_POOL *pPool, uint32_t* pItemArray, size_t arrayItems, size_t itemSize);
 
 static TCPIP_MAC_PACKET* _Azure_AllocatePkt(AZURE_GLUE_DCPT* pGDcpt, bool isTx);
 static void     _Azure_ReleasePkt(AZURE_GLUE_DCPT* pGDcpt, TCPIP_MAC_PACKET* pPkt, bool isTx);
@@ -369,8 +373,9 @@ AZURE_GLUE_INIT_RES Azure_Glue_Initialize(const AZURE_GLUE_INIT* azureInit)
 
     int netIx;
     AZURE_GLUE_DCPT* pGDcpt = &azure_glue_dcpt;
-    memset(pGDcpt, 0, sizeof(*pGDcpt));
     gAzureDcpt = 0;
+    _Azure_Cleanup(pGDcpt);     // in case of a re-initialization
+    memset(pGDcpt, 0, sizeof(*pGDcpt));
 
     AZURE_GLUE_INIT_RES initRes = AZURE_INIT_RES_OK;
     while(true)
@@ -528,7 +533,9 @@ static void _Azure_Mac_CheckReady(AZURE_MAC_DCPT* pMDcpt)
     else if(macStat == SYS_STATUS_READY)
     {   // get the MAC address and MAC processing flags
         // set the default MTU; MAC driver will override if needed
+        // not all MAC drivers fill in the checksum offload flags: default to none
         TCPIP_MAC_PARAMETERS macParams;
+        memset(&macParams, 0, sizeof(macParams));
         macParams.linkMtu = TCPIP_MAC_LINK_MTU_DEFAULT; 
         TCPIP_MAC_HANDLE hIfMac = pMDcpt->hIfMac;
         pMacObj->TCPIP_MAC_ParametersGet(hIfMac, &macParams);
@@ -538,6 +545,8 @@ static void _Azure_Mac_CheckReady(AZURE_MAC_DCPT* pMDcpt)
             pMDcpt->flags |= AZURE_MAC_FLAG_EVENT_PROCESS;
         }
         pMDcpt->linkMtu = macParams.linkMtu;
+        pMDcpt->csumOffloadRx = (uint8_t)macParams.checksumOffloadRx;
+        pMDcpt->csumOffloadTx = (uint8_t)macParams.checksumOffloadTx;
         // enable this interface
 
         pMDcpt->flags &= ~AZURE_MAC_FLAG_INIT_PENDING;
@@ -606,6 +615,7 @@ static void _Azure_SetMacCtrl(TCPIP_MAC_MODULE_CTRL* pMacCtrl, AZURE_GLUE_DCPT*
     memcpy(pMacCtrl->ifPhyAddress.v, pMDcpt->netMACAddr.v, sizeof(pMacCtrl->ifPhyAddress));
 }
 
+#if defined(__XC32)
 // stdio printf intercept
 size_t write(int fd, const void *buffer, size_t length)
 {
@@ -615,6 +625,7 @@ size_t write(int fd, const void *buffer, size_t length)
     }
     return -1;
 }
+#endif  // defined(__XC32)
 
 void Azure_Glue_Tasks(void)
 {
@@ -637,8 +648,10 @@ void Azure_Glue_Tasks(void)
     }
 
     if((pGDcpt->runAction & AZURE_GLUE_ACTION_SLEEP) != 0)
-    {
-        tx_thread_sleep((_AZURE_GLUE_SLEEP_MS / (TX_TICK_PERIOD_MS)) < 1 ? 1 : (_AZURE_GLUE_SLEEP_MS / (TX_TICK_PERIOD_MS)));
+    {   // wake up on the next MAC event or on timeout, for housekeeping
+        ULONG macEvents;
+        tx_event_flags_get(&pGDcpt->macEvents, _AZURE_GLUE_EVENTS_ALL, TX_OR_CLEAR, &macEvents, 
+                           (_AZURE_GLUE_SLEEP_MS / (TX_TICK_PERIOD_MS)) < 1 ? 1 : (_AZURE_GLUE_SLEEP_MS / (TX_TICK_PERIOD_MS)));
     }
 
     // clear the action for next round
@@ -650,7 +663,6 @@ static void _Azure_Idle_Fnc(AZURE_GLUE_DCPT* pGDcpt)
     // just starting the initialization
     // 1st time we run
     pGDcpt->currState = AZURE_GLUE_STAT_INIT;
-    pGDcpt->runAction = AZURE_GLUE_ACTION_SLEEP;
 }
 
 static void _Azure_Init_Fnc(AZURE_GLUE_DCPT* pGDcpt)
@@ -664,7 +676,6 @@ static void _Azure_Init_Fnc(AZURE_GLUE_DCPT* pGDcpt)
     }
 
     pGDcpt->currState = AZURE_GLUE_WAIT_MAC_READY;
-    pGDcpt->runAction = AZURE_GLUE_ACTION_SLEEP;
 }
 
 static void _Azure_Wait_Fnc(AZURE_GLUE_DCPT* pGDcpt)
@@ -699,8 +710,10 @@ static void _Azure_Wait_Fnc(AZURE_GLUE_DCPT* pGDcpt)
         // next state
         pGDcpt->currState = AZURE_GLUE_STAT_RUN;
     }
-
-    pGDcpt->runAction = AZURE_GLUE_ACTION_SLEEP;
+    else
+    {   // some MAC still pending
+        pGDcpt->runAction = AZURE_GLUE_ACTION_SLEEP;
+    }
 }
 
 static void _Azure_Run_Fnc(AZURE_GLUE_DCPT* pGDcpt)
@@ -795,7 +808,7 @@ static inline uint16_t __attribute__((always_inline)) Azure_ntohs(uint16_t hShor
 
 
 // NB: external function in nx_driver_harmony.c to pass packets to netxd
-extern void nx_driver_receive(NX_PACKET* nxp);
+extern void nx_driver_receive_chain(NX_PACKET* packet_ptr);
 static void _Azure_Process_MacRxPackets(AZURE_MAC_DCPT* pMDcpt)
 {
     TCPIP_MAC_PACKET* pRxPkt;
@@ -804,6 +817,9 @@ static void _Azure_Process_MacRxPackets(AZURE_MAC_DCPT* pMDcpt)
     AZ_SINGLE_LIST* pRxList = &pMDcpt->rxList;
     int nProcPkts = 0;
     int nDroppedPkts = 0;
+    // the packets of this pass, passed to netxd all at once
+    NX_PACKET* rxHead = 0;
+    NX_PACKET* rxTail = 0;
     // get all the pending MAC packets
     // NB: for now only this thread accesses the rxList, so no protection should be necessary!
     while((pRxPkt = (TCPIP_MAC_PACKET*)_Azure_SingleListHeadRemove(pRxList)) != 0)
@@ -837,8 +853,8 @@ static void _Azure_Process_MacRxPackets(AZURE_MAC_DCPT* pMDcpt)
             master_nxp = 0;
             for(pSeg = pRxPkt->pDSeg, segIx = 0; pSeg != 0; pSeg = pSeg->next, segIx++)
             {
-                uint32_t segLoad = (uint32_t)pSeg->segLoad;
-                uint32_t segBuffer = (uint32_t)pSeg->segBuffer;
+                uintptr_t segLoad = (uintptr_t)pSeg->segLoad;
+                uintptr_t segBuffer = (uintptr_t)pSeg->segBuffer;
                 uint16_t segLen = pSeg->segLen;
 
                 if(segIx == 0)
@@ -881,7 +897,16 @@ static void _Azure_Process_MacRxPackets(AZURE_MAC_DCPT* pMDcpt)
             }
 
             master_nxp->nx_packet_length = totSegLen;
-            nx_driver_receive(master_nxp);
+            master_nxp->nx_packet_queue_next = 0;
+            if(rxTail == 0)
+            {
+                rxHead = master_nxp;
+            }
+            else
+            {
+                rxTail->nx_packet_queue_next = master_nxp;
+            }
+            rxTail = master_nxp;
             nProcPkts++;
         }
 
@@ -902,9 +927,15 @@ static void _Azure_Process_MacRxPackets(AZURE_MAC_DCPT* pMDcpt)
         }
     }
 
+    if(rxHead != 0)
+    {   // the MAC packets are already returned, netxd gets the whole burst
+        nx_driver_receive_chain(rxHead);
+    }
+
     if(nProcPkts)
     {
         pMDcpt->procRxPkts += nProcPkts;
+        pMDcpt->rxBursts++;
     }
     if(nDroppedPkts)
     {
@@ -1018,7 +1049,7 @@ AZURE_GLUE_RES Azure_Glue_PacketTx(void* netxPkt)
     {
         // make there's enough space to save the packet pointer expected by  the MAC driver
         segLoad = nxp->nx_packet_prepend_ptr;
-        segBuffer = (uint8_t*)((uint32_t)segLoad & 0xfffffffc);   // align properly
+        segBuffer = (uint8_t*)((uintptr_t)segLoad & ~(uintptr_t)0x3);   // align properly
 
         // search for gap space
         pSegGap = (TCPIP_MAC_SEGMENT_GAP_DCPT*)(segBuffer + _TCPIP_MAC_GAP_OFFSET);
@@ -1102,14 +1133,7 @@ AZURE_GLUE_RES Azure_Glue_PacketTx(void* netxPkt)
         _Azure_ReleasePkt(pMDcpt->pParent, pPkt, true);
     }
 
-    // release the packet to nxp
-    nxp -> nx_packet_prepend_ptr += sizeof(TCPIP_MAC_ETHERNET_HEADER);
-    nxp -> nx_packet_length -= sizeof(TCPIP_MAC_ETHERNET_HEADER);
-    if(nx_packet_transmit_release(nxp) != NX_SUCCESS)
-    {
-        pMDcpt->netxAckFail++;
-    }
-    
+    // the NetX packet stays with the caller: nx_driver_harmony releases it on error
     pMDcpt->txRejected++;
     return azTxRes; 
 }
@@ -1137,6 +1161,28 @@ const uint8_t* Azure_Glue_MACAddress(int ifIx)
 }
 
 #ifdef NX_ENABLE_INTERFACE_CAPABILITY
+// translates the MAC checksum offload flags to NX capabilities
+// NB: TCPIP_MAC_CHECKSUM_IPV6 has no NX equivalent, IPv6 has no header checksum
+static uint32_t _Azure_CsumCapability(uint8_t csumFlags, bool isTx)
+{
+    uint32_t capFlags = 0;
+
+    if((csumFlags & TCPIP_MAC_CHECKSUM_IPV4) != 0)
+    {
+        capFlags |= isTx ? NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM : NX_INTERFACE_CAPABILITY_IPV4_RX_CHECKSUM;
+    }
+    if((csumFlags & TCPIP_MAC_CHECKSUM_TCP) != 0)
+    {
+        capFlags |= isTx ? NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM : NX_INTERFACE_CAPABILITY_TCP_RX_CHECKSUM;
+    }
+    if((csumFlags & TCPIP_MAC_CHECKSUM_UDP) != 0)
+    {
+        capFlags |= isTx ? NX_INTERFACE_CAPABILITY_UDP_TX_CHECKSUM : NX_INTERFACE_CAPABILITY_UDP_RX_CHECKSUM;
+    }
+
+    return capFlags;
+}
+
 uint32_t Azure_Glue_IfCapability(int ifIx)
 {
     AZURE_GLUE_DCPT* pGDcpt = gAzureDcpt;
@@ -1148,13 +1194,16 @@ uint32_t Azure_Glue_IfCapability(int ifIx)
             AZURE_MAC_DCPT* pMDcpt = pGDcpt->macDcpt + ifIx;
             if(pMDcpt->pMacObj != 0)
             {   // something here
-                // manually coded for now
-                if(pMDcpt->pMacObj->macId == TCPIP_MODULE_MAC_PIC32C)
+                // advertise what the MAC reported it can do
+                // anything else is calculated by netxd in software
+                uint32_t capFlags = _Azure_CsumCapability(pMDcpt->csumOffloadRx, false) | _Azure_CsumCapability(pMDcpt->csumOffloadTx, true);
+                if(capFlags == 0 && pMDcpt->pMacObj->macId == TCPIP_MODULE_MAC_PIC32C)
                 {   // GMAC supports checksum offload
-                    return (NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM | NX_INTERFACE_CAPABILITY_IPV4_RX_CHECKSUM |
-                            NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM  | NX_INTERFACE_CAPABILITY_TCP_RX_CHECKSUM  |
-                            NX_INTERFACE_CAPABILITY_UDP_TX_CHECKSUM  | NX_INTERFACE_CAPABILITY_UDP_RX_CHECKSUM);
+                    capFlags = (NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM | NX_INTERFACE_CAPABILITY_IPV4_RX_CHECKSUM |
+                                NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM  | NX_INTERFACE_CAPABILITY_TCP_RX_CHECKSUM  |
+                                NX_INTERFACE_CAPABILITY_UDP_TX_CHECKSUM  | NX_INTERFACE_CAPABILITY_UDP_RX_CHECKSUM);
                 }
+                return capFlags;
             }
         }
     }
@@ -1211,17 +1260,22 @@ static AZURE_GLUE_INIT_RES _Azure_CreateResources(AZURE_GLUE_DCPT* pGDcpt)
     pGDcpt->allocH = &byte_pool_0;
 
     // create the packet pool
-    _Azure_CreatePktLists(pGDcpt);
+    _Azure_CreatePktPools(pGDcpt);
+
+    // create the MAC events group
+    if(tx_event_flags_create(&pGDcpt->macEvents, "Azure Glue MAC Events") != TX_SUCCESS)
+    {
+        return AZURE_INIT_RES_MAC_EVENT_FAIL;
+    }
+    pGDcpt->iniFlags |= AZURE_GLUE_INI_FLAG_EVENTS_CREATED;
 
     return AZURE_INIT_RES_OK;
 }
 
-static void _Azure_InitPktList(AZ_SINGLE_LIST *pList, uint32_t* pItemArray, size_t arrayItems, size_t itemSize)
+static void _Azure_InitPktPool(AZ_NODE_POOL *pPool, uint32_t* pItemArray, size_t arrayItems, size_t itemSize)
 {
     int ix;
 
-    _Azure_SingleListInitialize(pList);
-
 
     TCPIP_MAC_PACKET* pPkt;
     TCPIP_MAC_DATA_SEGMENT* pSeg;
@@ -1243,69 +1297,43 @@ static void _Azure_InitPktList(AZ_SINGLE_LIST *pList, uint32_t* pItemArray, size
         // pPkt->ackFunc, pPkt->ackParam: for RX these are set by the MAC
         // for TX they'll be set when we get a buffer to TX
 
-        _Azure_SingleListTailAdd(pList, (AZ_SGL_LIST_NODE*)pPkt);
         pItem += itemSize;
     }
+
+    _Azure_NodePoolInitialize(pPool, pItemArray, arrayItems, itemSize);
 }
 
-static void _Azure_CreatePktLists(AZURE_GLUE_DCPT* pGDcpt)
+static void _Azure_CreatePktPools(AZURE_GLUE_DCPT* pGDcpt)
 {
-    _Azure_InitPktList(&pGDcpt->rxPktList, azure_glue_rx_pkt_array, AZURE_GLUE_PKT_RX_ARRAY_ITEMS, AZURE_GLUE_PKT_ITEM_SIZE);
-    _Azure_InitPktList(&pGDcpt->txPktList, azure_glue_tx_pkt_array, AZURE_GLUE_PKT_TX_ARRAY_ITEMS, AZURE_GLUE_PKT_ITEM_SIZE);
+    _Azure_InitPktPool(&pGDcpt->rxPktPool, azure_glue_rx_pkt_array, AZURE_GLUE_PKT_RX_ARRAY_ITEMS, AZURE_GLUE_PKT_ITEM_SIZE);
+    _Azure_InitPktPool(&pGDcpt->txPktPool, azure_glue_tx_pkt_array, AZURE_GLUE_PKT_TX_ARRAY_ITEMS, AZURE_GLUE_PKT_ITEM_SIZE);
 }
 
 
+// the packet pools are lock-free: used from the NetX threads and the MAC driver
+// without masking interrupts
 static TCPIP_MAC_PACKET* _Azure_AllocatePkt(AZURE_GLUE_DCPT* pGDcpt, bool isTx)
 {
-    TCPIP_MAC_PACKET* pPkt;
-
-    if(isTx)
-    {
-        AZ_SINGLE_LIST *pList = &pGDcpt->txPktList;
-        OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
-        pPkt = (TCPIP_MAC_PACKET*)_Azure_SingleListHeadRemove(pList);
-        if(pPkt)
-        {
-            pGDcpt->txAllocPkts++;
-        }
-        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
-    }
-    else
-    {
-        AZ_SINGLE_LIST *pList = &pGDcpt->rxPktList;
-        pPkt = (TCPIP_MAC_PACKET*)_Azure_SingleListHeadRemove(pList);
-        if(pPkt)
-        {
-            pGDcpt->rxAllocPkts++;
-        }
-    }
+    AZ_NODE_POOL *pPool = isTx ? &pGDcpt->txPktPool : &pGDcpt->rxPktPool;
 
-    return pPkt;
+    return (TCPIP_MAC_PACKET*)_Azure_NodePoolGet(pPool);
 }
 
 static void _Azure_ReleasePkt(AZURE_GLUE_DCPT* pGDcpt, TCPIP_MAC_PACKET* pPkt, bool isTx)
 {
-    OSAL_CRITSECT_DATA_TYPE status = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
-
-    if(isTx)
-    {
-        AZ_SINGLE_LIST *pList = &pGDcpt->txPktList;
-        _Azure_SingleListTailAdd(pList, (AZ_SGL_LIST_NODE*)pPkt);
-        pGDcpt->txReleasePkts++;
-    }
-    else
-    {
-        AZ_SINGLE_LIST *pList = &pGDcpt->rxPktList;
-        _Azure_SingleListTailAdd(pList, (AZ_SGL_LIST_NODE*)pPkt);
-        pGDcpt->rxReleasePkts++;
-    }
+    AZ_NODE_POOL *pPool = isTx ? &pGDcpt->txPktPool : &pGDcpt->rxPktPool;
 
-    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, status);
+    _Azure_NodePoolPut(pPool, (AZ_SGL_LIST_NODE*)pPkt);
 }
 
 // deallocate resources
 static void _Azure_Cleanup(AZURE_GLUE_DCPT* pGDcpt)
 {
+    if((pGDcpt->iniFlags & AZURE_GLUE_INI_FLAG_EVENTS_CREATED) != 0)
+    {
+        tx_event_flags_delete(&pGDcpt->macEvents);
+        pGDcpt->iniFlags &= ~AZURE_GLUE_INI_FLAG_EVENTS_CREATED;
+    }
 }
 
 extern NX_PACKET* nx_rx_pkt_allocate(void);
@@ -1430,8 +1458,17 @@ static void _Azure_Glue_MacEventCB(TCPIP_MAC_EVENT event, const void* hParam)
     pMDcpt->activeEvents |= event;
     pMDcpt->eventCount++;
 
+    // wake up the glue task waiting for the MAC initialization
+    // once running, the task is woken by the deferred events below
+    AZURE_GLUE_DCPT* pGDcpt = pMDcpt->pParent;
+    if(pGDcpt->currState != AZURE_GLUE_STAT_RUN)
+    {
+        tx_event_flags_set(&pGDcpt->macEvents, 1UL << (pMDcpt - pGDcpt->macDcpt), TX_OR);
+    }
+
     // set the new deferred events
-    if((event & (TCPIP_MAC_EV_RX_PKTPEND | TCPIP_MAC_EV_RX_DONE | TCPIP_MAC_EV_TX_DONE)) != 0)
+    // errors too: RX overflow/buffer not available need the RX path to be serviced
+    if((event & (TCPIP_MAC_EV_RX_PKTPEND | AZURE_MAC_ALL_EVENTS)) != 0)
     {
         nx_driver_set_deferred_events(0x05);    // NX_DRIVER_DEFERRED_PACKET_RECEIVED | NX_DRIVER_DEFERRED_PACKET_TRANSMITTED
     }
@@ -1519,11 +1556,12 @@ void Azure_Glue_Counters(void)
         TCPIP_MAC_RX_STATISTICS rxStatistics;
         pMDcpt->pMacObj->TCPIP_MAC_StatisticsGet(pMDcpt->hIfMac, &rxStatistics, 0);
 
-        SYS_CONSOLE_PRINT("Az Glue TX counters - txPkts: %u, txAckPkts: %u, txAllocPkts: %u, txReleasePkts: %u\r\n", pMDcpt->txPkts, pMDcpt->txAckPkts, pGDcpt->txAllocPkts, pGDcpt->txReleasePkts);
-        SYS_CONSOLE_PRINT("Az Glue RX counters - rxAllocBuffs: %u, rxReleaseBuffs: %u, rxAllocPkts: %u, rxReleasePkts: %u\r\n", pGDcpt->rxAllocBuffs, pGDcpt->rxReleaseBuffs, pGDcpt->rxAllocPkts, pGDcpt->rxReleasePkts);
+        SYS_CONSOLE_PRINT("Az Glue TX counters - txPkts: %u, txAckPkts: %u, txAllocPkts: %u, txReleasePkts: %u\r\n", pMDcpt->txPkts, pMDcpt->txAckPkts, pGDcpt->txPktPool.getCnt, pGDcpt->txPktPool.putCnt);
+        SYS_CONSOLE_PRINT("Az Glue RX counters - rxAllocBuffs: %u, rxReleaseBuffs: %u, rxAllocPkts: %u, rxReleasePkts: %u\r\n", pGDcpt->rxAllocBuffs, pGDcpt->rxReleaseBuffs, pGDcpt->rxPktPool.getCnt, pGDcpt->rxPktPool.putCnt);
         SYS_CONSOLE_PRINT("\tmac nRxOkPackets: %u, totEventCount: %u\r\n", rxStatistics.nRxOkPackets, pMDcpt->totEventCount);
-        SYS_CONSOLE_PRINT("\tmaxRxProc: %u, totRxEventCount: %u, procRxPkts: %u, chainedPkts: %u, droppedPkts: %u\r\n",
-                pMDcpt->maxRxProc, pMDcpt->totRxEventCount, pMDcpt->procRxPkts, pMDcpt->chainedPkts, pMDcpt->droppedPkts);
+        SYS_CONSOLE_PRINT("\tchecksum offload RX: 0x%x, TX: 0x%x, capability: 0x%x\r\n", pMDcpt->csumOffloadRx, pMDcpt->csumOffloadTx, Azure_Glue_IfCapability(0));
+        SYS_CONSOLE_PRINT("\tmaxRxProc: %u, totRxEventCount: %u, procRxPkts: %u, rxBursts: %u, chainedPkts: %u, droppedPkts: %u\r\n",
+                pMDcpt->maxRxProc, pMDcpt->totRxEventCount, pMDcpt->procRxPkts, pMDcpt->rxBursts, pMDcpt->chainedPkts, pMDcpt->droppedPkts);
 
 
         SYS_CONSOLE_PRINT("Az Glue errors - rxLenError: %u, rxAllocPktError: %u, rxAllocNetxError: %u, netxLenError: %u\r\n",
@@ -1533,13 +1571,23 @@ void Azure_Glue_Counters(void)
         SYS_CONSOLE_PRINT("\ttxAllocPktError: %u, netxAckFail: %u, netxTxIfError: %u, orphans: %u, gapError: %u\r\n",
                 pGDcpt->txAllocPktError, pMDcpt->netxAckFail, pGDcpt->netxTxIfError, pMDcpt->txOrphans, pGDcpt->gapError);
 
-        SYS_CONSOLE_PRINT("RX packets list: %d, now: %d\r\n", AZURE_GLUE_PKT_RX_ARRAY_ITEMS, _Azure_SingleListCount(&pGDcpt->rxPktList));
-        SYS_CONSOLE_PRINT("TX packets list: %d, now: %d\r\n", AZURE_GLUE_PKT_TX_ARRAY_ITEMS, _Azure_SingleListCount(&pGDcpt->txPktList));
+        SYS_CONSOLE_PRINT("RX packets pool: %d, now: %d, hiWater: %u, empty: %u, contention: %u\r\n", AZURE_GLUE_PKT_RX_ARRAY_ITEMS, _Azure_NodePoolFreeCount(&pGDcpt->rxPktPool),
+                pGDcpt->rxPktPool.hiWater, pGDcpt->rxPktPool.emptyCnt, pGDcpt->rxPktPool.retryCnt);
+        SYS_CONSOLE_PRINT("TX packets pool: %d, now: %d, hiWater: %u, empty: %u, contention: %u\r\n", AZURE_GLUE_PKT_TX_ARRAY_ITEMS, _Azure_NodePoolFreeCount(&pGDcpt->txPktPool),
+                pGDcpt->txPktPool.hiWater, pGDcpt->txPktPool.emptyCnt, pGDcpt->txPktPool.retryCnt);
 
         SYS_CONSOLE_PRINT("Netx err counters - okCnt: %u, allocErr: %u\r\n", netx_rx_err_count.okCnt, netx_rx_err_count.allocErr);
 
-        extern NX_PACKET_POOL pool_0;
-        SYS_CONSOLE_PRINT("netx pool - total: %u, avlbl: %u, empty req: %u, invalid release: %u\r\n", pool_0.nx_packet_pool_total, pool_0.nx_packet_pool_available, pool_0.nx_packet_pool_empty_requests, pool_0.nx_packet_pool_invalid_releases);
+        extern NX_PACKET_POOL pool_0, pool_rx, pool_small;
+        extern ULONG nx_driver_packet_pool_high_water_get(NX_PACKET_POOL* pool_ptr);
+        NX_PACKET_POOL* netxPools[] = {&pool_0, &pool_rx, &pool_small};
+        int poolIx;
+        for(poolIx = 0; poolIx < sizeof(netxPools) / sizeof(*netxPools); poolIx++)
+        {
+            NX_PACKET_POOL* pPool = netxPools[poolIx];
+            SYS_CONSOLE_PRINT("netx pool %s - total: %u, avlbl: %u, hiWater: %u, empty req: %u, invalid release: %u\r\n", pPool->nx_packet_pool_name,
+                    pPool->nx_packet_pool_total, pPool->nx_packet_pool_available, nx_driver_packet_pool_high_water_get(pPool), pPool->nx_packet_pool_empty_requests, pPool->nx_packet_pool_invalid_releases);
+        }
 
     }
 
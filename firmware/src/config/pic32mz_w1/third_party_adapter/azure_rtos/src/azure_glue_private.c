@@ -246,6 +246,98 @@ void  _Azure_SingleListAppend(AZ_SINGLE_LIST* pDstL, AZ_SINGLE_LIST* pAList)
 	}
 }
 
+// node pools implementation
+
+#define _AZ_NODE_POOL_IX_MASK   0x0000ffffU
+#define _AZ_NODE_POOL_TAG_INC   0x00010000U
+
+static __inline__ AZ_SGL_LIST_NODE* __attribute__((always_inline)) _Azure_NodePoolNode(AZ_NODE_POOL* pP, uint32_t head)
+{
+    uint32_t ix = head & _AZ_NODE_POOL_IX_MASK;
+    return ix == 0 ? 0 : (AZ_SGL_LIST_NODE*)(pP->base + (ix - 1) * pP->nodeSize);
+}
+
+static __inline__ uint32_t __attribute__((always_inline)) _Azure_NodePoolIndex(AZ_NODE_POOL* pP, AZ_SGL_LIST_NODE* pN)
+{
+    uint8_t* pNode = (uint8_t*)pN;
+    if(pNode < pP->base || pNode >= pP->base + pP->nNodes * pP->nodeSize)
+    {   // end of list; or a stale link that will fail the swap anyway
+        return 0;
+    }
+    return (pNode - pP->base) / pP->nodeSize + 1;
+}
+
+void  _Azure_NodePoolInitialize(AZ_NODE_POOL* pP, void* nodeArray, size_t nNodes, size_t nodeSize)
+{
+    size_t ix;
+    AZ_SGL_LIST_NODE* pN;
+
+    memset(pP, 0, sizeof(*pP));
+    pP->base = (uint8_t*)nodeArray;
+    pP->nodeSize = (uint16_t)nodeSize;
+    pP->nNodes = (uint16_t)nNodes;
+
+    // chain the nodes in array order
+    for(ix = 0; ix < nNodes; ix++)
+    {
+        pN = (AZ_SGL_LIST_NODE*)(pP->base + ix * nodeSize);
+        pN->next = (ix + 1 < nNodes) ? (AZ_SGL_LIST_NODE*)(pP->base + (ix + 1) * nodeSize) : 0;
+    }
+    pP->head = nNodes != 0 ? 1 : 0;
+}
+
+AZ_SGL_LIST_NODE*  _Azure_NodePoolGet(AZ_NODE_POOL* pP)
+{
+    uint32_t head, newHead, inUse;
+    AZ_SGL_LIST_NODE* pN;
+
+    head = __atomic_load_n(&pP->head, __ATOMIC_ACQUIRE);
+    while(true)
+    {
+        if((pN = _Azure_NodePoolNode(pP, head)) == 0)
+        {
+            __atomic_fetch_add(&pP->emptyCnt, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+
+        // pN->next is stale if pN was taken meanwhile; the tag fails the swap then
+        newHead = ((head + _AZ_NODE_POOL_TAG_INC) & ~_AZ_NODE_POOL_IX_MASK) | _Azure_NodePoolIndex(pP, pN->next);
+        if(__atomic_compare_exchange_n(&pP->head, &head, newHead, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+        __atomic_fetch_add(&pP->retryCnt, 1, __ATOMIC_RELAXED);
+    }
+
+    inUse = __atomic_add_fetch(&pP->getCnt, 1, __ATOMIC_RELAXED) - pP->putCnt;
+    if(inUse > pP->hiWater)
+    {   // approximate under contention; statistics only
+        pP->hiWater = inUse;
+    }
+
+    return pN;
+}
+
+void  _Azure_NodePoolPut(AZ_NODE_POOL* pP, AZ_SGL_LIST_NODE* pN)
+{
+    uint32_t head, newHead;
+    uint32_t ix = _Azure_NodePoolIndex(pP, pN);
+
+    head = __atomic_load_n(&pP->head, __ATOMIC_RELAXED);
+    while(true)
+    {
+        pN->next = _Azure_NodePoolNode(pP, head);
+        newHead = ((head + _AZ_NODE_POOL_TAG_INC) & ~_AZ_NODE_POOL_IX_MASK) | ix;
+        if(__atomic_compare_exchange_n(&pP->head, &head, newHead, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        __atomic_fetch_add(&pP->retryCnt, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&pP->putCnt, 1, __ATOMIC_RELAXED);
+}
+
 bool  _Azure_ProtectedSingleListInitialize(PROTECTED_SINGLE_LIST* pL)
 {
     _Azure_SingleListInitialize(&pL->list);
@@ -115,6 +115,44 @@ static __inline__ void __attribute__((always_inline)) _Azure_SingleListRemoveAll
 // expensive, traverses the list
 bool        _Azure_SingleListFind(AZ_SINGLE_LIST* pL, AZ_SGL_LIST_NODE* pN);
 
+/////  lock-free node pools ///////////
+//
+// LIFO pool of the fixed size nodes of an array.
+// Get and put can be called from any thread or ISR and do not mask interrupts:
+// the pool head is a single word updated by compare and swap (an LL/SC loop on MIPS).
+// The head holds the index of the first free node + 1 (0 when empty) in the low 16 bits
+// and a tag in the high 16 bits, incremented by each update, so that a stale head
+// (node taken and returned meanwhile) fails the swap.
+
+typedef struct
+{
+    uint8_t*            base;       // node array
+    uint16_t            nodeSize;   // size of a node
+    uint16_t            nNodes;     // number of nodes in the array
+    volatile uint32_t   head;       // tag << 16 | (first free node index + 1)
+    // statistics
+    volatile uint32_t   getCnt;     // nodes taken out
+    volatile uint32_t   putCnt;     // nodes returned
+    volatile uint32_t   emptyCnt;   // get requests that found the pool empty
+    volatile uint32_t   retryCnt;   // compare and swap retries, i.e. contention
+    uint32_t            hiWater;    // max nodes out of the pool at once
+}AZ_NODE_POOL;
+
+// all the array nodes are added to the pool; max 65535 nodes
+// the node next pointer is used while the node is in the pool
+void  _Azure_NodePoolInitialize(AZ_NODE_POOL* pP, void* nodeArray, size_t nNodes, size_t nodeSize);
+
+// takes a node out of the pool; 0 if empty
+AZ_SGL_LIST_NODE*  _Azure_NodePoolGet(AZ_NODE_POOL* pP);
+
+// returns a node to the pool
+void  _Azure_NodePoolPut(AZ_NODE_POOL* pP, AZ_SGL_LIST_NODE* pN);
+
+static __inline__ int __attribute__((always_inline)) _Azure_NodePoolFreeCount(AZ_NODE_POOL* pP)
+{
+    return pP->nNodes - (int)(pP->getCnt - pP->putCnt);
+}
+
 // other helpers
 //
 // convert a MAC address string to binary
@@ -98,7 +98,7 @@ USB_DEVICE_MSD_MEDIA_INIT_DATA USB_ALIGN  msdMediaInit0[1] =
             DRV_MEMORY_IsAttached,
             DRV_MEMORY_Open,
             DRV_MEMORY_Close,
-            DRV_MEMORY_GeometryGet,
+            DRV_MEMORY_FsGeometryGet,
             DRV_MEMORY_AsyncRead,
             DRV_MEMORY_AsyncEraseWrite,
             DRV_MEMORY_IsWriteProtected,
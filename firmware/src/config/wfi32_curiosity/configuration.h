@@ -166,8 +166,11 @@ extern "C" {
 
 /* Memory Driver Instance 0 Configuration */
 #define DRV_MEMORY_INDEX_0                   0
-#define DRV_MEMORY_CLIENTS_NUMBER_IDX0       2
-#define DRV_MEMORY_BUFFER_QUEUE_SIZE_IDX0    1
+#define DRV_MEMORY_CLIENTS_NUMBER_IDX0       4
+#define DRV_MEMORY_BUFFER_QUEUE_SIZE_IDX0    2
+
+/* Top of the flash kept out of the FAT volume for the telemetry journal and the DPS cache */
+#define DRV_MEMORY_FS_RESERVED_SIZE          (64 * 1024)
 
 /* Memory Driver Instance 0 RTOS Configurations*/
 #define DRV_MEMORY_STACK_SIZE_IDX0           4096
@@ -1459,6 +1459,40 @@ SYS_MEDIA_GEOMETRY * DRV_MEMORY_GeometryGet
     const DRV_HANDLE handle
 );
 
+// *****************************************************************************
+/* Function:
+    SYS_MEDIA_GEOMETRY * DRV_MEMORY_FsGeometryGet( const DRV_HANDLE handle );
+
+  Summary:
+    Returns the geometry of the media area available to the file system.
+
+  Description:
+    Same as DRV_MEMORY_GeometryGet, except that the last
+    DRV_MEMORY_FS_RESERVED_SIZE bytes of the media are not reported.
+    Used by the file system and USB MSD clients so the reserved area can be
+    accessed as raw storage through DRV_MEMORY_GeometryGet by other clients.
+
+  Precondition:
+    The DRV_MEMORY_Open() routine must have been called to obtain a valid
+    opened device handle.
+
+  Parameters:
+    handle       - A valid open-instance handle, returned from the driver's
+                   open function
+
+  Returns:
+    SYS_MEDIA_GEOMETRY - Pointer to structure which holds the file system view
+                         of the media geometry information.
+
+  Remarks:
+    Refer sys_media.h for definition of SYS_MEDIA_GEOMETRY.
+*/
+
+SYS_MEDIA_GEOMETRY * DRV_MEMORY_FsGeometryGet
+(
+    const DRV_HANDLE handle
+);
+
 // *****************************************************************************
 /* Function:
     MEMORY_DEVICE_TRANSFER_STATUS DRV_MEMORY_TransferStatusGet
@@ -62,6 +62,17 @@
 
 static DRV_MEMORY_OBJECT gDrvMemoryObj[DRV_MEMORY_INSTANCES_NUMBER];
 
+#if (DRV_MEMORY_FS_RESERVED_SIZE > 0)
+/*************************************************
+ * Geometry reported to the file system clients,
+ * excluding the reserved area at the end of the media
+ *************************************************/
+
+static SYS_MEDIA_GEOMETRY gDrvMemoryFsGeometryObj[DRV_MEMORY_INSTANCES_NUMBER];
+
+static SYS_MEDIA_REGION_GEOMETRY gDrvMemoryFsGeometryTable[DRV_MEMORY_INSTANCES_NUMBER][3];
+#endif
+
 
 /************************************************
  * This token is incremented for every request added to the queue and is used
@@ -1302,6 +1313,56 @@ SYS_MEDIA_GEOMETRY * DRV_MEMORY_GeometryGet
     return &dObj->mediaGeometryObj;
 }
 
+SYS_MEDIA_GEOMETRY * DRV_MEMORY_FsGeometryGet
+(
+    const DRV_HANDLE handle
+)
+{
+#if (DRV_MEMORY_FS_RESERVED_SIZE > 0)
+    DRV_MEMORY_CLIENT_OBJECT *clientObj = NULL;
+    DRV_MEMORY_OBJECT *dObj = NULL;
+    SYS_MEDIA_REGION_GEOMETRY *fsGeometryTable = NULL;
+    uint32_t reservedBlocks = 0;
+    uint32_t i = 0;
+
+    /* Get the Client object from the handle passed */
+    clientObj = DRV_MEMORY_DriverHandleValidate(handle);
+
+    /* Check if the client object is valid */
+    if (clientObj == NULL)
+    {
+        SYS_DEBUG_MESSAGE(SYS_ERROR_INFO, "DRV_MEMORY_FsGeometryGet(): Invalid driver handle.\n");
+        return NULL;
+    }
+
+    dObj = &gDrvMemoryObj[clientObj->drvIndex];
+    fsGeometryTable = gDrvMemoryFsGeometryTable[clientObj->drvIndex];
+
+    /* Hide the last DRV_MEMORY_FS_RESERVED_SIZE bytes of every region */
+    for (i = 0; i < 3; i++)
+    {
+        fsGeometryTable[i] = dObj->mediaGeometryTable[i];
+        reservedBlocks = DRV_MEMORY_FS_RESERVED_SIZE / fsGeometryTable[i].blockSize;
+
+        if (fsGeometryTable[i].numBlocks > reservedBlocks)
+        {
+            fsGeometryTable[i].numBlocks -= reservedBlocks;
+        }
+        else
+        {
+            fsGeometryTable[i].numBlocks = 0;
+        }
+    }
+
+    gDrvMemoryFsGeometryObj[clientObj->drvIndex] = dObj->mediaGeometryObj;
+    gDrvMemoryFsGeometryObj[clientObj->drvIndex].geometryTable = fsGeometryTable;
+
+    return &gDrvMemoryFsGeometryObj[clientObj->drvIndex];
+#else
+    return DRV_MEMORY_GeometryGet(handle);
+#endif
+}
+
 bool DRV_MEMORY_IsAttached
 (
     const DRV_HANDLE handle
@@ -152,6 +152,8 @@ const uint8_t* Azure_Glue_MACAddress(int ifIx);
 // Azure IoT function to get the MAC driver capabilities (IPv4 + UDP + TCP  RX/TX checksum offload) 
 // returns an or-ed NX_ENABLE_INTERFACE_CAPABILITY mask:
 //      NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM, NX_INTERFACE_CAPABILITY_IPV4_RX_CHECKSUM, etc. 
+// built from the checksum offload flags the MAC driver reports in its TCPIP_MAC_PARAMETERS;
+// checksums not offloaded are calculated by netxd
 uint32_t Azure_Glue_IfCapability(int ifIx);
 //*****************************************************************************
 // mapping of the printf to the system console
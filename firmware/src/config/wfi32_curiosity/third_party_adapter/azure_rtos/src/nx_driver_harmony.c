@@ -38,6 +38,22 @@
 
 static NX_DRIVER_INFORMATION   nx_driver_information;
 
+/* Pool of the received packets, if not the IP default one.  */
+static NX_PACKET_POOL          *nx_driver_rx_packet_pool_ptr;
+
+/* Low water marks of the packet pools: RX, IP default and one other (the application's) */
+#define NX_DRIVER_POOL_WATERMARKS   3
+
+typedef struct NX_DRIVER_POOL_WATERMARK_STRUCT
+{
+    NX_PACKET_POOL      *nx_driver_pool_ptr;
+    ULONG               nx_driver_pool_min_available;
+} NX_DRIVER_POOL_WATERMARK;
+
+static NX_DRIVER_POOL_WATERMARK nx_driver_pool_watermarks[NX_DRIVER_POOL_WATERMARKS];
+
+static VOID         nx_driver_pool_watermark_update(NX_DRIVER_POOL_WATERMARK *watermark_ptr, NX_PACKET_POOL *pool_ptr);
+
 
 /****** DRIVER SPECIFIC ****** Start of part/vendor specific data area.  Include hardware-specific data here!  */
 
@@ -363,7 +379,15 @@ static VOID  _nx_driver_initialize(NX_IP_DRIVER *driver_req_ptr)
     nx_driver_information.nx_driver_information_state =                NX_DRIVER_STATE_NOT_INITIALIZED;
 
     /* Setup the default packet pool for the driver's received packets.  */
-    nx_driver_information.nx_driver_information_packet_pool_ptr = ip_ptr -> nx_ip_default_packet_pool;
+    nx_driver_information.nx_driver_information_packet_pool_ptr = (nx_driver_rx_packet_pool_ptr != NX_NULL) ?
+                                                                  nx_driver_rx_packet_pool_ptr : ip_ptr -> nx_ip_default_packet_pool;
+
+    /* Track the RX and IP default pools; the other slot goes to the first other pool sent from.  */
+    nx_driver_pool_watermark_update(&nx_driver_pool_watermarks[0], nx_driver_information.nx_driver_information_packet_pool_ptr);
+    if (ip_ptr -> nx_ip_default_packet_pool != nx_driver_information.nx_driver_information_packet_pool_ptr)
+    {
+        nx_driver_pool_watermark_update(&nx_driver_pool_watermarks[1], ip_ptr -> nx_ip_default_packet_pool);
+    }
 
 
     /* Setup driver information to point to IP pointer.  */
@@ -715,6 +739,7 @@ UINT            status;
     }
 
     /* Transmit the packet through the Ethernet controller low level access routine. */
+    nx_driver_pool_watermark_update(NX_NULL, packet_ptr -> nx_packet_pool_owner);
     status = Azure_Glue_PacketTx(packet_ptr);
 
     /* Determine if there was an error.  */
@@ -979,8 +1004,9 @@ UINT        status;
 static VOID  _nx_driver_capability_get(NX_IP_DRIVER *driver_req_ptr)
 {
     
-    /* Return the capability of the Ethernet controller.  */
-    *(driver_req_ptr -> nx_ip_driver_return_ptr) = NX_DRIVER_CAPABILITY;
+    /* Return the capability of the Ethernet controller, as reported by the MAC driver.  */
+    *(driver_req_ptr -> nx_ip_driver_return_ptr) = NX_DRIVER_CAPABILITY &
+        Azure_Glue_IfCapability(driver_req_ptr -> nx_ip_driver_interface -> nx_interface_index);
     
     /* Return the success status.  */
     driver_req_ptr -> nx_ip_driver_status =  NX_SUCCESS;
@@ -1138,11 +1164,15 @@ void  nx_driver_set_deferred_events(ULONG new_events)
 
     TX_DISABLE
 
-    deffered_events = (nx_driver_information.nx_driver_information_deferred_events |= new_events);
+    deffered_events = nx_driver_information.nx_driver_information_deferred_events;
+    nx_driver_information.nx_driver_information_deferred_events |= new_events;
 
     TX_RESTORE
 
-    if (deffered_events)
+    /* Only wake up the IP thread when no deferred pass is pending yet. Events
+       arriving before the pass picks them up are served by that same pass, so
+       a burst of MAC interrupts costs a single IP thread wakeup.  */
+    if (deffered_events == 0 && new_events != 0)
     {
         /* Call NetX deferred driver processing.  */        
         _nx_ip_driver_deferred_processing(nx_driver_information.nx_driver_information_ip_ptr);
@@ -1520,10 +1550,68 @@ NX_PACKET* nx_rx_pkt_allocate(void)
         netx_rx_err_count.allocErr++;
         return 0;
     }
+    nx_driver_pool_watermark_update(&nx_driver_pool_watermarks[0], packet_ptr -> nx_packet_pool_owner);
 
     return packet_ptr;
 }
 
+void  nx_driver_rx_packet_pool_set(NX_PACKET_POOL* pool_ptr)
+{
+    nx_driver_rx_packet_pool_ptr = pool_ptr;
+}
+
+// updates the low water mark of a packet pool
+// the slot is looked up (and taken if free) when watermark_ptr is NX_NULL;
+// that happens on the send path only, which NetX serializes
+static VOID  nx_driver_pool_watermark_update(NX_DRIVER_POOL_WATERMARK *watermark_ptr, NX_PACKET_POOL *pool_ptr)
+{
+    ULONG available;
+    int ix;
+
+    if(watermark_ptr == NX_NULL)
+    {
+        for(ix = 0; ix < NX_DRIVER_POOL_WATERMARKS; ix++)
+        {
+            if(nx_driver_pool_watermarks[ix].nx_driver_pool_ptr == pool_ptr || nx_driver_pool_watermarks[ix].nx_driver_pool_ptr == NX_NULL)
+            {
+                watermark_ptr = nx_driver_pool_watermarks + ix;
+                break;
+            }
+        }
+        if(watermark_ptr == NX_NULL)
+        {   // not tracked
+            return;
+        }
+    }
+
+    if(watermark_ptr -> nx_driver_pool_ptr != pool_ptr)
+    {   // new slot
+        watermark_ptr -> nx_driver_pool_min_available = pool_ptr -> nx_packet_pool_total;
+        watermark_ptr -> nx_driver_pool_ptr = pool_ptr;
+    }
+
+    available = pool_ptr -> nx_packet_pool_available;
+    if(available < watermark_ptr -> nx_driver_pool_min_available)
+    {
+        watermark_ptr -> nx_driver_pool_min_available = available;
+    }
+}
+
+ULONG nx_driver_packet_pool_high_water_get(NX_PACKET_POOL* pool_ptr)
+{
+    int ix;
+
+    for(ix = 0; ix < NX_DRIVER_POOL_WATERMARKS; ix++)
+    {
+        if(nx_driver_pool_watermarks[ix].nx_driver_pool_ptr == pool_ptr)
+        {
+            return pool_ptr -> nx_packet_pool_total - nx_driver_pool_watermarks[ix].nx_driver_pool_min_available;
+        }
+    }
+
+    return 0;
+}
+
 // receive a packet from H3 MAC driver
 // netxd owns the packet
 /**************************************************************************/ 
@@ -1568,6 +1656,70 @@ void nx_driver_receive(NX_PACKET* nxp)
     _nx_driver_transfer_to_netx(nx_driver_information.nx_driver_information_ip_ptr, nxp);
 }
 
+// receive a burst of packets from H3 MAC driver
+// netxd owns the packets
+/**************************************************************************/ 
+/*                                                                        */ 
+/*  FUNCTION                                               RELEASE        */ 
+/*                                                                        */ 
+/*    nx_driver_receive_chain                                             */ 
+/*                                                                        */
+/*  AUTHOR                                                                */
+/*                                                                        */
+/*                                                                        */
+/*  DESCRIPTION                                                           */ 
+/*                                                                        */ 
+/*    This function passes a queue of packets, linked through             */ 
+/*    nx_packet_queue_next, to the netxd stack. It runs in the IP thread  */ 
+/*    deferred processing, so all the packets received in one pass are    */ 
+/*    handed over without waking up the IP thread per packet.             */ 
+/*                                                                        */ 
+/*  INPUT                                                                 */ 
+/*                                                                        */ 
+/*    packet_ptr                            First packet of the queue     */
+/*                                                                        */ 
+/*  OUTPUT                                                                */ 
+/*                                                                        */ 
+/*    None                                                                */
+/*                                                                        */ 
+/*  CALLS                                                                 */ 
+/*                                                                        */ 
+/*    _nx_driver_transfer_to_netx                                         */ 
+/*                                                                        */
+/*  CALLED BY                                                             */ 
+/*                                                                        */ 
+/*    Harmony driver glue code                                            */ 
+/*                                                                        */ 
+/*  RELEASE HISTORY                                                       */ 
+/*                                                                        */ 
+/*    DATE              NAME                      DESCRIPTION             */
+/*                                                                        */
+/*                                                                        */
+/**************************************************************************/
+void nx_driver_receive_chain(NX_PACKET* packet_ptr)
+{
+
+NX_IP       *ip_ptr = nx_driver_information.nx_driver_information_ip_ptr;
+NX_PACKET   *next_packet_ptr;
+UINT        packet_count = 0;
+
+
+    while (packet_ptr != NX_NULL)
+    {
+
+        /* Unlink the packet before NetX takes it, the queue link is reused by the stack.  */
+        next_packet_ptr = packet_ptr -> nx_packet_queue_next;
+        packet_ptr -> nx_packet_queue_next = NX_NULL;
+
+        _nx_driver_transfer_to_netx(ip_ptr, packet_ptr);
+        packet_count++;
+
+        packet_ptr = next_packet_ptr;
+    }
+
+    netx_rx_err_count.okCnt += packet_count;
+}
+
 
 #ifdef NX_ENABLE_INTERFACE_CAPABILITY
 /**************************************************************************/ 
@@ -1609,7 +1761,18 @@ void nx_driver_receive(NX_PACKET* nxp)
 /**************************************************************************/
 static UINT _nx_driver_hardware_capability_set(NX_IP_DRIVER *driver_req_ptr)
 {
-    
+
+NX_INTERFACE    *interface_ptr = driver_req_ptr -> nx_ip_driver_interface;
+ULONG           supported_capability;
+
+
+    /* Checksums the MAC does not handle have to stay with NetX.  */
+    supported_capability = NX_DRIVER_CAPABILITY & Azure_Glue_IfCapability(interface_ptr -> nx_interface_index);
+    if (interface_ptr -> nx_interface_capability_flag & NX_INTERFACE_CAPABILITY_CHECKSUM_ALL & ~supported_capability)
+    {
+        return NX_DRIVER_ERROR;
+    }
+
     return NX_SUCCESS;
 }
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
@@ -143,9 +143,20 @@ VOID  nx_driver_harmony(NX_IP_DRIVER *driver_req_ptr);
 /* Packet allocation function for the Harmony MAC driver */
 NX_PACKET* nx_rx_pkt_allocate(void);
 
+/* Sets the pool of the received packets, to be called before the IP instance is created.
+   The IP default packet pool is used if not set. */
+void  nx_driver_rx_packet_pool_set(NX_PACKET_POOL* pool_ptr);
+
+/* Max number of packets of a pool in use at once, as seen by the driver when
+   allocating RX packets and sending packets */
+ULONG nx_driver_packet_pool_high_water_get(NX_PACKET_POOL* pool_ptr);
+
 /* Passes a Harmony MAC packet to the netxd stack */ 
 void nx_driver_receive(NX_PACKET* nxp);
 
+/* Passes a queue of received packets, linked through nx_packet_queue_next, to the netxd stack */
+void nx_driver_receive_chain(NX_PACKET* packet_ptr);
+
 /* Sets new available events */
 void  nx_driver_set_deferred_events(ULONG new_events);
 
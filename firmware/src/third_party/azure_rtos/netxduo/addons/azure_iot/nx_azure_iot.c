@@ -693,6 +693,14 @@ NX_AZURE_IOT_RESOURCE *resource_ptr;
     nx_secure_tls_session_time_function_set(tls_session, nx_azure_iot_tls_time_function);
 #endif /* NX_AZURE_IOT_DISABLE_CERTIFICATE_DATE */
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* Offer the session of the previous connection to the same endpoint.  */
+    if (resource_ptr -> resource_tls_resume_ptr)
+    {
+        nx_secure_tls_session_resume_set(tls_session, resource_ptr -> resource_tls_resume_ptr);
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
     return(NX_AZURE_IOT_SUCCESS);
 }
 
@@ -190,6 +190,9 @@ typedef struct NX_AZURE_IOT_RESOURCE_STRUCT
     UINT                                   resource_metadata_size;
     NX_SECURE_X509_CERT                   *resource_trusted_certificates[NX_AZURE_IOT_MAX_NUM_OF_TRUSTED_CERTS];
     NX_SECURE_X509_CERT                   *resource_device_certificates[NX_AZURE_IOT_MAX_NUM_OF_DEVICE_CERTS];
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    NX_SECURE_TLS_RESUME                  *resource_tls_resume_ptr;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
     const UCHAR                           *resource_hostname;
     UINT                                   resource_hostname_length;
     struct NX_AZURE_IOT_RESOURCE_STRUCT   *resource_next;
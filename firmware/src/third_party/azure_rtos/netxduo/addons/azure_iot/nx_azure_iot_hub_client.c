@@ -361,7 +361,7 @@ NXD_MQTT_CLIENT *mqtt_client_ptr;
 UCHAR           *buffer_ptr;
 UINT            buffer_size;
 VOID            *buffer_context;
-UINT            buffer_length;
+size_t          buffer_length;
 ULONG           expiry_time_secs;
 az_result       core_result;
 
@@ -418,7 +418,7 @@ az_result       core_result;
     /* Build client id.  */
     buffer_length = buffer_size;
     core_result = az_iot_hub_client_get_client_id(&(hub_client_ptr -> iot_hub_client_core),
-                                                  (CHAR *)buffer_ptr, buffer_length, (size_t *)&buffer_length);
+                                                  (CHAR *)buffer_ptr, buffer_length, &buffer_length);
     if (az_result_failed(core_result))
     {
 
@@ -438,7 +438,7 @@ az_result       core_result;
     /* Build user name.  */
     buffer_length = buffer_size;
     core_result = az_iot_hub_client_get_user_name(&hub_client_ptr -> iot_hub_client_core,
-                                                  (CHAR *)buffer_ptr, buffer_length, (size_t *)&buffer_length);
+                                                  (CHAR *)buffer_ptr, buffer_length, &buffer_length);
     if (az_result_failed(core_result))
     {
 
@@ -928,6 +928,28 @@ NX_AZURE_IOT_RESOURCE *resource_ptr;
     }
 }
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+UINT nx_azure_iot_hub_client_tls_resume_set(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
+                                            NX_SECURE_TLS_RESUME *resume_ptr)
+{
+    if ((hub_client_ptr == NX_NULL) || (hub_client_ptr -> nx_azure_iot_ptr == NX_NULL))
+    {
+        LogError(LogLiteralArgs("IoTHub TLS resume set fail: INVALID POINTER"));
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    /* Obtain the mutex.  */
+    tx_mutex_get(hub_client_ptr -> nx_azure_iot_ptr -> nx_azure_iot_mutex_ptr, NX_WAIT_FOREVER);
+
+    hub_client_ptr -> nx_azure_iot_hub_client_resource.resource_tls_resume_ptr = resume_ptr;
+
+    /* Release the mutex.  */
+    tx_mutex_put(hub_client_ptr -> nx_azure_iot_ptr -> nx_azure_iot_mutex_ptr);
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
 UINT nx_azure_iot_hub_client_symmetric_key_set(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
                                                const UCHAR *symmetric_key, UINT symmetric_key_length)
 {
@@ -1028,7 +1050,7 @@ UINT nx_azure_iot_hub_client_telemetry_message_create(NX_AZURE_IOT_HUB_CLIENT *h
                                                       NX_PACKET **packet_pptr, UINT wait_option)
 {
 NX_PACKET *packet_ptr;
-UINT topic_length;
+size_t topic_length;
 UINT status;
 az_result core_result;
 
@@ -1052,7 +1074,7 @@ az_result core_result;
     topic_length = (UINT)(packet_ptr -> nx_packet_data_end - packet_ptr -> nx_packet_prepend_ptr);
     core_result = az_iot_hub_client_telemetry_get_publish_topic(&(hub_client_ptr -> iot_hub_client_core),
                                                                 NULL, (CHAR *)packet_ptr -> nx_packet_prepend_ptr,
-                                                                topic_length, (size_t *)&topic_length);
+                                                                topic_length, &topic_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("IoTHub client telemetry message create fail with error status: %d"), core_result);
@@ -1888,7 +1910,7 @@ UCHAR *buffer_ptr;
 ULONG buffer_size;
 az_span request_id_span;
 az_result core_result;
-UINT topic_length;
+size_t topic_length;
 
     if ((hub_client_ptr == NX_NULL) ||
         (packet_pptr == NX_NULL))
@@ -2063,7 +2085,7 @@ UINT nx_azure_iot_hub_client_properties_request(NX_AZURE_IOT_HUB_CLIENT *hub_cli
                                                 UINT wait_option)
 {
 UINT status;
-UINT topic_length;
+size_t topic_length;
 UINT buffer_size;
 NX_PACKET *packet_ptr;
 az_span request_id_span;
@@ -2126,7 +2148,7 @@ az_result core_result;
 
     core_result = az_iot_hub_client_properties_document_get_publish_topic(&(hub_client_ptr -> iot_hub_client_core),
                                                                           request_id_span, (CHAR *)packet_ptr -> nx_packet_prepend_ptr,
-                                                                          buffer_size, (size_t *)&topic_length);
+                                                                          buffer_size, &topic_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("IoTHub client device twin get topic fail."));
@@ -2291,7 +2313,7 @@ UINT nx_azure_iot_hub_client_device_twin_reported_properties_send(NX_AZURE_IOT_H
 UINT status;
 UINT buffer_size;
 NX_PACKET *packet_ptr;
-UINT topic_length;
+size_t topic_length;
 UINT request_id;
 az_span request_id_span;
 az_result core_result;
@@ -2364,7 +2386,7 @@ NX_PACKET *response_packet_ptr;
 
     core_result = az_iot_hub_client_twin_patch_get_publish_topic(&(hub_client_ptr -> iot_hub_client_core),
                                                                  request_id_span, (CHAR *)packet_ptr -> nx_packet_prepend_ptr,
-                                                                 buffer_size, (size_t *)&topic_length);
+                                                                 buffer_size, &topic_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("IoTHub client reported state send fail: NX_AZURE_IOT_HUB_CLIENT_TOPIC_SIZE is too small."));
@@ -3011,6 +3033,7 @@ UINT status;
 UCHAR *output_ptr;
 UINT output_len;
 az_result core_result;
+size_t sas_token_length;
 
     status = nx_azure_iot_buffer_allocate(hub_client_ptr -> nx_azure_iot_ptr, &buffer_ptr, &buffer_size, &buffer_context);
     if (status)
@@ -3041,7 +3064,7 @@ az_result core_result;
     buffer_span = az_span_create(output_ptr, (INT)output_len);
     core_result= az_iot_hub_client_sas_get_password(&(hub_client_ptr -> iot_hub_client_core),
                                                     expiry_time_secs, buffer_span, AZ_SPAN_EMPTY,
-                                                    (CHAR *)sas_buffer, sas_buffer_len, (size_t *)&sas_buffer_len);
+                                                    (CHAR *)sas_buffer, sas_buffer_len, &sas_token_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("IoTHub failed to generate token with error status: %d"), core_result);
@@ -3049,7 +3072,7 @@ az_result core_result;
         return(NX_AZURE_IOT_SDK_CORE_ERROR);
     }
 
-    *sas_length = sas_buffer_len;
+    *sas_length = (UINT)sas_token_length;
     nx_azure_iot_buffer_free(buffer_context);
 
     return(NX_AZURE_IOT_SUCCESS);
@@ -3193,7 +3216,7 @@ UINT nx_azure_iot_hub_client_command_message_response(NX_AZURE_IOT_HUB_CLIENT *h
                                                       UINT payload_length, UINT wait_option)
 {
 NX_PACKET *packet_ptr;
-UINT topic_length;
+size_t topic_length;
 az_span request_id_span;
 UINT status;
 az_result core_result;
@@ -3222,7 +3245,7 @@ az_result core_result;
     core_result = az_iot_hub_client_commands_response_get_publish_topic(&(hub_client_ptr -> iot_hub_client_core),
                                                                         request_id_span, (USHORT)status_code,
                                                                         (CHAR *)packet_ptr -> nx_packet_prepend_ptr,
-                                                                        topic_length, (size_t *)&topic_length);
+                                                                        topic_length, &topic_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("Failed to create the command response topic"));
@@ -236,6 +236,23 @@ UINT nx_azure_iot_hub_client_trusted_cert_add(NX_AZURE_IOT_HUB_CLIENT *hub_clien
 UINT nx_azure_iot_hub_client_device_cert_set(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
                                              NX_SECURE_X509_CERT *device_certificate);
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+/**
+ * @brief Set the TLS session cache of the IoT Hub client.
+ * @details The session of the last completed handshake is kept in the cache and offered when the client
+ *          connects again, a server that accepts it skips the certificate exchange and key agreement.
+ *          The cache must outlive the client and must only be used with one endpoint.
+ *
+ * @param[in] hub_client_ptr A pointer to a #NX_AZURE_IOT_HUB_CLIENT.
+ * @param[in] resume_ptr A pointer to a `NX_SECURE_TLS_RESUME`, NX_NULL to stop resuming sessions.
+ * @return A `UINT` with the result of the API.
+ *  @retval #NX_AZURE_IOT_SUCCESS Successfully set the TLS session cache.
+ *  @retval #NX_AZURE_IOT_INVALID_PARAMETER Fail to set the TLS session cache due to invalid parameter.
+ */
+UINT nx_azure_iot_hub_client_tls_resume_set(NX_AZURE_IOT_HUB_CLIENT *hub_client_ptr,
+                                            NX_SECURE_TLS_RESUME *resume_ptr);
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
 /**
  * @brief Set symmetric key in the IoT Hub client.
  *
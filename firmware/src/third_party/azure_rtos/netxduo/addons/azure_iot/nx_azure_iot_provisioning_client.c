@@ -605,7 +605,7 @@ UCHAR *buffer_ptr;
 UINT buffer_size;
 UCHAR packet_id[2];
 UINT status;
-UINT mqtt_topic_length;
+size_t mqtt_topic_length;
 az_result core_result;
 
     status = nx_azure_iot_publish_packet_get(prov_client_ptr -> nx_azure_iot_ptr,
@@ -636,14 +636,14 @@ az_result core_result;
     {
         core_result = az_iot_provisioning_client_register_get_publish_topic(&(prov_client_ptr -> nx_azure_iot_provisioning_client_core),
                                                                             (CHAR *)buffer_ptr, buffer_size,
-                                                                            (size_t *)&mqtt_topic_length);
+                                                                            &mqtt_topic_length);
     }
     else
     {
         core_result = az_iot_provisioning_client_query_status_get_publish_topic(&(prov_client_ptr -> nx_azure_iot_provisioning_client_core),
                                                                                 register_response -> operation_id, (CHAR *)buffer_ptr,
                                                                                 buffer_size,
-                                                                                (size_t *)&mqtt_topic_length);
+                                                                                &mqtt_topic_length);
     }
 
     if (az_result_failed(core_result))
@@ -730,6 +730,7 @@ az_span span;
 az_result core_result;
 az_span buffer_span;
 az_span policy_name = AZ_SPAN_LITERAL_FROM_STR(NX_AZURE_IOT_PROVISIONING_CLIENT_POLICY_NAME);
+size_t sas_token_length;
 
     resource_ptr = &(prov_client_ptr -> nx_azure_iot_provisioning_client_resource);
     span = az_span_create(resource_ptr -> resource_mqtt_sas_token,
@@ -771,7 +772,7 @@ az_span policy_name = AZ_SPAN_LITERAL_FROM_STR(NX_AZURE_IOT_PROVISIONING_CLIENT_
                                                               buffer_span, expiry_time_secs, policy_name,
                                                               (CHAR *)resource_ptr -> resource_mqtt_sas_token,
                                                               prov_client_ptr -> nx_azure_iot_provisioning_client_sas_token_buff_size,
-                                                              (size_t *)&(resource_ptr -> resource_mqtt_sas_token_length));
+                                                              &sas_token_length);
     if (az_result_failed(core_result))
     {
         LogError(LogLiteralArgs("IoTProvisioning failed to generate token with error : %d"), core_result);
@@ -779,6 +780,8 @@ az_span policy_name = AZ_SPAN_LITERAL_FROM_STR(NX_AZURE_IOT_PROVISIONING_CLIENT_
         return(NX_AZURE_IOT_SDK_CORE_ERROR);
     }
 
+    resource_ptr -> resource_mqtt_sas_token_length = (UINT)sas_token_length;
+
     nx_azure_iot_buffer_free(buffer_context);
 
     return(NX_AZURE_IOT_SUCCESS);
@@ -796,7 +799,7 @@ UINT nx_azure_iot_provisioning_client_initialize(NX_AZURE_IOT_PROVISIONING_CLIEN
                                                  NX_SECURE_X509_CERT *trusted_certificate)
 {
 UINT status;
-UINT mqtt_user_name_length;
+size_t mqtt_user_name_length;
 NXD_MQTT_CLIENT *mqtt_client_ptr;
 NX_AZURE_IOT_RESOURCE *resource_ptr;
 UCHAR *buffer_ptr;
@@ -892,7 +895,7 @@ az_span registration_id_span = az_span_create((UCHAR *)registration_id, (INT)reg
     /* Build user name.  */
     if (az_result_failed(az_iot_provisioning_client_get_user_name(&(prov_client_ptr -> nx_azure_iot_provisioning_client_core),
                                                                   (CHAR *)buffer_ptr, buffer_size,
-                                                                  (size_t *)&mqtt_user_name_length)))
+                                                                  &mqtt_user_name_length)))
     {
         LogError(LogLiteralArgs("IoTProvisioning client connect fail: NX_AZURE_IOT_Provisioning_CLIENT_USERNAME_SIZE is too small."));
         nx_azure_iot_buffer_free(buffer_context);
@@ -1154,6 +1157,28 @@ NX_AZURE_IOT_PROVISIONING_CLIENT *provisioning_client;
     tx_mutex_put(nx_azure_iot_ptr -> nx_azure_iot_mutex_ptr);
 }
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+UINT nx_azure_iot_provisioning_client_tls_resume_set(NX_AZURE_IOT_PROVISIONING_CLIENT *prov_client_ptr,
+                                                     NX_SECURE_TLS_RESUME *resume_ptr)
+{
+    if ((prov_client_ptr == NX_NULL) || (prov_client_ptr -> nx_azure_iot_ptr == NX_NULL))
+    {
+        LogError(LogLiteralArgs("IoTProvisioning TLS resume set fail: INVALID POINTER"));
+        return(NX_AZURE_IOT_INVALID_PARAMETER);
+    }
+
+    /* Obtain the mutex.  */
+    tx_mutex_get(prov_client_ptr -> nx_azure_iot_ptr -> nx_azure_iot_mutex_ptr, NX_WAIT_FOREVER);
+
+    prov_client_ptr -> nx_azure_iot_provisioning_client_resource.resource_tls_resume_ptr = resume_ptr;
+
+    /* Release the mutex.  */
+    tx_mutex_put(prov_client_ptr -> nx_azure_iot_ptr -> nx_azure_iot_mutex_ptr);
+
+    return(NX_AZURE_IOT_SUCCESS);
+}
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
 UINT nx_azure_iot_provisioning_client_register(NX_AZURE_IOT_PROVISIONING_CLIENT *prov_client_ptr, UINT wait_option)
 {
 NX_AZURE_IOT_PROVISIONING_THREAD thread_list;
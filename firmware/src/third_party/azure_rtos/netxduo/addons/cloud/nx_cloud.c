@@ -32,6 +32,7 @@
 /* Include necessary system files.  */
 
 #include "nx_cloud.h"
+#include "tx_timer.h"
 
 /* Bring in externs for caller checking code.  */
 
@@ -206,8 +207,9 @@ UINT old_threshold = 0;
 
     /* Create cloud helper thread. */
     status = tx_thread_create(&(cloud_ptr -> nx_cloud_thread), (CHAR*)cloud_name,
-                              _nx_cloud_thread_entry, (ULONG)cloud_ptr,
+                              _nx_cloud_thread_entry, (ULONG)(ALIGN_TYPE)cloud_ptr,
                               memory_ptr, memory_size, priority, priority, 1, TX_AUTO_START);
+    NX_THREAD_EXTENSION_PTR_SET(&(cloud_ptr -> nx_cloud_thread), cloud_ptr)
         
     /* Check status.  */
     if (status)
@@ -226,8 +228,9 @@ UINT old_threshold = 0;
     
     /* Create the periodic timer for cloud modules.  */
     status = tx_timer_create(&(cloud_ptr -> nx_cloud_periodic_timer), (CHAR*)cloud_name,
-                             _nx_cloud_periodic_timer_entry, (ULONG)cloud_ptr,
+                             _nx_cloud_periodic_timer_entry, (ULONG)(ALIGN_TYPE)cloud_ptr,
                              NX_IP_PERIODIC_RATE, NX_IP_PERIODIC_RATE, TX_AUTO_ACTIVATE);
+    NX_TIMER_EXTENSION_PTR_SET(&(cloud_ptr -> nx_cloud_periodic_timer), cloud_ptr)
 
     /* Check status.  */
     if (status)
@@ -1086,7 +1089,7 @@ ULONG           module_own_events;
 
 
     /* Setup the Cloud pointer.  */
-    cloud_ptr = (NX_CLOUD*)cloud_ptr_value;
+    NX_THREAD_EXTENSION_PTR_GET(cloud_ptr, NX_CLOUD, cloud_ptr_value)
 
     for (;;)
     {
@@ -1177,9 +1180,12 @@ ULONG           module_own_events;
 static VOID _nx_cloud_periodic_timer_entry(ULONG cloud_ptr_value)
 {
 
-NX_CLOUD *cloud_ptr = (NX_CLOUD *)cloud_ptr_value;
+NX_CLOUD *cloud_ptr;
 
 
+    /* Setup the Cloud pointer.  */
+    NX_TIMER_EXTENSION_PTR_GET(cloud_ptr, NX_CLOUD, cloud_ptr_value)
+
     /* Wakeup this cloud's helper thread.  */
     tx_event_flags_set(&(cloud_ptr -> nx_cloud_events), NX_CLOUD_COMMON_PERIODIC_EVENT, TX_OR);
 }
\ No newline at end of file
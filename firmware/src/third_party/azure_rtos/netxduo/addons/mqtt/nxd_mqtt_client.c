@@ -36,6 +36,7 @@
 #include    "nx_api.h"
 #include    "nx_ip.h"
 #include    "nxd_mqtt_client.h"
+#include    "tx_timer.h"
 
 /* Bring in externals for caller checking code.  */
 
@@ -868,6 +869,12 @@ static VOID _nxd_mqtt_release_transmit_packet(NXD_MQTT_CLIENT *client_ptr, NX_PA
 
 #ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
     client_ptr -> message_transmit_queue_depth--;
+
+    /* Let a publisher waiting for room in the transmit queue retry. */
+    if (client_ptr -> nxd_mqtt_transmit_window_notify)
+    {
+        client_ptr -> nxd_mqtt_transmit_window_notify(client_ptr, client_ptr -> nxd_mqtt_transmit_window_context);
+    }
 #endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
 }
 
@@ -1961,6 +1968,14 @@ UCHAR       fixed_header;
         client_ptr -> nxd_mqtt_connect_notify(client_ptr, NXD_MQTT_CONNECT_FAILURE, client_ptr -> nxd_mqtt_connect_context);
     }
 
+#ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
+    /* A publisher waiting for room in the transmit queue gives up now rather than at its timeout. */
+    if ((disconnect_callback == NX_TRUE) && (client_ptr -> nxd_mqtt_transmit_window_notify))
+    {
+        client_ptr -> nxd_mqtt_transmit_window_notify(client_ptr, client_ptr -> nxd_mqtt_transmit_window_context);
+    }
+#endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
+
     if (status == TX_SUCCESS)
     {
         /* Remove all the packets in the receive queue. */
@@ -2666,7 +2681,9 @@ static UINT _nxd_mqtt_send_simple_message(NXD_MQTT_CLIENT *client_ptr, UCHAR hea
 static VOID _nxd_mqtt_periodic_timer_entry(ULONG client)
 {
 /* Check if it is time to send out a ping message. */
-NXD_MQTT_CLIENT *client_ptr = (NXD_MQTT_CLIENT *)client;
+NXD_MQTT_CLIENT *client_ptr;
+
+    NX_TIMER_EXTENSION_PTR_GET(client_ptr, NXD_MQTT_CLIENT, client)
 
     /* If an outstanding ping response has not been received, and the client exceeds the time waiting for ping response,
        the client shall disconnect from the server. */
@@ -3840,8 +3857,9 @@ UINT                 old_priority;
         client_ptr -> nxd_mqtt_ping_timeout = NXD_MQTT_PING_TIMEOUT_DELAY;
 
         /* Create timer */
-        status = tx_timer_create(&(client_ptr -> nxd_mqtt_timer), "MQTT Timer", _nxd_mqtt_periodic_timer_entry, (ULONG)client_ptr,
+        status = tx_timer_create(&(client_ptr -> nxd_mqtt_timer), "MQTT Timer", _nxd_mqtt_periodic_timer_entry, (ULONG)(ALIGN_TYPE)client_ptr,
                                  client_ptr -> nxd_mqtt_timer_value, client_ptr -> nxd_mqtt_timer_value, TX_AUTO_ACTIVATE);
+        NX_TIMER_EXTENSION_PTR_SET(&(client_ptr -> nxd_mqtt_timer), client_ptr)
         if (status)
         {
 #ifdef NX_SECURE_ENABLE
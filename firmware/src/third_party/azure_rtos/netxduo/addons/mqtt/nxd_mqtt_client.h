@@ -347,6 +347,8 @@ typedef struct NXD_MQTT_CLIENT_STRUCT
     NX_PACKET                     *message_transmit_queue_tail;
 #ifdef NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH
     UINT                           message_transmit_queue_depth;
+    VOID                         (*nxd_mqtt_transmit_window_notify)(struct NXD_MQTT_CLIENT_STRUCT *client_ptr, VOID *context); /* Called when a transmit queue slot is freed or the client disconnects */
+    VOID                          *nxd_mqtt_transmit_window_context;
 #endif /* NXD_MQTT_MAXIMUM_TRANSMIT_QUEUE_DEPTH */
     NX_PACKET                     *message_receive_queue_head;
     NX_PACKET                     *message_receive_queue_tail;
@@ -59,6 +59,7 @@
 
 #include "nx_ipv4.h"
 #include "nxd_sntp_client.h"
+#include "tx_timer.h"
 #ifdef FEATURE_NX_IPV6
 #include "nx_ipv6.h"
 #endif
@@ -298,9 +299,10 @@ UINT status;
 
     /* Create the SNTP update timeout timer.  */
     status =  tx_timer_create(&client_ptr -> nx_sntp_update_timer, "SNTP Client Update Timer",
-              _nx_sntp_client_update_timeout_entry, (ULONG)client_ptr, 
+              _nx_sntp_client_update_timeout_entry, (ULONG)(ALIGN_TYPE)client_ptr, 
               (NX_IP_PERIODIC_RATE * NX_SNTP_UPDATE_TIMEOUT_INTERVAL), 
               (NX_IP_PERIODIC_RATE * NX_SNTP_UPDATE_TIMEOUT_INTERVAL), TX_NO_ACTIVATE);
+    NX_TIMER_EXTENSION_PTR_SET(&(client_ptr -> nx_sntp_update_timer), client_ptr)
 
     /* Check for error.  */
     if (status != TX_SUCCESS)
@@ -351,9 +353,10 @@ UINT status;
     }
 
     /* Create the SNTP Client processing thread.  */
-    status =  tx_thread_create(&(client_ptr -> nx_sntp_client_thread), "NetX SNTP Client", _nx_sntp_client_thread_entry, (ULONG)client_ptr,
+    status =  tx_thread_create(&(client_ptr -> nx_sntp_client_thread), "NetX SNTP Client", _nx_sntp_client_thread_entry, (ULONG)(ALIGN_TYPE)client_ptr,
                         client_ptr -> nx_sntp_client_thread_stack, NX_SNTP_CLIENT_THREAD_STACK_SIZE, 
                         NX_SNTP_CLIENT_THREAD_PRIORITY, NX_SNTP_CLIENT_PREEMPTION_THRESHOLD, 1, TX_DONT_START);
+    NX_THREAD_EXTENSION_PTR_SET(&(client_ptr -> nx_sntp_client_thread), client_ptr)
 
     /* Determine if the thread creation was successful.  */
     if (status != NX_SUCCESS)
@@ -572,7 +575,7 @@ VOID  _nx_sntp_client_update_timeout_entry(ULONG info)
 NX_SNTP_CLIENT *client_ptr;
 
 
-    client_ptr = (NX_SNTP_CLIENT *)info;
+    NX_TIMER_EXTENSION_PTR_GET(client_ptr, NX_SNTP_CLIENT, info)
 
     /* Is the Client's time remaining large enough to decrement by the timeout interval?  */ 
     if (client_ptr -> nx_sntp_update_time_remaining >= (NX_IP_PERIODIC_RATE * NX_SNTP_UPDATE_TIMEOUT_INTERVAL))
@@ -3572,7 +3575,7 @@ UINT    current_preemption;
 
 
     /* Setup the SNTP pointer.  */
-    client_ptr =    (NX_SNTP_CLIENT *) sntp_instance;
+    NX_THREAD_EXTENSION_PTR_GET(client_ptr, NX_SNTP_CLIENT, sntp_instance)
 
     /* Enter while loop.  */
     do
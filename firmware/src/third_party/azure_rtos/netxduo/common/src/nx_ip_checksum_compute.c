@@ -91,6 +91,9 @@ ULONG      packet_size;
 #endif /* NX_DISABLE_PACKET_CHAIN */
 NX_PACKET *current_packet;
 ALIGN_TYPE end_ptr;
+ULONG      word;
+ULONG      word_sum;
+ULONG      word_carry;
 #ifdef FEATURE_NX_IPV6
 UINT       i;
 #endif
@@ -200,14 +203,41 @@ UINT       i;
             /*lint -e{923} suppress cast of pointer to ULONG.  */
             data_length -= (UINT)(((end_ptr + 3) & (ALIGN_TYPE)(~3llu)) - (ALIGN_TYPE)long_ptr);
 
-            /* Loop to calculate the packet's checksum.  */
+            /* Loop to calculate the packet's checksum. The words are summed with
+               end-around carry, one add and one carry test per word instead of
+               adding both halves separately, four words per pass.  */
+            word_sum = 0;
+            word_carry = 0;
+            /*lint -e{946} suppress pointer subtraction, since it is necessary. */
+            while (((ALIGN_TYPE)long_ptr + 12) < end_ptr)
+            {
+                word = long_ptr[0];
+                word_sum += word;
+                word_carry += (word_sum < word);
+                word = long_ptr[1];
+                word_sum += word;
+                word_carry += (word_sum < word);
+                word = long_ptr[2];
+                word_sum += word;
+                word_carry += (word_sum < word);
+                word = long_ptr[3];
+                word_sum += word;
+                word_carry += (word_sum < word);
+                long_ptr += 4;
+            }
+
             /*lint -e{946} suppress pointer subtraction, since it is necessary. */
             while ((ALIGN_TYPE)long_ptr < end_ptr)
             {
-                checksum += (*long_ptr & NX_LOWER_16_MASK);
-                checksum += (*long_ptr >> NX_SHIFT_BY_16);
+                word = *long_ptr;
+                word_sum += word;
+                word_carry += (word_sum < word);
                 long_ptr++;
             }
+
+            /* Fold the 32-bit sum and its carries into the checksum, 2^32 being
+               1 modulo 0xFFFF.  */
+            checksum += (word_sum & NX_LOWER_16_MASK) + (word_sum >> NX_SHIFT_BY_16) + word_carry;
         }
 #ifndef NX_DISABLE_PACKET_CHAIN
 
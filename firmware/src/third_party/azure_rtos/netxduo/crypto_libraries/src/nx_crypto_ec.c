@@ -1204,7 +1204,7 @@ UINT                  compare_value;
 
     NX_CRYPTO_HUGE_NUMBER_INITIALIZE(&temp, scratch, 36);
 
-    data = (UINT *)(((ULONG)scratch + 3) & (ULONG) ~3);
+    data = (UINT *)(((ALIGN_TYPE)scratch + 3) & (ALIGN_TYPE) ~3);
 
     /* c= (c5,...,c2,c1,c0), ci is a 64-bit word */
     _nx_crypto_huge_number_extract(value, (UCHAR *)data, 48, &size);
@@ -1341,7 +1341,7 @@ UINT                  compare_value;
 
     NX_CRYPTO_HUGE_NUMBER_INITIALIZE(&temp, scratch, 36);
 
-    data = (UINT *)(((ULONG)scratch + 3) & (ULONG) ~3);
+    data = (UINT *)(((ALIGN_TYPE)scratch + 3) & (ALIGN_TYPE) ~3);
 
     /* c= (c13,...,c2,c1,c0), ci is a 32-bit word */
     _nx_crypto_huge_number_extract(value, (UCHAR *)data, 56, &size);
@@ -1485,7 +1485,7 @@ UINT                  compare_value;
 
     NX_CRYPTO_HUGE_NUMBER_INITIALIZE(&temp, scratch, 36);
 
-    data = (UINT *)(((ULONG)scratch + 3) & (ULONG) ~3);
+    data = (UINT *)(((ALIGN_TYPE)scratch + 3) & (ALIGN_TYPE) ~3);
 
     /* c= (c15,...,c2,c1,c0), ci is a 32-bit word */
     _nx_crypto_huge_number_extract(value, (UCHAR *)data, 64, &size);
@@ -1650,7 +1650,7 @@ UINT                  compare_value;
 
     NX_CRYPTO_HUGE_NUMBER_INITIALIZE(&temp, scratch, 52);
 
-    data = (UINT *)(((ULONG)scratch + 3) & (ULONG) ~3);
+    data = (UINT *)(((ALIGN_TYPE)scratch + 3) & (ALIGN_TYPE) ~3);
 
     /* c= (c23,...,c2,c1,c0), ci is a 32-bit word */
     _nx_crypto_huge_number_extract(value, (UCHAR *)data, 96, &size);
@@ -1821,7 +1821,7 @@ UINT                  compare_value;
 
     NX_CRYPTO_HUGE_NUMBER_INITIALIZE(&temp, scratch, 66);
 
-    data = (UCHAR *)(((ULONG)scratch + 3) & (ULONG) ~3);
+    data = (UCHAR *)(((ALIGN_TYPE)scratch + 3) & (ALIGN_TYPE) ~3);
 
 
     /* c= (c1041,...,c2,c1,c0) */
@@ -2912,7 +2912,7 @@ UINT               bit;
         }
     }
 
-    for (; (ULONG)ptr >= (ULONG)naf_data; ptr--)
+    for (; (ALIGN_TYPE)ptr >= (ALIGN_TYPE)naf_data; ptr--)
     {
         digit = *ptr;
 
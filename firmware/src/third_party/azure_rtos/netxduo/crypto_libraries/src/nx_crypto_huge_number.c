@@ -2680,7 +2680,7 @@ NX_CRYPTO_HUGE_NUMBER *operand, *temp_result, *temp_swap;
     val = e -> nx_crypto_huge_number_data + (exp_size - 1);
 
     /* Loop through the bits of the exponent. For each bit set, multiply the result by the running square. */
-    for (; (ULONG)val >= (ULONG)(e -> nx_crypto_huge_number_data); val--)
+    for (; (ALIGN_TYPE)val >= (ALIGN_TYPE)(e -> nx_crypto_huge_number_data); val--)
     {
         /* Current byte in the exponent determines whether we multiply or not. */
         cur_block = *val;
@@ -1095,6 +1095,37 @@ typedef struct NX_SECURE_TLS_HELLO_EXTENSION_STRUCT
 
 
 /* Definition of the top-level TLS session control block used by the application. */
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+/* Largest session ID a TLS 1.0-1.2 server may assign (RFC 5246). */
+#define NX_SECURE_TLS_RESUME_SESSION_ID_SIZE               (32)
+
+/* Session state kept by a TLS Client across connections so that the next handshake
+   with the same server can resume it (RFC 5246 section 7.3, abbreviated handshake).
+   The structure is owned by the application and attached to a session with
+   nx_secure_tls_session_resume_set. TLS fills it in at the end of every completed
+   full handshake, offers it in the next ClientHello and counts whether the server
+   accepted it. The master secret is kept in the clear, do not place the structure
+   in memory readable from outside the device. */
+typedef struct NX_SECURE_TLS_RESUME_STRUCT
+{
+    /* Protocol version and ciphersuite of the cached session. */
+    USHORT nx_secure_tls_resume_protocol_version;
+    USHORT nx_secure_tls_resume_ciphersuite;
+
+    /* Session ID assigned by the server, 0 length if nothing is cached. */
+    UCHAR  nx_secure_tls_resume_session_id_length;
+    UCHAR  nx_secure_tls_resume_session_id[NX_SECURE_TLS_RESUME_SESSION_ID_SIZE];
+
+    /* Master secret of the cached session. */
+    UCHAR  nx_secure_tls_resume_master_secret[NX_SECURE_TLS_MASTER_SIZE];
+
+    /* Completed handshakes that resumed the cached session (hits) and that
+       needed a full handshake (misses). */
+    ULONG  nx_secure_tls_resume_hits;
+    ULONG  nx_secure_tls_resume_misses;
+} NX_SECURE_TLS_RESUME;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
 typedef struct NX_SECURE_TLS_SESSION_STRUCT
 {
     /* Identifier to determine if TLS session has been properly initialized. */
@@ -1242,6 +1273,15 @@ typedef struct NX_SECURE_TLS_SESSION_STRUCT
 
     /* If the remote TLS Server requests a certificate, save that state here so we can send the cert. */
     USHORT nx_secure_tls_client_certificate_requested;
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* Cached session offered in the ClientHello (set by application). */
+    NX_SECURE_TLS_RESUME *nx_secure_tls_resume_ptr;
+
+    /* Set while the server has accepted the offered session and the abbreviated
+       handshake is in progress. */
+    USHORT nx_secure_tls_session_resumed;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 #endif
 
     /* Define the link between other TLS structures created by the application.  */
@@ -1626,6 +1666,9 @@ UINT _nx_secure_tls_session_sni_extension_set(NX_SECURE_TLS_SESSION *tls_session
                                               NX_SECURE_X509_DNS_NAME *dns_name);
 UINT _nx_secure_tls_session_start(NX_SECURE_TLS_SESSION *tls_session, NX_TCP_SOCKET *tcp_socket,
                                   UINT wait_option);
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+UINT _nx_secure_tls_session_resume_set(NX_SECURE_TLS_SESSION *tls_session, NX_SECURE_TLS_RESUME *resume_ptr);
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
 UINT _nx_secure_tls_session_time_function_set(NX_SECURE_TLS_SESSION *tls_session,
                                               ULONG (*time_func_ptr)(void));
 UINT _nx_secure_tls_trusted_certificate_add(NX_SECURE_TLS_SESSION *tls_session,
@@ -1718,6 +1761,9 @@ UINT _nxe_secure_tls_session_sni_extension_set(NX_SECURE_TLS_SESSION *tls_sessio
                                                NX_SECURE_X509_DNS_NAME *dns_name);
 UINT _nxe_secure_tls_session_start(NX_SECURE_TLS_SESSION *tls_session, NX_TCP_SOCKET *tcp_socket,
                                    UINT wait_option);
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+UINT _nxe_secure_tls_session_resume_set(NX_SECURE_TLS_SESSION *tls_session, NX_SECURE_TLS_RESUME *resume_ptr);
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
 UINT _nxe_secure_tls_session_time_function_set(NX_SECURE_TLS_SESSION *tls_session,
                                                ULONG (*time_func_ptr)(void));
 UINT _nxe_secure_tls_trusted_certificate_add(NX_SECURE_TLS_SESSION *tls_session,
@@ -104,6 +104,9 @@ extern   "C" {
 #define nx_secure_tls_session_sni_extension_parse          _nx_secure_tls_session_sni_extension_parse
 #define nx_secure_tls_session_sni_extension_set            _nx_secure_tls_session_sni_extension_set
 #define nx_secure_tls_session_start                        _nx_secure_tls_session_start
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+#define nx_secure_tls_session_resume_set                   _nx_secure_tls_session_resume_set
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
 #define nx_secure_tls_session_time_function_set            _nx_secure_tls_session_time_function_set
 #define nx_secure_tls_trusted_certificate_add              _nx_secure_tls_trusted_certificate_add
 #define nx_secure_tls_trusted_certificate_remove           _nx_secure_tls_trusted_certificate_remove
@@ -146,6 +149,9 @@ extern   "C" {
 #define nx_secure_tls_session_sni_extension_parse          _nxe_secure_tls_session_sni_extension_parse
 #define nx_secure_tls_session_sni_extension_set            _nxe_secure_tls_session_sni_extension_set
 #define nx_secure_tls_session_start                        _nxe_secure_tls_session_start
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+#define nx_secure_tls_session_resume_set                   _nxe_secure_tls_session_resume_set
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
 #define nx_secure_tls_session_time_function_set            _nxe_secure_tls_session_time_function_set
 #define nx_secure_tls_trusted_certificate_add              _nxe_secure_tls_trusted_certificate_add
 #define nx_secure_tls_trusted_certificate_remove           _nxe_secure_tls_trusted_certificate_remove
@@ -239,6 +245,9 @@ UINT nx_secure_tls_session_sni_extension_set(NX_SECURE_TLS_SESSION *tls_session,
                                              NX_SECURE_X509_DNS_NAME *dns_name);
 UINT nx_secure_tls_session_start(NX_SECURE_TLS_SESSION *tls_session, NX_TCP_SOCKET *tcp_socket,
                                  UINT wait_option);
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+UINT nx_secure_tls_session_resume_set(NX_SECURE_TLS_SESSION *tls_session, NX_SECURE_TLS_RESUME *resume_ptr);
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
 UINT nx_secure_tls_session_time_function_set(NX_SECURE_TLS_SESSION *tls_session,
                                              ULONG (*time_func_ptr)(VOID));
 UINT nx_secure_tls_trusted_certificate_add(NX_SECURE_TLS_SESSION *tls_session,
@@ -24,6 +24,12 @@
 
 #include "nx_secure_tls.h"
 
+#ifndef NX_SECURE_TLS_CLIENT_DISABLED
+static UINT _nx_secure_tls_client_handshake_hash_cleanup(NX_SECURE_TLS_SESSION *tls_session);
+static UINT _nx_secure_tls_client_handshake_finished_send(NX_SECURE_TLS_SESSION *tls_session,
+                                                          NX_PACKET_POOL *packet_pool, ULONG wait_option);
+#endif /* NX_SECURE_TLS_CLIENT_DISABLED */
+
 
 /**************************************************************************/
 /*                                                                        */
@@ -136,8 +142,6 @@ NX_PACKET_POOL *packet_pool;
 UINT            error_number;
 UINT            alert_number;
 UINT            alert_level;
-const NX_CRYPTO_METHOD
-               *method_ptr = NX_NULL;
 
     /* Basic state machine for handshake:
      * 1. We have received a handshake message, now process the header.
@@ -192,6 +196,16 @@ const NX_CRYPTO_METHOD
         /* Reduce total length by the size of this message. */
         data_length -= (message_length + header_bytes);
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+        /* An abbreviated handshake goes straight from the ServerHello to the server Finished. */
+        if (tls_session -> nx_secure_tls_session_resumed &&
+            (tls_session -> nx_secure_tls_client_state == NX_SECURE_TLS_CLIENT_STATE_SERVERHELLO) &&
+            (message_type != NX_SECURE_TLS_FINISHED))
+        {
+            message_type = NX_SECURE_TLS_INVALID_MESSAGE;
+        }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
         /* Process the message itself information from the header. */
         status = NX_SECURE_TLS_HANDSHAKE_FAILURE;
         switch (message_type)
@@ -222,45 +236,26 @@ const NX_CRYPTO_METHOD
             /* Final handshake message from the server, process it (verify the server handshake hash). */
             status = _nx_secure_tls_process_finished(tls_session, packet_buffer, message_length);
 
-            /* For client, cleanup hash handler after received the finished message from server. */
-            /* NOTE: we want to run all of the nx_crypto_cleanup calls regardless of the status of the finished processing above
-                     so use a secondary status to track their return status values. */
-#if (NX_SECURE_TLS_TLS_1_2_ENABLED)
-            method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_sha256_method;
-
-            /* NOTE: we want to run all of the nx_crypto_cleanup calls regardless of the  */
-            if (method_ptr -> nx_crypto_cleanup != NX_NULL)
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+            if (tls_session -> nx_secure_tls_session_resumed)
             {
-                temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_sha256_metadata);
-                if(temp_status != NX_CRYPTO_SUCCESS)
-                {
-                    status = temp_status;
-                }
-            }
 
-#endif /* (NX_SECURE_TLS_TLS_1_2_ENABLED) */
-
-#if (NX_SECURE_TLS_TLS_1_0_ENABLED || NX_SECURE_TLS_TLS_1_1_ENABLED)
-            method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_md5_method;
-            if (method_ptr != NX_NULL && method_ptr -> nx_crypto_cleanup != NX_NULL)
-            {
-                temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_md5_metadata);
-                if(temp_status != NX_CRYPTO_SUCCESS)
+                /* In an abbreviated handshake our Finished follows the server one and covers it,
+                   the handshake hash is cleaned up once ours has been sent. */
+                if (status == NX_SUCCESS)
                 {
-                    status = temp_status;
+                    status = _nx_secure_tls_handshake_hash_update(tls_session, packet_start, message_length + header_bytes);
                 }
+                break;
             }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 
-            method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_sha1_method;
-            if (method_ptr != NX_NULL && method_ptr -> nx_crypto_cleanup != NX_NULL)
+            /* For client, cleanup hash handler after received the finished message from server. */
+            temp_status = _nx_secure_tls_client_handshake_hash_cleanup(tls_session);
+            if (temp_status != NX_SUCCESS)
             {
-                temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_sha1_metadata);
-                if(temp_status != NX_CRYPTO_SUCCESS)
-                {
-                    status = temp_status;
-                }
+                status = temp_status;
             }
-#endif /* (NX_SECURE_TLS_TLS_1_0_ENABLED || NX_SECURE_TLS_TLS_1_1_ENABLED) */
 
             break;
         case NX_SECURE_TLS_HELLO_REQUEST:
@@ -417,6 +412,15 @@ const NX_CRYPTO_METHOD
 
                 _nx_secure_tls_handshake_hash_update(tls_session, packet_start, message_length + header_bytes);
             }
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+            /* A resumed session skips the key exchange, the keys come from the cached master
+               secret and must be ready for the server ChangeCipherSpec that follows. */
+            if (tls_session -> nx_secure_tls_session_resumed)
+            {
+                status = _nx_secure_tls_generate_keys(tls_session);
+            }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
             break;
         case NX_SECURE_TLS_CLIENT_STATE_SERVER_CERTIFICATE:
             /* Processed a server certificate above. Here, we extract the public key and do any verification
@@ -530,63 +534,58 @@ const NX_CRYPTO_METHOD
                 break;
             }
 
-            /* Release the protection before suspending on nx_packet_allocate. */
-            tx_mutex_put(&_nx_secure_tls_protection);
-
             /* We have received everything we need to complete the handshake. Keys have been
              * generated above. Now end the handshake with a ChangeCipherSpec (indicating following
              * messages are encrypted) and the encrypted Finished message. */
-            status = _nx_secure_tls_packet_allocate(tls_session, packet_pool, &send_packet, wait_option);
-
-            /* Get the protection after nx_packet_allocate. */
-            tx_mutex_get(&_nx_secure_tls_protection, TX_WAIT_FOREVER);
+            status = _nx_secure_tls_client_handshake_finished_send(tls_session, packet_pool, wait_option);
 
-            if (status != NX_SUCCESS)
+            break;
+        case NX_SECURE_TLS_CLIENT_STATE_HANDSHAKE_FINISHED:
+            /* We processed a server finished message, completing the handshake. Verify all is good and if so,
+               continue to the encrypted session. */
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+            if (tls_session -> nx_secure_tls_session_resumed)
             {
-                break;
-            }
 
-            /* ChangeCipherSpec is NOT a handshake message, so send as a normal TLS record. */
-            _nx_secure_tls_send_changecipherspec(tls_session, send_packet);
+                /* The server has verified the resumed session, answer with our own
+                   ChangeCipherSpec and Finished. */
+                status = _nx_secure_tls_client_handshake_finished_send(tls_session, packet_pool, wait_option);
+
+                temp_status = _nx_secure_tls_client_handshake_hash_cleanup(tls_session);
+                if (status == NX_SUCCESS)
+                {
+                    status = temp_status;
+                }
 
-            status = _nx_secure_tls_send_record(tls_session, send_packet, NX_SECURE_TLS_CHANGE_CIPHER_SPEC, wait_option);
+                tls_session -> nx_secure_tls_session_resumed = NX_FALSE;
 
-            if (status != NX_SUCCESS)
+                if ((status == NX_SUCCESS) && (tls_session -> nx_secure_tls_resume_ptr != NX_NULL))
+                {
+                    tls_session -> nx_secure_tls_resume_ptr -> nx_secure_tls_resume_hits++;
+                }
+            }
+            else if (tls_session -> nx_secure_tls_resume_ptr != NX_NULL)
             {
-                /* Release packet on send error. */
-                nx_secure_tls_packet_release(send_packet);
-                break;
+                tls_session -> nx_secure_tls_resume_ptr -> nx_secure_tls_resume_misses++;
             }
 
-            /* Reset the sequence number now that we are starting a new session. */
-            NX_SECURE_MEMSET(tls_session -> nx_secure_tls_local_sequence_number, 0, sizeof(tls_session -> nx_secure_tls_local_sequence_number));
-
-            /* The local session is now active since we sent the changecipherspec message.
-               NOTE: Do not set the keys until after the changecipherspec message has been passed to the send record
-               routine - this call causes encryption and hashing to happen on records. ChangeCipherSpec should be the last
-               un-encrypted/un-hashed record sent. For a renegotiation handshake, CCS is the last message encrypted using
-               the original session keys. */
-
-            /* Set our local session keys since we are sent a CCS message. */
-            _nx_secure_tls_session_keys_set(tls_session, NX_SECURE_TLS_KEY_SET_LOCAL);
-
-            /* We can now send our finished message, which will be encrypted using the chosen ciphersuite. */
-            status = _nx_secure_tls_allocate_handshake_packet(tls_session, packet_pool, &send_packet, wait_option);
-
-            if (status != NX_SUCCESS)
+            /* Cache the session for the next connection. */
+            if ((status == NX_SUCCESS) && (tls_session -> nx_secure_tls_resume_ptr != NX_NULL) &&
+                (tls_session -> nx_secure_tls_session_id_length > 0) &&
+                (tls_session -> nx_secure_tls_session_id_length <= NX_SECURE_TLS_RESUME_SESSION_ID_SIZE))
             {
-                break;
+                NX_SECURE_TLS_RESUME *resume_ptr = tls_session -> nx_secure_tls_resume_ptr;
+
+                resume_ptr -> nx_secure_tls_resume_protocol_version = tls_session -> nx_secure_tls_protocol_version;
+                resume_ptr -> nx_secure_tls_resume_ciphersuite = tls_session -> nx_secure_tls_session_ciphersuite -> nx_secure_tls_ciphersuite;
+                NX_SECURE_MEMCPY(resume_ptr -> nx_secure_tls_resume_session_id, tls_session -> nx_secure_tls_session_id,
+                                 tls_session -> nx_secure_tls_session_id_length); /* Use case of memcpy is verified. */
+                NX_SECURE_MEMCPY(resume_ptr -> nx_secure_tls_resume_master_secret,
+                                 tls_session -> nx_secure_tls_key_material.nx_secure_tls_master_secret,
+                                 NX_SECURE_TLS_MASTER_SIZE); /* Use case of memcpy is verified. */
+                resume_ptr -> nx_secure_tls_resume_session_id_length = tls_session -> nx_secure_tls_session_id_length;
             }
-
-            /* Generate and send the finished message, which completes the handshake. */
-            _nx_secure_tls_send_finished(tls_session, send_packet);
-
-            status = _nx_secure_tls_send_handshake_record(tls_session, send_packet, NX_SECURE_TLS_FINISHED, wait_option);
-
-            break;
-        case NX_SECURE_TLS_CLIENT_STATE_HANDSHAKE_FINISHED:
-            /* We processed a server finished message, completing the handshake. Verify all is good and if so,
-               continue to the encrypted session. */
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
             break;
         case NX_SECURE_TLS_CLIENT_STATE_HELLO_VERIFY: /* DTLS ONLY! */
         default:
@@ -641,3 +640,162 @@ const NX_CRYPTO_METHOD
 #endif
 }
 
+#ifndef NX_SECURE_TLS_CLIENT_DISABLED
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_secure_tls_client_handshake_hash_cleanup        PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function cleans up the handshake hash once the Finished        */
+/*    messages of both sides have been processed.                         */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    tls_session                           TLS control block             */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_secure_tls_client_handshake       TLS client state machine      */
+/*                                                                        */
+/**************************************************************************/
+static UINT _nx_secure_tls_client_handshake_hash_cleanup(NX_SECURE_TLS_SESSION *tls_session)
+{
+UINT                    status = NX_SUCCESS;
+UINT                    temp_status;
+const NX_CRYPTO_METHOD *method_ptr;
+
+    /* NOTE: we want to run all of the nx_crypto_cleanup calls regardless of their status,
+             so use a secondary status to track their return status values. */
+#if (NX_SECURE_TLS_TLS_1_2_ENABLED)
+    method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_sha256_method;
+
+    if (method_ptr -> nx_crypto_cleanup != NX_NULL)
+    {
+        temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_sha256_metadata);
+        if(temp_status != NX_CRYPTO_SUCCESS)
+        {
+            status = temp_status;
+        }
+    }
+
+#endif /* (NX_SECURE_TLS_TLS_1_2_ENABLED) */
+
+#if (NX_SECURE_TLS_TLS_1_0_ENABLED || NX_SECURE_TLS_TLS_1_1_ENABLED)
+    method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_md5_method;
+    if (method_ptr != NX_NULL && method_ptr -> nx_crypto_cleanup != NX_NULL)
+    {
+        temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_md5_metadata);
+        if(temp_status != NX_CRYPTO_SUCCESS)
+        {
+            status = temp_status;
+        }
+    }
+
+    method_ptr = tls_session -> nx_secure_tls_crypto_table -> nx_secure_tls_handshake_hash_sha1_method;
+    if (method_ptr != NX_NULL && method_ptr -> nx_crypto_cleanup != NX_NULL)
+    {
+        temp_status = method_ptr -> nx_crypto_cleanup(tls_session -> nx_secure_tls_handshake_hash.nx_secure_tls_handshake_hash_sha1_metadata);
+        if(temp_status != NX_CRYPTO_SUCCESS)
+        {
+            status = temp_status;
+        }
+    }
+#endif /* (NX_SECURE_TLS_TLS_1_0_ENABLED || NX_SECURE_TLS_TLS_1_1_ENABLED) */
+
+    return(status);
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_secure_tls_client_handshake_finished_send       PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function ends the client side of the handshake with a          */
+/*    ChangeCipherSpec (indicating following messages are encrypted) and  */
+/*    the encrypted Finished message. The session keys must have been     */
+/*    generated.                                                          */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    tls_session                           TLS control block             */
+/*    packet_pool                           Pool to allocate packets from */
+/*    wait_option                           Controls timeout actions      */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_secure_tls_client_handshake       TLS client state machine      */
+/*                                                                        */
+/**************************************************************************/
+static UINT _nx_secure_tls_client_handshake_finished_send(NX_SECURE_TLS_SESSION *tls_session,
+                                                          NX_PACKET_POOL *packet_pool, ULONG wait_option)
+{
+UINT       status;
+NX_PACKET *send_packet = NX_NULL;
+
+    /* Release the protection before suspending on nx_packet_allocate. */
+    tx_mutex_put(&_nx_secure_tls_protection);
+
+    status = _nx_secure_tls_packet_allocate(tls_session, packet_pool, &send_packet, wait_option);
+
+    /* Get the protection after nx_packet_allocate. */
+    tx_mutex_get(&_nx_secure_tls_protection, TX_WAIT_FOREVER);
+
+    if (status != NX_SUCCESS)
+    {
+        return(status);
+    }
+
+    /* ChangeCipherSpec is NOT a handshake message, so send as a normal TLS record. */
+    _nx_secure_tls_send_changecipherspec(tls_session, send_packet);
+
+    status = _nx_secure_tls_send_record(tls_session, send_packet, NX_SECURE_TLS_CHANGE_CIPHER_SPEC, wait_option);
+
+    if (status != NX_SUCCESS)
+    {
+        /* Release packet on send error. */
+        nx_secure_tls_packet_release(send_packet);
+        return(status);
+    }
+
+    /* Reset the sequence number now that we are starting a new session. */
+    NX_SECURE_MEMSET(tls_session -> nx_secure_tls_local_sequence_number, 0, sizeof(tls_session -> nx_secure_tls_local_sequence_number));
+
+    /* The local session is now active since we sent the changecipherspec message.
+       NOTE: Do not set the keys until after the changecipherspec message has been passed to the send record
+       routine - this call causes encryption and hashing to happen on records. ChangeCipherSpec should be the last
+       un-encrypted/un-hashed record sent. For a renegotiation handshake, CCS is the last message encrypted using
+       the original session keys. */
+
+    /* Set our local session keys since we are sent a CCS message. */
+    _nx_secure_tls_session_keys_set(tls_session, NX_SECURE_TLS_KEY_SET_LOCAL);
+
+    /* We can now send our finished message, which will be encrypted using the chosen ciphersuite. */
+    status = _nx_secure_tls_allocate_handshake_packet(tls_session, packet_pool, &send_packet, wait_option);
+
+    if (status != NX_SUCCESS)
+    {
+        return(status);
+    }
+
+    /* Generate and send the finished message, which completes the handshake. */
+    _nx_secure_tls_send_finished(tls_session, send_packet);
+
+    status = _nx_secure_tls_send_handshake_record(tls_session, send_packet, NX_SECURE_TLS_FINISHED, wait_option);
+
+    return(status);
+}
+#endif /* NX_SECURE_TLS_CLIENT_DISABLED */
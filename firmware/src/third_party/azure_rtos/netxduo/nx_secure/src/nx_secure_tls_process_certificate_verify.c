@@ -837,7 +837,7 @@ NX_SECURE_EC_PUBLIC_KEY              *ec_pubkey;
             return(status);
         }
 
-        if (((ULONG)packet_buffer + message_length) < ((ULONG)received_signature + length))
+        if (((ALIGN_TYPE)packet_buffer + message_length) < ((ALIGN_TYPE)received_signature + length))
         {
             return(NX_SECURE_X509_ASN1_LENGTH_TOO_LONG);
         }
@@ -95,6 +95,9 @@ USHORT                                ciphersuite;
 USHORT                                ciphersuite_priority;
 NX_SECURE_TLS_HELLO_EXTENSION         extension_data[NX_SECURE_TLS_HELLO_EXTENSIONS_MAX];
 UINT                                  num_extensions;
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+UINT                                  resumed = NX_FALSE;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 #if (NX_SECURE_TLS_TLS_1_3_ENABLED)
 USHORT                                tls_1_3 = tls_session -> nx_secure_tls_1_3;
 NX_SECURE_TLS_SERVER_STATE            old_client_state = tls_session -> nx_secure_tls_client_state;
@@ -167,6 +170,19 @@ NX_SECURE_TLS_SERVER_STATE            old_client_state = tls_session -> nx_secur
     }
     length += NX_SECURE_TLS_RANDOM_SIZE;
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* The server resumes the session offered in the ClientHello by echoing its ID. */
+    if ((tls_session -> nx_secure_tls_resume_ptr != NX_NULL) &&
+        (tls_session -> nx_secure_tls_session_id_length > 0) &&
+        (tls_session -> nx_secure_tls_session_id_length == packet_buffer[length]) &&
+        ((length + 1 + tls_session -> nx_secure_tls_session_id_length) <= message_length) &&
+        (NX_SECURE_MEMCMP(tls_session -> nx_secure_tls_session_id, &packet_buffer[length + 1],
+                          tls_session -> nx_secure_tls_session_id_length) == 0))
+    {
+        resumed = NX_TRUE;
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
     /* Session ID length is one byte. */
     tls_session -> nx_secure_tls_session_id_length = packet_buffer[length];
     length++;
@@ -201,6 +217,23 @@ NX_SECURE_TLS_SERVER_STATE            old_client_state = tls_session -> nx_secur
         return(NX_SECURE_TLS_UNKNOWN_CIPHERSUITE);
     }
 
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    if (resumed)
+    {
+        /* A resumed session keeps the version and ciphersuite it was established with. */
+        if ((version != tls_session -> nx_secure_tls_resume_ptr -> nx_secure_tls_resume_protocol_version) ||
+            (ciphersuite != tls_session -> nx_secure_tls_resume_ptr -> nx_secure_tls_resume_ciphersuite))
+        {
+            return(NX_SECURE_TLS_HANDSHAKE_FAILURE);
+        }
+
+        /* The server was authenticated in the handshake that established the session,
+           it proves it still holds the master secret with its Finished message. */
+        tls_session -> nx_secure_tls_session_resumed = NX_TRUE;
+        tls_session -> nx_secure_tls_received_remote_credentials = NX_TRUE;
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
+
     /* Compression method - for now this should be NULL. */
     compression_method = packet_buffer[length];
 
@@ -100,6 +100,9 @@ UINT                        status;
 UINT                        fallback_enabled = NX_FALSE;
 const NX_SECURE_TLS_CRYPTO *crypto_table;
 ULONG                      extension_length, total_extensions_length;
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+NX_SECURE_TLS_RESUME       *resume_ptr;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 
 
     /* ClientHello structure:
@@ -204,6 +207,27 @@ ULONG                      extension_length, total_extensions_length;
 
     /* Session ID length is one byte. */
     tls_session -> nx_secure_tls_session_id_length  = 0;
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    tls_session -> nx_secure_tls_session_resumed = NX_FALSE;
+
+    /* Offer the cached session, but not when renegotiating an active one. */
+    resume_ptr = tls_session -> nx_secure_tls_resume_ptr;
+    if ((resume_ptr != NX_NULL) && (resume_ptr -> nx_secure_tls_resume_session_id_length > 0) &&
+        (resume_ptr -> nx_secure_tls_resume_session_id_length <= NX_SECURE_TLS_RESUME_SESSION_ID_SIZE) &&
+        (!tls_session -> nx_secure_tls_local_session_active))
+    {
+        tls_session -> nx_secure_tls_session_id_length = resume_ptr -> nx_secure_tls_resume_session_id_length;
+        NX_SECURE_MEMCPY(tls_session -> nx_secure_tls_session_id, resume_ptr -> nx_secure_tls_resume_session_id,
+                         tls_session -> nx_secure_tls_session_id_length); /* Use case of memcpy is verified. */
+        NX_SECURE_MEMCPY(tls_session -> nx_secure_tls_key_material.nx_secure_tls_master_secret,
+                         resume_ptr -> nx_secure_tls_resume_master_secret, NX_SECURE_TLS_MASTER_SIZE); /* Use case of memcpy is verified. */
+
+        /* The entry is offered once, a completed handshake stores it again. A session
+           the server fails to resume is not offered over and over. */
+        resume_ptr -> nx_secure_tls_resume_session_id_length = 0;
+    }
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
     packet_buffer[length] = tls_session -> nx_secure_tls_session_id_length;
     length++;
 
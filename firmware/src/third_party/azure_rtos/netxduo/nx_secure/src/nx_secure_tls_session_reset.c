@@ -182,6 +182,11 @@ UINT temp_status;
 #ifndef NX_SECURE_TLS_CLIENT_DISABLED
     /* The state of the client handshake if this is a client socket. */
     session_ptr -> nx_secure_tls_client_state = NX_SECURE_TLS_CLIENT_STATE_IDLE;
+
+#ifdef NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION
+    /* The cache entry is kept, only the handshake state is cleared. */
+    session_ptr -> nx_secure_tls_session_resumed = NX_FALSE;
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION */
 #endif
 
     /* Indicate no messages to be hashed. */
@@ -0,0 +1,77 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Secure Component                                                 */
+/**                                                                       */
+/**    Transport Layer Security (TLS)                                     */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SECURE_SOURCE_CODE
+
+
+#include "nx_secure_tls.h"
+
+#if defined(NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION) && !defined(NX_SECURE_TLS_CLIENT_DISABLED)
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_secure_tls_session_resume_set                   PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function attaches the application owned session cache entry   */
+/*    used by a TLS Client. A session cached in the entry is offered in   */
+/*    the ClientHello, and if the server accepts it the handshake is      */
+/*    abbreviated to the hello and Finished messages. Every completed     */
+/*    full handshake stores its session in the entry.                     */
+/*                                                                        */
+/*    The same entry should only be used with the same server. Passing    */
+/*    NX_NULL detaches the entry.                                         */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    tls_session                           TLS control block             */
+/*    resume_ptr                            Session cache entry           */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    tx_mutex_get                          Get protection mutex          */
+/*    tx_mutex_put                          Put protection mutex          */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    Application Code                                                    */
+/*                                                                        */
+/**************************************************************************/
+UINT _nx_secure_tls_session_resume_set(NX_SECURE_TLS_SESSION *tls_session, NX_SECURE_TLS_RESUME *resume_ptr)
+{
+    /* Get the protection. */
+    tx_mutex_get(&_nx_secure_tls_protection, TX_WAIT_FOREVER);
+
+    tls_session -> nx_secure_tls_resume_ptr = resume_ptr;
+
+    /* Release the protection. */
+    tx_mutex_put(&_nx_secure_tls_protection);
+
+    return(NX_SUCCESS);
+}
+#endif /* NX_SECURE_TLS_CLIENT_SESSION_RESUMPTION && !NX_SECURE_TLS_CLIENT_DISABLED */
@@ -0,0 +1,213 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */ 
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Port Specific                                                       */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+
+/**************************************************************************/ 
+/*                                                                        */ 
+/*  PORT SPECIFIC C INFORMATION                            RELEASE        */
+/*                                                                        */
+/*    nx_port.h                                           Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This file contains data type definitions that make the NetX         */
+/*    real-time TCP/IP function identically on a variety of different     */
+/*    processor architectures.                                            */
+/*                                                                        */
+/*    This port runs NetX Duo on the ThreadX Linux port for the host      */
+/*    build.  Pointers do not fit the ULONG thread and timer inputs, so   */
+/*    NetX Duo keeps its control blocks in the extension pointers that    */
+/*    port adds to TX_THREAD and TX_TIMER_INTERNAL.                       */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef NX_PORT_H
+#define NX_PORT_H
+
+
+/* Determine if the optional NetX user define file should be used.  */
+
+#ifdef NX_INCLUDE_USER_DEFINE_FILE
+
+
+/* Yes, include the user defines in nx_user.h. The defines in this file may
+   alternately be defined on the command line.  */
+
+#include "nx_user.h"
+#endif
+
+
+/* Default to little endian, since this is what x86 and ARM Linux hosts are.  */
+
+#define NX_LITTLE_ENDIAN
+
+
+/* Define various constants for the port.  */
+
+#ifndef NX_IP_PERIODIC_RATE
+#define NX_IP_PERIODIC_RATE 100            /* Default IP periodic rate of 1 second for
+                                               the port's default 10ms timer interrupts.  This
+                                               value may be defined instead at the
+                                               command line and this value will not be
+                                               used.  */
+#endif
+
+
+/* Define macros that swap the endian for little endian ports.  */
+#ifdef NX_LITTLE_ENDIAN
+#define NX_CHANGE_ULONG_ENDIAN(arg)       (arg) = __builtin_bswap32((ULONG)(arg))
+#define NX_CHANGE_USHORT_ENDIAN(arg)      (arg) = (USHORT)__builtin_bswap16((USHORT)(arg))
+
+
+#ifndef htonl
+#define htonl(val)  __builtin_bswap32((ULONG)(val))
+#endif /* htonl */
+#ifndef ntohl
+#define ntohl(val)  __builtin_bswap32((ULONG)(val))
+#endif /* ntohl */
+
+#ifndef htons
+#define htons(val)  __builtin_bswap16((USHORT)(val))
+#endif /*htons */
+
+#ifndef ntohs
+#define ntohs(val)  __builtin_bswap16((USHORT)(val))
+#endif /*ntohs */
+
+
+#else
+
+#define NX_CHANGE_ULONG_ENDIAN(a)
+#define NX_CHANGE_USHORT_ENDIAN(a)
+
+#ifndef htons
+#define htons(val) (val)
+#endif /* htons */
+
+#ifndef ntohs
+#define ntohs(val) (val)
+#endif /* ntohs */
+
+#ifndef ntohl
+#define ntohl(val) (val)
+#endif
+
+#ifndef htonl
+#define htonl(val) (val)
+#endif /* htonl */
+#endif
+
+
+/* Keep the control block of a NetX Duo thread or timer in the ThreadX extension pointer,
+   the ULONG input cannot hold it.  A thread started before its pointer is set waits for it.  */
+
+#define NX_THREAD_EXTENSION_PTR_SET(a, b)                   { \
+                                                                TX_THREAD *thread_ptr; \
+                                                                thread_ptr = (TX_THREAD *) (a); \
+                                                                (thread_ptr -> tx_thread_extension_ptr) = (VOID *)(b); \
+                                                            }
+#define NX_THREAD_EXTENSION_PTR_GET(a, b, c)                { \
+                                                                NX_PARAMETER_NOT_USED(c); \
+                                                                TX_THREAD *thread_ptr; \
+                                                                thread_ptr = tx_thread_identify(); \
+                                                                while(1)\
+                                                                { \
+                                                                    if (thread_ptr -> tx_thread_extension_ptr) \
+                                                                    { \
+                                                                        (a) = (b *)(thread_ptr -> tx_thread_extension_ptr); \
+                                                                        break; \
+                                                                    } \
+                                                                    tx_thread_sleep(1); \
+                                                                } \
+                                                            }
+#define NX_TIMER_EXTENSION_PTR_SET(a, b)                    { \
+                                                                TX_TIMER *timer_ptr; \
+                                                                timer_ptr = (TX_TIMER *) (a);   \
+                                                                (timer_ptr -> tx_timer_internal.tx_timer_internal_extension_ptr) = (VOID *)(b); \
+                                                            }
+#define NX_TIMER_EXTENSION_PTR_GET(a, b, c)                 { \
+                                                                NX_PARAMETER_NOT_USED(c); \
+                                                                if (!_tx_timer_expired_timer_ptr -> tx_timer_internal_extension_ptr) \
+                                                                    return; \
+                                                                (a) = (b *)(_tx_timer_expired_timer_ptr -> tx_timer_internal_extension_ptr); \
+                                                            }
+
+/* Define several macros for the error checking shell in NetX.  */
+
+#ifndef TX_TIMER_PROCESS_IN_ISR
+
+#define NX_CALLER_CHECKING_EXTERNS          extern  TX_THREAD           *_tx_thread_current_ptr; \
+                                            extern  TX_THREAD           _tx_timer_thread; \
+                                            extern  volatile ULONG      _tx_thread_system_state;
+
+#define NX_THREADS_ONLY_CALLER_CHECKING     if ((_tx_thread_system_state) || \
+                                                (_tx_thread_current_ptr == TX_NULL) || \
+                                                (_tx_thread_current_ptr == &_tx_timer_thread)) \
+                                                return(NX_CALLER_ERROR);
+
+#define NX_INIT_AND_THREADS_CALLER_CHECKING if (((_tx_thread_system_state) && (_tx_thread_system_state < ((ULONG) 0xF0F0F0F0))) || \
+                                                (_tx_thread_current_ptr == &_tx_timer_thread)) \
+                                                return(NX_CALLER_ERROR);
+
+
+#define NX_NOT_ISR_CALLER_CHECKING          if ((_tx_thread_system_state) && (_tx_thread_system_state < ((ULONG) 0xF0F0F0F0))) \
+                                                return(NX_CALLER_ERROR);
+
+#define NX_THREAD_WAIT_CALLER_CHECKING      if ((wait_option) && \
+                                               ((_tx_thread_current_ptr == NX_NULL) || (_tx_thread_system_state) || (_tx_thread_current_ptr == &_tx_timer_thread))) \
+                                            return(NX_CALLER_ERROR);
+
+
+#else
+
+
+
+#define NX_CALLER_CHECKING_EXTERNS          extern  TX_THREAD           *_tx_thread_current_ptr; \
+                                            extern  volatile ULONG      _tx_thread_system_state;
+
+#define NX_THREADS_ONLY_CALLER_CHECKING     if ((_tx_thread_system_state) || \
+                                                (_tx_thread_current_ptr == TX_NULL)) \
+                                                return(NX_CALLER_ERROR);
+
+#define NX_INIT_AND_THREADS_CALLER_CHECKING if (((_tx_thread_system_state) && (_tx_thread_system_state < ((ULONG) 0xF0F0F0F0)))) \
+                                                return(NX_CALLER_ERROR);
+
+#define NX_NOT_ISR_CALLER_CHECKING          if ((_tx_thread_system_state) && (_tx_thread_system_state < ((ULONG) 0xF0F0F0F0))) \
+                                                return(NX_CALLER_ERROR);
+
+#define NX_THREAD_WAIT_CALLER_CHECKING      if ((wait_option) && \
+                                               ((_tx_thread_current_ptr == NX_NULL) || (_tx_thread_system_state))) \
+                                            return(NX_CALLER_ERROR);
+
+#endif
+
+
+/* Define the version ID of NetX.  This may be utilized by the application.  */
+
+#ifdef NX_SYSTEM_INIT
+CHAR                            _nx_version_id[] = 
+                                    "Copyright (c) Microsoft Corporation. All rights reserved. * NetX Duo Linux/GNU Version 6.1 *";
+#else
+extern  CHAR                    _nx_version_id[];
+#endif
+
+#endif
+
@@ -0,0 +1,135 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Initialize                                                          */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_initialize.h"
+#include "tx_thread.h"
+#include "tx_timer.h"
+#include "tx_linux.h"
+
+#include <errno.h>
+
+
+pthread_mutex_t             _tx_linux_mutex;
+sem_t                       _tx_linux_scheduler_semaphore;
+sem_t                       _tx_linux_idle_semaphore;
+UINT                        _tx_linux_scheduler_idle;
+__thread UINT               _tx_linux_interrupt_posture;
+__thread TX_THREAD          *_tx_linux_thread_self;
+__thread UINT               _tx_linux_interrupt_nesting;
+__thread UINT               _tx_linux_interrupt_saved_posture;
+
+
+static VOID                 *_tx_linux_timer_entry(VOID *parameter);
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_initialize_low_level                            Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is responsible for any low-level processor            */
+/*    initialization: it hands out the first unused memory, sets up the   */
+/*    kernel lock and starts the periodic timer pthread.  Initialization  */
+/*    continues with interrupts disabled, so the timer does not tick      */
+/*    until the scheduler first enables them.                             */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_initialize_kernel_enter           ThreadX entry function        */
+/*                                                                        */
+/**************************************************************************/
+VOID   _tx_initialize_low_level(VOID)
+{
+
+pthread_attr_t  attributes;
+pthread_t       timer;
+
+
+    /* Save the first available memory address.  */
+    _tx_initialize_unused_memory =  malloc(TX_LINUX_MEMORY_SIZE);
+
+    /* Setup the kernel lock and the scheduler semaphores.  */
+    pthread_mutex_init(&_tx_linux_mutex, NULL);
+    sem_init(&_tx_linux_scheduler_semaphore, 0, 0);
+    sem_init(&_tx_linux_idle_semaphore, 0, 0);
+
+    /* Disable interrupts for the rest of initialization.  */
+    pthread_mutex_lock(&_tx_linux_mutex);
+    _tx_linux_interrupt_posture =  TX_INT_DISABLE;
+
+    /* Start the periodic timer interrupt.  */
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_create(&timer, &attributes, _tx_linux_timer_entry, NULL);
+    pthread_attr_destroy(&attributes);
+}
+
+
+/* Raise the timer interrupt TX_TIMER_TICKS_PER_SECOND times a second.  Ticks are
+   scheduled on absolute times so a late wakeup does not stretch the time base.  */
+
+static VOID *_tx_linux_timer_entry(VOID *parameter)
+{
+
+struct timespec next;
+
+
+    (VOID) parameter;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (1)
+    {
+
+        next.tv_nsec +=  1000000000L / (long) TX_TIMER_TICKS_PER_SECOND;
+        if (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_nsec -=  1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+        {
+        }
+
+        _tx_thread_context_save();
+        _tx_timer_interrupt();
+        _tx_thread_context_restore();
+    }
+
+    return(NULL);
+}
+
+
+VOID   _tx_linux_semaphore_wait(sem_t *semaphore)
+{
+
+    while ((sem_wait(semaphore) != 0) && (errno == EINTR))
+    {
+    }
+}
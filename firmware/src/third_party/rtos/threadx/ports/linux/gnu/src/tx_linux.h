@@ -0,0 +1,59 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Port Specific                                                       */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#ifndef TX_LINUX_H
+#define TX_LINUX_H
+
+#include <pthread.h>
+#include <semaphore.h>
+
+
+/* Define the pthread side of a ThreadX thread.  */
+
+typedef struct TX_LINUX_CONTEXT_STRUCT
+{
+    pthread_t           tx_linux_context_pthread;
+    sem_t               tx_linux_context_run;
+    UINT                tx_linux_context_exit;
+    TX_THREAD           *tx_linux_context_thread;
+    VOID                (*tx_linux_context_entry)(VOID);
+} TX_LINUX_CONTEXT;
+
+
+/* Define the kernel lock standing in for the interrupt mask, the semaphores the scheduler
+   waits on, and the per-pthread posture and thread identity.  */
+
+extern pthread_mutex_t              _tx_linux_mutex;
+extern sem_t                        _tx_linux_scheduler_semaphore;
+extern sem_t                        _tx_linux_idle_semaphore;
+extern UINT                         _tx_linux_scheduler_idle;
+extern __thread UINT                _tx_linux_interrupt_posture;
+extern __thread TX_THREAD           *_tx_linux_thread_self;
+extern __thread UINT                _tx_linux_interrupt_nesting;
+extern __thread UINT                _tx_linux_interrupt_saved_posture;
+
+
+/* Wait on a semaphore, riding out signals.  */
+
+VOID    _tx_linux_semaphore_wait(sem_t *semaphore);
+
+#endif
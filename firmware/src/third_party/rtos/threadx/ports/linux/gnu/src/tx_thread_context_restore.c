@@ -0,0 +1,70 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Thread                                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_linux.h"
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_thread_context_restore                          Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function restores the interrupt context at the end of          */
+/*    interrupt processing.  An idle scheduler is woken when the ISR made */
+/*    a thread ready.  A thread running on another pthread sees the new   */
+/*    thread to execute at its next kernel call and gives up the          */
+/*    processor there.                                                    */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    ISRs                                                                */
+/*                                                                        */
+/**************************************************************************/
+VOID   _tx_thread_context_restore(VOID)
+{
+
+    _tx_thread_system_state--;
+
+    if ((_tx_thread_system_state == ((ULONG) 0)) &&
+        (_tx_linux_scheduler_idle) &&
+        (_tx_thread_execute_ptr != TX_NULL))
+    {
+        _tx_linux_scheduler_idle =  TX_FALSE;
+        sem_post(&_tx_linux_idle_semaphore);
+    }
+
+    /* Restoring the interrupted posture preempts an interrupted thread.  */
+    if (--_tx_linux_interrupt_nesting == ((UINT) 0))
+    {
+        _tx_thread_interrupt_control(_tx_linux_interrupt_saved_posture);
+    }
+}
@@ -0,0 +1,84 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Thread                                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_linux.h"
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_thread_interrupt_control                        Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is responsible for changing the interrupt lockout     */
+/*    posture of the system.  Disabling takes the kernel lock unless this */
+/*    pthread already holds it.  Enabling gives the processor to a        */
+/*    different thread to execute first, which is where this port         */
+/*    preempts, then drops the lock.                                      */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    new_posture                           New interrupt lockout posture */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    old_posture                           Old interrupt lockout posture */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    Application Code and ThreadX                                        */
+/*                                                                        */
+/**************************************************************************/
+UINT   _tx_thread_interrupt_control(UINT new_posture)
+{
+
+UINT    old_posture =  _tx_linux_interrupt_posture;
+
+
+    if (new_posture == TX_INT_DISABLE)
+    {
+
+        if (old_posture == TX_INT_ENABLE)
+        {
+            pthread_mutex_lock(&_tx_linux_mutex);
+            _tx_linux_interrupt_posture =  TX_INT_DISABLE;
+        }
+    }
+    else if (old_posture == TX_INT_DISABLE)
+    {
+
+        _tx_linux_thread_yield();
+        _tx_linux_interrupt_posture =  TX_INT_ENABLE;
+        pthread_mutex_unlock(&_tx_linux_mutex);
+    }
+
+    return(old_posture);
+}
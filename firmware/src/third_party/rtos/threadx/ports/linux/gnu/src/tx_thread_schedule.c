@@ -0,0 +1,89 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Thread                                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_timer.h"
+#include "tx_linux.h"
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_thread_schedule                                 Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function waits for a thread control block pointer to appear in */
+/*    the _tx_thread_execute_ptr variable.  Once a thread pointer appears */
+/*    in the variable, the corresponding thread's pthread is released and */
+/*    the scheduler waits for it to give the processor back.              */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_initialize_kernel_enter          ThreadX entry function         */
+/*                                                                        */
+/**************************************************************************/
+VOID   _tx_thread_schedule(VOID)
+{
+
+TX_THREAD           *thread_ptr;
+TX_LINUX_CONTEXT    *context_ptr;
+
+
+    /* Initialization is complete, enable interrupts.  */
+    _tx_linux_interrupt_posture =  TX_INT_ENABLE;
+    pthread_mutex_unlock(&_tx_linux_mutex);
+
+    while (1)
+    {
+
+        pthread_mutex_lock(&_tx_linux_mutex);
+
+        /* Wait for a thread to execute, an interrupt posts the idle semaphore.  */
+        while ((thread_ptr =  _tx_thread_execute_ptr) == TX_NULL)
+        {
+            _tx_linux_scheduler_idle =  TX_TRUE;
+            pthread_mutex_unlock(&_tx_linux_mutex);
+            _tx_linux_semaphore_wait(&_tx_linux_idle_semaphore);
+            pthread_mutex_lock(&_tx_linux_mutex);
+        }
+        _tx_linux_scheduler_idle =  TX_FALSE;
+
+        /* Setup the current thread pointer, its run count and time-slice.  */
+        _tx_thread_current_ptr =  thread_ptr;
+        thread_ptr -> tx_thread_run_count++;
+        _tx_timer_time_slice =  thread_ptr -> tx_thread_time_slice;
+        context_ptr =  (TX_LINUX_CONTEXT *) thread_ptr -> tx_thread_linux_context;
+        pthread_mutex_unlock(&_tx_linux_mutex);
+
+        /* Run the thread until it returns to the system.  */
+        sem_post(&context_ptr -> tx_linux_context_run);
+        _tx_linux_semaphore_wait(&_tx_linux_scheduler_semaphore);
+    }
+}
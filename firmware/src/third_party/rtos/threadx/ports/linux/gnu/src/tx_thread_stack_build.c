@@ -0,0 +1,121 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Thread                                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_linux.h"
+
+
+static VOID *_tx_linux_thread_entry(VOID *parameter);
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_thread_stack_build                              Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function builds the pthread a new thread runs on.  The pthread */
+/*    waits for the scheduler before calling the thread's entry, so the   */
+/*    thread starts with interrupts enabled the first time it executes.   */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    thread_ptr                            Pointer to thread control blk */
+/*    function_ptr                          Pointer to return function    */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_thread_create                     Create thread service         */
+/*    _tx_thread_reset                      Reset thread service          */
+/*                                                                        */
+/**************************************************************************/
+VOID   _tx_thread_stack_build(TX_THREAD *thread_ptr, VOID (*function_ptr)(VOID))
+{
+
+TX_LINUX_CONTEXT    *context_ptr;
+pthread_attr_t      attributes;
+
+
+    context_ptr =  (TX_LINUX_CONTEXT *) malloc(sizeof(TX_LINUX_CONTEXT));
+    sem_init(&context_ptr -> tx_linux_context_run, 0, 0);
+    context_ptr -> tx_linux_context_exit =    TX_FALSE;
+    context_ptr -> tx_linux_context_thread =  thread_ptr;
+    context_ptr -> tx_linux_context_entry =   function_ptr;
+    thread_ptr -> tx_thread_linux_context =   (VOID *) context_ptr;
+
+    /* The thread runs on the pthread's stack, the ThreadX stack is left untouched.  */
+    thread_ptr -> tx_thread_stack_ptr =  thread_ptr -> tx_thread_stack_end;
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_create(&context_ptr -> tx_linux_context_pthread, &attributes, _tx_linux_thread_entry, context_ptr);
+    pthread_attr_destroy(&attributes);
+}
+
+
+/* Release the pthread of a deleted or reset thread.  Called with interrupts disabled;
+   the thread is not executing, so its pthread is waiting for the scheduler and ends
+   once it sees the exit flag.  */
+
+VOID   _tx_linux_thread_release(TX_THREAD *thread_ptr)
+{
+
+TX_LINUX_CONTEXT    *context_ptr =  (TX_LINUX_CONTEXT *) thread_ptr -> tx_thread_linux_context;
+
+
+    if (context_ptr != TX_NULL)
+    {
+        thread_ptr -> tx_thread_linux_context =  TX_NULL;
+        context_ptr -> tx_linux_context_exit =   TX_TRUE;
+        sem_post(&context_ptr -> tx_linux_context_run);
+    }
+}
+
+
+static VOID *_tx_linux_thread_entry(VOID *parameter)
+{
+
+TX_LINUX_CONTEXT    *context_ptr =  (TX_LINUX_CONTEXT *) parameter;
+
+
+    _tx_linux_semaphore_wait(&context_ptr -> tx_linux_context_run);
+    if (context_ptr -> tx_linux_context_exit)
+    {
+        sem_destroy(&context_ptr -> tx_linux_context_run);
+        free(context_ptr);
+        return(NULL);
+    }
+
+    _tx_linux_thread_self =        context_ptr -> tx_linux_context_thread;
+    _tx_linux_interrupt_posture =  TX_INT_ENABLE;
+    (context_ptr -> tx_linux_context_entry)();
+
+    return(NULL);
+}
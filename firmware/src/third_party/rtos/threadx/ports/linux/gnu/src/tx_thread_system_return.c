@@ -0,0 +1,101 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Thread                                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_timer.h"
+#include "tx_linux.h"
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_thread_system_return                            Linux/GNU       */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is target processor specific.  It is used to transfer*/
+/*    control from a thread back to the ThreadX system.  The thread's     */
+/*    pthread blocks until the scheduler runs it again.                   */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    ThreadX components                                                  */
+/*                                                                        */
+/**************************************************************************/
+VOID   _tx_thread_system_return(VOID)
+{
+
+UINT    posture;
+
+
+    posture =  _tx_thread_interrupt_control(TX_INT_DISABLE);
+    _tx_linux_thread_yield();
+    _tx_thread_interrupt_control(posture);
+}
+
+
+/* Give the processor back to the scheduler while another thread is to execute.  Called
+   with the kernel lock held, from the pthread of the running thread; returns with the
+   lock held once the scheduler runs this thread again.  */
+
+VOID   _tx_linux_thread_yield(VOID)
+{
+
+TX_THREAD           *thread_ptr =  _tx_linux_thread_self;
+TX_LINUX_CONTEXT    *context_ptr;
+
+
+    while ((thread_ptr != TX_NULL) &&
+           (_tx_thread_current_ptr == thread_ptr) &&
+           (_tx_thread_execute_ptr != thread_ptr) &&
+           (_tx_thread_system_state == ((ULONG) 0)) &&
+           (_tx_thread_preempt_disable == ((UINT) 0)))
+    {
+
+        /* Save the remaining time-slice and clear the current thread.  */
+        thread_ptr -> tx_thread_time_slice =  _tx_timer_time_slice;
+        _tx_timer_time_slice =  ((ULONG) 0);
+        _tx_thread_current_ptr =  TX_NULL;
+
+        context_ptr =  (TX_LINUX_CONTEXT *) thread_ptr -> tx_thread_linux_context;
+        pthread_mutex_unlock(&_tx_linux_mutex);
+        sem_post(&_tx_linux_scheduler_semaphore);
+        _tx_linux_semaphore_wait(&context_ptr -> tx_linux_context_run);
+
+        /* A deleted or reset thread is not resumed, its pthread just ends.  */
+        if (context_ptr -> tx_linux_context_exit)
+        {
+            sem_destroy(&context_ptr -> tx_linux_context_run);
+            free(context_ptr);
+            pthread_exit(NULL);
+        }
+
+        pthread_mutex_lock(&_tx_linux_mutex);
+    }
+}